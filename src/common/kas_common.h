@@ -20,18 +20,19 @@
 #ifndef __KAS_COMMON_H__
 #define __KAS_COMMON_H__
 
+/* PROF_ZONE and PROF_ZONE_NAMED expand to declarations only and PROF_ZONE_END to a single statement */
 #ifdef KAS_PROFILE
 	#include "tracy/TracyC.h"
 	#define PROF_FRAME_MARK		TracyCFrameMark
-	#define	PROF_ZONE		TracyCZone(ctx, 1)
-	#define PROF_ZONE_NAMED(str)	TracyCZoneN(ctx, str, 1)
-	#define PROF_ZONE_END		TracyCZoneEnd(ctx)
+	#define	PROF_ZONE		TracyCZone(ctx, 1); TASK_TIMELINE_ZONE(__func__)
+	#define PROF_ZONE_NAMED(str)	TracyCZoneN(ctx, str, 1); TASK_TIMELINE_ZONE(str)
+	#define PROF_ZONE_END		do { TASK_TIMELINE_ZONE_END; TracyCZoneEnd(ctx); } while (0)
 	#define PROF_THREAD_NAMED(str)	TracyCSetThreadName(str)
 #else
 	#define PROF_FRAME_MARK		
-	#define	PROF_ZONE		
-	#define PROF_ZONE_NAMED(str)
-	#define PROF_ZONE_END	
+	#define	PROF_ZONE		TASK_TIMELINE_ZONE(__func__)
+	#define PROF_ZONE_NAMED(str)	TASK_TIMELINE_ZONE(str)
+	#define PROF_ZONE_END		TASK_TIMELINE_ZONE_END
 	#define PROF_THREAD_NAMED(str)
 #endif
 
@@ -88,6 +89,17 @@
 #include "kas_types.h"
 #include "kas_debug.h"
 
+/* task timeline capture (sys_public.h), profiler zones on task workers are recorded as timeline zones */
+#ifdef KAS_TASK_TIMELINE
+	u32	task_timeline_zone_begin(const char *name);
+	void	task_timeline_zone_end(const u32 zone);
+	#define TASK_TIMELINE_ZONE(str)	const u32 timeline_zone = task_timeline_zone_begin(str)
+	#define TASK_TIMELINE_ZONE_END	task_timeline_zone_end(timeline_zone)
+#else
+	#define TASK_TIMELINE_ZONE(str)
+	#define TASK_TIMELINE_ZONE_END
+#endif
+
 /* system identifiers for logger, profiler ... */
 enum system_id
 {
@@ -161,6 +161,29 @@ struct hash_map *hash_map_deserialize(struct arena *mem, struct serialize_stream
 	return map;
 }
 
+u32 hash_map_reserve(struct hash_map *map, const u32 index_len)
+{
+	if (map->index_len < index_len)
+	{
+		if (!map->growable)
+		{
+			return 0;	
+		}
+
+		const u32 len = (u32) power_of_two_ceil(index_len);
+		u32 *index = realloc(map->index, len * sizeof(u32));
+		if (!index)
+		{
+			return 0;
+		}
+
+		map->index_len = len;
+		map->index = index;
+	}
+
+	return 1;
+}
+
 u32 hash_map_add(struct hash_map *map, const u32 key, const u32 index)
 {
 	kas_assert(index >> 31 == 0);
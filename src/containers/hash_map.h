@@ -51,7 +51,10 @@ void			hash_map_flush(struct hash_map *map);
 void 			hash_map_serialize(struct serialize_stream *ss, const struct hash_map *map);
 /* deserialize and construct hash_map on arena if defined, otherwise alloc on heap. On failure, returns NULL  */
 struct hash_map *	hash_map_deserialize(struct arena *mem, struct serialize_stream *ss, const u32 growable);
-/* add the key-index pair to the hash map. return 1 on success, 0 on out-of-memory. */
+/* make sure indices < index_len can be added without reallocation. return 1 on success, 0 on out-of-memory. */
+u32			hash_map_reserve(struct hash_map *map, const u32 index_len);
+/* add the key-index pair to the hash map. return 1 on success, 0 on out-of-memory. Given a previous 
+ * hash_map_reserve, pairs may be added concurrently as long as no two threads add keys to the same bucket. */
 u32			hash_map_add(struct hash_map *map, const u32 key, const u32 index);
 /* remove  key-index pair to the hash map. If the pair is not found, do nothing. */
 void			hash_map_remove(struct hash_map *map, const u32 key, const u32 index);
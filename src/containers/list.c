@@ -297,6 +297,39 @@ struct slot nll_add(struct nll *net, void *data, const u32 next_0, const u32 nex
 	return slot;
 }
 
+struct slot nll_reserve(struct nll *net)
+{
+	struct slot slot = pool_add(&net->pool);
+	u32 *next = (u32 *)((u8 *) slot.address + net->next_offset);
+	u32 *prev = (u32 *)((u8 *) slot.address + net->prev_offset);
+	next[0] = NLL_NULL;
+	next[1] = NLL_NULL;
+	prev[0] = NLL_NULL;
+	prev[1] = NLL_NULL;
+
+	return slot;
+}
+
+void nll_link(struct nll *net, const u32 index, const u32 list, const u32 next)
+{
+	kas_assert(list <= 1);
+	u8 *node = pool_address(&net->pool, index);
+	u32 *node_next = (u32 *)(node + net->next_offset);
+	u32 *node_prev = (u32 *)(node + net->prev_offset);
+	node_next[list] = next;
+	node_prev[list] = NLL_NULL;
+
+	/* skip the NULL node so that concurrent linking never writes to shared memory */
+	if (next != NLL_NULL)
+	{
+		u8 *node_next_list;
+		const u32 index_next = net->index_in_next_node(net, (void **) &node_next_list, node, list);
+		u32 *prev = (u32 *)(node_next_list + net->prev_offset);
+		kas_assert_string(prev[index_next] == NLL_NULL, "the next node must be the previous head in the list, which should have its previous node as the NULL NODE");
+		prev[index_next] = index;
+	}
+}
+
 void nll_remove(struct nll *net, const u32 index)
 {
 	u8 *node = pool_address(&net->pool, index);
@@ -168,6 +168,11 @@ void 		nll_flush(struct nll *net);
 /* reserve a memory node and return the memory index and set the node's links. next_0 and next_1 MUST always be 
  * the first nodes, or static node references, of the two corresponding lists owning the node */
 struct slot	nll_add(struct nll *net, void *data, const u32 next_0, const u32 next_1);
+/* reserve a memory node with unset links, which must later be prepended to both of its lists using nll_link */
+struct slot	nll_reserve(struct nll *net);
+/* prepend the reserved node to list (0,1) of the node, where next is the current first node of that list. Nodes may
+ * be linked concurrently as long as no two threads link into the same list. */
+void		nll_link(struct nll *net, const u32 index, const u32 list, const u32 next);
 /* free a memory node, updating both lists it is a part of */
 void 		nll_remove(struct nll *net, const u32 index);
 /* get the node address given its index */
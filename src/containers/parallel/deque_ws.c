@@ -0,0 +1,133 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt 
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+
+#include "kas_math.h"
+#include "deque_ws.h"
+
+struct deque_ws *deque_ws_init(struct arena *mem_persistent, const u64 max_entry_count)
+{
+	kas_assert(max_entry_count > 0 && is_power_of_two(max_entry_count));
+
+	struct deque_ws *q = (mem_persistent) 
+		? arena_push(mem_persistent, sizeof(struct deque_ws))
+		: malloc(sizeof(struct deque_ws));
+	void **entries = (mem_persistent) 
+		? arena_push(mem_persistent, max_entry_count * sizeof(void *))
+		: malloc(max_entry_count * sizeof(void *));
+	if (!q || !entries)
+	{
+		if (!mem_persistent)
+		{
+			free(q);
+			free(entries);
+		}
+		return NULL;
+	}
+
+	q->max_entry_count = max_entry_count;
+	q->entries = entries;
+	for (u64 i = 0; i < max_entry_count; ++i)
+	{
+		q->entries[i] = NULL;
+	}
+
+	atomic_store_rel_64(&q->a_top, 0);
+	atomic_store_rel_64(&q->a_bottom, 0);
+
+	return q;
+}
+
+u32 deque_ws_try_push(struct deque_ws *q, void *data)
+{
+	const u64 b = atomic_load_rlx_64(&q->a_bottom);
+	const u64 t = atomic_load_acq_64(&q->a_top);
+	if (b - t >= q->max_entry_count)
+	{
+		return 0;
+	}
+
+	atomic_store_rlx_64(&q->entries[b & (q->max_entry_count - 1)], data);
+	/* stealers acquiring a_bottom will see the entry and anything written before the push */
+	atomic_store_rel_64(&q->a_bottom, b + 1);
+
+	return 1;
+}
+
+void *deque_ws_pop(struct deque_ws *q)
+{
+	const u64 b = atomic_load_rlx_64(&q->a_bottom);
+	if (b == atomic_load_rlx_64(&q->a_top))
+	{
+		return NULL;
+	}
+
+	/* 
+	 * Reserve the bottom entry before looking at a_top; the store and the load must not be reordered, or
+	 * a stealer and the owner may both take the last entry.
+	 */
+	atomic_store_seq_cst_64(&q->a_bottom, b - 1);
+	u64 t = atomic_load_seq_cst_64(&q->a_top);
+
+	void *data = NULL;
+	if ((i64) (b - 1 - t) >= 0)
+	{
+		data = (void *) atomic_load_rlx_64(&q->entries[(b - 1) & (q->max_entry_count - 1)]);
+		if (b - 1 == t)
+		{
+			/* last entry, race any stealers for it */
+			if (!atomic_compare_exchange_seq_cst_64(&q->a_top, &t, t + 1))
+			{
+				data = NULL;
+			}
+			atomic_store_rlx_64(&q->a_bottom, b);
+		}
+	}
+	else
+	{
+		atomic_store_rlx_64(&q->a_bottom, b);
+	}
+
+	return data;
+}
+
+void *deque_ws_steal(struct deque_ws *q)
+{
+	u64 t = atomic_load_seq_cst_64(&q->a_top);
+	const u64 b = atomic_load_seq_cst_64(&q->a_bottom);
+
+	void *data = NULL;
+	if ((i64) (b - t) > 0)
+	{
+		data = (void *) atomic_load_rlx_64(&q->entries[t & (q->max_entry_count - 1)]);
+		if (!atomic_compare_exchange_seq_cst_64(&q->a_top, &t, t + 1))
+		{
+			data = NULL;
+		}
+	}
+
+	return data;
+}
+
+u64 deque_ws_count(const struct deque_ws *q)
+{
+	const u64 t = atomic_load_acq_64(&q->a_top);
+	const u64 b = atomic_load_acq_64(&q->a_bottom);
+	return ((i64) (b - t) > 0) ? b - t : 0;
+}
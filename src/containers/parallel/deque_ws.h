@@ -0,0 +1,60 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt 
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+
+#ifndef __DEQUE_WS_H__
+#define __DEQUE_WS_H__
+
+#include "kas_common.h"
+#include "allocator.h"
+#include "sys_public.h"
+
+/*
+ * deque_ws - fixed size work-stealing deque (Chase-Lev). The owning thread pushes and pops at the bottom
+ * (LIFO) while any other thread may steal from the top (FIFO). Only the last remaining entry is contended,
+ * and is resolved by a CAS on a_top between the owner and the stealers.
+ *
+ * Invariant: 	(1) entries [a_top, a_bottom) are published and not yet taken
+ * 	     	(2) a_bottom is only written by the owner
+ * 	     	(3) a_top is monotonically increasing and only advanced by successful CAS 
+ * 	     	(4) a_bottom - a_top <= max_entry_count, so a published entry is never overwritten before it
+ * 	     	    is taken.
+ */
+struct deque_ws
+{
+	u64 	a_top;				/* Stealer end */
+	u8	pad1[120];
+	u64 	a_bottom;			/* Owner end */
+	u8	pad2[120];
+	void **	entries;
+	u64 	max_entry_count;		/* Must be power of 2 */
+};
+
+/* allocate the deque on the heap if mem_persistent is NULL; returns NULL on out-of-memory */
+struct deque_ws *	deque_ws_init(struct arena *mem_persistent, const u64 max_entry_count);
+/* (owner) returns 0 if the deque is full, otherwise return 1 */
+u32 			deque_ws_try_push(struct deque_ws *q, void *data);
+/* (owner) returns NULL if empty, otherwise the most recently pushed entry */
+void *			deque_ws_pop(struct deque_ws *q);
+/* (any thread) returns NULL if empty or if the steal lost a race, otherwise the oldest entry */
+void *			deque_ws_steal(struct deque_ws *q);
+/* (any thread) return an approximation of the number of entries in the deque */
+u64 			deque_ws_count(const struct deque_ws *q);
+
+#endif
@@ -162,7 +162,7 @@ struct min_queue min_queue_new(struct arena *arena, const u32 initial_length, co
 	}
 	else
 	{
-		queue.object_pool = pool_alloc(NULL, initial_length, struct queue_object, !GROWABLE);
+		queue.object_pool = pool_alloc(NULL, initial_length, struct queue_object, growable);
 		queue.elements = malloc(initial_length * sizeof(struct queue_element));
 		queue.heap_allocated = 1;
 	}
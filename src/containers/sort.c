@@ -0,0 +1,266 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+#include <string.h>
+
+#include "sort.h"
+#include "sys_public.h"
+
+/* merge entry [left, mid-1], [mid, right-1] => tmp => copy back to entry */
+static void internal_sort_merge(struct sort_entry *entry, struct sort_entry *tmp, const u32 left, const u32 mid, const u32 right)
+{
+	u32 l = left;
+	u32 r = mid;
+	const u32 count = right - left;
+
+	for (u32 i = left; i < right; ++i)
+	{
+		if (r < right && (l >= mid || entry[r].key < entry[l].key))
+		{
+			tmp[i] = entry[r];
+			r += 1;
+		}
+		else
+		{
+			tmp[i] = entry[l];
+			l += 1;
+		}
+	}
+
+	memcpy(entry + left, tmp + left, count * sizeof(struct sort_entry));
+}
+
+void sort_merge(struct sort_entry *entry, struct sort_entry *tmp, const u32 count)
+{
+	for (u32 width = 2; width/2 < count; width *= 2)
+	{
+		u32 i = 0;
+		for (; i + width <= count; i += width)
+		{
+			internal_sort_merge(entry, tmp, i, i + width/2, i + width);
+		}
+
+		if (i + width/2 < count)
+		{
+			internal_sort_merge(entry, tmp, i, i + width/2, count);
+		}
+	}
+}
+
+static void internal_sort_count_digits(u32 histogram[SORT_RADIX_DIGITS][SORT_RADIX_BUCKETS], const struct sort_entry *entry, const u32 count)
+{
+	memset(histogram, 0, SORT_RADIX_DIGITS * SORT_RADIX_BUCKETS * sizeof(u32));
+	for (u32 i = 0; i < count; ++i)
+	{
+		u64 key = entry[i].key;
+		for (u32 d = 0; d < SORT_RADIX_DIGITS; ++d)
+		{
+			histogram[d][key & (SORT_RADIX_BUCKETS - 1)] += 1;
+			key >>= SORT_RADIX_BITS;
+		}
+	}
+}
+
+static void internal_sort_count(u32 histogram[SORT_RADIX_BUCKETS], const struct sort_entry *entry, const u32 count, const u32 shift)
+{
+	memset(histogram, 0, SORT_RADIX_BUCKETS * sizeof(u32));
+	for (u32 i = 0; i < count; ++i)
+	{
+		histogram[(entry[i].key >> shift) & (SORT_RADIX_BUCKETS - 1)] += 1;
+	}
+}
+
+static void internal_sort_scatter(struct sort_entry *dst, const struct sort_entry *src, const u32 count, u32 offset[SORT_RADIX_BUCKETS], const u32 shift)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		dst[offset[(src[i].key >> shift) & (SORT_RADIX_BUCKETS - 1)]++] = src[i];
+	}
+}
+
+/* Return 1 if every key has the same digit, given the digit's histogram over all keys */
+static u32 internal_sort_digit_constant(const u32 histogram[SORT_RADIX_BUCKETS], const u32 count)
+{
+	for (u32 b = 0; b < SORT_RADIX_BUCKETS; ++b)
+	{
+		if (histogram[b])
+		{
+			return histogram[b] == count;
+		}
+	}
+
+	return 1;
+}
+
+void sort_radix(struct sort_entry *entry, struct sort_entry *tmp, const u32 count)
+{
+	u32 histogram[SORT_RADIX_DIGITS][SORT_RADIX_BUCKETS];
+	u32 offset[SORT_RADIX_BUCKETS];
+	internal_sort_count_digits(histogram, entry, count);
+
+	struct sort_entry *src = entry;
+	struct sort_entry *dst = tmp;
+	for (u32 d = 0; d < SORT_RADIX_DIGITS; ++d)
+	{
+		if (internal_sort_digit_constant(histogram[d], count))
+		{
+			continue;
+		}
+
+		u32 running = 0;
+		for (u32 b = 0; b < SORT_RADIX_BUCKETS; ++b)
+		{
+			offset[b] = running;
+			running += histogram[d][b];
+		}
+
+		internal_sort_scatter(dst, src, count, offset, d*SORT_RADIX_BITS);
+		struct sort_entry *swap = src;
+		src = dst;
+		dst = swap;
+	}
+
+	if (src != entry)
+	{
+		memcpy(entry, src, count * sizeof(struct sort_entry));
+	}
+}
+
+/* chunk of the entries owned by a single task */
+struct sort_radix_chunk
+{
+	u32	begin;
+	u32	count;
+	u32	histogram[SORT_RADIX_DIGITS][SORT_RADIX_BUCKETS];	/* digit counts of the chunk's entries */
+	u32	offset[SORT_RADIX_BUCKETS];				/* scatter offsets of the current pass */
+};
+
+struct sort_radix_pass
+{
+	const struct sort_entry *	src;
+	struct sort_entry *		dst;
+	u32				digit;
+};
+
+static void thread_sort_radix_count_digits(void *task_addr)
+{
+	struct task *task = task_addr;
+	const struct sort_radix_pass *pass = task->input;
+	struct sort_radix_chunk *chunk = task->range->base;
+	internal_sort_count_digits(chunk->histogram, pass->src + chunk->begin, chunk->count);
+}
+
+static void thread_sort_radix_count(void *task_addr)
+{
+	struct task *task = task_addr;
+	const struct sort_radix_pass *pass = task->input;
+	struct sort_radix_chunk *chunk = task->range->base;
+	internal_sort_count(chunk->histogram[pass->digit], pass->src + chunk->begin, chunk->count, pass->digit*SORT_RADIX_BITS);
+}
+
+static void thread_sort_radix_scatter(void *task_addr)
+{
+	struct task *task = task_addr;
+	const struct sort_radix_pass *pass = task->input;
+	struct sort_radix_chunk *chunk = task->range->base;
+	internal_sort_scatter(pass->dst, pass->src + chunk->begin, chunk->count, chunk->offset, pass->digit*SORT_RADIX_BITS);
+}
+
+static void internal_sort_radix_run(struct arena *mem, TASK task, struct sort_radix_chunk *chunk, const u32 chunk_count, struct sort_radix_pass *pass)
+{
+	struct task_bundle *bundle = task_bundle_split_range(mem, task, chunk_count, chunk, chunk_count, sizeof(struct sort_radix_chunk), pass);
+	task_main_master_run_available_jobs();
+	task_bundle_wait(bundle);
+	task_bundle_release(bundle);
+}
+
+void sort_radix_parallel(struct arena *mem, struct sort_entry *entry, struct sort_entry *tmp, const u32 count)
+{
+	if (count < SORT_RADIX_PARALLEL_MIN || task_worker_self() == NULL || g_task_ctx->worker_count == 1)
+	{
+		sort_radix(entry, tmp, count);
+		return;
+	}
+
+	PROF_ZONE;
+	arena_push_record(mem);
+
+	const u32 chunk_count = g_task_ctx->worker_count;
+	struct sort_radix_chunk *chunk = arena_push(mem, chunk_count * sizeof(struct sort_radix_chunk));
+	struct sort_radix_pass *pass = arena_push(mem, sizeof(struct sort_radix_pass));
+	for (u32 c = 0; c < chunk_count; ++c)
+	{
+		chunk[c].begin = (u32) (((u64) count * c) / chunk_count);
+		chunk[c].count = (u32) (((u64) count * (c + 1)) / chunk_count) - chunk[c].begin;
+	}
+
+	pass->src = entry;
+	pass->dst = tmp;
+	pass->digit = 0;
+	internal_sort_radix_run(mem, thread_sort_radix_count_digits, chunk, chunk_count, pass);
+
+	u32 first_pass = 1;
+	for (u32 d = 0; d < SORT_RADIX_DIGITS; ++d)
+	{
+		u32 total[SORT_RADIX_BUCKETS] = { 0 };
+		for (u32 c = 0; c < chunk_count; ++c)
+		{
+			for (u32 b = 0; b < SORT_RADIX_BUCKETS; ++b)
+			{
+				total[b] += chunk[c].histogram[d][b];
+			}
+		}
+
+		if (internal_sort_digit_constant(total, count))
+		{
+			continue;
+		}
+
+		/* the up front counts are of the input order, so only the first pass can use them */
+		pass->digit = d;
+		if (!first_pass)
+		{
+			internal_sort_radix_run(mem, thread_sort_radix_count, chunk, chunk_count, pass);
+		}
+		first_pass = 0;
+
+		/* bucket-major, chunk-minor offsets keep the scatter stable */
+		u32 running = 0;
+		for (u32 b = 0; b < SORT_RADIX_BUCKETS; ++b)
+		{
+			for (u32 c = 0; c < chunk_count; ++c)
+			{
+				chunk[c].offset[b] = running;
+				running += chunk[c].histogram[d][b];
+			}
+		}
+
+		internal_sort_radix_run(mem, thread_sort_radix_scatter, chunk, chunk_count, pass);
+		pass->src = pass->dst;
+		pass->dst = (pass->dst == tmp) ? entry : tmp;
+	}
+
+	if (pass->src != entry)
+	{
+		memcpy(entry, pass->src, count * sizeof(struct sort_entry));
+	}
+
+	arena_pop_record(mem);
+	PROF_ZONE_END;
+}
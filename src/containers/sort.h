@@ -0,0 +1,52 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+#ifndef __KAS_SORT_H__
+#define __KAS_SORT_H__
+
+#include "kas_common.h"
+#include "allocator.h"
+
+/*
+ * Stable ascending sorts of (key, value) entries. The radix sort is LSD over 8-bit digits; digits equal in
+ * every key are found in a single counting pass up front and skipped, so keys built from a few varying bit
+ * fields only pay for the digits those fields occupy.
+ */
+
+#define SORT_RADIX_BITS			8
+#define SORT_RADIX_BUCKETS		(1 << SORT_RADIX_BITS)
+#define SORT_RADIX_DIGITS		(64 / SORT_RADIX_BITS)
+#define SORT_RADIX_PARALLEL_MIN		16384	/* smallest count sorted in parallel */
+
+struct sort_entry
+{
+	u64	key;
+	u64	value;
+};
+
+/* bottom-up merge sort of entry[count], tmp[count] is scratch memory */
+void	sort_merge(struct sort_entry *entry, struct sort_entry *tmp, const u32 count);
+/* radix sort of entry[count], tmp[count] is scratch memory */
+void	sort_radix(struct sort_entry *entry, struct sort_entry *tmp, const u32 count);
+/* radix sort of entry[count] split over the task workers; each pass counts and scatters worker chunks in 
+ * parallel. Falls back to sort_radix for count < SORT_RADIX_PARALLEL_MIN or if the calling thread owns no 
+ * worker. Task memory is pushed onto and popped from mem. */
+void	sort_radix_parallel(struct arena *mem, struct sort_entry *entry, struct sort_entry *tmp, const u32 count);
+
+#endif
@@ -17,6 +17,8 @@
 ==========================================================================
 */
 
+#include <stdlib.h>
+
 #include "led_local.h"
 #include "kas_random.h"
 
@@ -378,6 +380,7 @@ struct slot led_render_mesh_add(struct led *led, const utf8 id, const utf8 shape
 		{
 			slot = string_database_add_and_alias(&led->render_mesh_db, copy);
 			struct r_mesh *mesh = slot.address;
+			r_mesh_init(mesh);
 
 			struct slot ref = string_database_lookup(&led->cs_db, shape);
 			if (ref.index == STRING_DATABASE_STUB_INDEX)
@@ -407,6 +410,7 @@ void led_render_mesh_remove(struct led *led, const utf8 id)
 	if (slot.index != STRING_DATABASE_STUB_INDEX && mesh->reference_count == 0)
 	{
 		void *buf = mesh->id.buf;
+		r_mesh_gpu_release(mesh);
 		string_database_remove(&led->render_mesh_db, id);
 		thread_free_256B(buf);
 	}
@@ -468,6 +472,7 @@ struct slot led_rigid_body_prefab_add(struct led *led, const utf8 id, const utf8
 			prefab->restitution = restitution;
 			prefab->friction = friction;
 			prefab->dynamic = dynamic;
+			prefab->bullet = 0;
 			prefab->density = density;
 			prefab_statics_setup(prefab, ref.address, density);
 		}
@@ -1468,14 +1473,10 @@ static void led_engine_init(struct led *led)
 static void led_engine_color_bodies(struct led *led, const u32 island, const vec4 color)
 {
 	struct island *is = array_list_address(led->physics.is_db.islands, island);
-	struct is_index_entry *entry = NULL;
-	u32 k = is->body_first;
+	const u32 *island_body = led->physics.is_db.body + is->body_offset;
 	for (u32 i = 0; i < is->body_count; ++i)
 	{
-		entry = array_list_address(led->physics.is_db.island_body_lists, k);
-		k = entry->next;
-
-		const struct rigid_body *body = pool_address(&led->physics.body_pool, entry->index);
+		const struct rigid_body *body = pool_address(&led->physics.body_pool, island_body[i]);
 		const struct led_node *node = pool_address(&led->node_pool, body->entity);
 		struct r_proxy3d *proxy = r_proxy3d_address(node->proxy);
 		vec4_copy(proxy->color, color);
@@ -1732,6 +1733,271 @@ static void led_engine_run(struct led *led)
 	dll_flush(&led->physics.event_list);
 }
 
+#define LED_PHYSICS_STACK_SIZE	(8*1024*1024)
+
+/* publish the back snapshot, and take the previously published one as the new back snapshot */
+static void led_physics_snapshot_publish(struct led_physics_thread *pt)
+{
+	u32 middle;
+	do
+	{
+		middle = atomic_load_acq_32(&pt->a_snapshot_middle);
+	} while (!atomic_compare_exchange_seq_cst_32(&pt->a_snapshot_middle, &middle, pt->snapshot_back | LED_SNAPSHOT_FRESH));
+	pt->snapshot_back = middle & ~LED_SNAPSHOT_FRESH;
+}
+
+/* swap in the most recently published snapshot as the front snapshot; returns 0 if nothing new was published */
+static u32 led_physics_snapshot_acquire(struct led_physics_thread *pt)
+{
+	u32 middle;
+	do
+	{
+		middle = atomic_load_acq_32(&pt->a_snapshot_middle);
+		if ((middle & LED_SNAPSHOT_FRESH) == 0)
+		{
+			return 0;
+		}
+	} while (!atomic_compare_exchange_seq_cst_32(&pt->a_snapshot_middle, &middle, pt->snapshot_front));
+	pt->snapshot_front = middle & ~LED_SNAPSHOT_FRESH;
+	return 1;
+}
+
+static void led_physics_snapshot_write(struct led_physics_thread *pt, const struct physics_pipeline *pipeline)
+{
+	struct led_pose_snapshot *snapshot = pt->snapshot + pt->snapshot_back;
+	if (snapshot->pose_length < pipeline->body_pool.count)
+	{
+		snapshot->pose_length = 2*pipeline->body_pool.count;
+		snapshot->pose = realloc(snapshot->pose, snapshot->pose_length * sizeof(struct led_pose));
+		if (!snapshot->pose)
+		{
+			log_string(T_SYSTEM, S_FATAL, "Failed to grow physics pose snapshot, exiting.");
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+	}
+
+	snapshot->ns = pipeline->ns_start + pipeline->frames_completed * pipeline->ns_tick;
+	snapshot->pose_count = 0;
+	const struct rigid_body *body = NULL;
+	for (u32 i = pipeline->body_non_marked_list.first; i != DLL_NULL; i = DLL_NEXT(body))
+	{
+		body = pool_address(&pipeline->body_pool, i);
+		struct led_pose *pose = snapshot->pose + snapshot->pose_count++;
+		quat_copy(pose->rotation, body->rotation);
+		vec3_copy(pose->position, body->position);
+		if (RB_IS_DYNAMIC(body) && RB_IS_AWAKE(body))
+		{
+			vec3_scale(pose->linear_velocity, body->linear_momentum, 1.0f / body->mass);
+			vec3_copy(pose->angular_velocity, body->angular_velocity);
+		}
+		else
+		{
+			vec3_set(pose->linear_velocity, 0.0f, 0.0f, 0.0f);
+			vec3_set(pose->angular_velocity, 0.0f, 0.0f, 0.0f);
+		}
+		pose->entity = body->entity;
+		pose->flags = body->flags;
+		pose->contact = (body->first_contact_index != NLL_NULL);
+	}
+}
+
+static void led_physics_thread_main(kas_thread *thr)
+{
+	struct led *led = kas_thread_args(thr);
+	struct led_physics_thread *pt = &led->physics_thread;
+	struct physics_pipeline *pipeline = &led->physics;
+	thread_xoshiro_256_init_sequence();
+	pt->thr = thr;
+	semaphore_post(&pt->stopped);
+
+	while (1)
+	{
+		while (!semaphore_wait(&pt->start));
+		if (atomic_load_acq_32(&pt->a_exit))
+		{
+			break;
+		}
+
+		/* physics tasks are dispatched from here now, so task frames are ticks rather than editor frames */
+		task_context_master_acquire();
+		while (atomic_load_acq_32(&pt->a_run))
+		{
+			pipeline->ns_elapsed = atomic_load_acq_64(&pt->a_ns_elapsed);
+			const u64 physics_frames_to_run = (pipeline->ns_elapsed - (pipeline->frames_completed * pipeline->ns_tick)) / pipeline->ns_tick;
+			if (physics_frames_to_run)
+			{
+				for (u64 i = 0; i < physics_frames_to_run; ++i)
+				{
+					task_context_frame_clear();
+					physics_pipeline_tick(pipeline);
+				}
+
+				/* body state goes through the snapshot; events are only consumed by the editor thread */
+				pool_flush(&pipeline->event_pool);
+				dll_flush(&pipeline->event_list);
+
+				led_physics_snapshot_write(pt, pipeline);
+				led_physics_snapshot_publish(pt);
+			}
+
+			/* the editor posts every frame; any backlog collapses into a single round of catching up */
+			semaphore_wait(&pt->tick);
+			while (semaphore_trywait(&pt->tick));
+		}
+		task_context_master_release();
+		semaphore_post(&pt->stopped);
+	}
+
+	kas_thread_exit(thr);
+}
+
+void led_physics_thread_init(struct led *led)
+{
+	struct led_physics_thread *pt = &led->physics_thread;
+	for (u32 i = 0; i < 3; ++i)
+	{
+		pt->snapshot[i].ns = 0;
+		pt->snapshot[i].pose = NULL;
+		pt->snapshot[i].pose_count = 0;
+		pt->snapshot[i].pose_length = 0;
+	}
+	pt->snapshot_back = 0;
+	pt->snapshot_front = 1;
+	atomic_store_rel_32(&pt->a_snapshot_middle, 2);
+	atomic_store_rel_32(&pt->a_run, 0);
+	atomic_store_rel_32(&pt->a_exit, 0);
+	atomic_store_rel_64(&pt->a_ns_elapsed, 0);
+	pt->ns_elapsed = 0;
+	pt->enabled = 0;
+	pt->active = 0;
+
+	semaphore_init(&pt->start, 0);
+	semaphore_init(&pt->tick, 0);
+	semaphore_init(&pt->stopped, 0);
+	pt->thr = NULL;
+	kas_thread_clone(NULL, led_physics_thread_main, led, LED_PHYSICS_STACK_SIZE);
+	/* wait until the thread has registered itself */
+	while (!semaphore_wait(&pt->stopped));
+}
+
+/* apply the latest pose snapshot to the proxies of the physics nodes */
+static void led_engine_apply_snapshot(struct led *led)
+{
+	struct led_physics_thread *pt = &led->physics_thread;
+	const u32 color_mode_changed = (led->physics.pending_body_color_mode != led->physics.body_color_mode);
+	led->physics.body_color_mode = led->physics.pending_body_color_mode;
+	if (!led_physics_snapshot_acquire(pt) && !color_mode_changed)
+	{
+		return;
+	}
+
+	/* island colors live in the physics thread's island database; ISLAND mode falls back to body colors */
+	const struct led_pose_snapshot *snapshot = pt->snapshot + pt->snapshot_front;
+	for (u32 i = 0; i < snapshot->pose_count; ++i)
+	{
+		const struct led_pose *pose = snapshot->pose + i;
+		const struct led_node *node = pool_address(&led->node_pool, pose->entity);
+		struct r_proxy3d *proxy = r_proxy3d_address(node->proxy);
+		if (!IS_DYNAMIC(pose->flags))
+		{
+			(led->physics.body_color_mode == RB_COLOR_MODE_BODY)
+				? vec4_copy(proxy->color, node->color)
+				: vec4_copy(proxy->color, led->physics.static_color);
+			continue;
+		}
+
+		r_proxy3d_set_linear_speculation(pose->position
+				, pose->rotation
+				, pose->linear_velocity
+				, pose->angular_velocity
+				, snapshot->ns
+				, node->proxy);
+
+		switch (led->physics.body_color_mode)
+		{
+			case RB_COLOR_MODE_COLLISION:
+			{
+				(pose->contact)
+					? vec4_copy(proxy->color, led->physics.collision_color)
+					: vec4_copy(proxy->color, node->color);
+			} break;
+
+			case RB_COLOR_MODE_SLEEP:
+			{
+				(IS_AWAKE(pose->flags))
+					? vec4_copy(proxy->color, led->physics.awake_color)
+					: vec4_copy(proxy->color, led->physics.sleep_color);
+			} break;
+
+			default:
+			{
+				vec4_copy(proxy->color, node->color);
+			} break;
+		}
+	}
+}
+
+static void led_physics_thread_start(struct led *led)
+{
+	struct led_physics_thread *pt = &led->physics_thread;
+	atomic_store_rel_32(&pt->a_run, 1);
+	pt->active = 1;
+	task_context_master_release();
+	semaphore_post(&pt->start);
+}
+
+static void led_physics_thread_stop(struct led *led)
+{
+	struct led_physics_thread *pt = &led->physics_thread;
+	atomic_store_rel_32(&pt->a_run, 0);
+	semaphore_post(&pt->tick);
+	while (!semaphore_wait(&pt->stopped));
+	task_context_master_acquire();
+	pt->active = 0;
+	led->physics.ns_elapsed = pt->ns_elapsed;
+	led_engine_apply_snapshot(led);
+}
+
+void led_physics_thread_destroy(struct led *led)
+{
+	struct led_physics_thread *pt = &led->physics_thread;
+	if (pt->active)
+	{
+		led_physics_thread_stop(led);
+	}
+
+	atomic_store_rel_32(&pt->a_exit, 1);
+	semaphore_post(&pt->start);
+	kas_thread_wait(pt->thr);
+	kas_thread_release(pt->thr);
+
+	semaphore_destroy(&pt->start);
+	semaphore_destroy(&pt->tick);
+	semaphore_destroy(&pt->stopped);
+	for (u32 i = 0; i < 3; ++i)
+	{
+		free(pt->snapshot[i].pose);
+	}
+}
+
+/* advance the physics thread's target time; it ticks towards it at its own pace while we keep on rendering */
+static void led_engine_run_threaded(struct led *led)
+{
+	struct led_physics_thread *pt = &led->physics_thread;
+	pt->ns_elapsed = ((pt->active) ? pt->ns_elapsed : led->physics.ns_elapsed) + led->ns_delta;
+	atomic_store_rel_64(&pt->a_ns_elapsed, pt->ns_elapsed);
+	if (pt->active)
+	{
+		semaphore_post(&pt->tick);
+	}
+	else
+	{
+		led_physics_thread_start(led);
+	}
+
+	led_engine_apply_snapshot(led);
+}
+
 void led_core(struct led *led)
 {
 	static u32 once = 1;
@@ -1743,6 +2009,11 @@ void led_core(struct led *led)
 	}
 	led_remove_marked_structs(led);
 
+	if (led->physics_thread.active && (!led->pending_engine_running || !led->physics_thread.enabled))
+	{
+		led_physics_thread_stop(led);
+	}
+
 	if (led->engine_initalized && !led->pending_engine_initalized)
 	{
 		led_engine_flush(led);
@@ -1758,7 +2029,9 @@ void led_core(struct led *led)
 	if (led->engine_running)
 	{
 		led->ns_engine_running += led->ns_delta;
-		led_engine_run(led);
+		(led->physics_thread.enabled)
+			? led_engine_run_threaded(led)
+			: led_engine_run(led);
 	}
 
 	if (led->engine_paused)
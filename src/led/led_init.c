@@ -18,6 +18,7 @@
 */
 
 #include <string.h>
+#include <stdlib.h>
 #include "led_local.h"
 
 struct led g_editor_storage = { 0 };
@@ -46,6 +47,68 @@ void led_project_menu_dealloc(struct led_project_menu *menu)
 	directory_navigator_dealloc(&menu->dir_nav);
 }
 
+#ifdef KAS_TASK_TIMELINE
+
+struct led_timeline led_timeline_alloc(void)
+{
+	struct led_timeline timeline =
+	{
+		.visible = 0,
+		.paused = 0,
+		.frame_count = 4,
+		.worker_count = g_task_ctx->worker_count,
+	};
+
+	timeline.event = malloc(timeline.worker_count * sizeof(struct timeline_event *));
+	timeline.event_count = calloc(timeline.worker_count, sizeof(u32));
+	timeline.row = malloc(timeline.worker_count * sizeof(struct timeline_row_config));
+	for (u32 i = 0; i < timeline.worker_count; ++i)
+	{
+		timeline.event[i] = malloc(TIMELINE_EVENT_COUNT * sizeof(struct timeline_event));
+		timeline.row[i].height = 64.0f;
+		timeline.row[i].depth_visible = intv_inline(0.0f, 2.0f);
+	}
+
+	timeline.config = (struct timeline_config)
+	{
+		.row_count = timeline.worker_count,
+		.row = timeline.row,
+		.task_height = 24.0f,
+		.perc_width_row_title_column = 0.1f,
+		.unit_line_width = 1.0f,
+		.subline_width = 0.5f,
+		.sublines_per_line = 4,
+		.unit_line_preferred_count = 10,
+		.draw_sublines = 1,
+		.draw_edgelines = 0,
+	};
+
+	vec4_set(timeline.config.unit_line_color, 0.2f, 0.2f, 0.2f, 1.0f);
+	vec4_set(timeline.config.subline_color, 0.1f, 0.1f, 0.1f, 1.0f);
+	vec4_set(timeline.config.text_color, 0.9f, 0.9f, 0.9f, 1.0f);
+	vec4_set(timeline.config.background_color, 0.0625f, 0.0625f, 0.0625f, 1.0f);
+	vec4_set(timeline.config.draggable_color, 0.0f, 0.15f, 0.25f, 1.0f);
+	vec4_set(timeline.config.task_gradient_br, 0.0f, 0.15f, 0.8f, 0.8f);
+	vec4_set(timeline.config.task_gradient_tr, 0.0f, 0.7f, 0.25f, 0.8f);
+	vec4_set(timeline.config.task_gradient_tl, 0.0f, 0.7f, 0.25f, 0.8f);
+	vec4_set(timeline.config.task_gradient_bl, 0.0f, 0.15f, 0.8f, 0.8f);
+
+	return timeline;
+}
+
+void led_timeline_dealloc(struct led_timeline *timeline)
+{
+	for (u32 i = 0; i < timeline->worker_count; ++i)
+	{
+		free(timeline->event[i]);
+	}
+	free(timeline->event);
+	free(timeline->event_count);
+	free(timeline->row);
+}
+
+#endif
+
 struct led *led_alloc(void)
 {
 	led_core_init_commands();
@@ -55,6 +118,9 @@ struct led *led_alloc(void)
 
 	g_editor->frame = arena_alloc(16*1024*1024);
 	g_editor->project_menu = led_project_menu_alloc();
+#ifdef KAS_TASK_TIMELINE
+	g_editor->timeline = led_timeline_alloc();
+#endif
 	g_editor->running = 1;
 	g_editor->ns = time_ns();
 	g_editor->root_folder = file_null();
@@ -113,6 +179,7 @@ struct led *led_alloc(void)
 	g_editor->rb_prefab_db = string_database_alloc(NULL, 32, 32, struct rigid_body_prefab, GROWABLE);
 	g_editor->cs_db = string_database_alloc(NULL, 32, 32, struct collision_shape, GROWABLE);
 	g_editor->physics = physics_pipeline_alloc(NULL, 1024, NSEC_PER_SEC / (u64) 60, 1024*1024, &g_editor->cs_db, &g_editor->rb_prefab_db);
+	led_physics_thread_init(g_editor);
 
 	g_editor->pending_engine_running = 0;
 	g_editor->pending_engine_initalized = 0;
@@ -123,6 +190,7 @@ struct led *led_alloc(void)
 	g_editor->ns_engine_running = 0;
 
 	struct r_mesh *r_mesh_stub = string_database_address(&g_editor->render_mesh_db, STRING_DATABASE_STUB_INDEX);
+	r_mesh_init(r_mesh_stub);
 	r_mesh_set_stub_box(r_mesh_stub);
 
 	struct collision_shape *shape_stub = string_database_address(&g_editor->cs_db, STRING_DATABASE_STUB_INDEX);
@@ -135,6 +203,7 @@ struct led *led_alloc(void)
 	prefab_stub->restitution = 0.0f;
 	prefab_stub->friction = 0.0f;
 	prefab_stub->dynamic = 1;
+	prefab_stub->bullet = 0;
 	prefab_statics_setup(prefab_stub, shape_stub, prefab_stub->density);
 
 	return g_editor;
@@ -142,8 +211,12 @@ struct led *led_alloc(void)
 
 void led_dealloc(struct led *led)
 {
+	led_physics_thread_destroy(led);
 	arena_free(&led->mem_persistent);
 	led_project_menu_dealloc(&led->project_menu);
+#ifdef KAS_TASK_TIMELINE
+	led_timeline_dealloc(&led->timeline);
+#endif
 	csg_dealloc(&led->csg);
 	gpool_dealloc(&led->node_pool);
 	arena_free(&g_editor->frame);
@@ -76,6 +76,12 @@ void 	led_visual_init_defaults(const u32 window);
 struct led_project_menu	led_project_menu_alloc(void);
 /* release project menu resources */
 void			led_project_menu_dealloc(struct led_project_menu *menu);
+#ifdef KAS_TASK_TIMELINE
+/* Allocate task timeline panel resources; the task context must be initialized */
+struct led_timeline	led_timeline_alloc(void);
+/* release task timeline panel resources */
+void			led_timeline_dealloc(struct led_timeline *timeline);
+#endif
 
 /*******************************************/
 /*                 led_main.c              */
@@ -99,6 +105,10 @@ extern struct led *g_editor;
 void 		led_core_init_commands(void);
 /* run level editor systems */
 void 		led_core(struct led *led);
+/* setup the physics thread; the thread stays idle until physics is handed over to it */
+void		led_physics_thread_init(struct led *led);
+/* hand physics back if needed, and shut down the physics thread */
+void		led_physics_thread_destroy(struct led *led);
 
 /* compile level editor map */
 void		led_compile(struct led *led);
@@ -61,6 +61,72 @@ struct led_project
 	struct file		file;		/* project main file 				*/
 };
 
+#ifdef KAS_TASK_TIMELINE
+/*
+led_timeline
+============
+Task system timeline panel; shows what every task worker did over the last frame_count frames.
+*/
+struct led_timeline
+{
+	u32			visible;
+	u32			paused;		/* keep showing the last captured events */
+	u32			frame_count;	/* number of frames shown */
+	u32			worker_count;
+	struct timeline_event **	event;		/* event[worker][TIMELINE_EVENT_COUNT] */
+	u32 *			event_count;	/* event_count[worker] */
+	struct timeline_row_config *	row;
+	struct timeline_config	config;
+};
+#endif
+
+/*
+led_physics_thread
+==================
+Runs the physics pipeline at its fixed tick on a dedicated thread, decoupled from the editor and render frames.
+While active, the thread owns led->physics and the master task worker. After every batch of ticks it publishes
+the body poses into a triple buffered snapshot; the editor picks up the latest snapshot and the renderer
+speculates it forward, so the render frame time does not depend on the physics frame time.
+*/
+struct led_pose
+{
+	quat		rotation;
+	vec3		position;
+	vec3		linear_velocity;
+	vec3		angular_velocity;
+	u32		entity;
+	u32		flags;		/* rigid body flags */
+	u32		contact;	/* Boolean: body is in contact with another body */
+};
+
+struct led_pose_snapshot
+{
+	u64		ns;		/* time of the physics frame the poses belong to */
+	struct led_pose *pose;
+	u32		pose_count;
+	u32		pose_length;
+};
+
+#define LED_SNAPSHOT_FRESH	((u32) 1 << 31)	/* set in a_snapshot_middle until the editor acquires it */
+
+struct led_physics_thread
+{
+	kas_thread *		thr;
+	semaphore		start;			/* posted by the editor to hand led->physics over */
+	semaphore		tick;			/* posted by the editor every frame while active */
+	semaphore		stopped;		/* posted by the thread once led->physics is handed back */
+	struct led_pose_snapshot snapshot[3];
+	u32			a_snapshot_middle;	/* last published snapshot | LED_SNAPSHOT_FRESH */
+	u32			snapshot_back;		/* snapshot written by the physics thread */
+	u32			snapshot_front;		/* snapshot read by the editor */
+	u32			a_run;			/* Boolean: keep ticking, cleared by the editor to stop */
+	u32			a_exit;			
+	u64			a_ns_elapsed;		/* pipeline time to simulate up to */
+	u64			ns_elapsed;		/* editor side copy of a_ns_elapsed */
+	u32			enabled;		/* Boolean: run physics on the thread while the engine runs */
+	u32			active;			/* Boolean: the thread owns led->physics */
+};
+
 /*
 led_node
 ========
@@ -108,6 +174,9 @@ struct led
 
 	struct led_project	project;
 	struct led_project_menu project_menu;
+#ifdef KAS_TASK_TIMELINE
+	struct led_timeline	timeline;
+#endif
 
 	struct r_camera		cam;
 	f32			cam_left_velocity;
@@ -139,6 +208,7 @@ struct led
 	struct ui_list 		brush_list;
 
 	struct physics_pipeline physics;
+	struct led_physics_thread physics_thread;
 	struct string_database 	cs_db;	
 	struct ui_list 		cs_list;
 	struct ui_dropdown_menu cs_mesh_menu;
@@ -390,6 +390,184 @@ static void led_input_handler(struct led *led, struct ui_node *viewport)
 	sys_win->ui->inter.cursor_delta[1] = 0.0f;
 }
 
+#ifdef KAS_TASK_TIMELINE
+
+#define LED_TIMELINE_MAX_DEPTH	32
+
+/* copy every worker's recorded events and fit the timeline interval to the last frame_count frames */
+static void led_timeline_capture(struct led_timeline *timeline)
+{
+	for (u32 i = 0; i < timeline->worker_count; ++i)
+	{
+		timeline->event_count[i] = task_timeline_copy(timeline->event[i], i);
+	}
+
+	const u32 count = timeline->event_count[0];
+	if (count == 0 || timeline->config.fixed)
+	{
+		return;
+	}
+
+	/* frames are marked by the master worker; the last mark starts the frame currently being built */
+	const struct timeline_event *master = timeline->event[0];
+	u64 tsc_start = master[0].tsc;
+	u64 tsc_end = master[count-1].tsc;
+	u32 frames = 0;
+	for (u32 i = count; i; --i)
+	{
+		if (master[i-1].type == TIMELINE_FRAME)
+		{
+			tsc_end = (frames == 0) ? master[i-1].tsc : tsc_end;
+			tsc_start = master[i-1].tsc;
+			if (frames++ == timeline->frame_count)
+			{
+				break;
+			}
+		}
+	}
+
+	struct timeline_config *config = &timeline->config;
+	config->ns_interval_start = time_ns_from_tsc(tsc_start);
+	config->ns_interval_end = time_ns_from_tsc(tsc_end);
+	config->ns_interval_end += (config->ns_interval_end == config->ns_interval_start);
+	config->ns_interval_size = config->ns_interval_end - config->ns_interval_start;
+}
+
+/* build a node for every completed scope of the worker that overlaps the timeline interval */
+static void led_timeline_row_ui(const struct led_timeline *timeline, const u32 worker)
+{
+	const struct timeline_config *config = &timeline->config;
+	const struct timeline_event *event = timeline->event[worker];
+	const u64 flags = UI_DRAW_BACKGROUND | UI_DRAW_GRADIENT | UI_DRAW_BORDER | UI_DRAW_TEXT;
+
+	u32 scope[LED_TIMELINE_MAX_DEPTH];
+	u32 depth = 0;
+	for (u32 i = 0; i < timeline->event_count[worker]; ++i)
+	{
+		switch (event[i].type)
+		{
+			case TIMELINE_TASK_BEGIN:
+			case TIMELINE_WAIT_BEGIN:
+			case TIMELINE_PARK_BEGIN:
+			case TIMELINE_ZONE_BEGIN:
+			{
+				if (depth < LED_TIMELINE_MAX_DEPTH)
+				{
+					scope[depth] = i;
+				}
+				depth += 1;
+			} break;
+
+			case TIMELINE_TASK_END:
+			case TIMELINE_WAIT_END:
+			case TIMELINE_PARK_END:
+			case TIMELINE_ZONE_END:
+			{
+				/* scopes opened before the oldest recorded event are dropped */
+				if (depth == 0 || --depth >= LED_TIMELINE_MAX_DEPTH)
+				{
+					break;
+				}
+
+				const struct timeline_event *begin = event + scope[depth];
+				const u64 ns_begin = time_ns_from_tsc(begin->tsc);
+				const u64 ns_end = time_ns_from_tsc(event[i].tsc);
+				if (ns_end < config->ns_interval_start || config->ns_interval_end < ns_begin)
+				{
+					break;
+				}
+
+				ui_width(ui_size_unit(intv_inline((f32) ns_begin, (f32) ns_end)))
+				ui_height(ui_size_unit(intv_inline((f32) depth, (f32) depth + 1.0f)))
+				switch (begin->type)
+				{
+					case TIMELINE_TASK_BEGIN:
+					{
+						if (begin->arg == worker)
+						{
+							ui_node_alloc_f(flags, "task##tl_%u_%u", worker, i);
+						}
+						else
+						{
+							ui_node_alloc_f(flags, "task (stolen from %u)##tl_%u_%u", begin->arg, worker, i);
+						}
+					} break;
+
+					case TIMELINE_WAIT_BEGIN:
+					{
+						ui_node_alloc_f(flags, "wait##tl_%u_%u", worker, i);
+					} break;
+
+					case TIMELINE_PARK_BEGIN:
+					{
+						ui_node_alloc_f(flags, "parked##tl_%u_%u", worker, i);
+					} break;
+
+					default:
+					{
+						ui_node_alloc_f(flags, "%s##tl_%u_%u", begin->name, worker, i);
+					} break;
+				}
+			} break;
+		}
+	}
+}
+
+static void led_timeline_ui(struct led *led)
+{
+	struct led_timeline *timeline = &led->timeline;
+	if (!timeline->paused)
+	{
+		led_timeline_capture(timeline);
+	}
+
+	ui_height(ui_size_childsum(1.0f))
+	ui_child_layout_axis(AXIS_2_Y)
+	ui_parent(ui_node_alloc_non_hashed(UI_DRAW_BACKGROUND | UI_DRAW_BORDER).index)
+	{
+		ui_height(ui_size_pixel(24.0f, 1.0f))
+		ui_child_layout_axis(AXIS_2_X)
+		ui_parent(ui_node_alloc_non_hashed(UI_FLAG_NONE).index)
+		ui_flags(UI_DRAW_ROUNDED_CORNERS | UI_TEXT_ALLOW_OVERFLOW)
+		ui_width(ui_size_text(F32_INFINITY, 1.0f))
+		{
+			ui_pad();
+
+			if (ui_button_f(UI_DRAW_TEXT | UI_DRAW_BORDER | UI_DRAW_BACKGROUND, "%s###tl_pause", (timeline->paused) ? "Resume" : "Pause") & UI_INTER_LEFT_CLICK)
+			{
+				/* resuming also lets the interval follow the frames again */
+				timeline->paused = !timeline->paused;
+				timeline->config.fixed = 0;
+			}
+
+			ui_pad();
+
+			if (ui_button_f(UI_DRAW_TEXT | UI_DRAW_BORDER | UI_DRAW_BACKGROUND, "-###tl_frames_dec") & UI_INTER_LEFT_CLICK)
+			{
+				timeline->frame_count -= (timeline->frame_count > 1);
+			}
+
+			ui_node_alloc_f(UI_DRAW_TEXT, " frames: %u ###tl_frames", timeline->frame_count);
+
+			if (ui_button_f(UI_DRAW_TEXT | UI_DRAW_BORDER | UI_DRAW_BACKGROUND, "+###tl_frames_inc") & UI_INTER_LEFT_CLICK)
+			{
+				timeline->frame_count += 1;
+			}
+		}
+
+		ui_timeline(&timeline->config);
+		for (u32 i = 0; i < timeline->worker_count; ++i)
+		{
+			ui_timeline_row(&timeline->config, i, "worker %u", i)
+			{
+				led_timeline_row_ui(timeline, i);
+			}
+		}
+	}
+}
+
+#endif
+
 static void led_ui(struct led *led, const struct ui_visual *visual)
 {
 	system_window_set_global(led->window);
@@ -468,6 +646,16 @@ static void led_ui(struct led *led, const struct ui_visual *visual)
 					{
 						cmd_submit_f(g_ui->mem_frame, "led_stop");
 					}
+
+#ifdef KAS_TASK_TIMELINE
+					ui_pad();
+
+					ui_width(ui_size_text(F32_INFINITY, 1.0f))
+					if (ui_button_f(UI_DRAW_TEXT, "Timeline###timeline") & UI_INTER_LEFT_CLICK)
+					{
+						led->timeline.visible = !led->timeline.visible;
+					}
+#endif
 				}
 
 				ui_pad_fill();
@@ -484,7 +672,8 @@ static void led_ui(struct led *led, const struct ui_visual *visual)
 				ui_parent(slot.index)
 				{
 					struct ui_node *node = slot.address;
-					if (node->inter & UI_INTER_HOVER)
+					/* the pipeline belongs to the physics thread while it is active */
+					if ((node->inter & UI_INTER_HOVER) && !led->physics_thread.active)
 					{
 						vec3 dir; 
 						const vec2 cursor_viewport_position =
@@ -535,6 +724,13 @@ static void led_ui(struct led *led, const struct ui_visual *visual)
 				}
 			}
 
+#ifdef KAS_TASK_TIMELINE
+			if (led->timeline.visible)
+			{
+				led_timeline_ui(led);
+			}
+#endif
+
 			u32 shape_selected = U32_MAX;
 			ui_height(ui_size_pixel(192.0f, 1.0f))
 			ui_child_layout_axis(AXIS_2_X)
@@ -804,6 +1000,20 @@ static void led_ui(struct led *led, const struct ui_visual *visual)
 
 							ui_pad();
 
+							ui_parent(ui_node_alloc_non_hashed(0).index)
+							{
+								ui_width(ui_size_text(F32_INFINITY, 1.0f))
+								ui_node_alloc_f(UI_DRAW_TEXT, "bullet: ");
+				
+								ui_pad_fill();
+
+								ui_flags(UI_DRAW_BORDER)
+								ui_width(ui_size_pixel(110.0f, 1.0f))
+								prefab->bullet = (u32) ui_field_u64_f(prefab->bullet, intvu64_inline(0, 1), "%u###s_bullet", prefab->bullet);
+							}
+
+							ui_pad();
+
 							ui_parent(ui_node_alloc_non_hashed(0).index)
 							{
 								ui_width(ui_size_text(F32_INFINITY, 1.0f))
@@ -995,6 +1205,29 @@ static void led_ui(struct led *led, const struct ui_visual *visual)
 								vec4_set(node->background_color, 0.3f, 0.3f, 0.4f, 1.0f);
 							}
 						}
+
+						ui_parent(ui_node_alloc_non_hashed(UI_FLAG_NONE).index)
+						{
+							ui_pad();
+							ui_width(ui_size_pixel(24.0f, 1.0f))
+							node = ui_node_alloc_f(UI_DRAW_BORDER | UI_DRAW_BACKGROUND | UI_INTER_LEFT_CLICK, "###physics_thread").address;
+							ui_pad();
+							ui_node_alloc_f(UI_DRAW_TEXT, "physics thread");
+							if (node->inter & UI_INTER_LEFT_CLICK)
+							{
+								led->physics_thread.enabled = !led->physics_thread.enabled;
+							}
+
+							if (led->physics_thread.enabled)
+							{
+								vec4_set(node->background_color, 0.9f, 0.9f, 0.9f, 1.0f);
+							}
+
+							if (node->inter & UI_INTER_HOVER)
+							{
+								vec4_set(node->background_color, 0.3f, 0.3f, 0.4f, 1.0f);
+							}
+						}
 					}
 
 
@@ -303,7 +303,7 @@ void dbvh_remove(struct bvh *bvh, const u32 index)
 	if (parent == POOL_NULL)
 	{
 		bvh->tree.root = POOL_NULL;
-		bt_node_remove(&bvh->tree, parent);
+		bt_node_remove(&bvh->tree, index);
 	}
 	else
 	{
@@ -373,7 +373,11 @@ u32 dbvh_internal_push_subtree_overlap_pairs(struct arena *mem, struct dbvh_over
 					overlap.id1 = nodes[subB].bt_left;	
 					overlap.id2 = nodes[subA].bt_left;	
 				}
-				arena_push_packed_memcpy(mem, &overlap, sizeof(overlap));
+				if (!arena_push_packed_memcpy(mem, &overlap, sizeof(overlap)))
+				{
+					log_string(T_PHYSICS, S_FATAL, "out-of-memory in overlap arena, increase arena size!");		
+					fatal_cleanup_and_exit(kas_thread_self_tid());
+				}
 			}
 			else
 			{
@@ -416,10 +420,10 @@ u32 dbvh_internal_push_subtree_overlap_pairs(struct arena *mem, struct dbvh_over
 
 struct dbvh_overlap *dbvh_push_overlap_pairs(struct arena *mem, u32 *count, const struct bvh *bvh)
 {
-	if (bt_leaf_count(&bvh->tree) < 2) { return 0; }
+	*count = 0;
+	if (bt_leaf_count(&bvh->tree) < 2) { return NULL; }
 	const struct bvh_node *nodes = (struct bvh_node *) bvh->tree.pool.buf;
 
-	*count = 0;
 	u32 a = nodes[bvh->tree.root].bt_left;
 	u32 b = nodes[bvh->tree.root].bt_right;
 	u32 q = U32_MAX;
@@ -473,6 +477,243 @@ struct dbvh_overlap *dbvh_push_overlap_pairs(struct arena *mem, u32 *count, cons
 	return (*count) ? overlaps : NULL;
 }
 
+u32 dbvh_push_bbox_overlaps(struct arena *mem, const struct bvh *bvh, const struct AABB *bbox)
+{
+	if (bvh->tree.root == POOL_NULL) { return 0; }
+
+	const struct bvh_node *nodes = (struct bvh_node *) bvh->tree.pool.buf;
+	u32 stack[DBVH_OVERLAP_STACK_MAX];
+	u32 sc = 1;
+	u32 overlap_count = 0;
+	stack[0] = bvh->tree.root;
+	while (sc--)
+	{
+		const u32 node = stack[sc];
+		if (!AABB_test(&nodes[node].bbox, bbox))
+		{
+			continue;
+		}
+
+		if (BT_IS_LEAF(nodes + node))
+		{
+			if (!arena_push_packed_memcpy(mem, &nodes[node].bt_left, sizeof(u32)))
+			{
+				log_string(T_PHYSICS, S_FATAL, "out-of-memory in overlap arena, increase arena size!");		
+				fatal_cleanup_and_exit(kas_thread_self_tid());
+			}
+			overlap_count += 1;
+		}
+		else
+		{
+			if (sc + 2 > DBVH_OVERLAP_STACK_MAX)
+			{
+				log_string(T_PHYSICS, S_FATAL, "out-of-memory in overlap stack, increase stack size!");		
+				fatal_cleanup_and_exit(kas_thread_self_tid());
+			}
+			stack[sc++] = nodes[node].bt_right;
+			stack[sc++] = nodes[node].bt_left;
+		}
+	}
+
+	return overlap_count;
+}
+
+/*
+ * Parallel overlap generation: the self-overlap of the tree is the union of the cross-overlaps between the
+ * children of every internal node. We gather these subtree pairs into a job list on the calling thread, where
+ * pairs close to the root are split further (they contain most of the work), and let the workers traverse
+ * disjoint ranges of the job list. Since the job list is generated in a fixed order and worker results are
+ * concatenated in task order, the output is independent of the worker count and scheduling.
+ */
+struct dbvh_overlap_output
+{
+	struct dbvh_overlap *	overlap;
+	u32			count;
+};
+
+static void thread_dbvh_push_overlap_pairs(void *task_addr)
+{
+	PROF_ZONE;
+
+	struct task *task = task_addr;
+	struct worker *worker = task->executor;
+	const struct task_range *range = task->range;
+	const struct bvh *bvh = task->input;
+	const struct dbvh_overlap *job = range->base;
+
+	struct dbvh_overlap stack[DBVH_OVERLAP_STACK_MAX];
+	struct dbvh_overlap_output *out = arena_push(&worker->mem_frame, sizeof(struct dbvh_overlap_output));
+	if (!out)
+	{
+		log_string(T_PHYSICS, S_FATAL, "out-of-memory in worker frame arena, increase arena size!");		
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+
+	out->overlap = (struct dbvh_overlap *) worker->mem_frame.stack_ptr;
+	out->count = 0;
+	for (u64 i = 0; i < range->count; ++i)
+	{
+		out->count += dbvh_internal_push_subtree_overlap_pairs(&worker->mem_frame, stack, DBVH_OVERLAP_STACK_MAX, bvh, job[i].id1, job[i].id2);
+	}
+
+	task->output = out;
+	PROF_ZONE_END;
+}
+
+static struct dbvh_overlap *dbvh_internal_push_overlap_jobs(struct arena *mem, u32 *job_count, const struct bvh *bvh)
+{
+	const struct bvh_node *nodes = (struct bvh_node *) bvh->tree.pool.buf;
+	struct dbvh_overlap *jobs = (struct dbvh_overlap *) mem->stack_ptr;
+	*job_count = 0;
+
+	/* (node, depth) tuples */
+	struct dbvh_overlap node_stack[DBVH_OVERLAP_STACK_MAX];
+	/* (subA, subB) pairs with remaining split depth */
+	struct dbvh_overlap split_stack[2*DBVH_OVERLAP_SPLIT_DEPTH + 2];
+	u32 split_depth[2*DBVH_OVERLAP_SPLIT_DEPTH + 2];
+
+	u32 nc = 1;
+	node_stack[0].id1 = bvh->tree.root;
+	node_stack[0].id2 = 0;
+	while (nc--)
+	{
+		const u32 node = node_stack[nc].id1;
+		const u32 depth = node_stack[nc].id2;
+		if (BT_IS_LEAF(nodes + node))
+		{
+			continue;
+		}
+
+		if (nc + 2 >= DBVH_OVERLAP_STACK_MAX)
+		{
+			log_string(T_PHYSICS, S_FATAL, "out-of-memory in overlap job stack, increase stack size!");		
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+
+		/* push right child first so that the left subtree is processed first */
+		node_stack[nc].id1 = nodes[node].bt_right;
+		node_stack[nc++].id2 = depth + 1;
+		node_stack[nc].id1 = nodes[node].bt_left;
+		node_stack[nc++].id2 = depth + 1;
+
+		u32 sc = 1;
+		split_stack[0].id1 = nodes[node].bt_left;
+		split_stack[0].id2 = nodes[node].bt_right;
+		split_depth[0] = (depth < DBVH_OVERLAP_SPLIT_DEPTH) ? DBVH_OVERLAP_SPLIT_DEPTH - depth : 0;
+		while (sc--)
+		{
+			const u32 a = split_stack[sc].id1;
+			const u32 b = split_stack[sc].id2;
+			const u32 split = split_depth[sc];
+			if (!AABB_test(&nodes[a].bbox, &nodes[b].bbox))
+			{
+				continue;
+			}
+
+			if (split == 0 || (BT_IS_LEAF(nodes + a) && BT_IS_LEAF(nodes + b)))
+			{
+				struct dbvh_overlap job = { .id1 = a, .id2 = b };
+				arena_push_packed_memcpy(mem, &job, sizeof(job));
+				*job_count += 1;
+				continue;
+			}
+
+			/* same descent rule as in the traversal: descend into the larger subtree */
+			if (BT_IS_LEAF(nodes + b) || (!BT_IS_LEAF(nodes + a) && bbox_sah(&nodes[b].bbox) < bbox_sah(&nodes[a].bbox)))
+			{
+				split_stack[sc].id1 = nodes[a].bt_right;
+				split_stack[sc].id2 = b;
+				split_depth[sc++] = split - 1;
+				split_stack[sc].id1 = nodes[a].bt_left;
+				split_stack[sc].id2 = b;
+				split_depth[sc++] = split - 1;
+			}
+			else
+			{
+				split_stack[sc].id1 = a;
+				split_stack[sc].id2 = nodes[b].bt_right;
+				split_depth[sc++] = split - 1;
+				split_stack[sc].id1 = a;
+				split_stack[sc].id2 = nodes[b].bt_left;
+				split_depth[sc++] = split - 1;
+			}
+		}
+	}
+
+	return jobs;
+}
+
+struct dbvh_overlap *dbvh_parallel_push_overlap_pairs(struct arena *mem, u32 *count, const struct bvh *bvh)
+{
+	*count = 0;
+	if (g_task_ctx->worker_count <= 1 || bt_leaf_count(&bvh->tree) < DBVH_PARALLEL_LEAF_COUNT_MIN)
+	{
+		return dbvh_push_overlap_pairs(mem, count, bvh);
+	}
+
+	arena_push_record(mem);
+	u32 job_count;
+	struct dbvh_overlap *jobs = dbvh_internal_push_overlap_jobs(mem, &job_count, bvh);
+	struct task_bundle *bundle = task_bundle_split_range(
+			mem, 
+			&thread_dbvh_push_overlap_pairs, 
+			DBVH_PARALLEL_TASKS_PER_WORKER * g_task_ctx->worker_count, 
+			jobs, 
+			job_count, 
+			sizeof(struct dbvh_overlap), 
+			(void *) bvh);
+
+	if (!bundle)
+	{
+		arena_pop_record(mem);
+		return NULL;
+	}
+
+	task_main_master_run_available_jobs();
+	task_bundle_wait(bundle);
+
+	struct dbvh_overlap_output **out = arena_push(mem, bundle->task_count * sizeof(struct dbvh_overlap_output *));
+	for (u32 i = 0; i < bundle->task_count; ++i)
+	{
+		out[i] = (struct dbvh_overlap_output *) atomic_load_acq_64(&bundle->tasks[i].output);
+		*count += out[i]->count;
+	}
+
+	struct dbvh_overlap *overlaps = NULL;
+	if (*count)
+	{
+		overlaps = arena_push(mem, *count * sizeof(struct dbvh_overlap));
+		if (!overlaps)
+		{
+			log_string(T_PHYSICS, S_FATAL, "out-of-memory in overlap arena, increase arena size!");		
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+
+		u32 offset = 0;
+		for (u32 i = 0; i < bundle->task_count; ++i)
+		{
+			memcpy(overlaps + offset, out[i]->overlap, out[i]->count * sizeof(struct dbvh_overlap));
+			offset += out[i]->count;
+		}
+	}
+
+	task_bundle_release(bundle);
+	arena_pop_record(mem);
+
+	/* job list and task memory is dead, move the merged overlaps down to the recorded position */
+	if (*count)
+	{
+		const u64 size = *count * sizeof(struct dbvh_overlap);
+		struct dbvh_overlap *dst = arena_push(mem, size);
+		UNPOISON_ADDRESS(overlaps, size);
+		memmove(dst, overlaps, size);
+		POISON_ADDRESS(mem->stack_ptr, (u64) ((u8 *) overlaps + size - mem->stack_ptr));
+		overlaps = dst;
+	}
+
+	return overlaps;
+}
+
 void bvh_validate(struct arena *tmp, const struct bvh *bvh)
 {
 	arena_push_record(tmp);
@@ -753,6 +994,214 @@ end:
 	return mesh_bvh;
 }
 
+void sbvh_build(struct arena *tmp, struct bvh *bvh, const struct AABB *bbox, const u32 *id, const u32 count, const u32 bin_count)
+{
+	kas_assert(bin_count >= 2 && bin_count <= 256);
+	kas_assert(bvh->heap_allocated);
+
+	bt_flush(&bvh->tree);
+	if (!count)
+	{
+		return;
+	}
+
+	PROF_ZONE;
+	arena_push_record(tmp);
+
+	u32 *prim = arena_push(tmp, count*sizeof(u32));
+	u32 *node_stack = arena_push(tmp, (count + 1)*sizeof(u32));
+	struct AABB *bin_bbox = arena_push(tmp, bin_count*sizeof(struct AABB));
+	struct AABB *bin_bbox_right = arena_push(tmp, bin_count*sizeof(struct AABB));
+	u32 *bin_prim_count = arena_push(tmp, bin_count*sizeof(u32));
+	if (!prim || !node_stack || !bin_bbox || !bin_bbox_right || !bin_prim_count)
+	{
+		log_string(T_PHYSICS, S_FATAL, "out-of-memory in static bvh construction, increase arena size!");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+
+	struct slot root = bt_node_add_root(&bvh->tree);
+	struct bvh_node *node = root.address;
+	/* bt_left = prim_first,
+	 * bt_right = prim_count */
+	node->bt_left = 0;
+	node->bt_right = count;
+	node->bbox = bbox[0];
+	for (u32 i = 0; i < count; ++i)
+	{
+		prim[i] = i;
+		node->bbox = bbox_union(node->bbox, bbox[i]);
+	}
+
+	u32 sc = 1;
+	node_stack[0] = root.index;
+	while (sc--)
+	{
+		const u32 node_index = node_stack[sc];
+		node = pool_address(&bvh->tree.pool, node_index);
+		const u32 prim_first = node->bt_left;
+		const u32 prim_count = node->bt_right;
+		if (prim_count == 1)
+		{
+			node->bt_left = id[prim[prim_first]];
+			continue;
+		}
+
+		/* bin on centroid bounds, so that clustered boxes within a large parent are still separated */
+		vec3 centroid_min, centroid_max;
+		vec3_copy(centroid_min, bbox[prim[prim_first]].center);
+		vec3_copy(centroid_max, bbox[prim[prim_first]].center);
+		for (u32 i = prim_first + 1; i < prim_first + prim_count; ++i)
+		{
+			const f32 *c = bbox[prim[i]].center;
+			centroid_min[0] = f32_min(centroid_min[0], c[0]); 
+			centroid_min[1] = f32_min(centroid_min[1], c[1]); 
+			centroid_min[2] = f32_min(centroid_min[2], c[2]); 
+			centroid_max[0] = f32_max(centroid_max[0], c[0]); 
+			centroid_max[1] = f32_max(centroid_max[1], c[1]); 
+			centroid_max[2] = f32_max(centroid_max[2], c[2]); 
+		}
+
+		const f32 parent_sah = bbox_sah(&node->bbox);
+		f32 best_score = F32_INFINITY;
+		u32 best_axis = U32_MAX;
+		u32 best_split = U32_MAX;
+		for (u32 axis = 0; axis < 3; ++axis)
+		{
+			const f32 extent = centroid_max[axis] - centroid_min[axis];
+			if (extent <= 0.0f)
+			{
+				continue;
+			}
+
+			for (u32 bi = 0; bi < bin_count; ++bi)
+			{
+				bin_prim_count[bi] = 0;
+			}
+
+			for (u32 i = prim_first; i < prim_first + prim_count; ++i)
+			{
+				const u32 p = prim[i];
+				const u32 bi = (u32) f32_clamp(bin_count * (bbox[p].center[axis] - centroid_min[axis]) / extent, 0.0f, bin_count - 0.01f);
+				bin_bbox[bi] = (bin_prim_count[bi]) 
+					? bbox_union(bin_bbox[bi], bbox[p])
+					: bbox[p];
+				bin_prim_count[bi] += 1;
+			}
+
+			/* suffix unions: bin_bbox_right[bi] = union of bins [bi, bin_count) */
+			u32 right_found = 0;
+			for (u32 bi = bin_count; bi-- > 0; )
+			{
+				if (bin_prim_count[bi])
+				{
+					bin_bbox_right[bi] = (right_found)
+						? bbox_union(bin_bbox_right[bi+1], bin_bbox[bi])
+						: bin_bbox[bi];
+					right_found = 1;
+				}
+				else if (right_found)
+				{
+					bin_bbox_right[bi] = bin_bbox_right[bi+1];
+				}
+			}
+
+			struct AABB bbox_left;
+			u32 left_count = 0;
+			for (u32 split = 0; split < bin_count-1; ++split)
+			{
+				if (bin_prim_count[split] == 0)
+				{
+					continue;
+				}
+
+				bbox_left = (left_count == 0)
+					? bin_bbox[split]
+					: bbox_union(bbox_left, bin_bbox[split]);
+				left_count += bin_prim_count[split];
+
+				const u32 right_count = prim_count - left_count;
+				if (right_count == 0)
+				{
+					break;
+				}
+
+				const f32 left_cost = left_count*bbox_sah(&bbox_left)/parent_sah;
+				const f32 right_cost = right_count*bbox_sah(&bin_bbox_right[split+1])/parent_sah;
+				const f32 score = COST_TRAVERSAL + COST_INTERNAL*(left_cost + right_cost);
+				if (score < best_score)
+				{
+					best_score = score;
+					best_axis = axis;
+					best_split = split;
+				}
+			}
+		}
+
+		u32 left_count = 0;
+		if (best_axis != U32_MAX)
+		{
+			const f32 extent = centroid_max[best_axis] - centroid_min[best_axis];
+			i64 left = prim_first;
+			i64 right = (i64) prim_first + prim_count - 1;
+			while (left <= right)
+			{
+				const u32 p = prim[left];
+				const u32 bi = (u32) f32_clamp(bin_count * (bbox[p].center[best_axis] - centroid_min[best_axis]) / extent, 0.0f, bin_count - 0.01f);
+				if (bi <= best_split)
+				{
+					left += 1;
+				}
+				else
+				{
+					prim[left] = prim[right];
+					prim[right] = p;
+					right -= 1;
+				}
+			}
+			left_count = (u32) (left - prim_first);
+		}
+
+		/* all centroids coincide; split in the middle as every leaf must contain a single box */
+		if (left_count == 0 || left_count == prim_count)
+		{
+			left_count = prim_count / 2;
+		}
+
+		struct AABB bbox_left = bbox[prim[prim_first]];
+		struct AABB bbox_right = bbox[prim[prim_first + left_count]];
+		for (u32 i = prim_first + 1; i < prim_first + left_count; ++i)
+		{
+			bbox_left = bbox_union(bbox_left, bbox[prim[i]]);
+		}
+		for (u32 i = prim_first + left_count + 1; i < prim_first + prim_count; ++i)
+		{
+			bbox_right = bbox_union(bbox_right, bbox[prim[i]]);
+		}
+
+		struct slot slot_left, slot_right;
+		bt_node_add_children(&bvh->tree, &slot_left, &slot_right, node_index);
+		kas_assert(slot_left.address && slot_right.address);
+
+		struct bvh_node *child_left = slot_left.address;
+		struct bvh_node *child_right = slot_right.address;
+
+		child_left->bbox = bbox_left;
+		child_left->bt_left = prim_first;
+		child_left->bt_right = left_count;
+
+		child_right->bbox = bbox_right;
+		child_right->bt_left = prim_first + left_count;
+		child_right->bt_right = prim_count - left_count;
+
+		node_stack[sc] = slot_right.index;
+		node_stack[sc+1] = slot_left.index;
+		sc += 2;
+	}
+
+	arena_pop_record(tmp);
+	PROF_ZONE_END;
+}
+
 struct bvh_raycast_info bvh_raycast_init(struct arena *mem, const struct bvh *bvh, const struct ray *ray)
 {
 	struct bvh_raycast_info info =
@@ -839,3 +1288,58 @@ u32f32 tri_mesh_bvh_raycast(struct arena *tmp, const struct tri_mesh_bvh *mesh_b
 	PROF_ZONE_END;
 	return info.hit;
 }
+
+u32 tri_mesh_bvh_push_bbox_overlaps(struct arena *mem, const struct tri_mesh_bvh *mesh_bvh, const struct AABB *bbox)
+{
+	const struct bvh *bvh = &mesh_bvh->bvh;
+	if (!mesh_bvh->tri_count || bvh->tree.root == POOL_NULL) { return 0; }
+
+	const struct tri_mesh *mesh = mesh_bvh->mesh;
+	const struct bvh_node *nodes = (struct bvh_node *) bvh->tree.pool.buf;
+	u32 stack[TRI_MESH_BVH_STACK_MAX];
+	u32 sc = 1;
+	u32 overlap_count = 0;
+	stack[0] = bvh->tree.root;
+	while (sc--)
+	{
+		const u32 node = stack[sc];
+		if (!AABB_test(&nodes[node].bbox, bbox))
+		{
+			continue;
+		}
+
+		if (BT_IS_LEAF(nodes + node))
+		{
+			const u32 tri_first = nodes[node].bt_left;
+			const u32 tri_last = tri_first + nodes[node].bt_right;
+			for (u32 i = tri_first; i < tri_last; ++i)
+			{
+				const u32 tri = mesh_bvh->tri[i];
+				const struct AABB bbox_tri = bbox_triangle(mesh->v[mesh->tri[tri][0]], mesh->v[mesh->tri[tri][1]], mesh->v[mesh->tri[tri][2]]);
+				if (!AABB_test(&bbox_tri, bbox))
+				{
+					continue;
+				}
+
+				if (!arena_push_packed_memcpy(mem, &tri, sizeof(u32)))
+				{
+					log_string(T_PHYSICS, S_FATAL, "out-of-memory in triangle overlap arena, increase arena size!");		
+					fatal_cleanup_and_exit(kas_thread_self_tid());
+				}
+				overlap_count += 1;
+			}
+		}
+		else
+		{
+			if (sc + 2 > TRI_MESH_BVH_STACK_MAX)
+			{
+				log_string(T_PHYSICS, S_FATAL, "out-of-memory in triangle overlap stack, increase stack size!");		
+				fatal_cleanup_and_exit(kas_thread_self_tid());
+			}
+			stack[sc++] = nodes[node].bt_right;
+			stack[sc++] = nodes[node].bt_left;
+		}
+	}
+
+	return overlap_count;
+}
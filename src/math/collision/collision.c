@@ -18,9 +18,11 @@
 */
 
 #include <float.h>
+#include <string.h>
 #include "float32.h"
 #include "collision.h"
 #include "dynamics.h"
+#include "math_batch.h"
 
 DEFINE_STACK(visual_segment);
 
@@ -654,6 +656,8 @@ struct gjk_input
 	vec3 pos;
 	mat3 rot;
 	u32 v_count;
+	const struct dcel *hull;	/* if set, v = hull->v and supports are searched using the hull's acceleration data */
+	u32 hint;			/* previous support index of hull */
 };
 
 static void gjk_internal_closest_points(vec3 c1, vec3 c2, struct gjk_input *in1, struct simplex *simplex, const vec4 lambda)
@@ -683,24 +687,25 @@ static void gjk_internal_closest_points(vec3 c1, vec3 c2, struct gjk_input *in1,
 
 static u32 gjk_internal_support(vec3 support, const vec3 dir, struct gjk_input *in)
 {
-	f32 max = -FLT_MAX;
-	u32 max_index = 0;
-	vec3 p;
-	for (u32 i = 0; i < in->v_count; ++i)
+	/* dot(rot*v, dir) = dot(v, transpose(rot)*dir); search the local vertices with the rotated direction */
+	vec3 local_dir;
+	mat3 rot_t;
+	mat3_transpose_to(rot_t, in->rot);
+	mat3_vec_mul(local_dir, rot_t, dir);
+	u32 max_index;
+	if (in->hull)
 	{
-		mat3_vec_mul(p, in->rot, in->v[i]);
-		const f32 dot = vec3_dot(p, dir);
-		if (max < dot)
-		{
-			max_index = i;
-			max = dot; 
-		}
+		max_index = dcel_vertex_support(in->hull, (constvec3ptr) in->v, local_dir, in->hint);
+		in->hint = max_index;
+	}
+	else
+	{
+		max_index = vec3_batch_support(in->v, in->v_count, local_dir);
 	}
 
 	mat3_vec_mul(support, in->rot, in->v[max_index]);
 	vec3_translate(support,in->pos);
 	return max_index;
-
 }
 
 static f32 gjk_distance_sq(vec3 c1, vec3 c2, struct gjk_input *in1, struct gjk_input *in2)
@@ -789,6 +794,635 @@ static f32 gjk_distance_sq(vec3 c1, vec3 c2, struct gjk_input *in1, struct gjk_i
 	return 0.0f;
 }
 
+/********************************** TRI MESH MIDPHASE **********************************/
+
+/*
+ * Collision against a tri_mesh_bvh is performed per triangle. The other body's box is moved into mesh space,
+ * and the triangles overlapping it are found through the mesh hierarchy. Contact pairs cache a fattened query
+ * box together with the overlapping triangles in their sat_cache, so as long as a body stays within its cached
+ * box (for example, when resting on static terrain), no traversal is needed. Contact points from all triangles
+ * are gathered and reduced into a single manifold.
+ */
+
+struct tri_contact_point
+{
+	vec3	p;
+	vec3	n;	/* mesh -> body */
+	f32	depth;
+};
+
+/* return the world space bounding box of b2 in the mesh space of b1 */
+static struct AABB tri_mesh_internal_local_box(mat3 inv_rot1, const struct rigid_body *b1, const struct rigid_body *b2)
+{
+	vec3 tmp;
+	struct AABB box;
+	vec3_add(tmp, b2->local_box.center, b2->position);
+	vec3_translate_scaled(tmp, b1->position, -1.0f);
+	AABB_rotate(&box, &b2->local_box, inv_rot1);
+	mat3_vec_mul(box.center, inv_rot1, tmp);
+	return box;
+}
+
+static void tri_mesh_internal_world_triangle(vec3 t[3], const struct tri_mesh *mesh, const u32 tri, mat3 rot, const vec3 pos)
+{
+	for (u32 i = 0; i < 3; ++i)
+	{
+		mat3_vec_mul(t[i], rot, mesh->v[mesh->tri[tri][i]]);
+		vec3_translate(t[i], pos);
+	}
+}
+
+static f32 tri_mesh_internal_AABB_distance_sq(const struct AABB *a, const struct AABB *b)
+{
+	f32 dist_sq = 0.0f;
+	for (u32 i = 0; i < 3; ++i)
+	{
+		const f32 d = f32_abs(a->center[i] - b->center[i]) - a->hw[i] - b->hw[i];
+		if (d > 0.0f)
+		{
+			dist_sq += d*d;
+		}
+	}
+
+	return dist_sq;
+}
+
+/*
+ * Return the smallest squared distance between the mesh triangles and the gjk input, and set the closest points
+ * c1 (on mesh) and c2 (on input). Subtrees that cannot contain anything closer than the current best triangle
+ * are pruned using the mesh space box of the input.
+ */
+static f32 tri_mesh_internal_distance_sq(vec3 c1, vec3 c2, const struct tri_mesh_bvh *mesh_bvh, mat3 rot, const vec3 pos, struct gjk_input *in, const struct AABB *local_box)
+{
+	const struct bvh *bvh = &mesh_bvh->bvh;
+	const struct bvh_node *nodes = (struct bvh_node *) bvh->tree.pool.buf;
+	f32 best = F32_INFINITY;
+	if (!mesh_bvh->tri_count)
+	{
+		return best;
+	}
+
+	vec3 t[3], p1, p2;
+	struct gjk_input g_tri = { .v = t, .v_count = 3, };
+	vec3_set(g_tri.pos, 0.0f, 0.0f, 0.0f);
+	mat3_identity(g_tri.rot);
+
+	u32 stack[TRI_MESH_BVH_STACK_MAX];
+	u32 sc = 1;
+	stack[0] = bvh->tree.root;
+	while (sc-- && best > 0.0f)
+	{
+		const u32 node = stack[sc];
+		if (tri_mesh_internal_AABB_distance_sq(&nodes[node].bbox, local_box) >= best)
+		{
+			continue;
+		}
+
+		if (BT_IS_LEAF(nodes + node))
+		{
+			const u32 tri_first = nodes[node].bt_left;
+			const u32 tri_last = tri_first + nodes[node].bt_right;
+			for (u32 i = tri_first; i < tri_last; ++i)
+			{
+				tri_mesh_internal_world_triangle(t, mesh_bvh->mesh, mesh_bvh->tri[i], rot, pos);
+				const f32 dist_sq = gjk_distance_sq(p1, p2, &g_tri, in);
+				if (dist_sq < best)
+				{
+					best = dist_sq;
+					vec3_copy(c1, p1);
+					vec3_copy(c2, p2);
+					if (best == 0.0f)
+					{
+						break;
+					}
+				}
+			}
+		}
+		else
+		{
+			if (sc + 2 > TRI_MESH_BVH_STACK_MAX)
+			{
+				log_string(T_PHYSICS, S_FATAL, "out-of-memory in triangle distance stack, increase stack size!");		
+				fatal_cleanup_and_exit(kas_thread_self_tid());
+			}
+			stack[sc++] = nodes[node].bt_right;
+			stack[sc++] = nodes[node].bt_left;
+		}
+	}
+
+	return best;
+}
+
+/*
+ * Lookup (or setup) the midphase cache of the pair and return the candidate triangles. If the pair has no cache,
+ * the new cache is stored in result->sat_cache and result->type is set to COLLISION_SAT_CACHE, otherwise the
+ * cache is touched and result->type is set to COLLISION_NONE.
+ */
+static u32 tri_mesh_internal_candidate_triangles(struct arena *tmp, const u32 **tri, struct collision_result *result, const struct physics_pipeline *pipeline, const struct rigid_body *b1, const struct rigid_body *b2, const struct tri_mesh_bvh *mesh_bvh, const struct AABB *local_box)
+{
+	const u32 bi1 = pool_index(&pipeline->body_pool, b1);
+	const u32 bi2 = pool_index(&pipeline->body_pool, b2);
+	const u32 lo = (bi1 < bi2) ? bi1 : bi2;
+	const u32 hi = (bi1 < bi2) ? bi2 : bi1;
+
+	struct sat_cache *sat_cache = sat_cache_lookup(&pipeline->c_db, lo, hi);
+	if (sat_cache)
+	{
+		kas_assert(sat_cache->type == SAT_CACHE_TRI_MESH);
+		sat_cache->touched = 1;
+		result->type = COLLISION_NONE;
+		if (sat_cache->tri_count <= SAT_CACHE_TRI_MESH_MAX && AABB_contains(&sat_cache->tri_query, local_box))
+		{
+			*tri = sat_cache->tri;
+			return sat_cache->tri_count;
+		}
+	}
+	else
+	{
+		sat_cache = &result->sat_cache;
+		sat_cache->key = key_gen_u32_u32(lo, hi);
+		sat_cache->type = SAT_CACHE_TRI_MESH;
+		result->type = COLLISION_SAT_CACHE;
+	}
+
+	sat_cache->tri_query = *local_box;
+	sat_cache->tri_query.hw[0] += SAT_CACHE_TRI_MESH_MARGIN;
+	sat_cache->tri_query.hw[1] += SAT_CACHE_TRI_MESH_MARGIN;
+	sat_cache->tri_query.hw[2] += SAT_CACHE_TRI_MESH_MARGIN;
+
+	*tri = (u32 *) tmp->stack_ptr;
+	sat_cache->tri_count = tri_mesh_bvh_push_bbox_overlaps(tmp, mesh_bvh, &sat_cache->tri_query);
+	if (sat_cache->tri_count <= SAT_CACHE_TRI_MESH_MAX)
+	{
+		memcpy(sat_cache->tri, *tri, sat_cache->tri_count * sizeof(u32));
+	}
+
+	return sat_cache->tri_count;
+}
+
+/*
+ * Reduce contact points gathered from several triangles into a manifold. The manifold normal is the depth
+ * weighted normal of all points, and at most 4 points are kept: the deepest point, the point furthest away
+ * from it, and the points spanning the largest areas on each side of the resulting segment. Returns 1 if
+ * a contact was generated.
+ */
+static u32 tri_mesh_internal_contact_reduce(struct contact_manifold *cm, struct tri_contact_point *cp, const u32 cp_count)
+{
+	if (!cp_count)
+	{
+		return 0;
+	}
+
+	u32 deepest = 0;
+	vec3 n = VEC3_ZERO;
+	for (u32 i = 0; i < cp_count; ++i)
+	{
+		if (cp[deepest].depth < cp[i].depth)
+		{
+			deepest = i;
+		}
+		vec3_translate_scaled(n, cp[i].n, f32_max(cp[i].depth, COLLISION_DEFAULT_MARGIN));
+	}
+
+	if (vec3_length_squared(n) <= COLLISION_POINT_DIST_SQ)
+	{
+		vec3_copy(cm->n, cp[deepest].n);
+	}
+	else
+	{
+		vec3_normalize(cm->n, n);
+	}
+
+	/* depths are measured along each point's own normal, project them onto the manifold normal */
+	for (u32 i = 0; i < cp_count; ++i)
+	{
+		cp[i].depth *= vec3_dot(cp[i].n, cm->n);
+	}
+
+	u32 furthest = deepest;
+	f32 max_dist = COLLISION_POINT_DIST_SQ;
+	for (u32 i = 0; i < cp_count; ++i)
+	{
+		const f32 dist = vec3_distance_squared(cp[deepest].p, cp[i].p);
+		if (cp[i].depth >= 0.0f && max_dist < dist)
+		{
+			max_dist = dist;
+			furthest = i;
+		}
+	}
+
+	vec3 tmp1, tmp2, cross;
+	u32 max_pos_i = U32_MAX;
+	u32 max_neg_i = U32_MAX;
+	f32 max_pos = COLLISION_POINT_DIST_SQ;
+	f32 max_neg = -COLLISION_POINT_DIST_SQ;
+	if (furthest != deepest)
+	{
+		vec3_sub(tmp2, cp[furthest].p, cp[deepest].p);
+		for (u32 i = 0; i < cp_count; ++i)
+		{
+			if (cp[i].depth < 0.0f)
+			{
+				continue;
+			}
+
+			vec3_sub(tmp1, cp[i].p, cp[deepest].p);
+			vec3_cross(cross, tmp1, tmp2);
+			const f32 area = vec3_dot(cross, cm->n);
+			if (max_pos < area)
+			{
+				max_pos = area;
+				max_pos_i = i;
+			}
+			else if (area < max_neg)
+			{
+				max_neg = area;
+				max_neg_i = i;
+			}
+		}
+	}
+
+	/* (v0, v1, v2, v3) is counter-clockwise around the manifold normal */
+	const u32 order[4] = { deepest, max_pos_i, furthest, max_neg_i };
+	cm->v_count = 0;
+	for (u32 i = 0; i < 4; ++i)
+	{
+		if (order[i] == U32_MAX || (i == 2 && furthest == deepest))
+		{
+			continue;
+		}
+
+		vec3_copy(cm->v[cm->v_count], cp[order[i]].p);
+		cm->depth[cm->v_count] = f32_max(cp[order[i]].depth, 0.0f);
+		cm->v_count += 1;
+	}
+
+	return 1;
+}
+
+/* Sutherland-Hodgman clipping of polygon src against plane (n, p), keep the part behind the plane. */
+static u32 tri_mesh_internal_clip_polygon(vec3ptr dst, constvec3ptr src, const u32 src_count, const vec3 n, const vec3 p)
+{
+	vec3 tmp;
+	u32 dst_count = 0;
+	for (u32 i = 0; i < src_count; ++i)
+	{
+		const f32 *a = src[i];
+		const f32 *b = src[(i+1) % src_count];
+		vec3_sub(tmp, a, p);
+		const f32 da = vec3_dot(tmp, n);
+		vec3_sub(tmp, b, p);
+		const f32 db = vec3_dot(tmp, n);
+
+		if (da <= 0.0f)
+		{
+			vec3_copy(dst[dst_count++], a);
+		}
+
+		if ((da < 0.0f && db > 0.0f) || (da > 0.0f && db < 0.0f))
+		{
+			vec3_sub(tmp, b, a);
+			vec3_copy(dst[dst_count], a);
+			vec3_translate_scaled(dst[dst_count], tmp, da / (da - db));
+			dst_count += 1;
+		}
+	}
+
+	return dst_count;
+}
+
+/* generate (at most one) contact point between triangle t and sphere (center, radius) */
+static u32 tri_sphere_contact_point(struct tri_contact_point *cp, vec3 t[3], const vec3 center, const f32 radius, const f32 margin)
+{
+	vec3 c1, c2, n_t, tmp;
+	struct gjk_input g1 = { .v = t, .v_count = 3, };
+	vec3_set(g1.pos, 0.0f, 0.0f, 0.0f);
+	mat3_identity(g1.rot);
+
+	vec3 zero = VEC3_ZERO;
+	struct gjk_input g2 = { .v = &zero, .v_count = 1, };
+	vec3_copy(g2.pos, center);
+	mat3_identity(g2.rot);
+
+	const f32 r_sum = radius + 2.0f * margin;
+	const f32 dist_sq = gjk_distance_sq(c1, c2, &g1, &g2);
+	if (dist_sq > r_sum*r_sum)
+	{
+		return 0;
+	}
+
+	tri_ccw_normal(n_t, t[0], t[1], t[2]);
+	if (dist_sq <= margin*margin)
+	{
+		vec3_copy(cp->n, n_t);
+	}
+	else
+	{
+		vec3_sub(tmp, c2, c1);
+		vec3_normalize(cp->n, tmp);
+		const f32 d = vec3_dot(cp->n, n_t);
+		if (d < 0.0f)
+		{
+			/* triangles are one-sided; only push the sphere out if it is behind the triangle interior */
+			if (d > -0.99f) { return 0; }
+			vec3_copy(cp->n, n_t);
+		}
+	}
+
+	vec3_sub(tmp, center, c1);
+	cp->depth = r_sum - vec3_dot(tmp, cp->n);
+	vec3_copy(cp->p, center);
+	vec3_translate_scaled(cp->p, cp->n, -(radius + margin - 0.5f*cp->depth));
+	return 1;
+}
+
+/* generate (at most two) contact points between triangle t and capsule segment (s0, s1) */
+static u32 tri_capsule_contact_points(struct tri_contact_point *cp, vec3 t[3], vec3 s[2], const f32 radius, const f32 margin)
+{
+	vec3 c1, c2, n, n_t, tmp;
+	struct gjk_input g1 = { .v = t, .v_count = 3, };
+	vec3_set(g1.pos, 0.0f, 0.0f, 0.0f);
+	mat3_identity(g1.rot);
+
+	struct gjk_input g2 = { .v = s, .v_count = 2, };
+	vec3_set(g2.pos, 0.0f, 0.0f, 0.0f);
+	mat3_identity(g2.rot);
+
+	const f32 r_sum = radius + 2.0f * margin;
+	const f32 dist_sq = gjk_distance_sq(c1, c2, &g1, &g2);
+	if (dist_sq > r_sum*r_sum)
+	{
+		return 0;
+	}
+
+	tri_ccw_normal(n_t, t[0], t[1], t[2]);
+	if (dist_sq <= margin*margin)
+	{
+		vec3_copy(n, n_t);
+	}
+	else
+	{
+		vec3_sub(tmp, c2, c1);
+		vec3_normalize(n, tmp);
+		const f32 d = vec3_dot(n, n_t);
+		if (d < 0.0f)
+		{
+			if (d > -0.99f) { return 0; }
+			vec3_copy(n, n_t);
+		}
+	}
+
+	/* end-point contacts, gives a stable 2 point manifold for capsules lying on the triangle */
+	u32 cp_count = 0;
+	g2.v_count = 1;
+	for (u32 k = 0; k < 2; ++k)
+	{
+		vec3 q1, q2;
+		g2.v = s + k;
+		if (gjk_distance_sq(q1, q2, &g1, &g2) <= r_sum*r_sum)
+		{
+			vec3_sub(tmp, s[k], q1);
+			cp[cp_count].depth = r_sum - vec3_dot(tmp, n);
+			vec3_copy(cp[cp_count].n, n);
+			vec3_copy(cp[cp_count].p, s[k]);
+			vec3_translate_scaled(cp[cp_count].p, n, -(radius + margin - 0.5f*cp[cp_count].depth));
+			cp_count += 1;
+		}
+	}
+
+	if (!cp_count)
+	{
+		vec3_sub(tmp, c2, c1);
+		cp[0].depth = r_sum - vec3_dot(tmp, n);
+		vec3_copy(cp[0].n, n);
+		vec3_copy(cp[0].p, c2);
+		vec3_translate_scaled(cp[0].p, n, -(radius + margin - 0.5f*cp[0].depth));
+		cp_count = 1;
+	}
+
+	return cp_count;
+}
+
+/* world space hull data shared by all triangle tests of a tri_mesh vs hull pair */
+struct tri_hull_input
+{
+	const struct dcel *	h;
+	vec3ptr			v;		/* world vertices */
+	vec3ptr			f_n;		/* world face normals */
+	u32 *			edge;		/* unique half edges (one of each twin pair) */
+	u32			edge_count;
+	vec3			center;
+	vec3ptr			clip[2];	/* clip buffers, room for (max face count + 3) vertices */
+	vec3ptr			ref;		/* reference face buffer, room for max face count vertices */
+};
+
+static u32 tri_hull_internal_edge_next(const struct dcel *h, const u32 ei)
+{
+	const struct dcel_face *f = h->f + h->e[ei].face_ccw;
+	return f->first + ((ei - f->first + 1) % f->count);
+}
+
+/* clip polygon poly (stored in in->clip[0]) against the side planes of the reference polygon ref with normal n_ref,
+ * and push the points behind the reference polygon, projected onto it. */
+static u32 tri_hull_internal_clip(struct tri_contact_point *cp, struct tri_hull_input *in, u32 count, constvec3ptr ref, const u32 ref_count, const vec3 n_ref, const vec3 cm_n)
+{
+	vec3 tmp, side_n;
+	u32 cur = 0;
+	for (u32 j = 0; j < ref_count && count; ++j)
+	{
+		vec3_sub(tmp, ref[(j+1) % ref_count], ref[j]);
+		vec3_cross(side_n, tmp, n_ref);
+		vec3_mul_constant(side_n, 1.0f / vec3_length(side_n));
+		count = tri_mesh_internal_clip_polygon(in->clip[1 - cur], (constvec3ptr) in->clip[cur], count, side_n, ref[j]);
+		cur = 1 - cur;
+	}
+
+	u32 cp_count = 0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		vec3_sub(tmp, in->clip[cur][i], ref[0]);
+		const f32 depth = -vec3_dot(tmp, n_ref);
+		if (depth >= 0.0f)
+		{
+			vec3_copy(cp[cp_count].p, in->clip[cur][i]);
+			vec3_translate_scaled(cp[cp_count].p, n_ref, depth);
+			vec3_copy(cp[cp_count].n, cm_n);
+			cp[cp_count].depth = depth;
+			cp_count += 1;
+		}
+	}
+
+	return cp_count;
+}
+
+/*
+ * SAT between triangle t and the hull; the candidate axes are the triangle normal, the hull face normals and
+ * the cross products of triangle and hull edges. As with hull_contact, face contacts are generated by clipping
+ * the incident polygon against the reference face, and edge contacts by the closest points of the edges.
+ */
+static u32 tri_hull_contact_points(struct tri_contact_point *cp, vec3 t[3], struct tri_hull_input *in)
+{
+	const struct dcel *h = in->h;
+	vec3 n_t, tmp;
+	tri_ccw_normal(n_t, t[0], t[1], t[2]);
+
+	/* (1) triangle normal */
+	f32 min_d = F32_INFINITY;
+	f32 max_d = -F32_INFINITY;
+	for (u32 i = 0; i < h->v_count; ++i)
+	{
+		vec3_sub(tmp, in->v[i], t[0]);
+		const f32 d = vec3_dot(tmp, n_t);
+		min_d = f32_min(min_d, d);
+		max_d = f32_max(max_d, d);
+	}
+
+	/* separated, or hull completely behind the (one-sided) triangle */
+	if (min_d > 0.0f || max_d < 0.0f)
+	{
+		return 0;
+	}
+	const f32 tri_sep = min_d;
+
+	/* (2) hull face normals */
+	u32 best_face = 0;
+	f32 face_sep = -F32_INFINITY;
+	for (u32 fi = 0; fi < h->f_count; ++fi)
+	{
+		const f32 *p_f = in->v[h->e[h->f[fi].first].origin];
+		f32 sep = F32_INFINITY;
+		for (u32 k = 0; k < 3; ++k)
+		{
+			vec3_sub(tmp, t[k], p_f);
+			sep = f32_min(sep, vec3_dot(tmp, in->f_n[fi]));
+		}
+
+		if (sep > 0.0f)
+		{
+			return 0;
+		}
+
+		if (face_sep < sep)
+		{
+			face_sep = sep;
+			best_face = fi;
+		}
+	}
+
+	/* (3) edge pairs */
+	vec3 centroid, axis, best_axis, d_t, d_h;
+	vec3_add(centroid, t[0], t[1]);
+	vec3_translate(centroid, t[2]);
+	vec3_mul_constant(centroid, 1.0f / 3.0f);
+	u32 best_tri_edge = 0;
+	u32 best_hull_edge = 0;
+	f32 edge_sep = -F32_INFINITY;
+	for (u32 k = 0; k < 3; ++k)
+	{
+		vec3_sub(d_t, t[(k+1) % 3], t[k]);
+		for (u32 j = 0; j < in->edge_count; ++j)
+		{
+			const u32 e0 = in->edge[j];
+			vec3_sub(d_h, in->v[h->e[tri_hull_internal_edge_next(h, e0)].origin], in->v[h->e[e0].origin]);
+			vec3_cross(axis, d_t, d_h);
+			const f32 len_sq = vec3_length_squared(axis);
+			if (len_sq <= COLLISION_POINT_DIST_SQ * vec3_length_squared(d_t) * vec3_length_squared(d_h))
+			{
+				continue;
+			}
+
+			vec3_mul_constant(axis, 1.0f / f32_sqrt(len_sq));
+			vec3_sub(tmp, in->center, centroid);
+			if (vec3_dot(axis, tmp) < 0.0f)
+			{
+				vec3_negative(axis);
+			}
+
+			f32 tri_max = -F32_INFINITY;
+			for (u32 i = 0; i < 3; ++i)
+			{
+				tri_max = f32_max(tri_max, vec3_dot(t[i], axis));
+			}
+
+			f32 hull_min = F32_INFINITY;
+			for (u32 i = 0; i < h->v_count; ++i)
+			{
+				hull_min = f32_min(hull_min, vec3_dot(in->v[i], axis));
+			}
+
+			const f32 sep = hull_min - tri_max;
+			if (sep > 0.0f)
+			{
+				return 0;
+			}
+
+			if (edge_sep < sep)
+			{
+				edge_sep = sep;
+				best_tri_edge = k;
+				best_hull_edge = e0;
+				vec3_copy(best_axis, axis);
+			}
+		}
+	}
+
+	/* (4) contact generation, prefer triangle face over hull face over edge pairs */
+	if (0.99f*tri_sep >= edge_sep || 0.99f*face_sep >= edge_sep)
+	{
+		if (0.99f*tri_sep >= face_sep)
+		{
+			/* incident face is the hull face most anti-parallel to the triangle normal */
+			u32 inc_fi = 0;
+			f32 min_dot = F32_INFINITY;
+			for (u32 fi = 0; fi < h->f_count; ++fi)
+			{
+				const f32 dot = vec3_dot(in->f_n[fi], n_t);
+				if (dot < min_dot)
+				{
+					min_dot = dot;
+					inc_fi = fi;
+				}
+			}
+
+			const struct dcel_face *f = h->f + inc_fi;
+			for (u32 i = 0; i < f->count; ++i)
+			{
+				vec3_copy(in->clip[0][i], in->v[h->e[f->first + i].origin]);
+			}
+
+			return tri_hull_internal_clip(cp, in, f->count, (constvec3ptr) t, 3, n_t, n_t);
+		}
+		else
+		{
+			const struct dcel_face *f = h->f + best_face;
+			for (u32 i = 0; i < f->count; ++i)
+			{
+				vec3_copy(in->ref[i], in->v[h->e[f->first + i].origin]);
+			}
+
+			vec3 cm_n;
+			vec3_copy(in->clip[0][0], t[0]);
+			vec3_copy(in->clip[0][1], t[1]);
+			vec3_copy(in->clip[0][2], t[2]);
+			vec3_negative_to(cm_n, in->f_n[best_face]);
+			return tri_hull_internal_clip(cp, in, 3, (constvec3ptr) in->ref, f->count, in->f_n[best_face], cm_n);
+		}
+	}
+	else
+	{
+		vec3 c1, c2;
+		const struct segment s1 = segment_construct(t[best_tri_edge], t[(best_tri_edge + 1) % 3]);
+		const struct segment s2 = segment_construct(in->v[h->e[best_hull_edge].origin], in->v[h->e[tri_hull_internal_edge_next(h, best_hull_edge)].origin]);
+		segment_distance_sq(c1, c2, &s1, &s2);
+		vec3_copy(cp->n, best_axis);
+		vec3_copy(cp->p, c1);
+		vec3_translate(cp->p, c2);
+		vec3_mul_constant(cp->p, 0.5f);
+		cp->depth = -edge_sep;
+		return 1;
+	}
+}
+
 /********************************** DISTANCE METHODS **********************************/
 
 static f32 sphere_distance(vec3 c1, vec3 c2, const struct physics_pipeline *pipeline, const struct rigid_body *b1, const struct rigid_body *b2, const f32 margin)
@@ -903,7 +1537,7 @@ static f32 hull_sphere_distance(vec3 c1, vec3 c2, const struct physics_pipeline
 	const struct collision_shape *shape1 = string_database_address(pipeline->shape_db, b1->shape_handle);
 	const struct collision_shape *shape2 = string_database_address(pipeline->shape_db, b2->shape_handle);
 
-	struct gjk_input g1 = { .v = shape1->hull.v, .v_count = shape1->hull.v_count, };
+	struct gjk_input g1 = { .v = shape1->hull.v, .v_count = shape1->hull.v_count, .hull = &shape1->hull, };
 	vec3_copy(g1.pos, b1->position);
 	quat_to_mat3(g1.rot, b1->rotation);
 
@@ -938,7 +1572,7 @@ static f32 hull_capsule_distance(vec3 c1, vec3 c2, const struct physics_pipeline
 	const struct collision_shape *shape1 = string_database_address(pipeline->shape_db, b1->shape_handle);
 	const struct collision_shape *shape2 = string_database_address(pipeline->shape_db, b2->shape_handle);
 
-	struct gjk_input g1 = { .v = shape1->hull.v, .v_count = shape1->hull.v_count, };
+	struct gjk_input g1 = { .v = shape1->hull.v, .v_count = shape1->hull.v_count, .hull = &shape1->hull, };
 	vec3_copy(g1.pos, b1->position);
 	quat_to_mat3(g1.rot, b1->rotation);
 
@@ -977,11 +1611,11 @@ static f32 hull_distance(vec3 c1, vec3 c2, const struct physics_pipeline *pipeli
 	const struct collision_shape *shape1 = string_database_address(pipeline->shape_db, b1->shape_handle);
 	const struct collision_shape *shape2 = string_database_address(pipeline->shape_db, b2->shape_handle);
 
-	struct gjk_input g1 = { .v = shape1->hull.v, .v_count = shape1->hull.v_count, };
+	struct gjk_input g1 = { .v = shape1->hull.v, .v_count = shape1->hull.v_count, .hull = &shape1->hull, };
 	vec3_copy(g1.pos, b1->position);
 	quat_to_mat3(g1.rot, b1->rotation);
 
-	struct gjk_input g2 = { .v = shape2->hull.v, .v_count = shape2->hull.v_count, };
+	struct gjk_input g2 = { .v = shape2->hull.v, .v_count = shape2->hull.v_count, .hull = &shape2->hull, };
 	vec3_copy(g2.pos, b2->position);
 	quat_to_mat3(g2.rot, b2->rotation);
 
@@ -1001,20 +1635,101 @@ static f32 hull_distance(vec3 c1, vec3 c2, const struct physics_pipeline *pipeli
 
 static f32 tri_mesh_bvh_sphere_distance(vec3 c1, vec3 c2, const struct physics_pipeline *pipeline, const struct rigid_body *b1, const struct rigid_body *b2, const f32 margin)
 {
-	kas_assert_string(0, "implement");
-	return 0.0f;
+	kas_assert(b1->shape_type == COLLISION_SHAPE_TRI_MESH);
+	kas_assert(b2->shape_type == COLLISION_SHAPE_SPHERE);
+
+	const struct tri_mesh_bvh *mesh_bvh = &((struct collision_shape *) string_database_address(pipeline->shape_db, b1->shape_handle))->mesh_bvh;
+	const struct sphere *sph = &((struct collision_shape *) string_database_address(pipeline->shape_db, b2->shape_handle))->sphere;
+
+	mat3 rot, inv_rot;
+	quat_to_mat3(rot, b1->rotation);
+	mat3_transpose_to(inv_rot, rot);
+	const struct AABB local_box = tri_mesh_internal_local_box(inv_rot, b1, b2);
+
+	vec3 zero = VEC3_ZERO;
+	struct gjk_input g2 = { .v = &zero, .v_count = 1, };
+	vec3_copy(g2.pos, b2->position);
+	mat3_identity(g2.rot);
+
+	const f32 dist_sq = tri_mesh_internal_distance_sq(c1, c2, mesh_bvh, rot, b1->position, &g2, &local_box);
+	const f32 r_sum = sph->radius + 2.0f * margin;
+	if (dist_sq <= r_sum*r_sum)
+	{
+		return 0.0f;
+	}
+
+	vec3 n;
+	vec3_sub(n, c2, c1);
+	vec3_mul_constant(n, 1.0f / vec3_length(n));
+	vec3_translate_scaled(c1, n, margin);
+	vec3_translate_scaled(c2, n, -(sph->radius + margin));
+	return f32_sqrt(vec3_distance_squared(c1, c2));
 }
 
 static f32 tri_mesh_bvh_capsule_distance(vec3 c1, vec3 c2, const struct physics_pipeline *pipeline, const struct rigid_body *b1, const struct rigid_body *b2, const f32 margin)
 {
-	kas_assert_string(0, "implement");
-	return 0.0f;
+	kas_assert(b1->shape_type == COLLISION_SHAPE_TRI_MESH);
+	kas_assert(b2->shape_type == COLLISION_SHAPE_CAPSULE);
+
+	const struct tri_mesh_bvh *mesh_bvh = &((struct collision_shape *) string_database_address(pipeline->shape_db, b1->shape_handle))->mesh_bvh;
+	const struct capsule *cap = &((struct collision_shape *) string_database_address(pipeline->shape_db, b2->shape_handle))->capsule;
+
+	mat3 rot, inv_rot;
+	quat_to_mat3(rot, b1->rotation);
+	mat3_transpose_to(inv_rot, rot);
+	const struct AABB local_box = tri_mesh_internal_local_box(inv_rot, b1, b2);
+
+	vec3 segment[2];
+	vec3_set(segment[0], 0.0f, cap->half_height, 0.0f);
+	vec3_set(segment[1], 0.0f, -cap->half_height, 0.0f);
+	struct gjk_input g2 = { .v = segment, .v_count = 2, };
+	vec3_copy(g2.pos, b2->position);
+	quat_to_mat3(g2.rot, b2->rotation);
+
+	const f32 dist_sq = tri_mesh_internal_distance_sq(c1, c2, mesh_bvh, rot, b1->position, &g2, &local_box);
+	const f32 r_sum = cap->radius + 2.0f * margin;
+	if (dist_sq <= r_sum*r_sum)
+	{
+		return 0.0f;
+	}
+
+	vec3 n;
+	vec3_sub(n, c2, c1);
+	vec3_mul_constant(n, 1.0f / vec3_length(n));
+	vec3_translate_scaled(c1, n, margin);
+	vec3_translate_scaled(c2, n, -(cap->radius + margin));
+	return f32_sqrt(vec3_distance_squared(c1, c2));
 }
 
 static f32 tri_mesh_bvh_hull_distance(vec3 c1, vec3 c2, const struct physics_pipeline *pipeline, const struct rigid_body *b1, const struct rigid_body *b2, const f32 margin)
 {
-	kas_assert_string(0, "implement");
-	return 0.0f;
+	kas_assert(b1->shape_type == COLLISION_SHAPE_TRI_MESH);
+	kas_assert(b2->shape_type == COLLISION_SHAPE_CONVEX_HULL);
+
+	const struct tri_mesh_bvh *mesh_bvh = &((struct collision_shape *) string_database_address(pipeline->shape_db, b1->shape_handle))->mesh_bvh;
+	const struct dcel *h = &((struct collision_shape *) string_database_address(pipeline->shape_db, b2->shape_handle))->hull;
+
+	mat3 rot, inv_rot;
+	quat_to_mat3(rot, b1->rotation);
+	mat3_transpose_to(inv_rot, rot);
+	const struct AABB local_box = tri_mesh_internal_local_box(inv_rot, b1, b2);
+
+	struct gjk_input g2 = { .v = h->v, .v_count = h->v_count, .hull = h, };
+	vec3_copy(g2.pos, b2->position);
+	quat_to_mat3(g2.rot, b2->rotation);
+
+	const f32 dist_sq = tri_mesh_internal_distance_sq(c1, c2, mesh_bvh, rot, b1->position, &g2, &local_box);
+	if (dist_sq <= 4.0f*margin*margin)
+	{
+		return 0.0f;
+	}
+
+	vec3 n;
+	vec3_sub(n, c2, c1);
+	vec3_mul_constant(n, 1.0f / vec3_length(n));
+	vec3_translate_scaled(c1, n, margin);
+	vec3_translate_scaled(c2, n, -margin);
+	return f32_sqrt(vec3_distance_squared(c1, c2));
 }
 
 /********************************** INTERSECTION TESTS **********************************/
@@ -1325,7 +2040,7 @@ static u32 hull_sphere_contact(struct arena *garbage, struct collision_result *r
 	result->type = COLLISION_NONE;
 	u32 contact_generated = 0;
 
-	struct gjk_input g1 = { .v = shape1->hull.v, .v_count = shape1->hull.v_count, };
+	struct gjk_input g1 = { .v = shape1->hull.v, .v_count = shape1->hull.v_count, .hull = &shape1->hull, };
 	vec3_copy(g1.pos, b1->position);
 	quat_to_mat3(g1.rot, b1->rotation);
 
@@ -1404,7 +2119,7 @@ static u32 hull_capsule_contact(struct arena *garbage, struct collision_result *
 	const struct collision_shape *shape2 = string_database_address(pipeline->shape_db, b2->shape_handle);
 
 	const struct dcel *h = &shape1->hull;
-	struct gjk_input g1 = { .v = h->v, .v_count = h->v_count, };
+	struct gjk_input g1 = { .v = h->v, .v_count = h->v_count, .hull = h, };
 	vec3_copy(g1.pos, b1->position);
 	quat_to_mat3(g1.rot, b1->rotation);
 
@@ -1631,11 +2346,10 @@ struct sat_edge_query
 	f32 depth;
 };
 
-static u32 hull_contact_internal_face_contact(struct arena *mem_tmp, struct contact_manifold *cm, const vec3 cm_n, const struct dcel *ref_dcel, const vec3 n_ref, const u32 ref_face_index, constvec3ptr v_ref, const struct dcel *inc_dcel, constvec3ptr v_inc)
+static u32 hull_contact_internal_incident_face(const struct dcel *inc_dcel, constvec3ptr v_inc, const vec3 n_ref)
 {
 	vec3 tmp1, tmp2, n;
 
-	/* (1) determine incident_face */
 	u32 inc_fi = 0;
 	f32 min_dot = 1.0f;
 	for (u32 fi = 0; fi < inc_dcel->f_count; ++fi)
@@ -1656,43 +2370,38 @@ static u32 hull_contact_internal_face_contact(struct arena *mem_tmp, struct cont
 			inc_fi = fi;
 		}
 	}
-	
-	struct dcel_face *ref_face = ref_dcel->f + ref_face_index;
-	struct dcel_face *inc_face = inc_dcel->f + inc_fi;
 
-	/* (2) Setup world polygons */
+	return inc_fi;
+}
+
+/* clip the world incident polygon against the world reference polygon and setup the contact manifold */
+static u32 hull_contact_internal_face_clip(struct arena *mem_tmp, struct contact_manifold *cm, const vec3 cm_n, const vec3 n_ref, constvec3ptr ref_v, const u32 ref_count, constvec3ptr inc_v, const u32 inc_count)
+{
+	vec3 tmp1, tmp2, n;
+
 	stack_vec3 clip_stack[2];
-	clip_stack[0] = stack_vec3_alloc(mem_tmp, 2*inc_face->count + ref_face->count, NOT_GROWABLE);
-	clip_stack[1] = stack_vec3_alloc(mem_tmp, 2*inc_face->count + ref_face->count, NOT_GROWABLE);
+	clip_stack[0] = stack_vec3_alloc(mem_tmp, 2*inc_count + ref_count, NOT_GROWABLE);
+	clip_stack[1] = stack_vec3_alloc(mem_tmp, 2*inc_count + ref_count, NOT_GROWABLE);
 	u32 cur = 0;
-	vec3ptr ref_v = arena_push(mem_tmp, ref_face->count * sizeof(vec3));
-	vec3ptr cp = arena_push(mem_tmp, (2*inc_face->count + ref_face->count) * sizeof(vec3));
-
-	for (u32 i = 0; i < ref_face->count; ++i)
-	{
-		const u32 vi = ref_dcel->e[ref_face->first + i].origin;
-		vec3_copy(ref_v[i], v_ref[vi]);
-	}
+	vec3ptr cp = arena_push(mem_tmp, (2*inc_count + ref_count) * sizeof(vec3));
 
-	for (u32 i = 0; i < inc_face->count; ++i)
+	for (u32 i = 0; i < inc_count; ++i)
 	{
-		const u32 vi = inc_dcel->e[inc_face->first + i].origin;
-		stack_vec3_push(clip_stack + cur, v_inc[vi]);
+		stack_vec3_push(clip_stack + cur, inc_v[i]);
 	}
 
-	/* (4) clip incident_face to reference_face */
-	f32 *depth = arena_push(mem_tmp, (inc_face->count * 2 + ref_face->count) * sizeof(f32));
+	f32 *depth = arena_push(mem_tmp, (inc_count * 2 + ref_count) * sizeof(f32));
 
 	/*
 	 * Sutherland-Hodgman 3D polygon clipping
 	 */
-	for (u32 j = 0; j < ref_face->count; ++j)
+	for (u32 j = 0; j < ref_count; ++j)
 	{
 		const u32 prev = cur;
 		cur = 1 - cur;
 		stack_vec3_flush(clip_stack + cur);
 
-		vec3_sub(tmp1, ref_v[(j+1) % ref_face->count], ref_v[j]);
+		vec3_sub(tmp1, ref_v[(j+1) % ref_count], ref_v[j]);
 		vec3_cross(n, tmp1, n_ref);
 		vec3_mul_constant(n, 1.0f / vec3_length(n));
 		struct plane clip_plane = plane_construct(n, ref_v[j]);
@@ -1889,23 +2598,43 @@ static u32 hull_contact_internal_face_contact(struct arena *mem_tmp, struct cont
 	return is_colliding;
 }
 
+/* generate face contact from reference face ref_face_index, and return the chosen incident face in inc_face */
+static u32 hull_contact_internal_face_contact(struct arena *mem_tmp, struct contact_manifold *cm, u32 *inc_face, const vec3 cm_n, const struct dcel *ref_dcel, const vec3 n_ref, const u32 ref_face_index, constvec3ptr v_ref, const struct dcel *inc_dcel, constvec3ptr v_inc)
+{
+	*inc_face = hull_contact_internal_incident_face(inc_dcel, v_inc, n_ref);
+	const struct dcel_face *ref_face = ref_dcel->f + ref_face_index;
+	const struct dcel_face *inc_f = inc_dcel->f + *inc_face;
+
+	vec3ptr ref_v = arena_push(mem_tmp, ref_face->count * sizeof(vec3));
+	vec3ptr inc_v = arena_push(mem_tmp, inc_f->count * sizeof(vec3));
+	for (u32 i = 0; i < ref_face->count; ++i)
+	{
+		vec3_copy(ref_v[i], v_ref[ref_dcel->e[ref_face->first + i].origin]);
+	}
+
+	for (u32 i = 0; i < inc_f->count; ++i)
+	{
+		vec3_copy(inc_v[i], v_inc[inc_dcel->e[inc_f->first + i].origin]);
+	}
+
+	return hull_contact_internal_face_clip(mem_tmp, cm, cm_n, n_ref, (constvec3ptr) ref_v, ref_face->count, (constvec3ptr) inc_v, inc_f->count);
+}
+
 static u32 hull_contact_internal_fv_separation(struct sat_face_query *query, const struct dcel *h1, constvec3ptr v1_world, const struct dcel *h2, constvec3ptr v2_world)
 {
+	u32 hint = 0;
 	for (u32 fi = 0; fi < h1->f_count; ++fi)
 	{
 		const u32 f_v0 = h1->e[h1->f[fi].first + 0].origin;
 		const u32 f_v1 = h1->e[h1->f[fi].first + 1].origin;
 		const u32 f_v2 = h1->e[h1->f[fi].first + 2].origin;
 		const struct plane sep_plane = plane_construct_from_ccw_triangle(v1_world[f_v0], v1_world[f_v1], v1_world[f_v2]);
-		f32 min_dist = FLT_MAX;
-		for (u32 i = 0; i < h2->v_count; ++i)
-		{
-			const f32 dist = plane_point_signed_distance(&sep_plane, v2_world[i]);
-			if (dist < min_dist)
-			{
-				min_dist = dist;
-			}
-		}
+
+		/* closest vertex of h2 to the face plane = support of h2 in -normal */
+		vec3 dir;
+		vec3_negative_to(dir, sep_plane.normal);
+		hint = dcel_vertex_support(h2, v2_world, dir, hint);
+		const f32 min_dist = plane_point_signed_distance(&sep_plane, v2_world[hint]);
 
 		if (min_dist > 0.0f) 
 		{ 
@@ -1955,28 +2684,16 @@ static u32 internal_ee_is_minkowski_face(const vec3 n1_1, const vec3 n1_2, const
 	return (n1_1d*n1_2d < 0.0f && n2_1d*n2_2d < 0.0f && n1_2d*n2_1d > 0.0f) ? 1 : 0;
 }
 
-static void hull_contact_internal_ee_check(struct sat_edge_query *query, const struct dcel *h1, constvec3ptr v1_world, const u32 e1_1, const struct dcel *h2, constvec3ptr v2_world, const u32 e2_1, const vec3 h1_world_center)
+static void hull_contact_internal_ee_query(struct sat_edge_query *query, vec3 n1_1, vec3 n1_2, vec3 n2_1, vec3 n2_2, const struct segment *s1_ptr, const struct segment *s2_ptr, const u32 e1_1, const u32 e2_1, const vec3 h1_world_center)
 {
-	vec3 n1_1, n1_2, n2_1, n2_2, e1, e2;
-	const u32 e1_2 = h1->e[e1_1].twin;
-	const u32 e2_2 = h2->e[e2_1].twin;
-
-	const u32 f1_1 = h1->e[e1_1].face_ccw;
-	const u32 f1_2 = h1->e[e1_2].face_ccw;
-	const u32 f2_1 = h2->e[e2_1].face_ccw;
-	const u32 f2_2 = h2->e[e2_2].face_ccw;
-	tri_ccw_direction(n1_1, v1_world[h1->e[h1->f[f1_1].first + 0].origin],  v1_world[h1->e[h1->f[f1_1].first + 1].origin], v1_world[h1->e[h1->f[f1_1].first + 2].origin]);
-	tri_ccw_direction(n1_2, v1_world[h1->e[h1->f[f1_2].first + 0].origin],  v1_world[h1->e[h1->f[f1_2].first + 1].origin], v1_world[h1->e[h1->f[f1_2].first + 2].origin]);
-	tri_ccw_direction(n2_1, v2_world[h2->e[h2->f[f2_1].first + 0].origin],  v2_world[h2->e[h2->f[f2_1].first + 1].origin], v2_world[h2->e[h2->f[f2_1].first + 2].origin]);
-	tri_ccw_direction(n2_2, v2_world[h2->e[h2->f[f2_2].first + 0].origin],  v2_world[h2->e[h2->f[f2_2].first + 1].origin], v2_world[h2->e[h2->f[f2_2].first + 2].origin]);
+	vec3 e1, e2;
+	const struct segment s1 = *s1_ptr;
+	const struct segment s2 = *s2_ptr;
 
 	///* we are working with minkowski difference A - B, so gauss map of B is (-B). n2_1, n2_2 cross product stays the same. */
 	vec3_negative(n2_1);	
 	vec3_negative(n2_2);
 
-	const struct segment s1 = segment_construct(v1_world[h1->e[e1_1].origin], v1_world[h1->e[e1_2].origin]);
-	const struct segment s2 = segment_construct(v2_world[h2->e[e2_1].origin], v2_world[h2->e[e2_2].origin]);
-
 	/* 
 	 * test if A, -B edges intersect on gauss map, only if they do, 
 	 * they are a candidate for collision
@@ -2015,6 +2732,58 @@ static void hull_contact_internal_ee_check(struct sat_edge_query *query, const s
 	}
 }
 
+static void hull_contact_internal_ee_check(struct sat_edge_query *query, const struct dcel *h1, constvec3ptr v1_world, const u32 e1_1, const struct dcel *h2, constvec3ptr v2_world, const u32 e2_1, const vec3 h1_world_center)
+{
+	vec3 n1_1, n1_2, n2_1, n2_2;
+	const u32 e1_2 = h1->e[e1_1].twin;
+	const u32 e2_2 = h2->e[e2_1].twin;
+
+	const u32 f1_1 = h1->e[e1_1].face_ccw;
+	const u32 f1_2 = h1->e[e1_2].face_ccw;
+	const u32 f2_1 = h2->e[e2_1].face_ccw;
+	const u32 f2_2 = h2->e[e2_2].face_ccw;
+	tri_ccw_direction(n1_1, v1_world[h1->e[h1->f[f1_1].first + 0].origin],  v1_world[h1->e[h1->f[f1_1].first + 1].origin], v1_world[h1->e[h1->f[f1_1].first + 2].origin]);
+	tri_ccw_direction(n1_2, v1_world[h1->e[h1->f[f1_2].first + 0].origin],  v1_world[h1->e[h1->f[f1_2].first + 1].origin], v1_world[h1->e[h1->f[f1_2].first + 2].origin]);
+	tri_ccw_direction(n2_1, v2_world[h2->e[h2->f[f2_1].first + 0].origin],  v2_world[h2->e[h2->f[f2_1].first + 1].origin], v2_world[h2->e[h2->f[f2_1].first + 2].origin]);
+	tri_ccw_direction(n2_2, v2_world[h2->e[h2->f[f2_2].first + 0].origin],  v2_world[h2->e[h2->f[f2_2].first + 1].origin], v2_world[h2->e[h2->f[f2_2].first + 2].origin]);
+
+	const struct segment s1 = segment_construct(v1_world[h1->e[e1_1].origin], v1_world[h1->e[e1_2].origin]);
+	const struct segment s2 = segment_construct(v2_world[h2->e[e2_1].origin], v2_world[h2->e[e2_2].origin]);
+
+	hull_contact_internal_ee_query(query, n1_1, n1_2, n2_1, n2_2, &s1, &s2, e1_1, e2_1, h1_world_center);
+}
+
+/* edge check of a cached edge pair, transforming only the features involved instead of the whole hulls */
+static void hull_contact_internal_ee_check_local(struct sat_edge_query *query, const struct dcel *h1, mat3 rot1, const vec3 pos1, const u32 e1_1, const struct dcel *h2, mat3 rot2, const vec3 pos2, const u32 e2_1)
+{
+	vec3 n1_1, n1_2, n2_1, n2_2, n, p0, p1;
+	const u32 e1_2 = h1->e[e1_1].twin;
+	const u32 e2_2 = h2->e[e2_1].twin;
+
+	dcel_face_normal(n, h1, h1->e[e1_1].face_ccw);
+	mat3_vec_mul(n1_1, rot1, n);
+	dcel_face_normal(n, h1, h1->e[e1_2].face_ccw);
+	mat3_vec_mul(n1_2, rot1, n);
+	dcel_face_normal(n, h2, h2->e[e2_1].face_ccw);
+	mat3_vec_mul(n2_1, rot2, n);
+	dcel_face_normal(n, h2, h2->e[e2_2].face_ccw);
+	mat3_vec_mul(n2_2, rot2, n);
+
+	mat3_vec_mul(p0, rot1, h1->v[h1->e[e1_1].origin]);
+	mat3_vec_mul(p1, rot1, h1->v[h1->e[e1_2].origin]);
+	vec3_translate(p0, pos1);
+	vec3_translate(p1, pos1);
+	const struct segment s1 = segment_construct(p0, p1);
+
+	mat3_vec_mul(p0, rot2, h2->v[h2->e[e2_1].origin]);
+	mat3_vec_mul(p1, rot2, h2->v[h2->e[e2_2].origin]);
+	vec3_translate(p0, pos2);
+	vec3_translate(p1, pos2);
+	const struct segment s2 = segment_construct(p0, p1);
+
+	hull_contact_internal_ee_query(query, n1_1, n1_2, n2_1, n2_2, &s1, &s2, e1_1, e2_1, pos1);
+}
+
 /*
  * For full algorithm: see GDC talk by Dirk Gregorius - 
  * 	Physics for Game Programmers: The Separating Axis Test between Convex Polyhedra
@@ -2061,6 +2830,117 @@ void sat_edge_query_collision_result(struct contact_manifold *manifold, struct s
 	kas_assert(vec3_length(manifold->n) < 1.0f + 1000.0f * F32_EPSILON);
 }
 
+/* relative transform of b2 in b1's frame, used to decide if a cached contact feature can be reused */
+static void hull_contact_internal_relative_transform(quat rel_rotation, vec3 rel_position, mat3 inv_rot1, const struct rigid_body *b1, const struct rigid_body *b2)
+{
+	quat q1_conj;
+	vec3 diff;
+	quat_conj(q1_conj, b1->rotation);
+	quat_mult(rel_rotation, q1_conj, b2->rotation);
+	vec3_sub(diff, b2->position, b1->position);
+	mat3_vec_mul(rel_position, inv_rot1, diff);
+}
+
+/* 
+ * Try to reuse the cached separating axis or contact feature without building the world hulls. A cached
+ * separating axis is exact and only needs to be retested, while cached contact features are only reused
+ * if the relative transform has stayed within tolerance since they were found by the full SAT.  Returns 1
+ * if the cache could be reused, 0 if the full SAT must be run.
+ */
+static u32 hull_contact_internal_sat_cache_reuse(struct arena *tmp, u32 *colliding, struct contact_manifold *cm, struct sat_cache *sat_cache, const struct dcel *h1, mat3 rot1, mat3 inv_rot1, const struct rigid_body *b1, const struct dcel *h2, mat3 rot2, mat3 inv_rot2, const struct rigid_body *b2, const quat rel_rotation, const vec3 rel_position)
+{
+	if (sat_cache->type == SAT_CACHE_SEPARATION)
+	{
+		vec3 dir1, dir2, support1, support2;
+		mat3_vec_mul(dir1, inv_rot1, sat_cache->separation_axis);
+		mat3_vec_mul(dir2, inv_rot2, sat_cache->separation_axis);
+		vec3_negative(dir2);
+
+		vec3_copy(support1, h1->v[dcel_vertex_support(h1, (constvec3ptr) h1->v, dir1, 0)]);
+		vec3_copy(support2, h2->v[dcel_vertex_support(h2, (constvec3ptr) h2->v, dir2, 0)]);
+
+		const f32 dot1 = vec3_dot(support1, dir1) + vec3_dot(b1->position, sat_cache->separation_axis);
+		const f32 dot2 = -vec3_dot(support2, dir2) + vec3_dot(b2->position, sat_cache->separation_axis);
+		const f32 separation = dot2 - dot1;
+		if (separation > 0.0f)
+		{
+			*colliding = 0;
+			sat_cache->separation = separation;
+			return 1;
+		}
+
+		return 0;
+	}
+
+	vec3 diff;
+	vec3_sub(diff, rel_position, sat_cache->rel_position);
+	if (vec3_length_squared(diff) > SAT_CACHE_LINEAR_TOLERANCE*SAT_CACHE_LINEAR_TOLERANCE
+		 || f32_abs(vec4_dot(rel_rotation, sat_cache->rel_rotation)) < SAT_CACHE_ANGULAR_TOLERANCE)
+	{
+		return 0;
+	}
+
+	if (sat_cache->type == SAT_CACHE_CONTACT_EE)
+	{
+		struct sat_edge_query e_query = { .depth = -F32_INFINITY };
+		hull_contact_internal_ee_check_local(&e_query, h1, rot1, b1->position, sat_cache->edge1, h2, rot2, b2->position, sat_cache->edge2);
+		if (-F32_INFINITY < e_query.depth && e_query.depth < 0.0f)
+		{
+			*colliding = 1;
+			sat_edge_query_collision_result(cm, sat_cache, &e_query);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	kas_assert(sat_cache->type == SAT_CACHE_CONTACT_FV);
+
+	const struct dcel *ref_h = h1;
+	const struct dcel *inc_h = h2;
+	vec3 *ref_rot = rot1;
+	vec3 *inc_rot = rot2;
+	const f32 *ref_pos = b1->position;
+	const f32 *inc_pos = b2->position;
+	if (sat_cache->body == 1)
+	{
+		ref_h = h2;
+		inc_h = h1;
+		ref_rot = rot2;
+		inc_rot = rot1;
+		ref_pos = b2->position;
+		inc_pos = b1->position;
+	}
+
+	vec3 n, ref_n, cm_n;
+	dcel_face_normal(n, ref_h, sat_cache->face);
+	mat3_vec_mul(ref_n, ref_rot, n);
+	vec3_copy(cm_n, ref_n);
+	if (sat_cache->body == 1)
+	{
+		vec3_negative(cm_n);
+	}
+
+	const struct dcel_face *ref_face = ref_h->f + sat_cache->face;
+	const struct dcel_face *inc_face = inc_h->f + sat_cache->inc_face;
+	vec3ptr ref_v = arena_push(tmp, ref_face->count * sizeof(vec3));
+	vec3ptr inc_v = arena_push(tmp, inc_face->count * sizeof(vec3));
+	for (u32 i = 0; i < ref_face->count; ++i)
+	{
+		mat3_vec_mul(ref_v[i], ref_rot, ref_h->v[ref_h->e[ref_face->first + i].origin]);
+		vec3_translate(ref_v[i], ref_pos);
+	}
+
+	for (u32 i = 0; i < inc_face->count; ++i)
+	{
+		mat3_vec_mul(inc_v[i], inc_rot, inc_h->v[inc_h->e[inc_face->first + i].origin]);
+		vec3_translate(inc_v[i], inc_pos);
+	}
+
+	*colliding = hull_contact_internal_face_clip(tmp, cm, cm_n, ref_n, (constvec3ptr) ref_v, ref_face->count, (constvec3ptr) inc_v, inc_face->count);
+	return *colliding;
+}
+
 /*
  * For the Algorithm, see
  * 	(Game Physics Pearls, Chapter 4)
@@ -2088,33 +2968,20 @@ static u32 hull_contact(struct arena *tmp, struct collision_result *result, cons
 	//TODO: Margins??
 	arena_push_record(tmp);
 
-	mat3 rot1, rot2;
+	mat3 rot1, rot2, inv_rot1, inv_rot2;
 	quat_to_mat3(rot1, b1->rotation);
 	quat_to_mat3(rot2, b2->rotation);
+	mat3_transpose_to(inv_rot1, rot1);
+	mat3_transpose_to(inv_rot2, rot2);
 
 	struct dcel *h1 = &((struct collision_shape *) string_database_address(pipeline->shape_db, b1->shape_handle))->hull;
 	struct dcel *h2 = &((struct collision_shape *) string_database_address(pipeline->shape_db, b2->shape_handle))->hull;
 
-	vec3ptr v1_world = arena_push(tmp, h1->v_count * sizeof(vec3));
-	vec3ptr v2_world = arena_push(tmp, h2->v_count * sizeof(vec3));
-
-	for (u32 i = 0; i < h1->v_count; ++i)
-	{
-		mat3_vec_mul(v1_world[i], rot1, h1->v[i]);
-		vec3_translate(v1_world[i], b1->position);
-	}
-
-	for (u32 i = 0; i < h2->v_count; ++i)
-	{
-		mat3_vec_mul(v2_world[i], rot2, h2->v[i]);
-		vec3_translate(v2_world[i], b2->position);
-	}
-
-	struct sat_face_query f_query[2] = { { .depth = -F32_INFINITY }, { .depth = -F32_INFINITY } };
-	struct sat_edge_query e_query = { .depth = -F32_INFINITY };
+	quat rel_rotation;
+	vec3 rel_position;
+	hull_contact_internal_relative_transform(rel_rotation, rel_position, inv_rot1, b1, b2);
 
 	u32 colliding = 1;
-	u32 calculate = 1;
 	struct sat_cache *sat_cache = NULL;
 
 	const u32 bi1 = pool_index(&pipeline->body_pool, b1);
@@ -2129,135 +2996,97 @@ static u32 hull_contact(struct arena *tmp, struct collision_result *result, cons
 		cache_found = 0;	
 		sat_cache = &result->sat_cache;
 	}
-	else
+	//TODO BUG to fix: when removing body's all contacts, ALSO remove any sat_cache; otherwise 
+	// it may be wrongfully alised the next frame by new indices.
+	else if (hull_contact_internal_sat_cache_reuse(tmp, &colliding, &result->manifold, sat_cache, h1, rot1, inv_rot1, b1, h2, rot2, inv_rot2, b2, rel_rotation, rel_position))
 	{
-		if (sat_cache->type == SAT_CACHE_SEPARATION)
-		{
-			vec3 support1, support2, tmp;
-			vec3_negative_to(tmp, sat_cache->separation_axis);
+		result->sat_query = SAT_CACHE_QUERY_HIT;
+		goto sat_cleanup;
+	}
 
-			vertex_support(support1, sat_cache->separation_axis, v1_world, h1->v_count);
-			vertex_support(support2, tmp, v2_world, h2->v_count);
+	result->sat_query = SAT_CACHE_QUERY_MISS;
 
-			const f32 dot1 = vec3_dot(support1, sat_cache->separation_axis);
-			const f32 dot2 = vec3_dot(support2, sat_cache->separation_axis);
-			const f32 separation = dot2 - dot1;
-			if (separation > 0.0f)
-			{
-				calculate = 0;
-				colliding = 0;
-				sat_cache->separation = separation;
-			}
-		}
-		else if (sat_cache->type == SAT_CACHE_CONTACT_EE)
-		{
-			hull_contact_internal_ee_check(&e_query, h1, v1_world, sat_cache->edge1, h2, v2_world, sat_cache->edge2, b1->position);
-			if (-F32_INFINITY < e_query.depth && e_query.depth < 0.0f)
-			{
-				calculate = 0;
-				sat_edge_query_collision_result(&result->manifold, sat_cache, &e_query);
-			}
-			else
-			{
-				colliding = 0;
-				e_query.depth = -F32_INFINITY;
-			}
-		}
-		else 
-		{
-			//TODO BUG to fix: when removing body's all contacts, ALSO remove any sat_cache; otherwise 
-			// it may be wrongfully alised the next frame by new indices.
-			//TODO Should we check that the manifold is still stable? if not, we throw it away.
-			vec3 ref_n, cm_n;
+	vec3ptr v1_world = arena_push(tmp, h1->v_count * sizeof(vec3));
+	vec3ptr v2_world = arena_push(tmp, h2->v_count * sizeof(vec3));
 
-			if (sat_cache->body == 0)
-			{
-				dcel_face_normal(cm_n, h1, sat_cache->face);
-				mat3_vec_mul(ref_n, rot1, cm_n);
-				colliding = hull_contact_internal_face_contact(tmp, &result->manifold, ref_n, h1, ref_n, sat_cache->face, v1_world, h2, v2_world);
-			}
-			else
-			{
-				dcel_face_normal(cm_n, h2, sat_cache->face);
-				mat3_vec_mul(ref_n, rot2, cm_n);
-				vec3_negative_to(cm_n, ref_n);
-				colliding = hull_contact_internal_face_contact(tmp, &result->manifold, cm_n, h2, ref_n, sat_cache->face, v2_world, h1, v1_world);
-			}
+	dcel_vertex_transform(v1_world, h1, rot1, b1->position);
+	dcel_vertex_transform(v2_world, h2, rot2, b2->position);
 
-			calculate = !colliding;
-		}
+	struct sat_face_query f_query[2] = { { .depth = -F32_INFINITY }, { .depth = -F32_INFINITY } };
+	struct sat_edge_query e_query = { .depth = -F32_INFINITY };
+
+	quat_copy(sat_cache->rel_rotation, rel_rotation);
+	vec3_copy(sat_cache->rel_position, rel_position);
+
+	if (hull_contact_internal_fv_separation(&f_query[0], h1, v1_world, h2, v2_world))
+	{
+		vec3_copy(sat_cache->separation_axis, f_query[0].normal);
+		sat_cache->separation = f_query[0].depth;
+		sat_cache->type = SAT_CACHE_SEPARATION;
+		colliding = 0;
+		goto sat_cleanup;
+	}
+
+	if (hull_contact_internal_fv_separation(&f_query[1], h2, v2_world, h1, v1_world))
+	{
+		vec3_negative_to(sat_cache->separation_axis, f_query[1].normal);
+		sat_cache->separation = f_query[1].depth;
+		sat_cache->type = SAT_CACHE_SEPARATION;
+		colliding = 0;
+		goto sat_cleanup;
+	}
+
+	if (hull_contact_internal_ee_separation(&e_query, h1, v1_world, h2, v2_world, b1->position))
+	{
+		vec3_copy(sat_cache->separation_axis, e_query.normal);
+		sat_cache->separation = e_query.depth;
+		sat_cache->type = SAT_CACHE_SEPARATION;
+		colliding = 0;
+		goto sat_cleanup;
 	}
 
-	if (calculate)
+	colliding = 1;
+	if (0.99f*f_query[0].depth >= e_query.depth || 0.99f*f_query[1].depth >= e_query.depth)
 	{
-		if (hull_contact_internal_fv_separation(&f_query[0], h1, v1_world, h2, v2_world))
+		u32 inc_face;
+		if (f_query[0].depth > f_query[1].depth)
 		{
-			vec3_copy(sat_cache->separation_axis, f_query[0].normal);
-			sat_cache->separation = f_query[0].depth;
-			sat_cache->type = SAT_CACHE_SEPARATION;
-			colliding = 0;
-			goto sat_cleanup;
+			sat_cache->body = 0;
+			sat_cache->face = f_query[0].fi;
+			colliding = hull_contact_internal_face_contact(tmp, &result->manifold, &inc_face, f_query[0].normal, h1, f_query[0].normal, f_query[0].fi, v1_world, h2, v2_world);
 		}
-
-		if (hull_contact_internal_fv_separation(&f_query[1], h2, v2_world, h1, v1_world))
+		else
 		{
-			vec3_negative_to(sat_cache->separation_axis, f_query[1].normal);
-			sat_cache->separation = f_query[1].depth;
-			sat_cache->type = SAT_CACHE_SEPARATION;
-			colliding = 0;
-			goto sat_cleanup;
+			vec3 cm_n;
+			sat_cache->body = 1;
+			sat_cache->face = f_query[1].fi;
+			vec3_negative_to(cm_n, f_query[1].normal);
+			colliding = hull_contact_internal_face_contact(tmp, &result->manifold, &inc_face, cm_n, h2, f_query[1].normal, f_query[1].fi, v2_world, h1, v1_world);
 		}
 
-		if (hull_contact_internal_ee_separation(&e_query, h1, v1_world, h2, v2_world, b1->position))
+		if (colliding)
 		{
-			vec3_copy(sat_cache->separation_axis, e_query.normal);
-			sat_cache->separation = e_query.depth;
-			sat_cache->type = SAT_CACHE_SEPARATION;
-			colliding = 0;
-			goto sat_cleanup;
+			sat_cache->inc_face = inc_face;
+			sat_cache->type = SAT_CACHE_CONTACT_FV;
 		}
-
-		colliding = 1;
-		if (0.99f*f_query[0].depth >= e_query.depth || 0.99f*f_query[1].depth >= e_query.depth)
+		else
 		{
-			if (f_query[0].depth > f_query[1].depth)
-			{
-				sat_cache->body = 0;
-				sat_cache->face = f_query[0].fi;
-				colliding = hull_contact_internal_face_contact(tmp, &result->manifold, f_query[0].normal, h1, f_query[0].normal, f_query[0].fi, v1_world, h2, v2_world);
-			}
-			else
-			{
-				vec3 cm_n;
-				sat_cache->body = 1;
-				sat_cache->face = f_query[1].fi;
-				vec3_negative_to(cm_n, f_query[1].normal);
-				colliding = hull_contact_internal_face_contact(tmp, &result->manifold, cm_n, h2, f_query[1].normal, f_query[1].fi, v2_world, h1, v1_world);
-			}
-
-			if (colliding)
+			if (sat_cache->body == 0)
 			{
-				sat_cache->type = SAT_CACHE_CONTACT_FV;
+				vec3_copy(sat_cache->separation_axis, f_query[0].normal);
 			}
 			else
 			{
-				if (sat_cache->body == 0)
-				{
-					vec3_copy(sat_cache->separation_axis, f_query[0].normal);
-				}
-				else
-				{
-					vec3_negative_to(sat_cache->separation_axis, f_query[1].normal);
-				}
-				sat_cache->separation = 0.0f;
-				sat_cache->type = SAT_CACHE_SEPARATION;
+				vec3_negative_to(sat_cache->separation_axis, f_query[1].normal);
 			}
+			sat_cache->separation = 0.0f;
+			sat_cache->type = SAT_CACHE_SEPARATION;
 		}
-		/* edge_contact */
-		else
-		{
-			sat_edge_query_collision_result(&result->manifold, sat_cache, &e_query);
-		}
+	}
+	/* edge_contact */
+	else
+	{
+		sat_edge_query_collision_result(&result->manifold, sat_cache, &e_query);
 	}
 
 sat_cleanup:
@@ -2284,63 +3113,41 @@ static u32 tri_mesh_bvh_sphere_contact(struct arena *tmp, struct collision_resul
 	kas_assert(b1->shape_type == COLLISION_SHAPE_TRI_MESH);
 	kas_assert(b2->shape_type == COLLISION_SHAPE_SPHERE);
 
-	struct tri_mesh_bvh *mesh_bvh = &((struct collision_shape *) string_database_address(pipeline->shape_db, b1->shape_handle))->mesh_bvh;
-	struct sphere *sph = &((struct collision_shape *) string_database_address(pipeline->shape_db, b2->shape_handle))->sphere;
-
-	struct AABB bbox_transform;
-	vec3_sub(bbox_transform.center, b2->position, b1->position);
-	vec3_set(bbox_transform.hw, sph->radius, sph->radius, sph->radius);
+	const struct tri_mesh_bvh *mesh_bvh = &((struct collision_shape *) string_database_address(pipeline->shape_db, b1->shape_handle))->mesh_bvh;
+	const struct sphere *sph = &((struct collision_shape *) string_database_address(pipeline->shape_db, b2->shape_handle))->sphere;
 
 	arena_push_record(tmp);
 
-	const struct bvh *bvh = &mesh_bvh->bvh;
-	const struct bvh_node *node = (struct bvh_node *) bvh->tree.pool.buf;
-	struct allocation_array arr = arena_push_aligned_all(tmp, sizeof(struct bvh_node *), sizeof(struct bvh_node *));
-	const struct bvh_node **node_stack = arr.addr;
+	mat3 rot, inv_rot;
+	quat_to_mat3(rot, b1->rotation);
+	mat3_transpose_to(inv_rot, rot);
+	const struct AABB local_box = tri_mesh_internal_local_box(inv_rot, b1, b2);
 
-	if (arr.len == 0)
+	const u32 *tri;
+	const u32 tri_count = tri_mesh_internal_candidate_triangles(tmp, &tri, result, pipeline, b1, b2, mesh_bvh, &local_box);
+	struct tri_contact_point *cp = arena_push(tmp, tri_count * sizeof(struct tri_contact_point));
+	if (tri_count && !cp)
 	{
-		log(T_SYSTEM, S_FATAL, "Out of memory in %s\n", __func__);
+		log(T_PHYSICS, S_FATAL, "Out of memory in %s\n", __func__);
 		fatal_cleanup_and_exit(kas_thread_self_tid());
 	}
 
-	u32 sc = 0;
-	if (AABB_test(&bbox_transform, &node[bvh->tree.root].bbox))
+	vec3 t[3];
+	u32 cp_count = 0;
+	for (u32 i = 0; i < tri_count; ++i)
 	{
-		node_stack[sc++] = node + bvh->tree.root;
+		tri_mesh_internal_world_triangle(t, mesh_bvh->mesh, tri[i], rot, b1->position);
+		cp_count += tri_sphere_contact_point(cp + cp_count, t, b2->position, sph->radius, margin);
 	}
 
-	while (sc--)
+	const u32 colliding = tri_mesh_internal_contact_reduce(&result->manifold, cp, cp_count);
+	if (result->type != COLLISION_SAT_CACHE && colliding)
 	{
-		if (BT_IS_LEAF(node_stack[sc]))
-		{
-			fprintf(stderr, "sphere hits triangle bbox\n");	
-		}
-		else
-		{
-			const struct bvh_node *left = node + node_stack[sc]->bt_left;
-			const struct bvh_node *right = node + node_stack[sc]->bt_right;
-			if (AABB_test(&bbox_transform, &right->bbox))
-			{
-				node_stack[sc++] = right;
-			}
-
-			if (AABB_test(&bbox_transform, &left->bbox))
-			{
-				if (sc >= arr.len)
-				{
-					log(T_SYSTEM, S_FATAL, "Out of memory in %s\n", __func__);
-					fatal_cleanup_and_exit(kas_thread_self_tid());
-				}
-				node_stack[sc++] = left;
-			}
-		}
+		result->type = COLLISION_CONTACT;
 	}
 
 	arena_pop_record(tmp);
-
-	result->type = COLLISION_NONE;
-	return 0;
+	return colliding;
 }
 
 static u32 tri_mesh_bvh_capsule_contact(struct arena *tmp, struct collision_result *result, const struct physics_pipeline *pipeline, const struct rigid_body *b1, const struct rigid_body *b2, const f32 margin)
@@ -2348,8 +3155,48 @@ static u32 tri_mesh_bvh_capsule_contact(struct arena *tmp, struct collision_resu
 	kas_assert(b1->shape_type == COLLISION_SHAPE_TRI_MESH);
 	kas_assert(b2->shape_type == COLLISION_SHAPE_CAPSULE);
 
-	result->type = COLLISION_NONE;
-	return 0;
+	const struct tri_mesh_bvh *mesh_bvh = &((struct collision_shape *) string_database_address(pipeline->shape_db, b1->shape_handle))->mesh_bvh;
+	const struct capsule *cap = &((struct collision_shape *) string_database_address(pipeline->shape_db, b2->shape_handle))->capsule;
+
+	arena_push_record(tmp);
+
+	mat3 rot, inv_rot, rot2;
+	quat_to_mat3(rot, b1->rotation);
+	mat3_transpose_to(inv_rot, rot);
+	const struct AABB local_box = tri_mesh_internal_local_box(inv_rot, b1, b2);
+
+	vec3 s[2];
+	quat_to_mat3(rot2, b2->rotation);
+	vec3_scale(s[0], rot2[1], cap->half_height);
+	vec3_negative_to(s[1], s[0]);
+	vec3_translate(s[0], b2->position);
+	vec3_translate(s[1], b2->position);
+
+	const u32 *tri;
+	const u32 tri_count = tri_mesh_internal_candidate_triangles(tmp, &tri, result, pipeline, b1, b2, mesh_bvh, &local_box);
+	struct tri_contact_point *cp = arena_push(tmp, 2 * tri_count * sizeof(struct tri_contact_point));
+	if (tri_count && !cp)
+	{
+		log(T_PHYSICS, S_FATAL, "Out of memory in %s\n", __func__);
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+
+	vec3 t[3];
+	u32 cp_count = 0;
+	for (u32 i = 0; i < tri_count; ++i)
+	{
+		tri_mesh_internal_world_triangle(t, mesh_bvh->mesh, tri[i], rot, b1->position);
+		cp_count += tri_capsule_contact_points(cp + cp_count, t, s, cap->radius, margin);
+	}
+
+	const u32 colliding = tri_mesh_internal_contact_reduce(&result->manifold, cp, cp_count);
+	if (result->type != COLLISION_SAT_CACHE && colliding)
+	{
+		result->type = COLLISION_CONTACT;
+	}
+
+	arena_pop_record(tmp);
+	return colliding;
 }
 
 static u32 tri_mesh_bvh_hull_contact(struct arena *tmp, struct collision_result *result, const struct physics_pipeline *pipeline, const struct rigid_body *b1, const struct rigid_body *b2, const f32 margin)
@@ -2357,8 +3204,87 @@ static u32 tri_mesh_bvh_hull_contact(struct arena *tmp, struct collision_result
 	kas_assert(b1->shape_type == COLLISION_SHAPE_TRI_MESH);
 	kas_assert(b2->shape_type == COLLISION_SHAPE_CONVEX_HULL);
 
-	result->type = COLLISION_NONE;
-	return 0;
+	const struct tri_mesh_bvh *mesh_bvh = &((struct collision_shape *) string_database_address(pipeline->shape_db, b1->shape_handle))->mesh_bvh;
+	const struct dcel *h = &((struct collision_shape *) string_database_address(pipeline->shape_db, b2->shape_handle))->hull;
+
+	arena_push_record(tmp);
+
+	mat3 rot, inv_rot, rot2;
+	quat_to_mat3(rot, b1->rotation);
+	mat3_transpose_to(inv_rot, rot);
+	const struct AABB local_box = tri_mesh_internal_local_box(inv_rot, b1, b2);
+
+	const u32 *tri;
+	const u32 tri_count = tri_mesh_internal_candidate_triangles(tmp, &tri, result, pipeline, b1, b2, mesh_bvh, &local_box);
+
+	u32 colliding = 0;
+	if (tri_count)
+	{
+		u32 face_max = 0;
+		for (u32 fi = 0; fi < h->f_count; ++fi)
+		{
+			face_max = (face_max < h->f[fi].count) ? h->f[fi].count : face_max;
+		}
+
+		struct tri_hull_input in = 
+		{ 
+			.h = h, 
+			.v = arena_push(tmp, h->v_count * sizeof(vec3)),
+			.f_n = arena_push(tmp, h->f_count * sizeof(vec3)),
+			.edge = arena_push(tmp, h->e_count * sizeof(u32)),
+			.edge_count = 0,
+			.clip = 
+			{ 
+				arena_push(tmp, (face_max + 3) * sizeof(vec3)),
+				arena_push(tmp, (face_max + 3) * sizeof(vec3)),
+			},
+			.ref = arena_push(tmp, face_max * sizeof(vec3)),
+		};
+		const u32 cp_max = face_max + 3;
+		struct tri_contact_point *cp = arena_push(tmp, tri_count * cp_max * sizeof(struct tri_contact_point));
+		if (!in.v || !in.f_n || !in.edge || !in.clip[0] || !in.clip[1] || !in.ref || !cp)
+		{
+			log(T_PHYSICS, S_FATAL, "Out of memory in %s\n", __func__);
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+
+		quat_to_mat3(rot2, b2->rotation);
+		vec3_copy(in.center, b2->position);
+		dcel_vertex_transform(in.v, h, rot2, b2->position);
+
+		vec3 n;
+		for (u32 fi = 0; fi < h->f_count; ++fi)
+		{
+			dcel_face_normal(n, h, fi);
+			mat3_vec_mul(in.f_n[fi], rot2, n);
+		}
+
+		for (u32 ei = 0; ei < h->e_count; ++ei)
+		{
+			if (ei < h->e[ei].twin)
+			{
+				in.edge[in.edge_count++] = ei;
+			}
+		}
+
+		vec3 t[3];
+		u32 cp_count = 0;
+		for (u32 i = 0; i < tri_count; ++i)
+		{
+			tri_mesh_internal_world_triangle(t, mesh_bvh->mesh, tri[i], rot, b1->position);
+			cp_count += tri_hull_contact_points(cp + cp_count, t, &in);
+		}
+
+		colliding = tri_mesh_internal_contact_reduce(&result->manifold, cp, cp_count);
+	}
+
+	if (result->type != COLLISION_SAT_CACHE && colliding)
+	{
+		result->type = COLLISION_CONTACT;
+	}
+
+	arena_pop_record(tmp);
+	return colliding;
 }
 
 /********************************** RAYCAST **********************************/
@@ -2500,6 +3426,7 @@ u32 body_body_contact_manifold(struct arena *tmp, struct collision_result *resul
 
 	/* TODO: Cannot do as above, we must make sure that CM is in correct A->B order,  maybe push this issue up? */
 	u32 collision;	
+	result->sat_query = SAT_CACHE_QUERY_NONE;
 	if (b1->shape_type >= b2->shape_type)  
 	{
 		collision = contact_methods[b1->shape_type][b2->shape_type](tmp, result, pipeline, b1, b2, margin);
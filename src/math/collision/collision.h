@@ -60,6 +60,11 @@ f32 		bvh_cost(const struct bvh *bvh);
 
 #define COST_QUEUE_INITIAL_COUNT 	64 
 
+#define DBVH_OVERLAP_STACK_MAX		256	/* fixed traversal stack size used by overlap workers */
+#define DBVH_OVERLAP_SPLIT_DEPTH	6	/* subtree pairs at depth < SPLIT_DEPTH are split into finer jobs */
+#define DBVH_PARALLEL_LEAF_COUNT_MIN	512	/* below this leaf count the overlap pass runs serially */
+#define DBVH_PARALLEL_TASKS_PER_WORKER	4
+
 //TODO remove
 struct dbvh_overlap
 {
@@ -76,8 +81,24 @@ u32 			dbvh_insert(struct bvh *bvh, const u32 id, const struct AABB *bbox);
 void 			dbvh_remove(struct bvh *bvh, const u32 index);
 /* Return overlapping ids ptr, set to NULL if no overlap. if overlap, count is set */
 struct dbvh_overlap *	dbvh_push_overlap_pairs(struct arena *mem, u32 *count, const struct bvh *bvh);
+/* Same as dbvh_push_overlap_pairs, but the traversal is split into subtree pairs that are distributed over the
+ * task system workers. The result (including the order of pairs) is independent of the worker count. Must be
+ * called from the main thread. */
+struct dbvh_overlap *	dbvh_parallel_push_overlap_pairs(struct arena *mem, u32 *count, const struct bvh *bvh);
+/* push id:s of leaves whose boxes overlap bbox onto mem as a packed u32 array, return number of pushed ids. */
+u32			dbvh_push_bbox_overlaps(struct arena *mem, const struct bvh *bvh, const struct AABB *bbox);
 /* push	id:s of leaves hit by raycast. returns number of hits. -1 == out of memory */
 
+/*
+static bvh
+==========
+Static hierarchy built top-down in one go using binned SAH, with a single box in each leaf. As with the dynamic
+hierarchy, leaves store their external id in bt_left, so the same overlap and raycast routines apply.
+*/
+
+/* (Re)build the heap allocated hierarchy from the given boxes and ids. tmp is used for scratch memory. */
+void			sbvh_build(struct arena *tmp, struct bvh *bvh, const struct AABB *bbox, const u32 *id, const u32 count, const u32 bin_count);
+
 struct tri_mesh_bvh
 {
 	const struct tri_mesh *	mesh;		
@@ -86,8 +107,12 @@ struct tri_mesh_bvh
 	u32			tri_count;	
 };
 
+#define TRI_MESH_BVH_STACK_MAX		128	/* fixed traversal stack size used by tri_mesh_bvh queries */
+
 /* Return non-empty tri_mesh_bvh on success. */
 struct tri_mesh_bvh 	tri_mesh_bvh_construct(struct arena *mem, const struct tri_mesh *mesh, const u32 bin_count);
+/* push indices of triangles whose boxes overlap the (mesh space) bbox onto mem as a packed u32 array, return number of pushed indices. */
+u32			tri_mesh_bvh_push_bbox_overlaps(struct arena *mem, const struct tri_mesh_bvh *mesh_bvh, const struct AABB *bbox);
 /* Return (index, ray hit parameter) on closest hit, or (U32_MAX, F32_INFINITY) on no hit */
 u32f32 			tri_mesh_bvh_raycast(struct arena *tmp, const struct tri_mesh_bvh *mesh_bvh, const struct ray *ray);
 
@@ -216,11 +241,17 @@ struct contact_manifold
 	u32 	i2;
 };
 
+#define SAT_CACHE_TRI_MESH_MAX		8	/* max number of midphase triangles cached for a tri_mesh pair */
+#define SAT_CACHE_TRI_MESH_MARGIN	0.1f	/* fattening of the cached midphase query box */
+#define SAT_CACHE_LINEAR_TOLERANCE	0.02f	/* max relative translation for a cached contact feature to be reused */
+#define SAT_CACHE_ANGULAR_TOLERANCE	0.9998f	/* min |dot| between relative rotations for a cached contact feature to be reused */
+
 enum sat_cache_type
 {
 	SAT_CACHE_SEPARATION,
 	SAT_CACHE_CONTACT_FV,
 	SAT_CACHE_CONTACT_EE,
+	SAT_CACHE_TRI_MESH,
 	SAT_CACHE_COUNT,
 };
 
@@ -235,8 +266,9 @@ struct sat_cache
 	{
 		struct
 		{
-			u32	body;	/* body (0,1) containing face */
-			u32	face;	/* reference face 	      */
+			u32	body;		/* body (0,1) containing face */
+			u32	face;		/* reference face 	      */
+			u32	inc_face;	/* incident face on other body */
 		};
 
 		struct
@@ -250,14 +282,33 @@ struct sat_cache
 			vec3	separation_axis;
 			f32	separation;
 		};
+
+		struct
+		{
+			struct AABB	tri_query;			/* fat mesh space box of the last midphase query */
+			u32		tri_count;			/* triangles overlapping tri_query, > SAT_CACHE_TRI_MESH_MAX if not cached */
+			u32		tri[SAT_CACHE_TRI_MESH_MAX];	/* cached triangle indices */
+		};
 	};
 
+	/* relative transform of body1 in body0's frame when contact feature was last computed */
+	quat	rel_rotation;
+	vec3	rel_position;
+
 	u64	key;
 };
 
+enum sat_cache_query
+{
+	SAT_CACHE_QUERY_NONE,	/* pair not using a sat cache */
+	SAT_CACHE_QUERY_HIT,	/* cached axis or feature reused, full SAT skipped */
+	SAT_CACHE_QUERY_MISS,	/* full SAT ran */
+};
+
 struct collision_result
 {
 	enum collision_result_type	type;
+	enum sat_cache_query		sat_query;
 	struct sat_cache		sat_cache;
 	struct contact_manifold 	manifold;
 };
@@ -20,6 +20,7 @@
 #include <string.h>
 #include "kas_math.h"
 #include "geometry.h"
+#include "math_batch.h"
 #include "hash_map.h"
 #include "array_list.h"
 #include "queue.h"
@@ -729,19 +730,8 @@ struct AABB bbox_union(const struct AABB a, const struct AABB b)
 
 u32 vertex_support(vec3 support, const vec3 dir, const vec3ptr v, const u32 v_count)
 {
-	u32 best = U32_MAX;
-	f32 max_dist = -F32_INFINITY;
-	for (u32 i = 0; i < v_count; ++i)
-	{
-		const f32 dist = vec3_dot(dir, v[i]);
-
-		if (max_dist < dist)
-		{
-			best = i;
-			max_dist = dist;
-		}
-	}
-
+	kas_assert(v_count > 0);
+	const u32 best = vec3_batch_support(v, v_count, dir);
 	vec3_copy(support, v[best]);
 	return best;
 }
@@ -829,11 +819,15 @@ static struct dcel_edge box_edge[] =
 	{ .origin = 7, .twin = 13,  .face_ccw = 5, },
 };
 
+/* box_vertex_edge[i] = first half edge in box_edge with origin i */
+static u32 box_vertex_edge[] = { 0, 1, 2, 3, 5, 6, 10, 14 };
+
 struct dcel dcel_box_stub(void)
 {
 	struct dcel box = 
 	{
 		.v = box_stub_vertex,
+		.v_edge = box_vertex_edge,
 		.e = box_edge,
 		.f = box_face,
 		.e_count = 24,
@@ -860,6 +854,8 @@ struct dcel dcel_box(struct arena *mem, const vec3 hw)
 	struct dcel box = 
 	{
 		.v = box_vertex,
+		.v_soa = arena_push(mem, 3*8*sizeof(f32)),
+		.v_edge = box_vertex_edge,
 		.e = box_edge,
 		.f = box_face,
 		.e_count = 24,
@@ -867,6 +863,11 @@ struct dcel dcel_box(struct arena *mem, const vec3 hw)
 		.f_count = 6,
 	};
 
+	if (box.v_soa)
+	{
+		dcel_vertex_soa_sync(&box);
+	}
+
 	return box; 
 }
 
@@ -1029,25 +1030,97 @@ void capsule_support(vec3 support, const vec3 dir, const struct capsule *cap, ma
 
 u32 dcel_support(vec3 support, const vec3 dir, const struct dcel *dcel, mat3 rot, const vec3 pos)
 {
-	f32 max = -F32_INFINITY;
-	u32 max_index = 0;
-	vec3 p;
-	for (u32 i = 0; i < dcel->v_count; ++i)
-	{
-		mat3_vec_mul(p, rot, dcel->v[i]);
-		const f32 dot = vec3_dot(p, dir);
-		if (max < dot)
-		{
-			max_index = i;
-			max = dot; 
-		}
-	}
+	/* dot(rot*v, dir) = dot(v, transpose(rot)*dir); search the local vertices with the rotated direction */
+	vec3 local_dir;
+	vec3_set(local_dir, vec3_dot(rot[0], dir), vec3_dot(rot[1], dir), vec3_dot(rot[2], dir));
+	const u32 max_index = dcel_vertex_support(dcel, (constvec3ptr) dcel->v, local_dir, 0);
 
 	mat3_vec_mul(support, rot, dcel->v[max_index]);
 	vec3_translate(support, pos);
 	return max_index;
 }
 
+/*
+ * Steepest ascent over the vertex graph. A linear function over a convex polytope has no local maxima
+ * other than the global one, so a vertex without any better neighbour is a support vertex.
+ */
+static u32 dcel_internal_hill_climb(const struct dcel *dcel, constvec3ptr v, const vec3 dir, u32 best)
+{
+	if (best >= dcel->v_count || dcel->v_edge[best] == U32_MAX)
+	{
+		best = dcel->e[0].origin;
+	}
+
+	f32 max = vec3_dot(dir, v[best]);
+	u32 current;
+	do
+	{
+		current = best;
+		const u32 first = dcel->v_edge[current];
+		u32 e = first;
+		do
+		{
+			/* neighbour = twin origin; next outgoing edge of current = next edge of twin in its face */
+			const u32 twin = dcel->e[e].twin;
+			const u32 neighbour = dcel->e[twin].origin;
+			const f32 dot = vec3_dot(dir, v[neighbour]);
+			if (max < dot)
+			{
+				max = dot;
+				best = neighbour;
+			}
+
+			const struct dcel_face *f = dcel->f + dcel->e[twin].face_ccw;
+			e = f->first + ((twin - f->first + 1) % f->count);
+		} while (e != first);
+	} while (best != current);
+
+	return best;
+}
+
+u32 dcel_vertex_support(const struct dcel *dcel, constvec3ptr v, const vec3 dir, const u32 hint)
+{
+	kas_assert(dcel->v_count > 0);
+	if (dcel->v_edge && dcel->v_count >= DCEL_HILL_CLIMB_MIN_VERTEX_COUNT)
+	{
+		return dcel_internal_hill_climb(dcel, v, dir, hint);
+	}
+	else if (dcel->v_soa && v == (constvec3ptr) dcel->v)
+	{
+		const u32 n = dcel->v_count;
+		return vec3_soa_batch_support(dcel->v_soa, dcel->v_soa + n, dcel->v_soa + 2*n, n, dir);
+	}
+
+	return vec3_batch_support((vec3ptr) v, dcel->v_count, dir);
+}
+
+void dcel_vertex_transform(vec3ptr dst, const struct dcel *dcel, mat3 rot, const vec3 pos)
+{
+	if (dcel->v_soa)
+	{
+		const u32 n = dcel->v_count;
+		vec3_soa_batch_transform(dst, dcel->v_soa, dcel->v_soa + n, dcel->v_soa + 2*n, n, rot, pos);
+	}
+	else
+	{
+		vec3_batch_transform(dst, dcel->v, dcel->v_count, rot, pos);
+	}
+}
+
+void dcel_vertex_soa_sync(struct dcel *dcel)
+{
+	if (dcel->v_soa)
+	{
+		const u32 n = dcel->v_count;
+		for (u32 i = 0; i < n; ++i)
+		{
+			dcel->v_soa[0*n + i] = dcel->v[i][0];
+			dcel->v_soa[1*n + i] = dcel->v[i][1];
+			dcel->v_soa[2*n + i] = dcel->v[i][2];
+		}
+	}
+}
+
 struct dcel dcel_empty(void)
 {
 	struct dcel dcel = { 0 };
@@ -1720,6 +1793,8 @@ struct dcel dcel_ddcel(struct arena *mem, const struct ddcel *ddcel)
 	struct dcel cpy =
 	{
 		.v = arena_push_memcpy(mem, ddcel->v, ddcel->v_count*sizeof(vec3)),
+		.v_soa = arena_push(mem, 3*ddcel->v_count*sizeof(f32)),
+		.v_edge = arena_push(mem, ddcel->v_count*sizeof(u32)),
 		.e = arena_push(mem, ddcel->edge_pool.count*sizeof(struct dcel_edge)),
 		.f = arena_push(mem, ddcel->face_pool.count*sizeof(struct dcel_face)),
 		.v_count = ddcel->v_count,
@@ -1728,7 +1803,7 @@ struct dcel dcel_ddcel(struct arena *mem, const struct ddcel *ddcel)
 	};
 
 
-	if (cpy.v && cpy.e && cpy.f)
+	if (cpy.v && cpy.v_soa && cpy.v_edge && cpy.e && cpy.f)
 	{
 		arena_push_record(mem);
 		u32 *emap = arena_push(mem, sizeof(u32) * ddcel->edge_pool.count_max);
@@ -1769,6 +1844,20 @@ struct dcel dcel_ddcel(struct arena *mem, const struct ddcel *ddcel)
 			}
 		}
 
+		/* input points inside the hull are kept in v, but have no half edges */
+		for (u32 i = 0; i < cpy.v_count; ++i)
+		{
+			cpy.v_edge[i] = U32_MAX;
+		}
+		for (u32 i = 0; i < cpy.e_count; ++i)
+		{
+			if (cpy.v_edge[cpy.e[i].origin] == U32_MAX)
+			{
+				cpy.v_edge[cpy.e[i].origin] = i;
+			}
+		}
+		dcel_vertex_soa_sync(&cpy);
+
 		//dcel_print(&cpy);
 		//dcel_assert_topology(&cpy);
 		arena_pop_record(mem);
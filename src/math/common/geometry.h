@@ -263,11 +263,16 @@ struct dcel
 	struct dcel_face *f;		/* f[i] = half-edge of face i */
 	struct dcel_edge *e;
 	vec3ptr	v;
+	f32 *v_soa;			/* x[v_count], y[v_count], z[v_count] copy of v for the batch kernels, or NULL */
+	u32 *v_edge;			/* v_edge[i] = half-edge with origin i, or U32_MAX if i is not on the hull; NULL if not built */
 	u32 f_count;
 	u32 e_count;
 	u32 v_count;
 };
 
+/* hulls with at least this many vertices are searched by hill climbing in dcel_vertex_support */
+#define DCEL_HILL_CLIMB_MIN_VERTEX_COUNT	32
+
 /* return dcel { 0 } */
 struct dcel 	dcel_empty(void);
 /* return dcel box stub */
@@ -278,6 +283,16 @@ struct dcel 	dcel_box(struct arena *mem, const vec3 hw);
 struct dcel 	dcel_convex_hull(struct arena *mem, const vec3ptr v, const u32 v_count, const f32 tol);
 /* Return support of dcel in given direction, and return supporting vertex index */
 u32		dcel_support(vec3 support, const vec3 dir, const struct dcel *hull, mat3 rot, const vec3 pos);
+/* 
+ * Return index of a vertex maximizing dot(dir, v[i]), where v is the dcel's vertices in any affine frame 
+ * (dcel->v or a transformed copy). Large hulls are searched by hill climbing over the vertex adjacency 
+ * starting at vertex hint (e.g. the previous support), small hulls by a linear batch scan.
+ */
+u32		dcel_vertex_support(const struct dcel *dcel, constvec3ptr v, const vec3 dir, const u32 hint);
+/* dst[i] = rot*dcel->v[i] + pos */
+void		dcel_vertex_transform(vec3ptr dst, const struct dcel *dcel, mat3 rot, const vec3 pos);
+/* rewrite dcel->v_soa from dcel->v; must be called after modifying dcel->v in place */
+void		dcel_vertex_soa_sync(struct dcel *dcel);
 
 /* TODO: document, go through ... */
 void 		dcel_face_direction(vec3 dir, const struct dcel *h, const u32 fi); /* not normalized */
@@ -0,0 +1,510 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+#include "math_batch.h"
+
+const char *math_isa_cstr[MATH_ISA_COUNT] =
+{
+	"scalar",
+	"sse4.1",
+	"avx2",
+	"simd128",
+};
+
+enum math_isa g_math_isa = MATH_ISA_SCALAR;
+
+void 	(*vec3_batch_transform)(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation) = vec3_batch_transform_scalar;
+void 	(*vec3_batch_bounds)(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot) = vec3_batch_bounds_scalar;
+u32 	(*vec3_batch_support)(const vec3ptr v, const u32 count, const vec3 dir) = vec3_batch_support_scalar;
+void 	(*quat_batch_integrate)(quatptr q, const vec3ptr w, const u32 count, const f32 timestep) = quat_batch_integrate_scalar;
+void 	(*vec3_soa_batch_transform)(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation) = vec3_soa_batch_transform_scalar;
+u32 	(*vec3_soa_batch_support)(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir) = vec3_soa_batch_support_scalar;
+
+u32 math_isa_compiled(const enum math_isa isa)
+{
+	switch (isa)
+	{
+		case MATH_ISA_SCALAR: { return 1; }
+#if defined(KAS_MATH_BATCH_X86)
+		case MATH_ISA_SSE4_1: { return 1; }
+		case MATH_ISA_AVX2: { return 1; }
+#endif
+#if defined(__wasm_simd128__)
+		case MATH_ISA_SIMD128: { return 1; }
+#endif
+		default: { return 0; }
+	}
+}
+
+u32 math_batch_init(const enum math_isa isa)
+{
+	switch (isa)
+	{
+		case MATH_ISA_SCALAR:
+		{
+			vec3_batch_transform = vec3_batch_transform_scalar;
+			vec3_batch_bounds = vec3_batch_bounds_scalar;
+			vec3_batch_support = vec3_batch_support_scalar;
+			quat_batch_integrate = quat_batch_integrate_scalar;
+			vec3_soa_batch_transform = vec3_soa_batch_transform_scalar;
+			vec3_soa_batch_support = vec3_soa_batch_support_scalar;
+		} break;
+
+#if defined(KAS_MATH_BATCH_X86)
+		case MATH_ISA_SSE4_1:
+		{
+			vec3_batch_transform = vec3_batch_transform_sse4_1;
+			vec3_batch_bounds = vec3_batch_bounds_sse4_1;
+			vec3_batch_support = vec3_batch_support_sse4_1;
+			quat_batch_integrate = quat_batch_integrate_sse4_1;
+			vec3_soa_batch_transform = vec3_soa_batch_transform_sse4_1;
+			vec3_soa_batch_support = vec3_soa_batch_support_sse4_1;
+		} break;
+
+		case MATH_ISA_AVX2:
+		{
+			vec3_batch_transform = vec3_batch_transform_avx2;
+			vec3_batch_bounds = vec3_batch_bounds_avx2;
+			vec3_batch_support = vec3_batch_support_avx2;
+			quat_batch_integrate = quat_batch_integrate_avx2;
+			vec3_soa_batch_transform = vec3_soa_batch_transform_avx2;
+			vec3_soa_batch_support = vec3_soa_batch_support_avx2;
+		} break;
+#endif
+
+#if defined(__wasm_simd128__)
+		case MATH_ISA_SIMD128:
+		{
+			vec3_batch_transform = vec3_batch_transform_simd128;
+			vec3_batch_bounds = vec3_batch_bounds_simd128;
+			vec3_batch_support = vec3_batch_support_simd128;
+			quat_batch_integrate = quat_batch_integrate_simd128;
+			vec3_soa_batch_transform = vec3_soa_batch_transform_simd128;
+			vec3_soa_batch_support = vec3_soa_batch_support_simd128;
+		} break;
+#endif
+
+		default:
+		{
+			return 0;
+		} break;
+	}
+
+	g_math_isa = isa;
+	return 1;
+}
+
+void vec3_batch_transform_scalar(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		const f32 x = src[i][0];
+		const f32 y = src[i][1];
+		const f32 z = src[i][2];
+		dst[i][0] = (x * rot[0][0] + y * rot[1][0] + z * rot[2][0]) + translation[0];
+		dst[i][1] = (x * rot[0][1] + y * rot[1][1] + z * rot[2][1]) + translation[1];
+		dst[i][2] = (x * rot[0][2] + y * rot[1][2] + z * rot[2][2]) + translation[2];
+	}
+}
+
+void vec3_batch_bounds_scalar(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot)
+{
+	vec3_set(min, F32_INFINITY, F32_INFINITY, F32_INFINITY);
+	vec3_set(max, -F32_INFINITY, -F32_INFINITY, -F32_INFINITY);
+	for (u32 i = 0; i < count; ++i)
+	{
+		const f32 x = v[i][0];
+		const f32 y = v[i][1];
+		const f32 z = v[i][2];
+		const f32 rx = x * rot[0][0] + y * rot[1][0] + z * rot[2][0];
+		const f32 ry = x * rot[0][1] + y * rot[1][1] + z * rot[2][1];
+		const f32 rz = x * rot[0][2] + y * rot[1][2] + z * rot[2][2];
+		min[0] = f32_min(min[0], rx);
+		min[1] = f32_min(min[1], ry);
+		min[2] = f32_min(min[2], rz);
+		max[0] = f32_max(max[0], rx);
+		max[1] = f32_max(max[1], ry);
+		max[2] = f32_max(max[2], rz);
+	}
+}
+
+u32 vec3_batch_support_scalar(const vec3ptr v, const u32 count, const vec3 dir)
+{
+	u32 best = 0;
+	f32 max = -F32_INFINITY;
+	for (u32 i = 0; i < count; ++i)
+	{
+		const f32 d = dir[0] * v[i][0] + dir[1] * v[i][1] + dir[2] * v[i][2];
+		if (max < d)
+		{
+			max = d;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+u32 vec3_batch_support_reduce(const f32 *lane_max, const u32 *lane_best, const u32 lane_count, const vec3ptr v, const u32 i, const u32 count, const vec3 dir)
+{
+	/* each lane holds its first maximum; the first global maximum is the lowest index among tied lanes */
+	u32 best = lane_best[0];
+	f32 max = lane_max[0];
+	for (u32 l = 1; l < lane_count; ++l)
+	{
+		if (max < lane_max[l] || (max == lane_max[l] && lane_best[l] < best))
+		{
+			max = lane_max[l];
+			best = lane_best[l];
+		}
+	}
+
+	for (u32 j = i; j < count; ++j)
+	{
+		const f32 d = dir[0] * v[j][0] + dir[1] * v[j][1] + dir[2] * v[j][2];
+		if (max < d)
+		{
+			max = d;
+			best = j;
+		}
+	}
+
+	return best;
+}
+
+void vec3_soa_batch_transform_scalar(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		dst[i][0] = (x[i] * rot[0][0] + y[i] * rot[1][0] + z[i] * rot[2][0]) + translation[0];
+		dst[i][1] = (x[i] * rot[0][1] + y[i] * rot[1][1] + z[i] * rot[2][1]) + translation[1];
+		dst[i][2] = (x[i] * rot[0][2] + y[i] * rot[1][2] + z[i] * rot[2][2]) + translation[2];
+	}
+}
+
+u32 vec3_soa_batch_support_scalar(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir)
+{
+	const f32 lane_max = -F32_INFINITY;
+	const u32 lane_best = 0;
+	return vec3_soa_batch_support_reduce(&lane_max, &lane_best, 1, x, y, z, 0, count, dir);
+}
+
+u32 vec3_soa_batch_support_reduce(const f32 *lane_max, const u32 *lane_best, const u32 lane_count, const f32 *x, const f32 *y, const f32 *z, const u32 i, const u32 count, const vec3 dir)
+{
+	u32 best = lane_best[0];
+	f32 max = lane_max[0];
+	for (u32 l = 1; l < lane_count; ++l)
+	{
+		if (max < lane_max[l] || (max == lane_max[l] && lane_best[l] < best))
+		{
+			max = lane_max[l];
+			best = lane_best[l];
+		}
+	}
+
+	for (u32 j = i; j < count; ++j)
+	{
+		const f32 d = dir[0] * x[j] + dir[1] * y[j] + dir[2] * z[j];
+		if (max < d)
+		{
+			max = d;
+			best = j;
+		}
+	}
+
+	return best;
+}
+
+void quat_batch_integrate_scalar(quatptr q, const vec3ptr w, const u32 count, const f32 timestep)
+{
+	/* q += (timestep/2) * (w,0)*q, followed by a renormalization; same operations as quat_mult, quat_scale, ... */
+	const f32 h = timestep / 2.0f;
+	const f32 w3 = 0.0f;
+	for (u32 i = 0; i < count; ++i)
+	{
+		const f32 w0 = w[i][0];
+		const f32 w1 = w[i][1];
+		const f32 w2 = w[i][2];
+		const f32 q0 = q[i][0];
+		const f32 q1 = q[i][1];
+		const f32 q2 = q[i][2];
+		const f32 q3 = q[i][3];
+
+		const f32 x = q0 + (w0 * q3 + w3 * q0 + w1 * q2 - w2 * q1) * h;
+		const f32 y = q1 + (w1 * q3 + w3 * q1 + w2 * q0 - w0 * q2) * h;
+		const f32 z = q2 + (w2 * q3 + w3 * q2 + w0 * q1 - w1 * q0) * h;
+		const f32 s = q3 + (w3 * q3 - w0 * q0 - w1 * q1 - w2 * q2) * h;
+
+		const f32 inv = 1.0f / f32_sqrt(x * x + y * y + z * z + s * s);
+		q[i][0] = x * inv;
+		q[i][1] = y * inv;
+		q[i][2] = z * inv;
+		q[i][3] = s * inv;
+	}
+}
+
+#if defined(__wasm_simd128__)
+
+#include <wasm_simd128.h>
+
+/* 4 consecutive vec3 => x, y, z lanes */
+static inline void simd128_load_vec3x4(v128_t *x, v128_t *y, v128_t *z, const f32 *p)
+{
+	const v128_t m0 = wasm_v128_load(p + 0);	/* x0 y0 z0 x1 */
+	const v128_t m1 = wasm_v128_load(p + 4);	/* y1 z1 x2 y2 */
+	const v128_t m2 = wasm_v128_load(p + 8);	/* z2 x3 y3 z3 */
+	*x = wasm_i32x4_shuffle(wasm_i32x4_shuffle(m0, m1, 0, 3, 6, 0), m2, 0, 1, 2, 5);
+	*y = wasm_i32x4_shuffle(wasm_i32x4_shuffle(m0, m1, 1, 4, 7, 0), m2, 0, 1, 2, 6);
+	*z = wasm_i32x4_shuffle(wasm_i32x4_shuffle(m0, m1, 2, 5, 0, 0), m2, 0, 1, 4, 7);
+}
+
+/* x, y, z lanes => 4 consecutive vec3 */
+static inline void simd128_store_vec3x4(f32 *p, const v128_t x, const v128_t y, const v128_t z)
+{
+	const v128_t xy_lo = wasm_i32x4_shuffle(x, y, 0, 4, 1, 5);	/* x0 y0 x1 y1 */
+	const v128_t m0 = wasm_i32x4_shuffle(xy_lo, z, 0, 1, 4, 2);	/* x0 y0 z0 x1 */
+	const v128_t m1 = wasm_i32x4_shuffle(y, z, 1, 5, 0, 0);		/* y1 z1 -- -- */
+	const v128_t xy_hi = wasm_i32x4_shuffle(x, y, 2, 6, 3, 7);	/* x2 y2 x3 y3 */
+	wasm_v128_store(p + 0, m0);
+	wasm_v128_store(p + 4, wasm_i32x4_shuffle(m1, xy_hi, 0, 1, 4, 5));
+	wasm_v128_store(p + 8, wasm_i32x4_shuffle(z, xy_hi, 2, 6, 7, 3));
+}
+
+void vec3_batch_transform_simd128(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation)
+{
+	const v128_t r00 = wasm_f32x4_splat(rot[0][0]);
+	const v128_t r01 = wasm_f32x4_splat(rot[0][1]);
+	const v128_t r02 = wasm_f32x4_splat(rot[0][2]);
+	const v128_t r10 = wasm_f32x4_splat(rot[1][0]);
+	const v128_t r11 = wasm_f32x4_splat(rot[1][1]);
+	const v128_t r12 = wasm_f32x4_splat(rot[1][2]);
+	const v128_t r20 = wasm_f32x4_splat(rot[2][0]);
+	const v128_t r21 = wasm_f32x4_splat(rot[2][1]);
+	const v128_t r22 = wasm_f32x4_splat(rot[2][2]);
+	const v128_t tx = wasm_f32x4_splat(translation[0]);
+	const v128_t ty = wasm_f32x4_splat(translation[1]);
+	const v128_t tz = wasm_f32x4_splat(translation[2]);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		v128_t x, y, z;
+		simd128_load_vec3x4(&x, &y, &z, src[i]);
+		const v128_t rx = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(x, r00), wasm_f32x4_mul(y, r10)), wasm_f32x4_mul(z, r20)), tx);
+		const v128_t ry = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(x, r01), wasm_f32x4_mul(y, r11)), wasm_f32x4_mul(z, r21)), ty);
+		const v128_t rz = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(x, r02), wasm_f32x4_mul(y, r12)), wasm_f32x4_mul(z, r22)), tz);
+		simd128_store_vec3x4(dst[i], rx, ry, rz);
+	}
+
+	vec3_batch_transform_scalar(dst + i, src + i, count - i, rot, translation);
+}
+
+void vec3_batch_bounds_simd128(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot)
+{
+	const v128_t r00 = wasm_f32x4_splat(rot[0][0]);
+	const v128_t r01 = wasm_f32x4_splat(rot[0][1]);
+	const v128_t r02 = wasm_f32x4_splat(rot[0][2]);
+	const v128_t r10 = wasm_f32x4_splat(rot[1][0]);
+	const v128_t r11 = wasm_f32x4_splat(rot[1][1]);
+	const v128_t r12 = wasm_f32x4_splat(rot[1][2]);
+	const v128_t r20 = wasm_f32x4_splat(rot[2][0]);
+	const v128_t r21 = wasm_f32x4_splat(rot[2][1]);
+	const v128_t r22 = wasm_f32x4_splat(rot[2][2]);
+
+	v128_t min_x = wasm_f32x4_splat(F32_INFINITY);
+	v128_t min_y = min_x;
+	v128_t min_z = min_x;
+	v128_t max_x = wasm_f32x4_splat(-F32_INFINITY);
+	v128_t max_y = max_x;
+	v128_t max_z = max_x;
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		v128_t x, y, z;
+		simd128_load_vec3x4(&x, &y, &z, v[i]);
+		const v128_t rx = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(x, r00), wasm_f32x4_mul(y, r10)), wasm_f32x4_mul(z, r20));
+		const v128_t ry = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(x, r01), wasm_f32x4_mul(y, r11)), wasm_f32x4_mul(z, r21));
+		const v128_t rz = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(x, r02), wasm_f32x4_mul(y, r12)), wasm_f32x4_mul(z, r22));
+		min_x = wasm_f32x4_pmin(rx, min_x);
+		min_y = wasm_f32x4_pmin(ry, min_y);
+		min_z = wasm_f32x4_pmin(rz, min_z);
+		max_x = wasm_f32x4_pmax(rx, max_x);
+		max_y = wasm_f32x4_pmax(ry, max_y);
+		max_z = wasm_f32x4_pmax(rz, max_z);
+	}
+
+	vec3 tail_min, tail_max;
+	vec3_batch_bounds_scalar(tail_min, tail_max, v + i, count - i, rot);
+	f32 lane[3][2][4];
+	wasm_v128_store(lane[0][0], min_x);
+	wasm_v128_store(lane[1][0], min_y);
+	wasm_v128_store(lane[2][0], min_z);
+	wasm_v128_store(lane[0][1], max_x);
+	wasm_v128_store(lane[1][1], max_y);
+	wasm_v128_store(lane[2][1], max_z);
+	for (u32 c = 0; c < 3; ++c)
+	{
+		min[c] = f32_min(f32_min(lane[c][0][0], lane[c][0][1]), f32_min(lane[c][0][2], lane[c][0][3]));
+		max[c] = f32_max(f32_max(lane[c][1][0], lane[c][1][1]), f32_max(lane[c][1][2], lane[c][1][3]));
+		min[c] = f32_min(min[c], tail_min[c]);
+		max[c] = f32_max(max[c], tail_max[c]);
+	}
+}
+
+u32 vec3_batch_support_simd128(const vec3ptr v, const u32 count, const vec3 dir)
+{
+	const v128_t dx = wasm_f32x4_splat(dir[0]);
+	const v128_t dy = wasm_f32x4_splat(dir[1]);
+	const v128_t dz = wasm_f32x4_splat(dir[2]);
+	const v128_t four = wasm_i32x4_splat(4);
+
+	v128_t max = wasm_f32x4_splat(-F32_INFINITY);
+	v128_t best = wasm_i32x4_splat(0);
+	v128_t index = wasm_i32x4_make(0, 1, 2, 3);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		v128_t x, y, z;
+		simd128_load_vec3x4(&x, &y, &z, v[i]);
+		const v128_t d = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(dx, x), wasm_f32x4_mul(dy, y)), wasm_f32x4_mul(dz, z));
+		const v128_t greater = wasm_f32x4_lt(max, d);
+		max = wasm_v128_bitselect(d, max, greater);
+		best = wasm_v128_bitselect(index, best, greater);
+		index = wasm_i32x4_add(index, four);
+	}
+
+	f32 lane_max[4];
+	u32 lane_best[4];
+	wasm_v128_store(lane_max, max);
+	wasm_v128_store(lane_best, best);
+	return vec3_batch_support_reduce(lane_max, lane_best, 4, v, i, count, dir);
+}
+
+void quat_batch_integrate_simd128(quatptr q, const vec3ptr w, const u32 count, const f32 timestep)
+{
+	const v128_t h = wasm_f32x4_splat(timestep / 2.0f);
+	const v128_t w3 = wasm_f32x4_splat(0.0f);
+	const v128_t one = wasm_f32x4_splat(1.0f);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		v128_t w0, w1, w2;
+		simd128_load_vec3x4(&w0, &w1, &w2, w[i]);
+
+		/* 4x4 transpose of the quaternions */
+		const v128_t a = wasm_v128_load(q[i + 0]);
+		const v128_t b = wasm_v128_load(q[i + 1]);
+		const v128_t c = wasm_v128_load(q[i + 2]);
+		const v128_t d = wasm_v128_load(q[i + 3]);
+		const v128_t ab_lo = wasm_i32x4_shuffle(a, b, 0, 4, 1, 5);
+		const v128_t ab_hi = wasm_i32x4_shuffle(a, b, 2, 6, 3, 7);
+		const v128_t cd_lo = wasm_i32x4_shuffle(c, d, 0, 4, 1, 5);
+		const v128_t cd_hi = wasm_i32x4_shuffle(c, d, 2, 6, 3, 7);
+		const v128_t q0 = wasm_i32x4_shuffle(ab_lo, cd_lo, 0, 1, 4, 5);
+		const v128_t q1 = wasm_i32x4_shuffle(ab_lo, cd_lo, 2, 3, 6, 7);
+		const v128_t q2 = wasm_i32x4_shuffle(ab_hi, cd_hi, 0, 1, 4, 5);
+		const v128_t q3 = wasm_i32x4_shuffle(ab_hi, cd_hi, 2, 3, 6, 7);
+
+		const v128_t x = wasm_f32x4_add(q0, wasm_f32x4_mul(wasm_f32x4_sub(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(w0, q3), wasm_f32x4_mul(w3, q0)), wasm_f32x4_mul(w1, q2)), wasm_f32x4_mul(w2, q1)), h));
+		const v128_t y = wasm_f32x4_add(q1, wasm_f32x4_mul(wasm_f32x4_sub(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(w1, q3), wasm_f32x4_mul(w3, q1)), wasm_f32x4_mul(w2, q0)), wasm_f32x4_mul(w0, q2)), h));
+		const v128_t z = wasm_f32x4_add(q2, wasm_f32x4_mul(wasm_f32x4_sub(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(w2, q3), wasm_f32x4_mul(w3, q2)), wasm_f32x4_mul(w0, q1)), wasm_f32x4_mul(w1, q0)), h));
+		const v128_t s = wasm_f32x4_add(q3, wasm_f32x4_mul(wasm_f32x4_sub(wasm_f32x4_sub(wasm_f32x4_sub(wasm_f32x4_mul(w3, q3), wasm_f32x4_mul(w0, q0)), wasm_f32x4_mul(w1, q1)), wasm_f32x4_mul(w2, q2)), h));
+
+		const v128_t norm = wasm_f32x4_sqrt(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(x, x), wasm_f32x4_mul(y, y)), wasm_f32x4_mul(z, z)), wasm_f32x4_mul(s, s)));
+		const v128_t inv = wasm_f32x4_div(one, norm);
+		const v128_t nx = wasm_f32x4_mul(x, inv);
+		const v128_t ny = wasm_f32x4_mul(y, inv);
+		const v128_t nz = wasm_f32x4_mul(z, inv);
+		const v128_t ns = wasm_f32x4_mul(s, inv);
+
+		const v128_t xy_lo = wasm_i32x4_shuffle(nx, ny, 0, 4, 1, 5);
+		const v128_t xy_hi = wasm_i32x4_shuffle(nx, ny, 2, 6, 3, 7);
+		const v128_t zs_lo = wasm_i32x4_shuffle(nz, ns, 0, 4, 1, 5);
+		const v128_t zs_hi = wasm_i32x4_shuffle(nz, ns, 2, 6, 3, 7);
+		wasm_v128_store(q[i + 0], wasm_i32x4_shuffle(xy_lo, zs_lo, 0, 1, 4, 5));
+		wasm_v128_store(q[i + 1], wasm_i32x4_shuffle(xy_lo, zs_lo, 2, 3, 6, 7));
+		wasm_v128_store(q[i + 2], wasm_i32x4_shuffle(xy_hi, zs_hi, 0, 1, 4, 5));
+		wasm_v128_store(q[i + 3], wasm_i32x4_shuffle(xy_hi, zs_hi, 2, 3, 6, 7));
+	}
+
+	quat_batch_integrate_scalar(q + i, w + i, count - i, timestep);
+}
+
+void vec3_soa_batch_transform_simd128(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation)
+{
+	const v128_t r00 = wasm_f32x4_splat(rot[0][0]);
+	const v128_t r01 = wasm_f32x4_splat(rot[0][1]);
+	const v128_t r02 = wasm_f32x4_splat(rot[0][2]);
+	const v128_t r10 = wasm_f32x4_splat(rot[1][0]);
+	const v128_t r11 = wasm_f32x4_splat(rot[1][1]);
+	const v128_t r12 = wasm_f32x4_splat(rot[1][2]);
+	const v128_t r20 = wasm_f32x4_splat(rot[2][0]);
+	const v128_t r21 = wasm_f32x4_splat(rot[2][1]);
+	const v128_t r22 = wasm_f32x4_splat(rot[2][2]);
+	const v128_t tx = wasm_f32x4_splat(translation[0]);
+	const v128_t ty = wasm_f32x4_splat(translation[1]);
+	const v128_t tz = wasm_f32x4_splat(translation[2]);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const v128_t vx = wasm_v128_load(x + i);
+		const v128_t vy = wasm_v128_load(y + i);
+		const v128_t vz = wasm_v128_load(z + i);
+		const v128_t rx = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(vx, r00), wasm_f32x4_mul(vy, r10)), wasm_f32x4_mul(vz, r20)), tx);
+		const v128_t ry = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(vx, r01), wasm_f32x4_mul(vy, r11)), wasm_f32x4_mul(vz, r21)), ty);
+		const v128_t rz = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(vx, r02), wasm_f32x4_mul(vy, r12)), wasm_f32x4_mul(vz, r22)), tz);
+		simd128_store_vec3x4(dst[i], rx, ry, rz);
+	}
+
+	vec3_soa_batch_transform_scalar(dst + i, x + i, y + i, z + i, count - i, rot, translation);
+}
+
+u32 vec3_soa_batch_support_simd128(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir)
+{
+	const v128_t dx = wasm_f32x4_splat(dir[0]);
+	const v128_t dy = wasm_f32x4_splat(dir[1]);
+	const v128_t dz = wasm_f32x4_splat(dir[2]);
+	const v128_t four = wasm_i32x4_splat(4);
+
+	v128_t max = wasm_f32x4_splat(-F32_INFINITY);
+	v128_t best = wasm_i32x4_splat(0);
+	v128_t index = wasm_i32x4_make(0, 1, 2, 3);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const v128_t d = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(dx, wasm_v128_load(x + i)), wasm_f32x4_mul(dy, wasm_v128_load(y + i))), wasm_f32x4_mul(dz, wasm_v128_load(z + i)));
+		const v128_t greater = wasm_f32x4_lt(max, d);
+		max = wasm_v128_bitselect(d, max, greater);
+		best = wasm_v128_bitselect(index, best, greater);
+		index = wasm_i32x4_add(index, four);
+	}
+
+	f32 lane_max[4];
+	u32 lane_best[4];
+	wasm_v128_store(lane_max, max);
+	wasm_v128_store(lane_best, best);
+	return vec3_soa_batch_support_reduce(lane_max, lane_best, 4, x, y, z, i, count, dir);
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+#ifndef __MATH_BATCH_H__
+#define __MATH_BATCH_H__
+
+#include "kas_math.h"
+
+/**
+ * Batch math kernels: operations over arrays of vec3/quat, with one implementation per instruction set.
+ * The kernels are called through function pointers that default to the scalar implementation and are
+ * replaced at startup by math_batch_init (system_resources_init picks the best isa from g_arch_config).
+ *
+ * Every implementation performs the same float operations in the same order as the scalar kernel
+ * (no fused multiply-add), so results are bit-identical between instruction sets, which keeps the
+ * physics deterministic regardless of which machine ran it.
+ */
+
+enum math_isa
+{
+	MATH_ISA_SCALAR,
+	MATH_ISA_SSE4_1,	/* x86, 4 lanes */
+	MATH_ISA_AVX2,		/* x86, 8 lanes */
+	MATH_ISA_SIMD128,	/* web builds compiled with -msimd128, 4 lanes */
+	MATH_ISA_COUNT
+};
+
+extern const char *math_isa_cstr[MATH_ISA_COUNT];
+/* isa of the currently selected kernels */
+extern enum math_isa g_math_isa;
+
+/* Return 1 if the isa was compiled into this build, otherwise 0 */
+u32	math_isa_compiled(const enum math_isa isa);
+/* select the kernels of the given isa. Returns 1 on success, or 0 (keeping the current kernels) if the
+ * isa was not compiled into this build. The caller is responsible for the isa being supported by the cpu. */
+u32	math_batch_init(const enum math_isa isa);
+
+/* dst[i] = rot*src[i] + translation, dst may alias src */
+extern void	(*vec3_batch_transform)(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation);
+/* min/max = componentwise bounds of { rot*v[i] }, count > 0 */
+extern void	(*vec3_batch_bounds)(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot);
+/* Return index of the first vertex maximizing dot(dir, v[i]), count > 0 */
+extern u32	(*vec3_batch_support)(const vec3ptr v, const u32 count, const vec3 dir);
+/* dst[i] = rot*(x[i], y[i], z[i]) + translation, vertices in SoA layout, AoS output */
+extern void	(*vec3_soa_batch_transform)(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation);
+/* Return index of the first vertex maximizing dot(dir, (x[i], y[i], z[i])), count > 0 */
+extern u32	(*vec3_soa_batch_support)(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir);
+/* explicit euler integration of unit quaternions q[i] with angular velocities w[i], renormalizing the result */
+extern void	(*quat_batch_integrate)(quatptr q, const vec3ptr w, const u32 count, const f32 timestep);
+
+/********************************** INTERNAL **********************************/
+
+void 	vec3_batch_transform_scalar(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation);
+void 	vec3_batch_bounds_scalar(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot);
+u32 	vec3_batch_support_scalar(const vec3ptr v, const u32 count, const vec3 dir);
+void 	quat_batch_integrate_scalar(quatptr q, const vec3ptr w, const u32 count, const f32 timestep);
+void 	vec3_soa_batch_transform_scalar(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation);
+u32 	vec3_soa_batch_support_scalar(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir);
+/* reduce per-lane (first maximum, index) pairs of v[0..i) and continue the search over the tail v[i..count) */
+u32	vec3_batch_support_reduce(const f32 *lane_max, const u32 *lane_best, const u32 lane_count, const vec3ptr v, const u32 i, const u32 count, const vec3 dir);
+u32	vec3_soa_batch_support_reduce(const f32 *lane_max, const u32 *lane_best, const u32 lane_count, const f32 *x, const f32 *y, const f32 *z, const u32 i, const u32 count, const vec3 dir);
+
+#if defined(KAS_MATH_BATCH_X86)
+void 	vec3_batch_transform_sse4_1(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation);
+void 	vec3_batch_bounds_sse4_1(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot);
+u32 	vec3_batch_support_sse4_1(const vec3ptr v, const u32 count, const vec3 dir);
+void 	quat_batch_integrate_sse4_1(quatptr q, const vec3ptr w, const u32 count, const f32 timestep);
+void 	vec3_soa_batch_transform_sse4_1(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation);
+u32 	vec3_soa_batch_support_sse4_1(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir);
+
+void 	vec3_batch_transform_avx2(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation);
+void 	vec3_batch_bounds_avx2(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot);
+u32 	vec3_batch_support_avx2(const vec3ptr v, const u32 count, const vec3 dir);
+void 	quat_batch_integrate_avx2(quatptr q, const vec3ptr w, const u32 count, const f32 timestep);
+void 	vec3_soa_batch_transform_avx2(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation);
+u32 	vec3_soa_batch_support_avx2(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir);
+#endif
+
+#if defined(__wasm_simd128__)
+void 	vec3_batch_transform_simd128(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation);
+void 	vec3_batch_bounds_simd128(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot);
+u32 	vec3_batch_support_simd128(const vec3ptr v, const u32 count, const vec3 dir);
+void 	quat_batch_integrate_simd128(quatptr q, const vec3ptr w, const u32 count, const f32 timestep);
+void 	vec3_soa_batch_transform_simd128(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation);
+u32 	vec3_soa_batch_support_simd128(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir);
+#endif
+
+#endif
@@ -0,0 +1,290 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+/* compiled with -mavx2 (see CMakeLists.txt); only called if the cpu supports avx2. FMA is deliberately
+ * not enabled, contracting a*b + c would break bit-equality with the other kernels. */
+
+#include <immintrin.h>
+#include "math_batch.h"
+
+/* 8 consecutive vec3 => x, y, z lanes; each 128-bit half is transposed as in the sse kernels */
+static inline void avx_load_vec3x8(__m256 *x, __m256 *y, __m256 *z, const f32 *p)
+{
+	const __m256 m03 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 0)), _mm_loadu_ps(p + 12), 1);
+	const __m256 m14 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+	const __m256 m25 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+	const __m256 xy = _mm256_shuffle_ps(m14, m25, _MM_SHUFFLE(2, 1, 3, 2));
+	const __m256 yz = _mm256_shuffle_ps(m03, m14, _MM_SHUFFLE(1, 0, 2, 1));
+	*x = _mm256_shuffle_ps(m03, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	*y = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	*z = _mm256_shuffle_ps(yz, m25, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+/* x, y, z lanes => 8 consecutive vec3 */
+static inline void avx_store_vec3x8(f32 *p, const __m256 x, const __m256 y, const __m256 z)
+{
+	const __m256 xy = _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));
+	const __m256 yz = _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));
+	const __m256 zx = _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));
+	const __m256 m03 = _mm256_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));
+	const __m256 m14 = _mm256_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	const __m256 m25 = _mm256_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));
+	_mm_storeu_ps(p + 0, _mm256_castps256_ps128(m03));
+	_mm_storeu_ps(p + 4, _mm256_castps256_ps128(m14));
+	_mm_storeu_ps(p + 8, _mm256_castps256_ps128(m25));
+	_mm_storeu_ps(p + 12, _mm256_extractf128_ps(m03, 1));
+	_mm_storeu_ps(p + 16, _mm256_extractf128_ps(m14, 1));
+	_mm_storeu_ps(p + 20, _mm256_extractf128_ps(m25, 1));
+}
+
+/* transpose the 4x4 blocks held in each 128-bit half */
+static inline void avx_transpose4x4x2(__m256 *a, __m256 *b, __m256 *c, __m256 *d)
+{
+	const __m256 t0 = _mm256_unpacklo_ps(*a, *b);
+	const __m256 t1 = _mm256_unpacklo_ps(*c, *d);
+	const __m256 t2 = _mm256_unpackhi_ps(*a, *b);
+	const __m256 t3 = _mm256_unpackhi_ps(*c, *d);
+	*a = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	*b = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	*c = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	*d = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+void vec3_batch_transform_avx2(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation)
+{
+	const __m256 r00 = _mm256_set1_ps(rot[0][0]);
+	const __m256 r01 = _mm256_set1_ps(rot[0][1]);
+	const __m256 r02 = _mm256_set1_ps(rot[0][2]);
+	const __m256 r10 = _mm256_set1_ps(rot[1][0]);
+	const __m256 r11 = _mm256_set1_ps(rot[1][1]);
+	const __m256 r12 = _mm256_set1_ps(rot[1][2]);
+	const __m256 r20 = _mm256_set1_ps(rot[2][0]);
+	const __m256 r21 = _mm256_set1_ps(rot[2][1]);
+	const __m256 r22 = _mm256_set1_ps(rot[2][2]);
+	const __m256 tx = _mm256_set1_ps(translation[0]);
+	const __m256 ty = _mm256_set1_ps(translation[1]);
+	const __m256 tz = _mm256_set1_ps(translation[2]);
+
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x, y, z;
+		avx_load_vec3x8(&x, &y, &z, src[i]);
+		const __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, r00), _mm256_mul_ps(y, r10)), _mm256_mul_ps(z, r20)), tx);
+		const __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, r01), _mm256_mul_ps(y, r11)), _mm256_mul_ps(z, r21)), ty);
+		const __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, r02), _mm256_mul_ps(y, r12)), _mm256_mul_ps(z, r22)), tz);
+		avx_store_vec3x8(dst[i], rx, ry, rz);
+	}
+
+	vec3_batch_transform_scalar(dst + i, src + i, count - i, rot, translation);
+}
+
+void vec3_batch_bounds_avx2(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot)
+{
+	const __m256 r00 = _mm256_set1_ps(rot[0][0]);
+	const __m256 r01 = _mm256_set1_ps(rot[0][1]);
+	const __m256 r02 = _mm256_set1_ps(rot[0][2]);
+	const __m256 r10 = _mm256_set1_ps(rot[1][0]);
+	const __m256 r11 = _mm256_set1_ps(rot[1][1]);
+	const __m256 r12 = _mm256_set1_ps(rot[1][2]);
+	const __m256 r20 = _mm256_set1_ps(rot[2][0]);
+	const __m256 r21 = _mm256_set1_ps(rot[2][1]);
+	const __m256 r22 = _mm256_set1_ps(rot[2][2]);
+
+	__m256 min_x = _mm256_set1_ps(F32_INFINITY);
+	__m256 min_y = min_x;
+	__m256 min_z = min_x;
+	__m256 max_x = _mm256_set1_ps(-F32_INFINITY);
+	__m256 max_y = max_x;
+	__m256 max_z = max_x;
+
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x, y, z;
+		avx_load_vec3x8(&x, &y, &z, v[i]);
+		const __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, r00), _mm256_mul_ps(y, r10)), _mm256_mul_ps(z, r20));
+		const __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, r01), _mm256_mul_ps(y, r11)), _mm256_mul_ps(z, r21));
+		const __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, r02), _mm256_mul_ps(y, r12)), _mm256_mul_ps(z, r22));
+		min_x = _mm256_min_ps(min_x, rx);
+		min_y = _mm256_min_ps(min_y, ry);
+		min_z = _mm256_min_ps(min_z, rz);
+		max_x = _mm256_max_ps(max_x, rx);
+		max_y = _mm256_max_ps(max_y, ry);
+		max_z = _mm256_max_ps(max_z, rz);
+	}
+
+	vec3 tail_min, tail_max;
+	vec3_batch_bounds_scalar(tail_min, tail_max, v + i, count - i, rot);
+	f32 lane[3][2][8];
+	_mm256_storeu_ps(lane[0][0], min_x);
+	_mm256_storeu_ps(lane[1][0], min_y);
+	_mm256_storeu_ps(lane[2][0], min_z);
+	_mm256_storeu_ps(lane[0][1], max_x);
+	_mm256_storeu_ps(lane[1][1], max_y);
+	_mm256_storeu_ps(lane[2][1], max_z);
+	for (u32 c = 0; c < 3; ++c)
+	{
+		min[c] = tail_min[c];
+		max[c] = tail_max[c];
+		for (u32 l = 0; l < 8; ++l)
+		{
+			min[c] = f32_min(min[c], lane[c][0][l]);
+			max[c] = f32_max(max[c], lane[c][1][l]);
+		}
+	}
+}
+
+u32 vec3_batch_support_avx2(const vec3ptr v, const u32 count, const vec3 dir)
+{
+	const __m256 dx = _mm256_set1_ps(dir[0]);
+	const __m256 dy = _mm256_set1_ps(dir[1]);
+	const __m256 dz = _mm256_set1_ps(dir[2]);
+	const __m256i eight = _mm256_set1_epi32(8);
+
+	__m256 max = _mm256_set1_ps(-F32_INFINITY);
+	__m256i best = _mm256_setzero_si256();
+	__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 x, y, z;
+		avx_load_vec3x8(&x, &y, &z, v[i]);
+		const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, x), _mm256_mul_ps(dy, y)), _mm256_mul_ps(dz, z));
+		const __m256 greater = _mm256_cmp_ps(max, d, _CMP_LT_OQ);
+		max = _mm256_blendv_ps(max, d, greater);
+		best = _mm256_blendv_epi8(best, index, _mm256_castps_si256(greater));
+		index = _mm256_add_epi32(index, eight);
+	}
+
+	f32 lane_max[8];
+	u32 lane_best[8];
+	_mm256_storeu_ps(lane_max, max);
+	_mm256_storeu_si256((__m256i *) lane_best, best);
+	return vec3_batch_support_reduce(lane_max, lane_best, 8, v, i, count, dir);
+}
+
+void quat_batch_integrate_avx2(quatptr q, const vec3ptr w, const u32 count, const f32 timestep)
+{
+	const __m256 h = _mm256_set1_ps(timestep / 2.0f);
+	const __m256 w3 = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 w0, w1, w2;
+		avx_load_vec3x8(&w0, &w1, &w2, w[i]);
+
+		/* low half holds quaternions i..i+3, high half i+4..i+7 */
+		__m256 q0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[i + 0])), _mm_loadu_ps(q[i + 4]), 1);
+		__m256 q1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[i + 1])), _mm_loadu_ps(q[i + 5]), 1);
+		__m256 q2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[i + 2])), _mm_loadu_ps(q[i + 6]), 1);
+		__m256 q3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(q[i + 3])), _mm_loadu_ps(q[i + 7]), 1);
+		avx_transpose4x4x2(&q0, &q1, &q2, &q3);
+
+		/* same operation order as the scalar kernel */
+		__m256 x = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w0, q3), _mm256_mul_ps(w3, q0)), _mm256_mul_ps(w1, q2)), _mm256_mul_ps(w2, q1));
+		__m256 y = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w1, q3), _mm256_mul_ps(w3, q1)), _mm256_mul_ps(w2, q0)), _mm256_mul_ps(w0, q2));
+		__m256 z = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(w2, q3), _mm256_mul_ps(w3, q2)), _mm256_mul_ps(w0, q1)), _mm256_mul_ps(w1, q0));
+		__m256 s = _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(_mm256_mul_ps(w3, q3), _mm256_mul_ps(w0, q0)), _mm256_mul_ps(w1, q1)), _mm256_mul_ps(w2, q2));
+		x = _mm256_add_ps(q0, _mm256_mul_ps(x, h));
+		y = _mm256_add_ps(q1, _mm256_mul_ps(y, h));
+		z = _mm256_add_ps(q2, _mm256_mul_ps(z, h));
+		s = _mm256_add_ps(q3, _mm256_mul_ps(s, h));
+
+		const __m256 norm = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)), _mm256_mul_ps(s, s)));
+		const __m256 inv = _mm256_div_ps(one, norm);
+		x = _mm256_mul_ps(x, inv);
+		y = _mm256_mul_ps(y, inv);
+		z = _mm256_mul_ps(z, inv);
+		s = _mm256_mul_ps(s, inv);
+
+		avx_transpose4x4x2(&x, &y, &z, &s);
+		_mm_storeu_ps(q[i + 0], _mm256_castps256_ps128(x));
+		_mm_storeu_ps(q[i + 1], _mm256_castps256_ps128(y));
+		_mm_storeu_ps(q[i + 2], _mm256_castps256_ps128(z));
+		_mm_storeu_ps(q[i + 3], _mm256_castps256_ps128(s));
+		_mm_storeu_ps(q[i + 4], _mm256_extractf128_ps(x, 1));
+		_mm_storeu_ps(q[i + 5], _mm256_extractf128_ps(y, 1));
+		_mm_storeu_ps(q[i + 6], _mm256_extractf128_ps(z, 1));
+		_mm_storeu_ps(q[i + 7], _mm256_extractf128_ps(s, 1));
+	}
+
+	quat_batch_integrate_scalar(q + i, w + i, count - i, timestep);
+}
+
+void vec3_soa_batch_transform_avx2(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation)
+{
+	const __m256 r00 = _mm256_set1_ps(rot[0][0]);
+	const __m256 r01 = _mm256_set1_ps(rot[0][1]);
+	const __m256 r02 = _mm256_set1_ps(rot[0][2]);
+	const __m256 r10 = _mm256_set1_ps(rot[1][0]);
+	const __m256 r11 = _mm256_set1_ps(rot[1][1]);
+	const __m256 r12 = _mm256_set1_ps(rot[1][2]);
+	const __m256 r20 = _mm256_set1_ps(rot[2][0]);
+	const __m256 r21 = _mm256_set1_ps(rot[2][1]);
+	const __m256 r22 = _mm256_set1_ps(rot[2][2]);
+	const __m256 tx = _mm256_set1_ps(translation[0]);
+	const __m256 ty = _mm256_set1_ps(translation[1]);
+	const __m256 tz = _mm256_set1_ps(translation[2]);
+
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 vx = _mm256_loadu_ps(x + i);
+		const __m256 vy = _mm256_loadu_ps(y + i);
+		const __m256 vz = _mm256_loadu_ps(z + i);
+		const __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, r00), _mm256_mul_ps(vy, r10)), _mm256_mul_ps(vz, r20)), tx);
+		const __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, r01), _mm256_mul_ps(vy, r11)), _mm256_mul_ps(vz, r21)), ty);
+		const __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, r02), _mm256_mul_ps(vy, r12)), _mm256_mul_ps(vz, r22)), tz);
+		avx_store_vec3x8(dst[i], rx, ry, rz);
+	}
+
+	vec3_soa_batch_transform_scalar(dst + i, x + i, y + i, z + i, count - i, rot, translation);
+}
+
+u32 vec3_soa_batch_support_avx2(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir)
+{
+	const __m256 dx = _mm256_set1_ps(dir[0]);
+	const __m256 dy = _mm256_set1_ps(dir[1]);
+	const __m256 dz = _mm256_set1_ps(dir[2]);
+	const __m256i eight = _mm256_set1_epi32(8);
+
+	__m256 max = _mm256_set1_ps(-F32_INFINITY);
+	__m256i best = _mm256_setzero_si256();
+	__m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+	u32 i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, _mm256_loadu_ps(x + i)), _mm256_mul_ps(dy, _mm256_loadu_ps(y + i))), _mm256_mul_ps(dz, _mm256_loadu_ps(z + i)));
+		const __m256 greater = _mm256_cmp_ps(max, d, _CMP_LT_OQ);
+		max = _mm256_blendv_ps(max, d, greater);
+		best = _mm256_blendv_epi8(best, index, _mm256_castps_si256(greater));
+		index = _mm256_add_epi32(index, eight);
+	}
+
+	f32 lane_max[8];
+	u32 lane_best[8];
+	_mm256_storeu_ps(lane_max, max);
+	_mm256_storeu_si256((__m256i *) lane_best, best);
+	return vec3_soa_batch_support_reduce(lane_max, lane_best, 8, x, y, z, i, count, dir);
+}
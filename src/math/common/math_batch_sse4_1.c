@@ -0,0 +1,262 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+/* compiled with -msse4.1 (see CMakeLists.txt); only called if the cpu supports sse4.1 */
+
+#include <smmintrin.h>
+#include "math_batch.h"
+
+/* 4 consecutive vec3 => x, y, z lanes */
+static inline void sse_load_vec3x4(__m128 *x, __m128 *y, __m128 *z, const f32 *p)
+{
+	const __m128 m0 = _mm_loadu_ps(p + 0);						/* x0 y0 z0 x1 */
+	const __m128 m1 = _mm_loadu_ps(p + 4);						/* y1 z1 x2 y2 */
+	const __m128 m2 = _mm_loadu_ps(p + 8);						/* z2 x3 y3 z3 */
+	const __m128 xy = _mm_shuffle_ps(m1, m2, _MM_SHUFFLE(2, 1, 3, 2));		/* x2 y2 x3 y3 */
+	const __m128 yz = _mm_shuffle_ps(m0, m1, _MM_SHUFFLE(1, 0, 2, 1));		/* y0 z0 y1 z1 */
+	*x = _mm_shuffle_ps(m0, xy, _MM_SHUFFLE(2, 0, 3, 0));
+	*y = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+	*z = _mm_shuffle_ps(yz, m2, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+/* x, y, z lanes => 4 consecutive vec3 */
+static inline void sse_store_vec3x4(f32 *p, const __m128 x, const __m128 y, const __m128 z)
+{
+	const __m128 xy = _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0));		/* x0 x2 y0 y2 */
+	const __m128 yz = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 1, 3, 1));		/* y1 y3 z1 z3 */
+	const __m128 zx = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 1, 2, 0));		/* z0 z2 x1 x3 */
+	_mm_storeu_ps(p + 0, _mm_shuffle_ps(xy, zx, _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(p + 4, _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0)));
+	_mm_storeu_ps(p + 8, _mm_shuffle_ps(zx, yz, _MM_SHUFFLE(3, 1, 3, 1)));
+}
+
+void vec3_batch_transform_sse4_1(vec3ptr dst, const vec3ptr src, const u32 count, mat3 rot, const vec3 translation)
+{
+	const __m128 r00 = _mm_set1_ps(rot[0][0]);
+	const __m128 r01 = _mm_set1_ps(rot[0][1]);
+	const __m128 r02 = _mm_set1_ps(rot[0][2]);
+	const __m128 r10 = _mm_set1_ps(rot[1][0]);
+	const __m128 r11 = _mm_set1_ps(rot[1][1]);
+	const __m128 r12 = _mm_set1_ps(rot[1][2]);
+	const __m128 r20 = _mm_set1_ps(rot[2][0]);
+	const __m128 r21 = _mm_set1_ps(rot[2][1]);
+	const __m128 r22 = _mm_set1_ps(rot[2][2]);
+	const __m128 tx = _mm_set1_ps(translation[0]);
+	const __m128 ty = _mm_set1_ps(translation[1]);
+	const __m128 tz = _mm_set1_ps(translation[2]);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		sse_load_vec3x4(&x, &y, &z, src[i]);
+		const __m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r00), _mm_mul_ps(y, r10)), _mm_mul_ps(z, r20)), tx);
+		const __m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r01), _mm_mul_ps(y, r11)), _mm_mul_ps(z, r21)), ty);
+		const __m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r02), _mm_mul_ps(y, r12)), _mm_mul_ps(z, r22)), tz);
+		sse_store_vec3x4(dst[i], rx, ry, rz);
+	}
+
+	vec3_batch_transform_scalar(dst + i, src + i, count - i, rot, translation);
+}
+
+void vec3_batch_bounds_sse4_1(vec3 min, vec3 max, const vec3ptr v, const u32 count, mat3 rot)
+{
+	const __m128 r00 = _mm_set1_ps(rot[0][0]);
+	const __m128 r01 = _mm_set1_ps(rot[0][1]);
+	const __m128 r02 = _mm_set1_ps(rot[0][2]);
+	const __m128 r10 = _mm_set1_ps(rot[1][0]);
+	const __m128 r11 = _mm_set1_ps(rot[1][1]);
+	const __m128 r12 = _mm_set1_ps(rot[1][2]);
+	const __m128 r20 = _mm_set1_ps(rot[2][0]);
+	const __m128 r21 = _mm_set1_ps(rot[2][1]);
+	const __m128 r22 = _mm_set1_ps(rot[2][2]);
+
+	__m128 min_x = _mm_set1_ps(F32_INFINITY);
+	__m128 min_y = min_x;
+	__m128 min_z = min_x;
+	__m128 max_x = _mm_set1_ps(-F32_INFINITY);
+	__m128 max_y = max_x;
+	__m128 max_z = max_x;
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		sse_load_vec3x4(&x, &y, &z, v[i]);
+		const __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r00), _mm_mul_ps(y, r10)), _mm_mul_ps(z, r20));
+		const __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r01), _mm_mul_ps(y, r11)), _mm_mul_ps(z, r21));
+		const __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, r02), _mm_mul_ps(y, r12)), _mm_mul_ps(z, r22));
+		min_x = _mm_min_ps(min_x, rx);
+		min_y = _mm_min_ps(min_y, ry);
+		min_z = _mm_min_ps(min_z, rz);
+		max_x = _mm_max_ps(max_x, rx);
+		max_y = _mm_max_ps(max_y, ry);
+		max_z = _mm_max_ps(max_z, rz);
+	}
+
+	vec3 tail_min, tail_max;
+	vec3_batch_bounds_scalar(tail_min, tail_max, v + i, count - i, rot);
+	f32 lane[3][2][4];
+	_mm_storeu_ps(lane[0][0], min_x);
+	_mm_storeu_ps(lane[1][0], min_y);
+	_mm_storeu_ps(lane[2][0], min_z);
+	_mm_storeu_ps(lane[0][1], max_x);
+	_mm_storeu_ps(lane[1][1], max_y);
+	_mm_storeu_ps(lane[2][1], max_z);
+	for (u32 c = 0; c < 3; ++c)
+	{
+		min[c] = f32_min(f32_min(lane[c][0][0], lane[c][0][1]), f32_min(lane[c][0][2], lane[c][0][3]));
+		max[c] = f32_max(f32_max(lane[c][1][0], lane[c][1][1]), f32_max(lane[c][1][2], lane[c][1][3]));
+		min[c] = f32_min(min[c], tail_min[c]);
+		max[c] = f32_max(max[c], tail_max[c]);
+	}
+}
+
+u32 vec3_batch_support_sse4_1(const vec3ptr v, const u32 count, const vec3 dir)
+{
+	const __m128 dx = _mm_set1_ps(dir[0]);
+	const __m128 dy = _mm_set1_ps(dir[1]);
+	const __m128 dz = _mm_set1_ps(dir[2]);
+	const __m128i four = _mm_set1_epi32(4);
+
+	__m128 max = _mm_set1_ps(-F32_INFINITY);
+	__m128i best = _mm_setzero_si128();
+	__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z;
+		sse_load_vec3x4(&x, &y, &z, v[i]);
+		const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, x), _mm_mul_ps(dy, y)), _mm_mul_ps(dz, z));
+		const __m128 greater = _mm_cmplt_ps(max, d);
+		max = _mm_blendv_ps(max, d, greater);
+		best = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(best), _mm_castsi128_ps(index), greater));
+		index = _mm_add_epi32(index, four);
+	}
+
+	f32 lane_max[4];
+	u32 lane_best[4];
+	_mm_storeu_ps(lane_max, max);
+	_mm_storeu_si128((__m128i *) lane_best, best);
+	return vec3_batch_support_reduce(lane_max, lane_best, 4, v, i, count, dir);
+}
+
+void quat_batch_integrate_sse4_1(quatptr q, const vec3ptr w, const u32 count, const f32 timestep)
+{
+	const __m128 h = _mm_set1_ps(timestep / 2.0f);
+	const __m128 w3 = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 w0, w1, w2;
+		sse_load_vec3x4(&w0, &w1, &w2, w[i]);
+
+		__m128 q0 = _mm_loadu_ps(q[i + 0]);
+		__m128 q1 = _mm_loadu_ps(q[i + 1]);
+		__m128 q2 = _mm_loadu_ps(q[i + 2]);
+		__m128 q3 = _mm_loadu_ps(q[i + 3]);
+		_MM_TRANSPOSE4_PS(q0, q1, q2, q3);
+
+		/* same operation order as the scalar kernel */
+		__m128 x = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, q3), _mm_mul_ps(w3, q0)), _mm_mul_ps(w1, q2)), _mm_mul_ps(w2, q1));
+		__m128 y = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w1, q3), _mm_mul_ps(w3, q1)), _mm_mul_ps(w2, q0)), _mm_mul_ps(w0, q2));
+		__m128 z = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(w2, q3), _mm_mul_ps(w3, q2)), _mm_mul_ps(w0, q1)), _mm_mul_ps(w1, q0));
+		__m128 s = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(_mm_mul_ps(w3, q3), _mm_mul_ps(w0, q0)), _mm_mul_ps(w1, q1)), _mm_mul_ps(w2, q2));
+		x = _mm_add_ps(q0, _mm_mul_ps(x, h));
+		y = _mm_add_ps(q1, _mm_mul_ps(y, h));
+		z = _mm_add_ps(q2, _mm_mul_ps(z, h));
+		s = _mm_add_ps(q3, _mm_mul_ps(s, h));
+
+		const __m128 norm = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)), _mm_mul_ps(s, s)));
+		const __m128 inv = _mm_div_ps(one, norm);
+		x = _mm_mul_ps(x, inv);
+		y = _mm_mul_ps(y, inv);
+		z = _mm_mul_ps(z, inv);
+		s = _mm_mul_ps(s, inv);
+
+		_MM_TRANSPOSE4_PS(x, y, z, s);
+		_mm_storeu_ps(q[i + 0], x);
+		_mm_storeu_ps(q[i + 1], y);
+		_mm_storeu_ps(q[i + 2], z);
+		_mm_storeu_ps(q[i + 3], s);
+	}
+
+	quat_batch_integrate_scalar(q + i, w + i, count - i, timestep);
+}
+
+void vec3_soa_batch_transform_sse4_1(vec3ptr dst, const f32 *x, const f32 *y, const f32 *z, const u32 count, mat3 rot, const vec3 translation)
+{
+	const __m128 r00 = _mm_set1_ps(rot[0][0]);
+	const __m128 r01 = _mm_set1_ps(rot[0][1]);
+	const __m128 r02 = _mm_set1_ps(rot[0][2]);
+	const __m128 r10 = _mm_set1_ps(rot[1][0]);
+	const __m128 r11 = _mm_set1_ps(rot[1][1]);
+	const __m128 r12 = _mm_set1_ps(rot[1][2]);
+	const __m128 r20 = _mm_set1_ps(rot[2][0]);
+	const __m128 r21 = _mm_set1_ps(rot[2][1]);
+	const __m128 r22 = _mm_set1_ps(rot[2][2]);
+	const __m128 tx = _mm_set1_ps(translation[0]);
+	const __m128 ty = _mm_set1_ps(translation[1]);
+	const __m128 tz = _mm_set1_ps(translation[2]);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 vx = _mm_loadu_ps(x + i);
+		const __m128 vy = _mm_loadu_ps(y + i);
+		const __m128 vz = _mm_loadu_ps(z + i);
+		const __m128 rx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, r00), _mm_mul_ps(vy, r10)), _mm_mul_ps(vz, r20)), tx);
+		const __m128 ry = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, r01), _mm_mul_ps(vy, r11)), _mm_mul_ps(vz, r21)), ty);
+		const __m128 rz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, r02), _mm_mul_ps(vy, r12)), _mm_mul_ps(vz, r22)), tz);
+		sse_store_vec3x4(dst[i], rx, ry, rz);
+	}
+
+	vec3_soa_batch_transform_scalar(dst + i, x + i, y + i, z + i, count - i, rot, translation);
+}
+
+u32 vec3_soa_batch_support_sse4_1(const f32 *x, const f32 *y, const f32 *z, const u32 count, const vec3 dir)
+{
+	const __m128 dx = _mm_set1_ps(dir[0]);
+	const __m128 dy = _mm_set1_ps(dir[1]);
+	const __m128 dz = _mm_set1_ps(dir[2]);
+	const __m128i four = _mm_set1_epi32(4);
+
+	__m128 max = _mm_set1_ps(-F32_INFINITY);
+	__m128i best = _mm_setzero_si128();
+	__m128i index = _mm_setr_epi32(0, 1, 2, 3);
+
+	u32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, _mm_loadu_ps(x + i)), _mm_mul_ps(dy, _mm_loadu_ps(y + i))), _mm_mul_ps(dz, _mm_loadu_ps(z + i)));
+		const __m128 greater = _mm_cmplt_ps(max, d);
+		max = _mm_blendv_ps(max, d, greater);
+		best = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(best), _mm_castsi128_ps(index), greater));
+		index = _mm_add_epi32(index, four);
+	}
+
+	f32 lane_max[4];
+	u32 lane_best[4];
+	_mm_storeu_ps(lane_max, max);
+	_mm_storeu_si128((__m128i *) lane_best, best);
+	return vec3_soa_batch_support_reduce(lane_max, lane_best, 4, x, y, z, i, count, dir);
+}
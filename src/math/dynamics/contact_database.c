@@ -17,6 +17,9 @@
 ==========================================================================
 */
 
+#include <string.h>
+#include <stddef.h>
+
 #include "sys_public.h"
 #include "dynamics.h"
 
@@ -211,62 +214,87 @@ void c_db_clear_frame(struct contact_database *c_db)
 	}
 }
 
-struct contact *c_db_add_contact(struct physics_pipeline *pipeline, const struct contact_manifold *cm, const u32 i1, const u32 i2)
+u32 c_db_update_persisting_contact(const struct contact_database *c_db, const struct contact_manifold *cm)
 {
-	u32 b1, b2;
-	if (i1 < i2)
+	const u32 index = c_db_lookup_contact_index(c_db, cm->i1, cm->i2);
+	if (index != NLL_NULL)
 	{
-		b1 = i1;
-		b2 = i2;
+		struct contact *c = nll_address(&c_db->contact_net, index);
+		c->cm = *cm;
+
+		/* other threads may set bits within the same block */
+		kas_assert(index < c_db->contacts_frame_usage.bit_count);
+		u64 *block = c_db->contacts_frame_usage.bits + index / BIT_VEC_BLOCK_SIZE;
+		const u64 bit = (u64) 1 << (index % BIT_VEC_BLOCK_SIZE);
+		u64 expected = atomic_load_rlx_64(block);
+		while (!atomic_compare_exchange_rlx_64(block, &expected, expected | bit));
 	}
-	else
+
+	return index;
+}
+
+u32 c_db_reserve_contact(struct physics_pipeline *pipeline, const u32 i1, const u32 i2)
+{
+	const u32 b1 = (i1 < i2) ? i1 : i2;
+	const u32 b2 = (i1 < i2) ? i2 : i1;
+	kas_assert(c_db_lookup_contact_index(&pipeline->c_db, b1, b2) == NLL_NULL);
+	kas_assert(POOL_SLOT_ALLOCATED((struct rigid_body *) pool_address(&pipeline->body_pool, b1)));
+	kas_assert(POOL_SLOT_ALLOCATED((struct rigid_body *) pool_address(&pipeline->body_pool, b2)));
+
+	struct slot slot = nll_reserve(&pipeline->c_db.contact_net);
+	struct contact *c = slot.address;
+	/* key is needed by the nll identifier methods when linking, so it must be set before any shard runs */
+	c->key = key_gen_u32_u32(b1, b2);
+
+	if (slot.index < pipeline->c_db.contacts_frame_usage.bit_count)
 	{
-		b1 = i2;
-		b2 = i1;
+		bit_vec_set_bit(&pipeline->c_db.contacts_frame_usage, slot.index, 1);
 	}
+	PHYSICS_EVENT_CONTACT_NEW(pipeline, b1, b2);
 
-	struct rigid_body *body1 = pool_address(&pipeline->body_pool, b1);
-	struct rigid_body *body2 = pool_address(&pipeline->body_pool, b2);
-
-	const u64 key = key_gen_u32_u32(b1, b2);
-	kas_assert(b1 == CONTACT_KEY_TO_BODY_0(key));
-	kas_assert(b2 == CONTACT_KEY_TO_BODY_1(key));
-	const u32 index = c_db_lookup_contact_index(&pipeline->c_db, b1, b2);
+	return slot.index;
+}
 
-	if (index == NLL_NULL)
+void c_db_shard_link_contacts(struct physics_pipeline *pipeline, const struct c_db_link *link, const u32 link_count, const u32 shard, const u32 shard_count)
+{
+	struct contact_database *c_db = &pipeline->c_db;
+	for (u32 i = 0; i < link_count; ++i)
 	{
-		/* smaller valued body owns slot 0, larger valued body owns slot 1 in node header */
-		kas_assert(POOL_SLOT_ALLOCATED(body1));
-		kas_assert(POOL_SLOT_ALLOCATED(body2));
-		struct contact cpy =
-		{
-			.cm = *cm,
-			.key = key,
-			.cached_count = 0,
-		};
-		struct slot slot = nll_add(&pipeline->c_db.contact_net, &cpy, body1->first_contact_index, body2->first_contact_index);
-		const u32 ci = slot.index; 
-		struct contact *c = slot.address; 
+		struct contact *c = nll_address(&c_db->contact_net, link[i].index);
+		const u32 b0 = CONTACT_KEY_TO_BODY_0(c->key);
+		const u32 b1 = CONTACT_KEY_TO_BODY_1(c->key);
 
-		body1->first_contact_index = ci;
-		body2->first_contact_index = ci;
-
-		hash_map_add(pipeline->c_db.contact_map, (u32) key, ci);
+		if (((u32) c->key & c_db->contact_map->hash_mask) % shard_count == shard)
+		{
+			c->cm = *link[i].cm;
+			memset(c->normal_cache, 0, sizeof(struct contact) - offsetof(struct contact, normal_cache));
+			hash_map_add(c_db->contact_map, (u32) c->key, link[i].index);
+		}
 
-		if (ci < pipeline->c_db.contacts_frame_usage.bit_count)
+		/* smaller valued body owns slot 0, larger valued body owns slot 1 in node header */
+		if (b0 % shard_count == shard)
 		{
-			bit_vec_set_bit(&pipeline->c_db.contacts_frame_usage, ci, 1);
+			struct rigid_body *body = pool_address(&pipeline->body_pool, b0);
+			nll_link(&c_db->contact_net, link[i].index, 0, body->first_contact_index);
+			body->first_contact_index = link[i].index;
 		}
-		PHYSICS_EVENT_CONTACT_NEW(pipeline, b1, b2);
 
-		return c;
+		if (b1 % shard_count == shard)
+		{
+			struct rigid_body *body = pool_address(&pipeline->body_pool, b1);
+			nll_link(&c_db->contact_net, link[i].index, 1, body->first_contact_index);
+			body->first_contact_index = link[i].index;
+		}
 	}
-	else
+}
+
+void c_db_shard_link_prepare(struct contact_database *c_db)
+{
+	if (!hash_map_reserve(c_db->contact_map, c_db->contact_net.pool.length)
+		|| !hash_map_reserve(c_db->sat_cache_map, c_db->sat_cache_pool.length))
 	{
-		struct contact *c = nll_address(&pipeline->c_db.contact_net, index);
-		bit_vec_set_bit(&pipeline->c_db.contacts_frame_usage, index, 1);
-		c->cm = *cm;
-		return c;
+		log_string(T_PHYSICS, S_FATAL, "Failed to reserve contact database hash maps, exiting.");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
 	}
 }
 
@@ -437,7 +465,7 @@ u32 c_db_lookup_contact_index(const struct contact_database *c_db, const u32 i1,
 	return ret;
 }
 
-void sat_cache_add(struct contact_database *c_db, const struct sat_cache *sat_cache)
+u32 sat_cache_reserve(struct contact_database *c_db, const struct sat_cache *sat_cache)
 {
 	const u32 b0 = CONTACT_KEY_TO_BODY_0(sat_cache->key);
 	const u32 b1 = CONTACT_KEY_TO_BODY_1(sat_cache->key);
@@ -450,8 +478,27 @@ void sat_cache_add(struct contact_database *c_db, const struct sat_cache *sat_ca
 	*sat = *sat_cache;
 	sat->slot_allocation_state = slot_allocation_state;
 	dll_append(&c_db->sat_cache_list, c_db->sat_cache_pool.buf, slot.index);
-	hash_map_add(c_db->sat_cache_map, (u32) sat_cache->key, slot.index);
 	sat->touched = 1;
+
+	return slot.index;
+}
+
+void sat_cache_add(struct contact_database *c_db, const struct sat_cache *sat_cache)
+{
+	const u32 index = sat_cache_reserve(c_db, sat_cache);
+	hash_map_add(c_db->sat_cache_map, (u32) sat_cache->key, index);
+}
+
+void sat_cache_shard_link(struct contact_database *c_db, const u32 *index, const u32 index_count, const u32 shard, const u32 shard_count)
+{
+	for (u32 i = 0; i < index_count; ++i)
+	{
+		const struct sat_cache *sat = pool_address(&c_db->sat_cache_pool, index[i]);
+		if (((u32) sat->key & c_db->sat_cache_map->hash_mask) % shard_count == shard)
+		{
+			hash_map_add(c_db->sat_cache_map, (u32) sat->key, index[i]);
+		}
+	}
 }
 
 struct sat_cache *sat_cache_lookup(const struct contact_database *c_db, const u32 b1, const u32 b2)
@@ -18,11 +18,52 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "collision.h"
 #include "dynamics.h"
 #include "sys_public.h"
 
+/*
+ * wide solver lane operations, one f32xl holds CONTACT_SOLVER_LANE_COUNT floats. SSE on x86 (the baseline isa
+ * of every x86_64 build, the bundle layout is fixed at compile time so wider isas can't be selected at startup), 
+ * simd128 on web builds compiled with -msimd128, and a plain array fallback otherwise.
+ */
+#if defined(__SSE2__) || defined(_M_X64)
+	#include <emmintrin.h>
+	typedef __m128 f32xl;
+	#define f32xl_load(ptr)		_mm_loadu_ps(ptr)
+	#define f32xl_store(ptr, a)	_mm_storeu_ps(ptr, a)
+	#define f32xl_set1(f)		_mm_set1_ps(f)
+	#define f32xl_add(a, b)		_mm_add_ps(a, b)
+	#define f32xl_sub(a, b)		_mm_sub_ps(a, b)
+	#define f32xl_mul(a, b)		_mm_mul_ps(a, b)
+	#define f32xl_min(a, b)		_mm_min_ps(a, b)
+	#define f32xl_max(a, b)		_mm_max_ps(a, b)
+#elif defined(__wasm_simd128__)
+	#include <wasm_simd128.h>
+	typedef v128_t f32xl;
+	#define f32xl_load(ptr)		wasm_v128_load(ptr)
+	#define f32xl_store(ptr, a)	wasm_v128_store(ptr, a)
+	#define f32xl_set1(f)		wasm_f32x4_splat(f)
+	#define f32xl_add(a, b)		wasm_f32x4_add(a, b)
+	#define f32xl_sub(a, b)		wasm_f32x4_sub(a, b)
+	#define f32xl_mul(a, b)		wasm_f32x4_mul(a, b)
+	#define f32xl_min(a, b)		wasm_f32x4_pmin(a, b)
+	#define f32xl_max(a, b)		wasm_f32x4_pmax(a, b)
+#else
+	typedef struct { f32 v[CONTACT_SOLVER_LANE_COUNT]; } f32xl;
+
+	static f32xl f32xl_load(const f32 *ptr) { f32xl r; for (u32 i = 0; i < CONTACT_SOLVER_LANE_COUNT; ++i) { r.v[i] = ptr[i]; } return r; }
+	static void f32xl_store(f32 *ptr, const f32xl a) { for (u32 i = 0; i < CONTACT_SOLVER_LANE_COUNT; ++i) { ptr[i] = a.v[i]; } }
+	static f32xl f32xl_set1(const f32 f) { f32xl r; for (u32 i = 0; i < CONTACT_SOLVER_LANE_COUNT; ++i) { r.v[i] = f; } return r; }
+	static f32xl f32xl_add(const f32xl a, const f32xl b) { f32xl r; for (u32 i = 0; i < CONTACT_SOLVER_LANE_COUNT; ++i) { r.v[i] = a.v[i] + b.v[i]; } return r; }
+	static f32xl f32xl_sub(const f32xl a, const f32xl b) { f32xl r; for (u32 i = 0; i < CONTACT_SOLVER_LANE_COUNT; ++i) { r.v[i] = a.v[i] - b.v[i]; } return r; }
+	static f32xl f32xl_mul(const f32xl a, const f32xl b) { f32xl r; for (u32 i = 0; i < CONTACT_SOLVER_LANE_COUNT; ++i) { r.v[i] = a.v[i] * b.v[i]; } return r; }
+	static f32xl f32xl_min(const f32xl a, const f32xl b) { f32xl r; for (u32 i = 0; i < CONTACT_SOLVER_LANE_COUNT; ++i) { r.v[i] = (a.v[i] < b.v[i]) ? a.v[i] : b.v[i]; } return r; }
+	static f32xl f32xl_max(const f32xl a, const f32xl b) { f32xl r; for (u32 i = 0; i < CONTACT_SOLVER_LANE_COUNT; ++i) { r.v[i] = (a.v[i] > b.v[i]) ? a.v[i] : b.v[i]; } return r; }
+#endif
+
 /* used in contact solver to cleanup the code from if-statements */
 struct rigid_body static_body = { 0 };
 
@@ -30,12 +71,14 @@ struct rigid_body static_body = { 0 };
 struct contact_solver_config config_storage = { 0 };
 struct contact_solver_config *g_solver_config = &config_storage;
 
-void contact_solver_config_init(const u32 iteration_count, const u32 block_solver, const u32 warmup_solver, const vec3 gravity, const f32 baumgarte_constant, const f32 max_condition, const f32 linear_dampening, const f32 angular_dampening, const f32 linear_slop, const f32 restitution_threshold, const u32 sleep_enabled, const f32 sleep_time_threshold, const f32 sleep_linear_velocity_sq_limit, const f32 sleep_angular_velocity_sq_limit)
+void contact_solver_config_init(const u32 iteration_count, const u32 block_solver, const u32 wide_solver, const u32 split_island_body_count, const u32 warmup_solver, const vec3 gravity, const f32 baumgarte_constant, const f32 max_condition, const f32 linear_dampening, const f32 angular_dampening, const f32 linear_slop, const f32 restitution_threshold, const u32 sleep_enabled, const f32 sleep_time_threshold, const f32 sleep_linear_velocity_sq_limit, const f32 sleep_angular_velocity_sq_limit)
 {
 	assert(iteration_count >= 1);
 
 	g_solver_config->iteration_count = iteration_count;
 	g_solver_config->block_solver = block_solver;
+	g_solver_config->wide_solver = wide_solver;
+	g_solver_config->split_island_body_count = split_island_body_count;
 	g_solver_config->warmup_solver = warmup_solver;
 	vec3_copy(g_solver_config->gravity, gravity);
 	g_solver_config->baumgarte_constant = baumgarte_constant;
@@ -52,6 +95,8 @@ void contact_solver_config_init(const u32 iteration_count, const u32 block_solve
 
 	g_solver_config->pending_warmup_solver = g_solver_config->warmup_solver;
 	g_solver_config->pending_block_solver = g_solver_config->block_solver;
+	g_solver_config->pending_wide_solver = g_solver_config->wide_solver;
+	g_solver_config->pending_split_island_body_count = g_solver_config->split_island_body_count;
 	g_solver_config->pending_sleep_enabled = g_solver_config->sleep_enabled;
 	g_solver_config->pending_iteration_count = g_solver_config->iteration_count;
 	g_solver_config->pending_linear_slop = g_solver_config->linear_slop;
@@ -450,384 +495,802 @@ void contact_solver_cache_impulse_data(struct contact_solver *solver, const stru
 	}
 }
 
-void contact_solver_iterate_velocity_constraints(struct contact_solver *solver)
+static void internal_iterate_velocity_constraint(struct contact_solver *solver, struct velocity_constraint *vc)
 {
 	vec4 b, new_total_impulse;
 	vec3 tmp1, tmp2, tmp3;
 	vec3 relative_velocity;
-	for (u32 i = 0; i < solver->contact_count; ++i)
+
+	/* solve friction constraints first, since normal constraints are more important */
+	for (u32 j = 0; j < vc->vcp_count; ++j)
 	{
-		struct velocity_constraint *vc = solver->vcs + i;
+		struct velocity_constraint_point *vcp = vc->vcps + j;
+		const f32 impulse_bound = vc->friction * vcp->normal_impulse;
 
-		/* solve friction constraints first, since normal constraints are more important */
+		for (u32 k = 0; k < 2; ++k)
+		{
+			/* Calculate seperating velocity at point: JV */
+			vec3_sub(relative_velocity, 
+					solver->linear_velocity[vc->lb2],
+					solver->linear_velocity[vc->lb1]);
+			vec3_cross(tmp2, solver->angular_velocity[vc->lb2], vcp->r2);
+			vec3_cross(tmp3, solver->angular_velocity[vc->lb1], vcp->r1);
+			vec3_translate(relative_velocity, tmp2);
+			vec3_translate_scaled(relative_velocity, tmp3, -1.0f);
+			const f32 seperating_velocity = vec3_dot(vc->tangent[k], relative_velocity);
+
+			/* update constraint point tangent impulse */
+			f32 delta_impulse = -vcp->tangent_mass[k] * seperating_velocity;
+			const f32 old_impulse = vcp->tangent_impulse[k];
+			vcp->tangent_impulse[k] = f32_clamp(vcp->tangent_impulse[k] + delta_impulse, -impulse_bound, impulse_bound);
+			delta_impulse = vcp->tangent_impulse[k] - old_impulse;
+
+			/* update body velocities */
+			vec3_scale(tmp1, vc->tangent[k], delta_impulse);
+			vec3_translate_scaled(solver->linear_velocity[vc->lb1], tmp1, -1.0f / solver->bodies[vc->lb1]->mass);
+			vec3_translate_scaled(solver->linear_velocity[vc->lb2], tmp1, 1.0f / solver->bodies[vc->lb2]->mass);
+			vec3_cross(tmp2, vcp->r1, tmp1);
+			mat3_vec_mul(tmp3, solver->Iw_inv[vc->lb1], tmp2);
+			vec3_translate_scaled(solver->angular_velocity[vc->lb1], tmp3, -1.0f);
+			vec3_cross(tmp2, vcp->r2, tmp1);
+			mat3_vec_mul(tmp3, solver->Iw_inv[vc->lb2], tmp2);
+			vec3_translate(solver->angular_velocity[vc->lb2], tmp3);
+		}
+	}
+
+	if (vc->vcp_count == 1 || !vc->block_solve)
+	{
 		for (u32 j = 0; j < vc->vcp_count; ++j)
 		{
 			struct velocity_constraint_point *vcp = vc->vcps + j;
-			const f32 impulse_bound = vc->friction * vcp->normal_impulse;
 
-			for (u32 k = 0; k < 2; ++k)
-			{
-				/* Calculate seperating velocity at point: JV */
-				vec3_sub(relative_velocity, 
-						solver->linear_velocity[vc->lb2],
-						solver->linear_velocity[vc->lb1]);
-				vec3_cross(tmp2, solver->angular_velocity[vc->lb2], vcp->r2);
-				vec3_cross(tmp3, solver->angular_velocity[vc->lb1], vcp->r1);
-				vec3_translate(relative_velocity, tmp2);
-				vec3_translate_scaled(relative_velocity, tmp3, -1.0f);
-				const f32 seperating_velocity = vec3_dot(vc->tangent[k], relative_velocity);
-
-				/* update constraint point tangent impulse */
-				f32 delta_impulse = -vcp->tangent_mass[k] * seperating_velocity;
-				const f32 old_impulse = vcp->tangent_impulse[k];
-				vcp->tangent_impulse[k] = f32_clamp(vcp->tangent_impulse[k] + delta_impulse, -impulse_bound, impulse_bound);
-				delta_impulse = vcp->tangent_impulse[k] - old_impulse;
-
-				/* update body velocities */
-				vec3_scale(tmp1, vc->tangent[k], delta_impulse);
-				vec3_translate_scaled(solver->linear_velocity[vc->lb1], tmp1, -1.0f / solver->bodies[vc->lb1]->mass);
-				vec3_translate_scaled(solver->linear_velocity[vc->lb2], tmp1, 1.0f / solver->bodies[vc->lb2]->mass);
-				vec3_cross(tmp2, vcp->r1, tmp1);
-				mat3_vec_mul(tmp3, solver->Iw_inv[vc->lb1], tmp2);
-				vec3_translate_scaled(solver->angular_velocity[vc->lb1], tmp3, -1.0f);
-				vec3_cross(tmp2, vcp->r2, tmp1);
-				mat3_vec_mul(tmp3, solver->Iw_inv[vc->lb2], tmp2);
-				vec3_translate(solver->angular_velocity[vc->lb2], tmp3);
-			}
-		}
+			/* Calculate seperating velocity at point: JV */
+			vec3_sub(relative_velocity, 
+					solver->linear_velocity[vc->lb2],
+					solver->linear_velocity[vc->lb1]);
+			vec3_cross(tmp2, solver->angular_velocity[vc->lb2], vcp->r2);
+			vec3_cross(tmp3, solver->angular_velocity[vc->lb1], vcp->r1);
+			vec3_translate(relative_velocity, tmp2);
+			vec3_translate_scaled(relative_velocity, tmp3, -1.0f);
+			const f32 seperating_velocity = vec3_dot(vc->normal, relative_velocity);
 
-		if (vc->vcp_count == 1 || !vc->block_solve)
+			/* update constraint point normal impulse */
+			f32 delta_impulse = vcp->normal_mass * (vcp->velocity_bias - seperating_velocity);
+			const f32 old_impulse = vcp->normal_impulse;
+			vcp->normal_impulse = f32_max(0.0f, vcp->normal_impulse + delta_impulse);
+			delta_impulse = vcp->normal_impulse - old_impulse;
+
+			/* update body velocities */
+			vec3_scale(tmp1, vc->normal, delta_impulse);
+			vec3_translate_scaled(solver->linear_velocity[vc->lb1], tmp1, -1.0f / solver->bodies[vc->lb1]->mass);
+			vec3_translate_scaled(solver->linear_velocity[vc->lb2], tmp1, 1.0f / solver->bodies[vc->lb2]->mass);
+			vec3_cross(tmp2, vcp->r1, tmp1);
+			mat3_vec_mul(tmp3, solver->Iw_inv[vc->lb1], tmp2);
+			vec3_translate_scaled(solver->angular_velocity[vc->lb1], tmp3, -1.0f);
+			vec3_cross(tmp2, vcp->r2, tmp1);
+			mat3_vec_mul(tmp3, solver->Iw_inv[vc->lb2], tmp2);
+			vec3_translate(solver->angular_velocity[vc->lb2], tmp3);
+		}
+	}
+	else
+	{
+		vec3_sub(tmp1, solver->linear_velocity[vc->lb2], solver->linear_velocity[vc->lb1]);
+		for (u32 j = 0; j < vc->vcp_count; ++j)
 		{
-			for (u32 j = 0; j < vc->vcp_count; ++j)
-			{
-				struct velocity_constraint_point *vcp = vc->vcps + j;
-
-				/* Calculate seperating velocity at point: JV */
-				vec3_sub(relative_velocity, 
-						solver->linear_velocity[vc->lb2],
-						solver->linear_velocity[vc->lb1]);
-				vec3_cross(tmp2, solver->angular_velocity[vc->lb2], vcp->r2);
-				vec3_cross(tmp3, solver->angular_velocity[vc->lb1], vcp->r1);
-				vec3_translate(relative_velocity, tmp2);
-				vec3_translate_scaled(relative_velocity, tmp3, -1.0f);
-				const f32 seperating_velocity = vec3_dot(vc->normal, relative_velocity);
-
-				/* update constraint point normal impulse */
-				f32 delta_impulse = vcp->normal_mass * (vcp->velocity_bias - seperating_velocity);
-				const f32 old_impulse = vcp->normal_impulse;
-				vcp->normal_impulse = f32_max(0.0f, vcp->normal_impulse + delta_impulse);
-				delta_impulse = vcp->normal_impulse - old_impulse;
-
-				/* update body velocities */
-				vec3_scale(tmp1, vc->normal, delta_impulse);
-				vec3_translate_scaled(solver->linear_velocity[vc->lb1], tmp1, -1.0f / solver->bodies[vc->lb1]->mass);
-				vec3_translate_scaled(solver->linear_velocity[vc->lb2], tmp1, 1.0f / solver->bodies[vc->lb2]->mass);
-				vec3_cross(tmp2, vcp->r1, tmp1);
-				mat3_vec_mul(tmp3, solver->Iw_inv[vc->lb1], tmp2);
-				vec3_translate_scaled(solver->angular_velocity[vc->lb1], tmp3, -1.0f);
-				vec3_cross(tmp2, vcp->r2, tmp1);
-				mat3_vec_mul(tmp3, solver->Iw_inv[vc->lb2], tmp2);
-				vec3_translate(solver->angular_velocity[vc->lb2], tmp3);
-			}
+			struct velocity_constraint_point *vcp = vc->vcps + j;
+			/* Calculate seperating velocity at point: JV */
+			vec3_cross(tmp2, solver->angular_velocity[vc->lb2], vcp->r2);
+			vec3_cross(tmp3, solver->angular_velocity[vc->lb1], vcp->r1);
+			vec3_add(relative_velocity, tmp1, tmp2);
+			vec3_translate_scaled(relative_velocity, tmp3, -1.0f);
+			const f32 seperating_velocity = vec3_dot(vc->normal, relative_velocity);
+			b[j] = vcp->velocity_bias - seperating_velocity;
 		}
-		else
+		
+		u32 solution_found = 0;
+		switch (vc->vcp_count)
 		{
-			vec3_sub(tmp1, solver->linear_velocity[vc->lb2], solver->linear_velocity[vc->lb1]);
-			for (u32 j = 0; j < vc->vcp_count; ++j)
-			{
-				struct velocity_constraint_point *vcp = vc->vcps + j;
-				/* Calculate seperating velocity at point: JV */
-				vec3_cross(tmp2, solver->angular_velocity[vc->lb2], vcp->r2);
-				vec3_cross(tmp3, solver->angular_velocity[vc->lb1], vcp->r1);
-				vec3_add(relative_velocity, tmp1, tmp2);
-				vec3_translate_scaled(relative_velocity, tmp3, -1.0f);
-				const f32 seperating_velocity = vec3_dot(vc->normal, relative_velocity);
-				b[j] = vcp->velocity_bias - seperating_velocity;
-			}
-			
-			u32 solution_found = 0;
-			switch (vc->vcp_count)
-			{
-				case 2: 
-				{ 
-					mat2ptr normal_mass = vc->normal_mass;
-					mat2ptr inv_normal_mass = vc->inv_normal_mass;
+			case 2: 
+			{ 
+				mat2ptr normal_mass = vc->normal_mass;
+				mat2ptr inv_normal_mass = vc->inv_normal_mass;
+
+				/* (1) xn == 0 
+				 * 	=> vn = -b
+				 */
+				if (b[0] <= 0.0f && b[1] <= 0.0f)
+				{
+					solution_found = 1;	
+					vec2_set(new_total_impulse, 0.0f, 0.0f);
+					goto BLOCK_SOLVER_UPDATE;
+				}
 
-					/* (1) xn == 0 
-					 * 	=> vn = -b
-					 */
-					if (b[0] <= 0.0f && b[1] <= 0.0f)
+				/* (2) vn == 0  
+				 *	=>	x = inv(A)*b
+				 */
+				mat2_vec_mul(new_total_impulse, *normal_mass, b);
+				if (new_total_impulse[0] >= 0.0f && new_total_impulse[1] >= 0.0f)
+				{
+					solution_found = 1;
+					goto BLOCK_SOLVER_UPDATE;
+				}
+
+				/* (3) xi != 0  
+				 * 	=> 0 = Ai1 * x1 + Ai2 * x2 - bi 
+				 * 	=> xi = bi / Aii
+				 * 	=> vn = A*x_i - b
+				 */
+				for (u32 j = 0; j < vc->vcp_count; ++j)
+				{
+					struct velocity_constraint_point *vcp = vc->vcps + j;
+					const f32 xj = vcp->normal_mass * b[j];
+					const u32 i1 = (j+1) % 2;
+					if (xj >= 0.0f && (xj*(*inv_normal_mass)[j][i1] - b[i1]) >= 0.0f)
 					{
-						solution_found = 1;	
-						vec2_set(new_total_impulse, 0.0f, 0.0f);
+						solution_found = 1;
+						new_total_impulse[j] = xj;
+						new_total_impulse[i1] = 0.0f;
 						goto BLOCK_SOLVER_UPDATE;
 					}
+				}
+			} break;
 
-					/* (2) vn == 0  
-					 *	=>	x = inv(A)*b
-					 */
-					mat2_vec_mul(new_total_impulse, *normal_mass, b);
-					if (new_total_impulse[0] >= 0.0f && new_total_impulse[1] >= 0.0f)
+			case 3: 
+			{ 
+				mat3ptr normal_mass = vc->normal_mass;
+				mat3ptr inv_normal_mass = vc->inv_normal_mass;
+
+				/* (1) xn == 0 
+				 * 	=> vn = -b
+				 */
+				if (b[0] <= 0.0f && b[1] <= 0.0f && b[2] <= 0.0f)
+				{
+					solution_found = 1;	
+					vec3_set(new_total_impulse, 0.0f, 0.0f, 0.0f);
+					goto BLOCK_SOLVER_UPDATE;
+				}
+
+				/* (2) vn == 0  
+				 *	=>	x = inv(A)*b
+				 */
+				mat3_vec_mul(new_total_impulse, *normal_mass, b);
+				if (new_total_impulse[0] >= 0.0f && new_total_impulse[1] >= 0.0f && new_total_impulse[2] >= 0.0f)
+				{
+					solution_found = 1;
+					goto BLOCK_SOLVER_UPDATE;
+				}
+
+				/* (3) xi != 0  
+				 * 	=> 0 = Ai1 * x1 + ... + Ai3 * x3 - bi 
+				 * 	=> xi = bi / Aii
+				 * 	=> vn = A*x_i - b
+				 */
+				for (u32 j = 0; j < vc->vcp_count; ++j)
+				{
+					struct velocity_constraint_point *vcp = vc->vcps + j;
+					const f32 xj = vcp->normal_mass * b[j];
+					const u32 i1 = (j+1) % 3;
+					const u32 i2 = (j+2) % 3;
+					const f32 vni1 = xj*(*inv_normal_mass)[j][i1] - b[i1];
+					const f32 vni2 = xj*(*inv_normal_mass)[j][i2] - b[i2];
+					if (xj >= 0.0f && vni1 >= 0.0f && vni2 >= 0.0f)
 					{
 						solution_found = 1;
+						new_total_impulse[j] = xj;
+						new_total_impulse[i1] = 0.0f;
+						new_total_impulse[i2] = 0.0f;
 						goto BLOCK_SOLVER_UPDATE;
 					}
+				}
 
-					/* (3) xi != 0  
-					 * 	=> 0 = Ai1 * x1 + Ai2 * x2 - bi 
-					 * 	=> xi = bi / Aii
-					 * 	=> vn = A*x_i - b
-					 */
-					for (u32 j = 0; j < vc->vcp_count; ++j)
-					{
-						struct velocity_constraint_point *vcp = vc->vcps + j;
-						const f32 xj = vcp->normal_mass * b[j];
-						const u32 i1 = (j+1) % 2;
-						if (xj >= 0.0f && (xj*(*inv_normal_mass)[j][i1] - b[i1]) >= 0.0f)
-						{
-							solution_found = 1;
-							new_total_impulse[j] = xj;
-							new_total_impulse[i1] = 0.0f;
-							goto BLOCK_SOLVER_UPDATE;
-						}
-					}
-				} break;
+				/* (4) vni != 0  
+				 * 	=>	inv(A)*vn = x - inv(A)*b
+				 * 	=>	inv(A)_ii*vni = -row(inv(A),i)*b
+				 * 	=>	vni = -row(inv(A),i)*b/inv(A)_ii
+				 * 	=>	x = inv(A)(vn + b)
+				 */
+				for (u32 j = 0; j < vc->vcp_count; ++j)
+				{
+					struct velocity_constraint_point *vcp = vc->vcps + j;
+					const f32 vnj = -((*normal_mass)[0][j]*b[0] + (*normal_mass)[1][j]*b[1] + (*normal_mass)[2][j]*b[2]) / (*normal_mass)[j][j];
+					
+					if (vnj < 0.0f) { continue; }
 
-				case 3: 
-				{ 
-					mat3ptr normal_mass = vc->normal_mass;
-					mat3ptr inv_normal_mass = vc->inv_normal_mass;
+					vec3 tmp;
+					vec3_copy(tmp, b);
+					tmp[j] += vnj;
+					mat3_vec_mul(new_total_impulse, vc->normal_mass, tmp);
+					new_total_impulse[j] = 0.0f;
+
+					const u32 i1 = (j+1) % 3;
+					const u32 i2 = (j+2) % 3;
 
-					/* (1) xn == 0 
-					 * 	=> vn = -b
-					 */
-					if (b[0] <= 0.0f && b[1] <= 0.0f && b[2] <= 0.0f)
+					if (new_total_impulse[i1] >= 0.0f && new_total_impulse[i2] >= 0.0f)
 					{
-						solution_found = 1;	
-						vec3_set(new_total_impulse, 0.0f, 0.0f, 0.0f);
+						solution_found = 1;
 						goto BLOCK_SOLVER_UPDATE;
 					}
+				}
+			} break;
 
-					/* (2) vn == 0  
-					 *	=>	x = inv(A)*b
-					 */
-					mat3_vec_mul(new_total_impulse, *normal_mass, b);
-					if (new_total_impulse[0] >= 0.0f && new_total_impulse[1] >= 0.0f && new_total_impulse[2] >= 0.0f)
+			case 4: 
+			{ 
+				mat4ptr normal_mass = vc->normal_mass;
+				mat4ptr inv_normal_mass = vc->inv_normal_mass;
+
+				/* (1) xn == 0 
+				 * 	=> vn = -b
+				 */
+				if (b[0] <= 0.0f && b[1] <= 0.0f && b[2] <= 0.0f && b[3] <= 0.0f)
+				{
+					solution_found = 1;	
+					vec4_set(new_total_impulse, 0.0f, 0.0f, 0.0f, 0.0f);
+					goto BLOCK_SOLVER_UPDATE;
+				}
+
+				/* (2) vn == 0  
+				 *	=>	x = inv(A)*b
+				 */
+				mat4_vec_mul(new_total_impulse, *((mat4ptr) vc->normal_mass), b);
+				if (new_total_impulse[0] >= 0.0f && new_total_impulse[1] >= 0.0f && new_total_impulse[2] >= 0.0f && new_total_impulse[3] >= 0.0f)
+				{
+					solution_found = 1;
+					goto BLOCK_SOLVER_UPDATE;
+				}
+
+				/* (3) xi != 0  
+				 * 	=> 0 = Ai1 * x1 + ... + Ai4 * x4 - bi 
+				 * 	=> xi = bi / Aii
+				 * 	=> vn = col(A,i)*x_i - b
+				 */
+				for (u32 j = 0; j < vc->vcp_count; ++j)
+				{
+					struct velocity_constraint_point *vcp = vc->vcps + j;
+					const f32 xj = b[j] * vcp->normal_mass;
+					const u32 i1 = (j+1) % 4;
+					const u32 i2 = (j+2) % 4;
+					const u32 i3 = (j+3) % 4;
+					if (xj >= 0.0f  && (xj * (*inv_normal_mass)[j][i1] - b[i1]) >= 0.0f
+							&& (xj * (*inv_normal_mass)[j][i2] - b[i2]) >= 0.0f
+							&& (xj * (*inv_normal_mass)[j][i3] - b[i3]) >= 0.0f)
 					{
 						solution_found = 1;
+						new_total_impulse[j] = xj;
+						new_total_impulse[i1] = 0.0f;
+						new_total_impulse[i2] = 0.0f;
+						new_total_impulse[i3] = 0.0f;
 						goto BLOCK_SOLVER_UPDATE;
 					}
+				}
 
-					/* (3) xi != 0  
-					 * 	=> 0 = Ai1 * x1 + ... + Ai3 * x3 - bi 
-					 * 	=> xi = bi / Aii
-					 * 	=> vn = A*x_i - b
-					 */
-					for (u32 j = 0; j < vc->vcp_count; ++j)
-					{
-						struct velocity_constraint_point *vcp = vc->vcps + j;
-						const f32 xj = vcp->normal_mass * b[j];
-						const u32 i1 = (j+1) % 3;
-						const u32 i2 = (j+2) % 3;
-						const f32 vni1 = xj*(*inv_normal_mass)[j][i1] - b[i1];
-						const f32 vni2 = xj*(*inv_normal_mass)[j][i2] - b[i2];
-						if (xj >= 0.0f && vni1 >= 0.0f && vni2 >= 0.0f)
-						{
-							solution_found = 1;
-							new_total_impulse[j] = xj;
-							new_total_impulse[i1] = 0.0f;
-							new_total_impulse[i2] = 0.0f;
-							goto BLOCK_SOLVER_UPDATE;
-						}
-					}
-	
-					/* (4) vni != 0  
-					 * 	=>	inv(A)*vn = x - inv(A)*b
-					 * 	=>	inv(A)_ii*vni = -row(inv(A),i)*b
-					 * 	=>	vni = -row(inv(A),i)*b/inv(A)_ii
-					 * 	=>	x = inv(A)(vn + b)
-					 */
-					for (u32 j = 0; j < vc->vcp_count; ++j)
-					{
-						struct velocity_constraint_point *vcp = vc->vcps + j;
-						const f32 vnj = -((*normal_mass)[0][j]*b[0] + (*normal_mass)[1][j]*b[1] + (*normal_mass)[2][j]*b[2]) / (*normal_mass)[j][j];
-						
-						if (vnj < 0.0f) { continue; }
-
-						vec3 tmp;
-						vec3_copy(tmp, b);
-						tmp[j] += vnj;
-						mat3_vec_mul(new_total_impulse, vc->normal_mass, tmp);
-						new_total_impulse[j] = 0.0f;
-
-						const u32 i1 = (j+1) % 3;
-						const u32 i2 = (j+2) % 3;
-
-						if (new_total_impulse[i1] >= 0.0f && new_total_impulse[i2] >= 0.0f)
-						{
-							solution_found = 1;
-							goto BLOCK_SOLVER_UPDATE;
-						}
-					}
-				} break;
+				/* (4) vni != 0  
+				 * 	=>	inv(A)*vn = x - inv(A)*b
+				 * 	=>	inv(A)_ii*vni = -row(inv(A),i)*b
+				 * 	=>	vni = -row(inv(A),i)*b/inv(A)_ii
+				 * 	=>	x = inv(A)(vn + b)
+				 */
+				for (u32 j = 0; j < vc->vcp_count; ++j)
+				{
+					struct velocity_constraint_point *vcp = vc->vcps + j;
+					const f32 vnj = -((*normal_mass)[0][j]*b[0] + (*normal_mass)[1][j]*b[1] + (*normal_mass)[2][j]*b[2] + (*normal_mass)[3][j]*b[3]) / vcp->normal_mass;
+					
+					if (vnj < 0.0f) { continue; }
 
-				case 4: 
-				{ 
-					mat4ptr normal_mass = vc->normal_mass;
-					mat4ptr inv_normal_mass = vc->inv_normal_mass;
+					vec4 tmp;
+					vec4_copy(tmp, b);
+					tmp[j] += vnj;
+					mat4_vec_mul(new_total_impulse, *normal_mass, tmp);
+					new_total_impulse[j] = 0.0f;
 
-					/* (1) xn == 0 
-					 * 	=> vn = -b
-					 */
-					if (b[0] <= 0.0f && b[1] <= 0.0f && b[2] <= 0.0f && b[3] <= 0.0f)
+					const u32 i1 = (j+1) % 4;
+					const u32 i2 = (j+2) % 4;
+					const u32 i3 = (j+3) % 4;
+
+					if (new_total_impulse[i1] >= 0.0f && new_total_impulse[i2] >= 0.0f && new_total_impulse[i3] >= 0.0f)
 					{
-						solution_found = 1;	
-						vec4_set(new_total_impulse, 0.0f, 0.0f, 0.0f, 0.0f);
+						solution_found = 1;
 						goto BLOCK_SOLVER_UPDATE;
 					}
+				}
 
-					/* (2) vn == 0  
-					 *	=>	x = inv(A)*b
-					 */
-					mat4_vec_mul(new_total_impulse, *((mat4ptr) vc->normal_mass), b);
-					if (new_total_impulse[0] >= 0.0f && new_total_impulse[1] >= 0.0f && new_total_impulse[2] >= 0.0f && new_total_impulse[3] >= 0.0f)
+				/* (5) xi, xj != 0  
+				 *	=> 	[bi] = [Aii  Aij][xi]
+				 *	=> 	[bj]   [Aji  Ajj][xj]
+				 *
+				 *	=>	1/(Aii*Ajj - Aij*Aji) * [ Ajj  -Aij] [bi] = [xi]
+				 *					[-Aji   Aii] [bj]   [xj]
+				 * 	=> vn = col(A,i)*xi + col(A,j)*x_j - b
+				 */
+				const u32 xj1_scheme[6] =  { 0, 0, 0, 1, 1, 2 };
+				const u32 xj2_scheme[6] =  { 1, 2, 3, 2, 3, 3 };
+				const u32 vnj1_scheme[6] = { 2, 1, 1, 0, 0, 0 };
+				const u32 vnj2_scheme[6] = { 3, 3, 2, 3, 2, 1 };
+
+				for (u32 j = 0; j < 6; ++j)
+				{
+					const u32 x_index1 = xj1_scheme[j];
+					const u32 x_index2 = xj2_scheme[j];
+					const u32 vn_index1 = vnj1_scheme[j];
+					const u32 vn_index2 = vnj2_scheme[j];
+				
+					const f32 Aii = (*inv_normal_mass)[x_index1][x_index1];
+					const f32 Aij = (*inv_normal_mass)[x_index2][x_index1];
+					const f32 Ajj = (*inv_normal_mass)[x_index2][x_index2];
+					const f32 det = Aii*Ajj - Aij*Aij;
+
+					//TODO
+					if (det*det <= 0.0001f) { continue; }
+					
+					const f32 det_inv = 1.0f / det;
+					new_total_impulse[x_index1] = det_inv * ( Ajj*b[x_index1] - Aij*b[x_index2]);
+					new_total_impulse[x_index2] = det_inv * (-Aij*b[x_index1] + Aii*b[x_index2]);
+
+					if (new_total_impulse[x_index1] < 0.0f || new_total_impulse[x_index2] < 0.0f) { continue; }
+
+
+					const f32 vnj1 = 
+						  (*inv_normal_mass)[x_index1][vn_index1]*new_total_impulse[x_index1] 
+						+ (*inv_normal_mass)[x_index2][vn_index1]*new_total_impulse[x_index2]
+ 							- b[vn_index1];
+					const f32 vnj2 = 
+						  (*inv_normal_mass)[x_index1][vn_index2]*new_total_impulse[x_index1] 
+						+ (*inv_normal_mass)[x_index2][vn_index2]*new_total_impulse[x_index2]
+ 							- b[vn_index2];
+
+					if (vnj1 >= 0.0f && vnj2 >= 0.0f)
 					{
+						new_total_impulse[vn_index1] = 0.0f;
+						new_total_impulse[vn_index2] = 0.0f;
 						solution_found = 1;
 						goto BLOCK_SOLVER_UPDATE;
 					}
 
-					/* (3) xi != 0  
-					 * 	=> 0 = Ai1 * x1 + ... + Ai4 * x4 - bi 
-					 * 	=> xi = bi / Aii
-					 * 	=> vn = col(A,i)*x_i - b
-					 */
-					for (u32 j = 0; j < vc->vcp_count; ++j)
-					{
-						struct velocity_constraint_point *vcp = vc->vcps + j;
-						const f32 xj = b[j] * vcp->normal_mass;
-						const u32 i1 = (j+1) % 4;
-						const u32 i2 = (j+2) % 4;
-						const u32 i3 = (j+3) % 4;
-						if (xj >= 0.0f  && (xj * (*inv_normal_mass)[j][i1] - b[i1]) >= 0.0f
-								&& (xj * (*inv_normal_mass)[j][i2] - b[i2]) >= 0.0f
-								&& (xj * (*inv_normal_mass)[j][i3] - b[i3]) >= 0.0f)
-						{
-							solution_found = 1;
-							new_total_impulse[j] = xj;
-							new_total_impulse[i1] = 0.0f;
-							new_total_impulse[i2] = 0.0f;
-							new_total_impulse[i3] = 0.0f;
-							goto BLOCK_SOLVER_UPDATE;
-						}
-					}
+				}
+			} break;
+		}
 
-					/* (4) vni != 0  
-					 * 	=>	inv(A)*vn = x - inv(A)*b
-					 * 	=>	inv(A)_ii*vni = -row(inv(A),i)*b
-					 * 	=>	vni = -row(inv(A),i)*b/inv(A)_ii
-					 * 	=>	x = inv(A)(vn + b)
-					 */
-					for (u32 j = 0; j < vc->vcp_count; ++j)
-					{
-						struct velocity_constraint_point *vcp = vc->vcps + j;
-						const f32 vnj = -((*normal_mass)[0][j]*b[0] + (*normal_mass)[1][j]*b[1] + (*normal_mass)[2][j]*b[2] + (*normal_mass)[3][j]*b[3]) / vcp->normal_mass;
-						
-						if (vnj < 0.0f) { continue; }
-
-						vec4 tmp;
-						vec4_copy(tmp, b);
-						tmp[j] += vnj;
-						mat4_vec_mul(new_total_impulse, *normal_mass, tmp);
-						new_total_impulse[j] = 0.0f;
-
-						const u32 i1 = (j+1) % 4;
-						const u32 i2 = (j+2) % 4;
-						const u32 i3 = (j+3) % 4;
-
-						if (new_total_impulse[i1] >= 0.0f && new_total_impulse[i2] >= 0.0f && new_total_impulse[i3] >= 0.0f)
-						{
-							solution_found = 1;
-							goto BLOCK_SOLVER_UPDATE;
-						}
-					}
+		BLOCK_SOLVER_UPDATE:
+		if (solution_found)
+		{
+			for (u32 j = 0; j < vc->vcp_count; ++j)
+			{
+				struct velocity_constraint_point *vcp = vc->vcps + j;
+				const f32 delta_impulse = new_total_impulse[j] - vcp->normal_impulse;
+				vcp->normal_impulse = new_total_impulse[j];
+				
+				vec3_scale(tmp1, vc->normal, delta_impulse);
+				vec3_translate_scaled(solver->linear_velocity[vc->lb2], tmp1, 1.0f/solver->bodies[vc->lb2]->mass);
+				vec3_translate_scaled(solver->linear_velocity[vc->lb1], tmp1, -1.0f/solver->bodies[vc->lb1]->mass);
 
-					/* (5) xi, xj != 0  
-					 *	=> 	[bi] = [Aii  Aij][xi]
-					 *	=> 	[bj]   [Aji  Ajj][xj]
-					 *
-					 *	=>	1/(Aii*Ajj - Aij*Aji) * [ Ajj  -Aij] [bi] = [xi]
-					 *					[-Aji   Aii] [bj]   [xj]
-					 * 	=> vn = col(A,i)*xi + col(A,j)*x_j - b
-					 */
-					const u32 xj1_scheme[6] =  { 0, 0, 0, 1, 1, 2 };
-					const u32 xj2_scheme[6] =  { 1, 2, 3, 2, 3, 3 };
-					const u32 vnj1_scheme[6] = { 2, 1, 1, 0, 0, 0 };
-					const u32 vnj2_scheme[6] = { 3, 3, 2, 3, 2, 1 };
-
-					for (u32 j = 0; j < 6; ++j)
-					{
-						const u32 x_index1 = xj1_scheme[j];
-						const u32 x_index2 = xj2_scheme[j];
-						const u32 vn_index1 = vnj1_scheme[j];
-						const u32 vn_index2 = vnj2_scheme[j];
-					
-						const f32 Aii = (*inv_normal_mass)[x_index1][x_index1];
-						const f32 Aij = (*inv_normal_mass)[x_index2][x_index1];
-						const f32 Ajj = (*inv_normal_mass)[x_index2][x_index2];
-						const f32 det = Aii*Ajj - Aij*Aij;
+				vec3_cross(tmp2, vcp->r2, tmp1);
+				vec3_cross(tmp3, vcp->r1, tmp1);
 
-						//TODO
-						if (det*det <= 0.0001f) { continue; }
-						
-						const f32 det_inv = 1.0f / det;
-						new_total_impulse[x_index1] = det_inv * ( Ajj*b[x_index1] - Aij*b[x_index2]);
-						new_total_impulse[x_index2] = det_inv * (-Aij*b[x_index1] + Aii*b[x_index2]);
+				mat3_vec_mul(tmp1, solver->Iw_inv[vc->lb2], tmp2);
+				vec3_translate(solver->angular_velocity[vc->lb2], tmp1);
+				mat3_vec_mul(tmp1, solver->Iw_inv[vc->lb1], tmp3);
+				vec3_translate_scaled(solver->angular_velocity[vc->lb1], tmp1, -1.0f);
+			}
+		}
+	}
+}
 
-						if (new_total_impulse[x_index1] < 0.0f || new_total_impulse[x_index2] < 0.0f) { continue; }
+void contact_solver_iterate_velocity_constraints(struct contact_solver *solver)
+{
+	for (u32 i = 0; i < solver->contact_count; ++i)
+	{
+		internal_iterate_velocity_constraint(solver, solver->vcs + i);
+	}
+}
 
+void contact_solver_init_wide_constraints(struct arena *mem, struct contact_solver *solver)
+{
+	const u32 word_count = (solver->body_count + 63) / 64;
+	u64 *color_bodies = arena_push(mem, CONTACT_SOLVER_COLOR_COUNT * word_count * sizeof(u64));
+	u32 *color = arena_push(mem, solver->contact_count * sizeof(u32));
+	solver->scalar_vcs = arena_push(mem, solver->contact_count * sizeof(u32));
+	solver->scalar_count = 0;
+	solver->bundle_count = 0;
+	solver->bundles = NULL;
+
+	/* 
+	 * Greedy coloring: put each constraint in the first color in which neither of its dynamic bodies is 
+	 * used. Block solved constraints are kept in the scalar path, as are any constraints we fail to color.
+	 */
+	memset(color_bodies, 0, CONTACT_SOLVER_COLOR_COUNT * word_count * sizeof(u64));
+	u32 color_count[CONTACT_SOLVER_COLOR_COUNT] = { 0 };
+	for (u32 i = 0; i < solver->contact_count; ++i)
+	{
+		const struct velocity_constraint *vc = solver->vcs + i;
+		color[i] = U32_MAX;
+		if (vc->block_solve && vc->vcp_count > 1)
+		{
+			solver->scalar_vcs[solver->scalar_count++] = i;
+			continue;
+		}
 
-						const f32 vnj1 = 
-							  (*inv_normal_mass)[x_index1][vn_index1]*new_total_impulse[x_index1] 
-							+ (*inv_normal_mass)[x_index2][vn_index1]*new_total_impulse[x_index2]
- 							- b[vn_index1];
-						const f32 vnj2 = 
-							  (*inv_normal_mass)[x_index1][vn_index2]*new_total_impulse[x_index1] 
-							+ (*inv_normal_mass)[x_index2][vn_index2]*new_total_impulse[x_index2]
- 							- b[vn_index2];
+		const u32 w1 = vc->lb1 >> 6;
+		const u64 m1 = (u64) 1 << (vc->lb1 & 63);
+		const u32 lb2_dynamic = (vc->lb2 != solver->body_count);
+		const u32 w2 = (lb2_dynamic) ? (vc->lb2 >> 6) : w1;
+		const u64 m2 = (lb2_dynamic) ? ((u64) 1 << (vc->lb2 & 63)) : 0;
+		for (u32 c = 0; c < CONTACT_SOLVER_COLOR_COUNT; ++c)
+		{
+			u64 *bodies = color_bodies + c*word_count;
+			if ((bodies[w1] & m1) == 0 && (bodies[w2] & m2) == 0)
+			{
+				bodies[w1] |= m1;
+				bodies[w2] |= m2;
+				color[i] = c;
+				color_count[c] += 1;
+				break;
+			}
+		}
 
-						if (vnj1 >= 0.0f && vnj2 >= 0.0f)
-						{
-							new_total_impulse[vn_index1] = 0.0f;
-							new_total_impulse[vn_index2] = 0.0f;
-							solution_found = 1;
-							goto BLOCK_SOLVER_UPDATE;
-						}
+		if (color[i] == U32_MAX)
+		{
+			solver->scalar_vcs[solver->scalar_count++] = i;
+		}
+	}
 
-					}
-				} break;
+	u32 *first_bundle = solver->color_first_bundle;
+	for (u32 c = 0; c < CONTACT_SOLVER_COLOR_COUNT; ++c)
+	{
+		first_bundle[c] = solver->bundle_count;
+		solver->bundle_count += (color_count[c] + CONTACT_SOLVER_LANE_COUNT - 1) / CONTACT_SOLVER_LANE_COUNT;
+		color_count[c] = 0;
+	}
+	first_bundle[CONTACT_SOLVER_COLOR_COUNT] = solver->bundle_count;
+
+	if (solver->bundle_count == 0)
+	{
+		return;
+	}
+
+	solver->bundles = arena_push(mem, solver->bundle_count * sizeof(struct velocity_constraint_bundle));
+	if (solver->bundles == NULL)
+	{
+		/* out of frame memory, fall back on solving every constraint using the scalar path */
+		solver->bundle_count = 0;
+		memset(first_bundle, 0, sizeof(solver->color_first_bundle));
+		solver->scalar_count = solver->contact_count;
+		for (u32 i = 0; i < solver->contact_count; ++i)
+		{
+			solver->scalar_vcs[i] = i;
+		}
+		return;
+	}
+
+	/* empty lanes refer to the static body and have zero mass, so they never produce any impulse */
+	memset(solver->bundles, 0, solver->bundle_count * sizeof(struct velocity_constraint_bundle));
+	for (u32 b = 0; b < solver->bundle_count; ++b)
+	{
+		for (u32 l = 0; l < CONTACT_SOLVER_LANE_COUNT; ++l)
+		{
+			solver->bundles[b].vc[l] = U32_MAX;
+			solver->bundles[b].lb1[l] = solver->body_count;
+			solver->bundles[b].lb2[l] = solver->body_count;
+		}
+	}
+
+	for (u32 i = 0; i < solver->contact_count; ++i)
+	{
+		if (color[i] == U32_MAX)
+		{
+			continue;
+		}
+
+		const u32 k = color_count[color[i]]++;
+		struct velocity_constraint_bundle *bundle = solver->bundles + first_bundle[color[i]] + k / CONTACT_SOLVER_LANE_COUNT;
+		const u32 l = k % CONTACT_SOLVER_LANE_COUNT;
+		const struct velocity_constraint *vc = solver->vcs + i;
+
+		bundle->vc[l] = i;
+		bundle->lb1[l] = vc->lb1;
+		bundle->lb2[l] = vc->lb2;
+		bundle->vcp_count = (bundle->vcp_count < vc->vcp_count) ? vc->vcp_count : bundle->vcp_count;
+		bundle->inv_mass1[l] = 1.0f / solver->bodies[vc->lb1]->mass;
+		bundle->inv_mass2[l] = 1.0f / solver->bodies[vc->lb2]->mass;
+		for (u32 c = 0; c < 3; ++c)
+		{
+			for (u32 r = 0; r < 3; ++r)
+			{
+				bundle->Iw_inv1[c][r][l] = solver->Iw_inv[vc->lb1][c][r];
+				bundle->Iw_inv2[c][r][l] = solver->Iw_inv[vc->lb2][c][r];
 			}
+			bundle->normal[c][l] = vc->normal[c];
+			bundle->tangent[0][c][l] = vc->tangent[0][c];
+			bundle->tangent[1][c][l] = vc->tangent[1][c];
+		}
+		bundle->friction[l] = vc->friction;
 
-			BLOCK_SOLVER_UPDATE:
-			if (solution_found)
+		for (u32 j = 0; j < vc->vcp_count; ++j)
+		{
+			const struct velocity_constraint_point *vcp = vc->vcps + j;
+			for (u32 c = 0; c < 3; ++c)
 			{
-				for (u32 j = 0; j < vc->vcp_count; ++j)
-				{
-					struct velocity_constraint_point *vcp = vc->vcps + j;
-					const f32 delta_impulse = new_total_impulse[j] - vcp->normal_impulse;
-					vcp->normal_impulse = new_total_impulse[j];
-					
-					vec3_scale(tmp1, vc->normal, delta_impulse);
-					vec3_translate_scaled(solver->linear_velocity[vc->lb2], tmp1, 1.0f/solver->bodies[vc->lb2]->mass);
-					vec3_translate_scaled(solver->linear_velocity[vc->lb1], tmp1, -1.0f/solver->bodies[vc->lb1]->mass);
+				bundle->r1[j][c][l] = vcp->r1[c];
+				bundle->r2[j][c][l] = vcp->r2[c];
+			}
+			bundle->normal_mass[j][l] = vcp->normal_mass;
+			bundle->tangent_mass[j][0][l] = vcp->tangent_mass[0];
+			bundle->tangent_mass[j][1][l] = vcp->tangent_mass[1];
+			bundle->velocity_bias[j][l] = vcp->velocity_bias;
+			bundle->normal_impulse[j][l] = vcp->normal_impulse;
+			bundle->tangent_impulse[j][0][l] = vcp->tangent_impulse[0];
+			bundle->tangent_impulse[j][1][l] = vcp->tangent_impulse[1];
+		}
+	}
+}
 
-					vec3_cross(tmp2, vcp->r2, tmp1);
-					vec3_cross(tmp3, vcp->r1, tmp1);
+static f32xl internal_wide_dot(const f32xl a[3], const f32xl b[3])
+{
+	return f32xl_add(f32xl_add(f32xl_mul(a[0], b[0]), f32xl_mul(a[1], b[1])), f32xl_mul(a[2], b[2]));
+}
 
-					mat3_vec_mul(tmp1, solver->Iw_inv[vc->lb2], tmp2);
-					vec3_translate(solver->angular_velocity[vc->lb2], tmp1);
-					mat3_vec_mul(tmp1, solver->Iw_inv[vc->lb1], tmp3);
-					vec3_translate_scaled(solver->angular_velocity[vc->lb1], tmp1, -1.0f);
-				}
+static void internal_wide_cross(f32xl dst[3], const f32xl a[3], const f32xl b[3])
+{
+	dst[0] = f32xl_sub(f32xl_mul(a[1], b[2]), f32xl_mul(a[2], b[1]));
+	dst[1] = f32xl_sub(f32xl_mul(a[2], b[0]), f32xl_mul(a[0], b[2]));
+	dst[2] = f32xl_sub(f32xl_mul(a[0], b[1]), f32xl_mul(a[1], b[0]));
+}
+
+/* same (column major) convention as mat3_vec_mul */
+static void internal_wide_mat3_vec_mul(f32xl dst[3], const f32xl m[3][3], const f32xl v[3])
+{
+	for (u32 r = 0; r < 3; ++r)
+	{
+		dst[r] = f32xl_add(f32xl_add(f32xl_mul(v[0], m[0][r]), f32xl_mul(v[1], m[1][r])), f32xl_mul(v[2], m[2][r]));
+	}
+}
+
+struct wide_body_pair
+{
+	f32xl	v1[3];
+	f32xl	w1[3];
+	f32xl	v2[3];
+	f32xl	w2[3];
+	f32xl	inv_mass1;
+	f32xl	inv_mass2;
+	f32xl	Iw_inv1[3][3];
+	f32xl	Iw_inv2[3][3];
+};
+
+/* returns dot(dir, v2 + w2 x r2 - v1 - w1 x r1) */
+static f32xl internal_wide_seperating_velocity(const struct wide_body_pair *p, const f32xl r1[3], const f32xl r2[3], const f32xl dir[3])
+{
+	f32xl c1[3], c2[3], dv[3];
+	internal_wide_cross(c1, p->w1, r1);
+	internal_wide_cross(c2, p->w2, r2);
+	for (u32 c = 0; c < 3; ++c)
+	{
+		dv[c] = f32xl_sub(f32xl_add(p->v2[c], c2[c]), f32xl_add(p->v1[c], c1[c]));
+	}
+	return internal_wide_dot(dir, dv);
+}
+
+static void internal_wide_apply_impulse(struct wide_body_pair *p, const f32xl r1[3], const f32xl r2[3], const f32xl dir[3], const f32xl impulse)
+{
+	f32xl P[3], c[3], Ic[3];
+	for (u32 i = 0; i < 3; ++i)
+	{
+		P[i] = f32xl_mul(dir[i], impulse);
+		p->v1[i] = f32xl_sub(p->v1[i], f32xl_mul(p->inv_mass1, P[i]));
+		p->v2[i] = f32xl_add(p->v2[i], f32xl_mul(p->inv_mass2, P[i]));
+	}
+
+	internal_wide_cross(c, r1, P);
+	internal_wide_mat3_vec_mul(Ic, (const f32xl (*)[3]) p->Iw_inv1, c);
+	for (u32 i = 0; i < 3; ++i)
+	{
+		p->w1[i] = f32xl_sub(p->w1[i], Ic[i]);
+	}
+
+	internal_wide_cross(c, r2, P);
+	internal_wide_mat3_vec_mul(Ic, (const f32xl (*)[3]) p->Iw_inv2, c);
+	for (u32 i = 0; i < 3; ++i)
+	{
+		p->w2[i] = f32xl_add(p->w2[i], Ic[i]);
+	}
+}
+
+static void internal_solve_bundle(struct contact_solver *solver, struct velocity_constraint_bundle *bundle)
+{
+	f32 gather[12][CONTACT_SOLVER_LANE_COUNT];
+	struct wide_body_pair p;
+
+	/* gather body velocities into lanes; no dynamic body is shared between lanes */
+	for (u32 l = 0; l < CONTACT_SOLVER_LANE_COUNT; ++l)
+	{
+		const u32 lb1 = bundle->lb1[l];
+		const u32 lb2 = bundle->lb2[l];
+		for (u32 c = 0; c < 3; ++c)
+		{
+			gather[0 + c][l] = solver->linear_velocity[lb1][c];
+			gather[3 + c][l] = solver->angular_velocity[lb1][c];
+			gather[6 + c][l] = solver->linear_velocity[lb2][c];
+			gather[9 + c][l] = solver->angular_velocity[lb2][c];
+		}
+	}
+
+	f32xl n[3], t[2][3];
+	for (u32 c = 0; c < 3; ++c)
+	{
+		p.v1[c] = f32xl_load(gather[0 + c]);
+		p.w1[c] = f32xl_load(gather[3 + c]);
+		p.v2[c] = f32xl_load(gather[6 + c]);
+		p.w2[c] = f32xl_load(gather[9 + c]);
+		n[c] = f32xl_load(bundle->normal[c]);
+		t[0][c] = f32xl_load(bundle->tangent[0][c]);
+		t[1][c] = f32xl_load(bundle->tangent[1][c]);
+		for (u32 r = 0; r < 3; ++r)
+		{
+			p.Iw_inv1[c][r] = f32xl_load(bundle->Iw_inv1[c][r]);
+			p.Iw_inv2[c][r] = f32xl_load(bundle->Iw_inv2[c][r]);
+		}
+	}
+	p.inv_mass1 = f32xl_load(bundle->inv_mass1);
+	p.inv_mass2 = f32xl_load(bundle->inv_mass2);
+	const f32xl friction = f32xl_load(bundle->friction);
+	const f32xl zero = f32xl_set1(0.0f);
+
+	f32xl r1[3], r2[3];
+
+	/* solve friction constraints first, since normal constraints are more important */
+	for (u32 j = 0; j < bundle->vcp_count; ++j)
+	{
+		for (u32 c = 0; c < 3; ++c)
+		{
+			r1[c] = f32xl_load(bundle->r1[j][c]);
+			r2[c] = f32xl_load(bundle->r2[j][c]);
+		}
+
+		const f32xl impulse_bound = f32xl_mul(friction, f32xl_load(bundle->normal_impulse[j]));
+		const f32xl neg_impulse_bound = f32xl_sub(zero, impulse_bound);
+		for (u32 k = 0; k < 2; ++k)
+		{
+			const f32xl seperating_velocity = internal_wide_seperating_velocity(&p, r1, r2, t[k]);
+			const f32xl old_impulse = f32xl_load(bundle->tangent_impulse[j][k]);
+			const f32xl delta = f32xl_mul(f32xl_load(bundle->tangent_mass[j][k]), seperating_velocity);
+			const f32xl new_impulse = f32xl_min(f32xl_max(f32xl_sub(old_impulse, delta), neg_impulse_bound), impulse_bound);
+			f32xl_store(bundle->tangent_impulse[j][k], new_impulse);
+			internal_wide_apply_impulse(&p, r1, r2, t[k], f32xl_sub(new_impulse, old_impulse));
+		}
+	}
+
+	for (u32 j = 0; j < bundle->vcp_count; ++j)
+	{
+		for (u32 c = 0; c < 3; ++c)
+		{
+			r1[c] = f32xl_load(bundle->r1[j][c]);
+			r2[c] = f32xl_load(bundle->r2[j][c]);
+		}
+
+		const f32xl seperating_velocity = internal_wide_seperating_velocity(&p, r1, r2, n);
+		const f32xl old_impulse = f32xl_load(bundle->normal_impulse[j]);
+		const f32xl delta = f32xl_mul(f32xl_load(bundle->normal_mass[j]), f32xl_sub(f32xl_load(bundle->velocity_bias[j]), seperating_velocity));
+		const f32xl new_impulse = f32xl_max(f32xl_add(old_impulse, delta), zero);
+		f32xl_store(bundle->normal_impulse[j], new_impulse);
+		internal_wide_apply_impulse(&p, r1, r2, n, f32xl_sub(new_impulse, old_impulse));
+	}
+
+	for (u32 c = 0; c < 3; ++c)
+	{
+		f32xl_store(gather[0 + c], p.v1[c]);
+		f32xl_store(gather[3 + c], p.w1[c]);
+		f32xl_store(gather[6 + c], p.v2[c]);
+		f32xl_store(gather[9 + c], p.w2[c]);
+	}
+
+	/* scatter; the static slot is shared by every bundle of a color (and by empty lanes), so it is never
+	 * written, as bundles of the same color may be solved concurrently */
+	const u32 static_slot = solver->body_count;
+	for (u32 l = 0; l < CONTACT_SOLVER_LANE_COUNT; ++l)
+	{
+		const u32 lb1 = bundle->lb1[l];
+		const u32 lb2 = bundle->lb2[l];
+		if (lb1 != static_slot)
+		{
+			for (u32 c = 0; c < 3; ++c)
+			{
+				solver->linear_velocity[lb1][c] = gather[0 + c][l];
+				solver->angular_velocity[lb1][c] = gather[3 + c][l];
+			}
+		}
+
+		if (lb2 != static_slot)
+		{
+			for (u32 c = 0; c < 3; ++c)
+			{
+				solver->linear_velocity[lb2][c] = gather[6 + c][l];
+				solver->angular_velocity[lb2][c] = gather[9 + c][l];
+			}
+		}
+	}
+}
+
+void contact_solver_iterate_wide_velocity_constraints(struct contact_solver *solver)
+{
+	for (u32 b = 0; b < solver->bundle_count; ++b)
+	{
+		internal_solve_bundle(solver, solver->bundles + b);
+	}
+
+	for (u32 i = 0; i < solver->scalar_count; ++i)
+	{
+		internal_iterate_velocity_constraint(solver, solver->vcs + solver->scalar_vcs[i]);
+	}
+}
+
+static void thread_solve_bundles(void *task_addr)
+{
+	struct task *task = task_addr;
+	struct contact_solver *solver = task->input;
+	struct velocity_constraint_bundle *bundle = task->range->base;
+	for (u64 i = 0; i < task->range->count; ++i)
+	{
+		internal_solve_bundle(solver, bundle + i);
+	}
+}
+
+void contact_solver_parallel_iterate_wide_velocity_constraints(struct arena *mem_task, struct contact_solver *solver)
+{
+	/* 
+	 * Bundles of the same color share no dynamic bodies, so each color can be split freely between workers.
+	 * Colors are still solved in order, with the main thread waiting on each color before starting the next.
+	 */
+	for (u32 c = 0; c < CONTACT_SOLVER_COLOR_COUNT; ++c)
+	{
+		const u32 first = solver->color_first_bundle[c];
+		const u32 count = solver->color_first_bundle[c+1] - first;
+		if (count < CONTACT_SOLVER_PARALLEL_BUNDLE_MIN || g_task_ctx->worker_count <= 1)
+		{
+			for (u32 b = first; b < first + count; ++b)
+			{
+				internal_solve_bundle(solver, solver->bundles + b);
+			}
+			continue;
+		}
+
+		arena_push_record(mem_task);
+		struct task_bundle *bundle = task_bundle_split_range(
+				mem_task,
+				&thread_solve_bundles,
+				g_task_ctx->worker_count,
+				solver->bundles + first,
+				count,
+				sizeof(struct velocity_constraint_bundle),
+				solver);
+
+		task_main_master_run_available_jobs();
+		task_bundle_wait(bundle);
+		task_bundle_release(bundle);
+		arena_pop_record(mem_task);
+	}
+
+	for (u32 i = 0; i < solver->scalar_count; ++i)
+	{
+		internal_iterate_velocity_constraint(solver, solver->vcs + solver->scalar_vcs[i]);
+	}
+}
+
+void contact_solver_store_wide_impulses(struct contact_solver *solver)
+{
+	for (u32 b = 0; b < solver->bundle_count; ++b)
+	{
+		const struct velocity_constraint_bundle *bundle = solver->bundles + b;
+		for (u32 l = 0; l < CONTACT_SOLVER_LANE_COUNT; ++l)
+		{
+			if (bundle->vc[l] == U32_MAX)
+			{
+				continue;
+			}
+
+			struct velocity_constraint *vc = solver->vcs + bundle->vc[l];
+			for (u32 j = 0; j < vc->vcp_count; ++j)
+			{
+				vc->vcps[j].normal_impulse = bundle->normal_impulse[j][l];
+				vc->vcps[j].tangent_impulse[0] = bundle->tangent_impulse[j][0][l];
+				vc->vcps[j].tangent_impulse[1] = bundle->tangent_impulse[j][1][l];
 			}
 		}
 	}
@@ -27,6 +27,7 @@
 #include "hash_map.h"
 #include "bit_vector.h"
 #include "array_list.h"
+#include "kas_vector.h"
 #include "kas_math.h"
 
 struct rigid_body;
@@ -63,7 +64,7 @@ and current contacts, and if necessary, invalidate any contact data.
 Frame layout:
 	1. generate_contacts
  	2. c_db_new_frame(contact_count)	// alloc memory for frame contacts
- 	3. c_db_add_contact(i1, i2, contact)	// add all new contacts 
+ 	3. reserve and link all new contacts	// see batched contact insertion below
  	4. solve
  	5. invalidate any contacts before caching them.
  	6. switch frame and cache 
@@ -110,8 +111,6 @@ void 			c_db_free(struct contact_database *c_db);
 void			c_db_flush(struct contact_database *c_db);
 void			c_db_validate(const struct physics_pipeline *pipeline);
 void			c_db_clear_frame(struct contact_database *c_db);
-/* Update or add new contact depending on if the contact persisted from prevous frame. */
-struct contact *	c_db_add_contact(struct physics_pipeline *pipeline, const struct contact_manifold *cm, const u32 i1, const u32 i2);
 void 			c_db_remove_contact(struct physics_pipeline *pipeline, const u64 key, const u32 index);
 /* Remove all contacts associated with the given body */
 void			c_db_remove_body_contacts(struct physics_pipeline *pipeline, const u32 body_index);
@@ -121,6 +120,35 @@ struct contact *	c_db_lookup_contact(const struct contact_database *c_db, const
 u32 			c_db_lookup_contact_index(const struct contact_database *c_db, const u32 i1, const u32 i2);
 void 			c_db_update_persistent_contacts_usage(struct contact_database *c_db);
 
+/*
+ * Batched contact insertion
+ * =========================
+ * (1) narrowphase workers update persisting contacts in place using c_db_update_persisting_contact.
+ * (2) the main thread reserves any new contacts and sat caches in a deterministic order. 
+ * (3) shards link the reserved nodes into the hash maps and body contact lists; shard i only touches hash
+ *     buckets and bodies b with (b % shard_count == i), so no synchronization between shards is needed.
+ */
+
+struct c_db_link
+{
+	const struct contact_manifold *	cm;	/* manifold of new contact */
+	u32				index;	/* reserved contact index  */
+};
+
+/* Update the persisting contact of the manifold from any thread and return its index, or NLL_NULL if no such contact 
+ * exists. Must not run concurrently with contact insertion or removal. */
+u32			c_db_update_persisting_contact(const struct contact_database *c_db, const struct contact_manifold *cm);
+/* reserve a new contact node between bodies i1 and i2 and return its index; the contact is unlinked until c_db_shard_link_contacts */
+u32 			c_db_reserve_contact(struct physics_pipeline *pipeline, const u32 i1, const u32 i2);
+/* link and initiate any reserved contacts owned by the given shard */
+void 			c_db_shard_link_contacts(struct physics_pipeline *pipeline, const struct c_db_link *link, const u32 link_count, const u32 shard, const u32 shard_count);
+/* reserve a new sat cache and return its index; the cache is not found in lookups until sat_cache_shard_link */
+u32 			sat_cache_reserve(struct contact_database *c_db, const struct sat_cache *sat_cache);
+/* link any reserved sat caches owned by the given shard */
+void 			sat_cache_shard_link(struct contact_database *c_db, const u32 *index, const u32 index_count, const u32 shard, const u32 shard_count);
+/* make sure that reserved contacts and sat caches can be linked concurrently without any reallocation */
+void			c_db_shard_link_prepare(struct contact_database *c_db);
+
 /* add sat_cache to pipeline; if it already exists, reset the cache. */
 void 			sat_cache_add(struct contact_database *c_db, const struct sat_cache *sat_cache);
 /* lookup sat_cache to pipeline; if it does't exist, return NULL. */
@@ -205,6 +233,17 @@ FRAME n+1:
 Assuming that the island only contains linked lists of indices to various data, we wish to fully defer any
 lookups into that data until the Solver stage. [1] We traverse the lists and retrieve the wanted data. This
 data (ListData) is kept throughout [2], [3], and discarded at [4] when islands are split/merged.
+
+Instead of linked lists, the bodies and contacts of an island are stored as contiguous ranges in is_db.body and
+is_db.contact, so [1] only has to read two slices. At [4], islands connected by new contacts are merged using a
+concurrent union-find over island indices (each root being the smallest island index of its component). A growing
+root has its body range moved to the body tail, the ranges of the islands merged into it are appended, and only
+those bodies are relabeled. Once contacts have been removed, the contact range of every island given new contacts
+or tagged for splitting is gathered again at the contact tail from the contact lists of its bodies; untouched
+islands keep their ranges. Any island tagged for splitting is then flood-filled as its own task; the flood fill
+sorts the island's ranges by connected component in place, so each resulting island is again a contiguous
+sub-range. Abandoned ranges are reclaimed by copying all live ranges into fresh memory once a tail has grown past
+twice its length at the last compaction, so the cost is amortised over the appended entries.
 */
 
 #define BODY_NO_ISLAND_INDEX 	U32_MAX
@@ -244,11 +283,8 @@ struct island
 	/* Persistent Island */
 	u32 flags;
 
-	u32 body_first;			/* index into first node in island_body_lists 		*/
-	u32 contact_first;		/* index into first node in island_contact_lists 	*/
-
-	u32 body_last;			/* index into last node in island_body_lists 		*/
-	u32 contact_last;		/* index into last node in island_contact_lists 	*/
+	u32 body_offset;		/* offset of island's body range in is_db.body 		*/
+	u32 contact_offset;		/* offset of island's contact range in is_db.contact 	*/
 
 	u32 body_count;
 	u32 contact_count;
@@ -258,25 +294,29 @@ struct island
 #endif
 };
 
-struct is_index_entry
-{
-	u32 index;
-	u32 next;
-};
-
 struct island_database
 {
 	/* PERSISTENT DATA */
 	struct bit_vec island_usage;			/* NOT GROWABLE, bit vector for islands in use */
-	struct array_list *islands;			/* NOT GROWABLE, set to max_body_count 	*/
-	struct array_list *island_contact_lists;	/* GROWABLE, list nodes to contacts 	*/
-	struct array_list *island_body_lists;		/* NOT GROWABLE, list nodes to bodies   */
+	struct array_list *islands;			/* GROWABLE, island slots 		*/
+	u32 *body;					/* GROWABLE, contiguous body ranges of islands 	*/
+	u32 *contact;					/* GROWABLE, contiguous contact ranges of islands */
+	u32 body_length;
+	u32 contact_length;
+	u32 body_tail;					/* end of last body range, new and merged ranges are appended here */
+	u32 contact_tail;				/* end of last contact range, gathered ranges are appended here */
+	u32 body_compact;				/* body_tail after the last compaction */
+	u32 contact_compact;				/* contact_tail after the last compaction */
 
 	/* FRAME DATA */
 	u32 *possible_splits;				/* Islands in which a contact has been broken during frame */
 	u32 possible_splits_count;
+	u32 *dirty;					/* Islands given new contacts during frame */
+	u32 dirty_count;
 };
 
+#define IS_DB_RANGE_COMPACT_MIN	1024		/* tail growth (in entries) below which ranges are never compacted */
+
 #ifdef KAS_PHYSICS_DEBUG
 #define IS_DB_VALIDATE(pipeline)	is_db_validate((pipeline)
 #else
@@ -286,7 +326,7 @@ struct island_database
 struct physics_pipeline;
 
 /* Setup and allocate memory for new database */
-struct island_database 	is_db_alloc(struct arena *mem_persistent, const u32 initial_size);
+struct island_database 	is_db_alloc(const u32 initial_size);
 /* Free any heap memory */
 void		       	is_db_free(struct island_database *is_db);
 /* Flush / reset the island database */
@@ -303,8 +343,6 @@ void is_db_print_island(FILE *file, const struct island_database *is_db, const s
 void 			is_db_validate(const struct physics_pipeline *pipeline);
 /* Setup new island from single body */
 struct island *		is_db_init_island_from_body(struct physics_pipeline *pipeline, const u32 body);
-/* Add contact to island */
-void 			is_db_add_contact_to_island(struct island_database *is_db, const u32 island, const u32 contact);
 /* Return island that body is assigned to */
 struct island *		is_db_body_to_island(struct physics_pipeline *pipeline, const u32 body);
 /* Reserve enough memory to fit all possible split */
@@ -313,10 +351,14 @@ void			is_db_reserve_splits_memory(struct arena *mem_frame, struct island_databa
 void			is_db_release_unused_splits_memory(struct arena *mem_frame, struct island_database *is_db);
 /* Tag the island that the body is in for splitting and push it onto split memory (if we havn't already) */
 void 			is_db_tag_for_splitting(struct physics_pipeline *pipeline, const u32 body);
-/* Merge islands (Or simply update if new local contact) using new contact */
-void 			is_db_merge_islands(struct physics_pipeline *pipeline, const u32 ci, const u32 b1, const u32 b2);
-/* Split island, or remake if no split happens: TODO: Make thread-safe  */
+/* Merge any islands connected by the new contacts using a concurrent union-find over islands, and push the islands given new contacts onto dirty */
+void 			is_db_merge_islands(struct arena *mem_frame, struct physics_pipeline *pipeline, const u32 *contact, const u32 contact_count);
+/* Gather the contact ranges of dirty islands and islands tagged for splitting, compacting the ranges when needed */
+void			is_db_update_ranges(struct arena *mem_frame, struct physics_pipeline *pipeline);
+/* Split island, or remake if no split happens. Requires valid ranges. */
 void 			is_db_split_island(struct arena *mem_tmp, struct physics_pipeline *pipeline, const u32 island_to_split);
+/* Split all islands tagged for splitting, flood-filling the islands in parallel. Requires ranges updated by is_db_update_ranges. */
+void 			is_db_split_islands(struct arena *mem_frame, struct physics_pipeline *pipeline);
 /* Solve island constraints, and update bodies in pipeline */
 //void 			island_solve(struct arena *mem_frame, struct physics_pipeline *pipeline, struct island *is, const f32 timestep);
 
@@ -353,6 +395,12 @@ struct island_solve_input
  */
 void	thread_island_solve(void *task_input);
 
+/*
+ * Same as thread_island_solve, but run on the main thread and for large islands; the velocity iterations of 
+ * the island are split across all workers, see contact_solver_parallel_iterate_wide_velocity_constraints.
+ */
+void	island_solve_parallel(struct arena *mem_frame, struct island_solve_input *args);
+
 /*
 =================================================================================================================
 |						Contact Solver				  	      	    	|
@@ -384,6 +432,9 @@ struct contact_solver_config
 {
 	u32 	iteration_count;	/* velocity solver iteration count */
 	u32 	block_solver;		/* bool : Use block solver when applicable */
+	u32 	wide_solver;		/* bool : Solve graph colored constraint bundles using simd lanes */
+	u32 	split_island_body_count;/* Range[1, U32_MAX] : awake islands with at least this many bodies have
+					   their colored bundles solved by all workers (requires wide_solver) */
 	u32 	warmup_solver;		/* bool : Should warmup solver when applicable */
 	vec3 	gravity;
 	f32 	baumgarte_constant;  	/* Range[0.0, 1.0] : Determine how quickly contacts are resolved, 1.0f max 
@@ -403,6 +454,8 @@ struct contact_solver_config
 
 	/* Pending updates */
 	u32 pending_block_solver;		
+	u32 pending_wide_solver;		
+	u32 pending_split_island_body_count;
 	u32 pending_warmup_solver;		
 	u32 pending_sleep_enabled;		
 	u32 pending_iteration_count;
@@ -415,7 +468,7 @@ struct contact_solver_config
 
 extern struct contact_solver_config *g_solver_config;
 
-void	contact_solver_config_init(const u32 iteration_count, const u32 block_solver, const u32 warmup_solver, const vec3 gravity, const f32 baumgarte_constant, const f32 max_condition, const f32 linear_dampening, const f32 angular_dampening, const f32 linear_slop, const f32 restitution_threshold, const u32 sleep_enabled, const f32 sleep_time_threshold, const f32 sleep_linear_velocity_sq_limit, const f32 sleep_angular_velocity_sq_limit);
+void	contact_solver_config_init(const u32 iteration_count, const u32 block_solver, const u32 wide_solver, const u32 split_island_body_count, const u32 warmup_solver, const vec3 gravity, const f32 baumgarte_constant, const f32 max_condition, const f32 linear_dampening, const f32 angular_dampening, const f32 linear_slop, const f32 restitution_threshold, const u32 sleep_enabled, const f32 sleep_time_threshold, const f32 sleep_linear_velocity_sq_limit, const f32 sleep_angular_velocity_sq_limit);
 
 
 /*
@@ -462,6 +515,44 @@ struct velocity_constraint
 	u32	block_solve;	/* if config->block_solver && condition number of block normal mass is ok, then = 1 */
 };
 
+/*
+velocity_constraint_bundle
+==========================
+Structure of arrays copy of up to CONTACT_SOLVER_LANE_COUNT velocity constraints, used by the wide solver.
+Constraints are graph colored beforehand so that no two lanes in a bundle share a dynamic body; the static
+body slot may be shared since its velocity is never changed. Unused lanes and contact points have zero mass
+and thus never produce any impulse. Arrays are indexed [point][axis][lane].
+*/
+
+#define CONTACT_SOLVER_LANE_COUNT	4
+#define CONTACT_SOLVER_COLOR_COUNT	12	/* constraints that can't be colored are solved using the scalar path */
+#define CONTACT_SOLVER_PARALLEL_BUNDLE_MIN 8	/* colors with fewer bundles are solved on the calling thread */
+
+struct velocity_constraint_bundle
+{
+	u32	vc[CONTACT_SOLVER_LANE_COUNT];		/* velocity constraint index, U32_MAX for empty lane */
+	u32	lb1[CONTACT_SOLVER_LANE_COUNT];
+	u32	lb2[CONTACT_SOLVER_LANE_COUNT];
+	u32	vcp_count;				/* max vcp_count of constraints in bundle */
+
+	f32	inv_mass1[CONTACT_SOLVER_LANE_COUNT];
+	f32	inv_mass2[CONTACT_SOLVER_LANE_COUNT];
+	f32	Iw_inv1[3][3][CONTACT_SOLVER_LANE_COUNT];
+	f32	Iw_inv2[3][3][CONTACT_SOLVER_LANE_COUNT];
+
+	f32	normal[3][CONTACT_SOLVER_LANE_COUNT];
+	f32	tangent[2][3][CONTACT_SOLVER_LANE_COUNT];
+	f32	friction[CONTACT_SOLVER_LANE_COUNT];
+
+	f32	r1[4][3][CONTACT_SOLVER_LANE_COUNT];
+	f32	r2[4][3][CONTACT_SOLVER_LANE_COUNT];
+	f32	normal_mass[4][CONTACT_SOLVER_LANE_COUNT];
+	f32	tangent_mass[4][2][CONTACT_SOLVER_LANE_COUNT];
+	f32	velocity_bias[4][CONTACT_SOLVER_LANE_COUNT];
+	f32	normal_impulse[4][CONTACT_SOLVER_LANE_COUNT];
+	f32	tangent_impulse[4][2][CONTACT_SOLVER_LANE_COUNT];
+};
+
 struct contact_solver
 {
 	f32 			timestep;
@@ -475,6 +566,13 @@ struct contact_solver
 	/* temporary state of bodies in island, static bodies index last element */
 	vec3ptr			linear_velocity;
 	vec3ptr			angular_velocity;
+
+	/* wide solver state, set in contact_solver_init_wide_constraints */
+	struct velocity_constraint_bundle *bundles;
+	u32			bundle_count;
+	u32			color_first_bundle[CONTACT_SOLVER_COLOR_COUNT + 1];	/* bundles of color c: [first[c], first[c+1]) */
+	u32 *			scalar_vcs;	/* constraints solved using the scalar path (block solved or uncolored) */
+	u32			scalar_count;
 };
 
 struct contact_solver *	contact_solver_init_body_data(struct arena *mem, struct island *is, const f32 timestep);
@@ -482,6 +580,15 @@ void 			contact_solver_init_velocity_constraints(struct arena *mem, struct conta
 void 			contact_solver_iterate_velocity_constraints(struct contact_solver *solver);
 void 			contact_solver_warmup(struct contact_solver *solver, const struct island *is);
 void 			contact_solver_cache_impulse_data(struct contact_solver *solver, const struct island *is);
+/* graph color constraints (after warmup) into bundles for the wide solver */
+void 			contact_solver_init_wide_constraints(struct arena *mem, struct contact_solver *solver);
+/* solve colored bundles using simd lanes, followed by any remaining scalar constraints */
+void 			contact_solver_iterate_wide_velocity_constraints(struct contact_solver *solver);
+/* same as contact_solver_iterate_wide_velocity_constraints, but each color is split across all workers. Must
+ * be called from the main thread. */
+void 			contact_solver_parallel_iterate_wide_velocity_constraints(struct arena *mem_task, struct contact_solver *solver);
+/* write back bundle impulses to solver->vcs, must be called before contact_solver_cache_impulse_data */
+void 			contact_solver_store_wide_impulses(struct contact_solver *solver);
 
 /*
 =================================================================================================================
@@ -500,18 +607,22 @@ physics engine entity
 #define RB_AWAKE		((u32) 1 << 2)
 #define RB_ISLAND		((u32) 1 << 3)
 #define RB_MARKED_FOR_REMOVAL	((u32) 1 << 4)
+#define RB_PROXY_MOVED		((u32) 1 << 5)	/* proxy (re)inserted since last broadphase, body is in move buffer */
+#define RB_BULLET		((u32) 1 << 6)	/* fast body, swept in broadphase and clamped to its time of impact against non-bullets */
 
 #define RB_IS_ACTIVE(b)		((b->flags & RB_ACTIVE) >> 0u)
 #define RB_IS_DYNAMIC(b)	((b->flags & RB_DYNAMIC) >> 1u)
 #define RB_IS_AWAKE(b)		((b->flags & RB_AWAKE) >> 2u)
 #define RB_IS_ISLAND(b)		((b->flags & RB_ISLAND) >> 3u)
 #define RB_IS_MARKED(b)		((b->flags & RB_MARKED_FOR_REMOVAL) >> 4u)
+#define RB_IS_BULLET(b)		((b->flags & RB_BULLET) >> 6u)
 
 #define IS_ACTIVE(flags)	((flags & RB_ACTIVE) >> 0u)
 #define IS_DYNAMIC(flags)	((flags & RB_DYNAMIC) >> 1u)
 #define IS_AWAKE(flags)		((flags & RB_AWAKE) >> 2u)
 #define IS_ISLAND(flags)	((flags & RB_ISLAND) >> 3u)
 #define IS_MARKED(flags)	((flags & RB_MARKED_FOR_REMOVAL) >> 4u)
+#define IS_BULLET(flags)	((flags & RB_BULLET) >> 6u)
 
 struct rigid_body
 {
@@ -529,6 +640,7 @@ struct rigid_body
 	vec3 		linear_momentum;   	/* L = mv */
 
 	u32		first_contact_index;
+	u32		first_proxy_pair_index;
 	u32		island_index;
 
 	/* static state */
@@ -568,6 +680,7 @@ struct rigid_body_prefab
 	f32 		friction;		/* Range [0.0, 1.0f] : bound tangent impulses to 
 						   mix(b1->friction, b2->friction)*(normal impuse) */
 	u32		dynamic;		/* dynamic body is true, static if false */
+	u32		bullet;			/* continuous collision against non-bullets, see physics_pipeline_rigid_body_set_bullet */
 };
 
 void 	prefab_statics_setup(struct rigid_body_prefab *prefab, struct collision_shape *shape, const f32 density);
@@ -579,6 +692,10 @@ void 	prefab_statics_setup(struct rigid_body_prefab *prefab, struct collision_sh
 
 #define COLLISION_MARGIN_DEFAULT 5.0f * UNITS_PER_MILIMETER 
 
+#define STATIC_TREE_BIN_COUNT			16
+#define STATIC_TREE_REBUILD_EDIT_MIN		16	/* fewest static edits that trigger a rebuild */
+#define STATIC_TREE_REBUILD_EDIT_FRACTION	4	/* rebuild once FRACTION*edits >= static leaf count */
+
 #define UNIFORM_SIZE 256
 #define GRAVITY_CONSTANT_DEFAULT 9.80665f
 
@@ -678,6 +795,24 @@ enum rigid_body_color_mode
 };
 
 extern const char **body_color_mode_str;
+
+/*
+proxy_pair
+==========
+Persistent broadphase pair; the pair set is only updated by querying proxies in the move buffer against the
+dynamic tree, so that broadphase cost scales with the number of moving bodies rather than the total count.
+A pair is kept as long as the fat proxy boxes overlap, and at least one of the bodies is dynamic. Pairs are
+linked into per-body lists (list 0 owned by id1, list 1 by id2) so that only the pairs of moved or removed
+bodies are revisited, and mirrored in a dense overlap array which is the frame's proxy overlap set.
+*/
+struct proxy_pair
+{
+	NLL_SLOT_STATE;
+	u32	id1;		/* id1 < id2 */
+	u32	id2;
+	u32	overlap_index;	/* index of pair in proxy_pair_overlap */
+};
+
 /*
  * Physics Pipeline
  */
@@ -701,6 +836,13 @@ struct physics_pipeline
 	struct dll		event_list;
 
 	struct bvh 		dynamic_tree;
+	struct bvh 		static_tree;		/* static body proxies, edited incrementally and rebuilt (binned SAH) once edits pile up */
+	u32			static_tree_dirty;	/* rebuild pending */
+	u32			static_tree_edit_count;	/* static inserts and removals since last rebuild */
+	stack_u32		proxy_move;		/* move buffer: bodies whose proxies moved since last broadphase */
+	struct nll		proxy_pair_net;		/* persistent set of overlapping proxy pairs */
+	struct hash_map *	proxy_pair_map;		
+	struct vector		proxy_pair_overlap;	/* dense (id1, id2) array of the persistent pairs */
 
 	struct contact_database	c_db;
 	struct island_database 	is_db;
@@ -718,7 +860,12 @@ struct physics_pipeline
 	u32			contact_new_count;
 	u32			proxy_overlap_count;
 	u32			cm_count;
+	u32			sat_cache_hit_count;	/* hull pairs reusing their cached axis or feature */
+	u32			sat_cache_miss_count;	/* hull pairs running the full SAT */
+	u32			bullet_count;
+	u32			ccd_hit_count;		/* bullets clamped to their time of impact */
 	u32 *			contact_new;
+	u32 *			bullet;			/* awake dynamic bullets, collected in broadphase */
 	struct dbvh_overlap *	proxy_overlap;
 	struct contact_manifold *cm;
 
@@ -756,6 +903,8 @@ void 			physics_pipeline_tick(struct physics_pipeline *pipeline);
 struct slot		physics_pipeline_rigid_body_alloc(struct physics_pipeline *pipeline, struct rigid_body_prefab *prefab, const vec3 position, const quat rotation, const u32 entity);
 /* deallocate a collision shape associated with the given handle. If no shape is found, do nothing */
 void			physics_pipeline_rigid_body_tag_for_removal(struct physics_pipeline *pipeline, const u32 handle);
+/* set or clear continuous collision detection for the given body. Only convex dynamic bodies are swept, and never against other bullets (bullet pairs may tunnel). Applied on alloc from prefab->bullet. */
+void			physics_pipeline_rigid_body_set_bullet(struct physics_pipeline *pipeline, const u32 handle, const u32 bullet);
 /* validate and assert internal state of physics pipeline */
 void			physics_pipeline_validate(const struct physics_pipeline *pipeline);
 /* If hit, return parameter (body,t) of ray at first collision. Otherwise return (U32_MAX, F32_INFINITY) */
@@ -20,72 +20,53 @@
 #include "sys_common.h"
 #include "dynamics.h"
 #include "quaternion.h"
+#include "math_batch.h"
 
-/* Add new body to island */
-static void is_db_internal_add_body_to_island(struct physics_pipeline *pipeline, struct island *is, const u32 body)
+static void is_db_internal_reserve_range_memory(u32 **range, u32 *length, const u32 required)
 {
-	kas_assert(is->body_first != ISLAND_NULL && is->body_last != ISLAND_NULL);
-
-	const u32 is_index = (u32) array_list_index(pipeline->is_db.islands, is);
-
-	struct rigid_body *b = pool_address(&pipeline->body_pool, body);
-	b->island_index = is_index;
-
-	const u32 b_index = (u32) array_list_reserve_index(pipeline->is_db.island_body_lists);
-	struct is_index_entry *entry = array_list_address(pipeline->is_db.island_body_lists, b_index);
-
-	entry->next = is->body_first;
-	entry->index = body;
-	is->body_first = b_index;
-	is->body_count += 1;
+	if (*length < required)
+	{
+		*length = power_of_two_ceil(required);
+		*range = realloc(*range, *length * sizeof(u32));
+		if (!*range)
+		{
+			log_string(T_PHYSICS, S_FATAL, "Failed to grow island range memory, exiting.");
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+	}
 }
 
-/* Add new contact to island */
-static void is_db_internal_add_contact_to_island(struct island_database *is_db, struct island *is, const u32 contact)
+/* Reserve new island slot, returns island index */
+static u32 is_db_internal_island_alloc(struct physics_pipeline *pipeline)
 {
-	const u32 c_index = (u32) array_list_reserve_index(is_db->island_contact_lists);
-	struct is_index_entry *entry = array_list_address(is_db->island_contact_lists, c_index);
-
-	entry->next = is->contact_first;
-	entry->index = contact;
-	is->contact_first = c_index;
-	is->contact_count += 1;
-
-	if (is->contact_last == ISLAND_NULL)
+	const u32 is_index = (u32) array_list_reserve_index(pipeline->is_db.islands);
+	PHYSICS_EVENT_ISLAND_NEW(pipeline, is_index);
+	if (pipeline->is_db.island_usage.bit_count <= is_index)
 	{
-		is->contact_last = c_index;
+		bit_vec_increase_size(&pipeline->is_db.island_usage, power_of_two_ceil(is_index+1), 0);
 	}
-}
+	bit_vec_set_bit(&pipeline->is_db.island_usage, is_index, 1);
 
-void is_db_add_contact_to_island(struct island_database *is_db, const u32 island, const u32 contact)
-{
-	struct island *is = array_list_address(is_db->islands, island);
-	is_db_internal_add_contact_to_island(is_db, is, contact);
+	struct island *is = array_list_address(pipeline->is_db.islands, is_index);
+	is->flags = g_solver_config->sleep_enabled * (ISLAND_AWAKE | ISLAND_SLEEP_RESET);
+
+	return is_index;
 }
 
 struct island *is_db_init_island_from_body(struct physics_pipeline *pipeline, const u32 body)
 {
+	struct island_database *is_db = &pipeline->is_db;
 	struct rigid_body *b = pool_address(&pipeline->body_pool, body);
-	b->island_index = (u32) array_list_reserve_index(pipeline->is_db.islands);
-	PHYSICS_EVENT_ISLAND_NEW(pipeline, b->island_index);
-	if (pipeline->is_db.island_usage.bit_count <= b->island_index)
-	{
-		bit_vec_increase_size(&pipeline->is_db.island_usage, power_of_two_ceil(b->island_index+1), 0);
-	}
-	bit_vec_set_bit(&pipeline->is_db.island_usage, b->island_index, 1);
+	b->island_index = is_db_internal_island_alloc(pipeline);
 
-	struct island *is = array_list_address(pipeline->is_db.islands, b->island_index);
-	is->contact_first = ISLAND_NULL;
-	is->contact_last = ISLAND_NULL;
-	is->contact_count = 0;
-	is->body_first = (u32) array_list_reserve_index(pipeline->is_db.island_body_lists);
-	is->body_last = is->body_first;
+	/* append body range, the ranges are compacted once the tail has grown enough */
+	is_db_internal_reserve_range_memory(&is_db->body, &is_db->body_length, is_db->body_tail + 1);
+	struct island *is = array_list_address(is_db->islands, b->island_index);
+	is->body_offset = is_db->body_tail;
+	is->contact_offset = 0;
 	is->body_count = 1;
-	is->flags = g_solver_config->sleep_enabled * (ISLAND_AWAKE | ISLAND_SLEEP_RESET);
-
-	struct is_index_entry *entry = array_list_address(pipeline->is_db.island_body_lists, is->body_first);
-	entry->next = ISLAND_NULL;
-	entry->index = body;
+	is->contact_count = 0;
+	is_db->body[is_db->body_tail++] = body;
 
 	return is;
 }
@@ -95,35 +76,26 @@ void is_db_print_island(FILE *file, const struct island_database *is_db, const s
 	const struct island *is = array_list_address(is_db->islands, island);
 	if (!is) { return; }
 
-	const struct is_index_entry *entry;
-
 	fprintf(file, "Island %u %s:\n{\n", island, desc);
 
 	fprintf(file, "\tbody_count: %u\n", is->body_count);
 	fprintf(file, "\tcontact_count: %u\n", is->contact_count);
+	fprintf(file, "\tbody_offset: %u\n", is->body_offset);
+	fprintf(file, "\tcontact_offset: %u\n", is->contact_offset);
 		
-	fprintf(file, "\t(ListIndex, Body):                     { ");
-	for (u32 i = is->body_first; i != ISLAND_NULL; i = entry->next)
-	{
-		entry = array_list_address(is_db->island_body_lists, i);
-		fprintf(file, "(%u,%u) ", i, entry->index);
-	}
-	fprintf(file, "}\n");
-
-	fprintf(file, "\tContact Pointers (ListIndex, Contact): { ");
-	for (u32 i = is->contact_first; i != ISLAND_NULL; i = entry->next)
+	fprintf(file, "\tBodies:                                { ");
+	for (u32 i = 0; i < is->body_count; ++i)
 	{
-		entry = array_list_address(is_db->island_contact_lists, i);
-		fprintf(file, "(%u,%u) ", i, entry->index);
+		fprintf(file, "%u ", is_db->body[is->body_offset + i]);
 	}
 	fprintf(file, "}\n");
 
-	fprintf(file, "\tContacts (Body1, Body2):               { ");
-	for (u32 i = is->contact_first; i != ISLAND_NULL; i = entry->next)
+	fprintf(file, "\tContacts (Contact, Body1, Body2):      { ");
+	for (u32 i = 0; i < is->contact_count; ++i)
 	{
-		entry = array_list_address(is_db->island_contact_lists, i);
-		const struct contact *c = nll_address(&c_db->contact_net, entry->index);
-		fprintf(file, "(%u,%u) ", c->cm.i1, c->cm.i2);
+		const u32 ci = is_db->contact[is->contact_offset + i];
+		const struct contact *c = nll_address(&c_db->contact_net, ci);
+		fprintf(file, "(%u,%u,%u) ", ci, c->cm.i1, c->cm.i2);
 	}
 	fprintf(file, "}\n");
 
@@ -136,22 +108,22 @@ void is_db_print_island(FILE *file, const struct island_database *is_db, const s
 	fprintf(file, "}\n");
 }
 
-struct island_database is_db_alloc(struct arena *mem_persistent, const u32 initial_size)
+struct island_database is_db_alloc(const u32 initial_size)
 {
 	struct island_database is_db = { 0 };
 
 	is_db.island_usage = bit_vec_alloc(NULL, initial_size, 0, 1);
 	is_db.islands = array_list_alloc(NULL, initial_size, sizeof(struct island), ARRAY_LIST_GROWABLE);
-	is_db.island_contact_lists = array_list_alloc(NULL, initial_size, sizeof(struct is_index_entry), ARRAY_LIST_GROWABLE);
-	is_db.island_body_lists = array_list_alloc(NULL, initial_size, sizeof(struct is_index_entry), ARRAY_LIST_GROWABLE);
+	is_db_internal_reserve_range_memory(&is_db.body, &is_db.body_length, initial_size);
+	is_db_internal_reserve_range_memory(&is_db.contact, &is_db.contact_length, initial_size);
 
 	return is_db;
 }
 
 void is_db_free(struct island_database *is_db)
 {
-	array_list_free(is_db->island_contact_lists);
-	array_list_free(is_db->island_body_lists);
+	free(is_db->body);
+	free(is_db->contact);
 	array_list_free(is_db->islands);
 	bit_vec_free(&is_db->island_usage);
 }
@@ -161,14 +133,18 @@ void is_db_flush(struct island_database *is_db)
 	is_db_clear_frame(is_db);
 	bit_vec_clear(&is_db->island_usage, 0);	
 	array_list_flush(is_db->islands);
-	array_list_flush(is_db->island_contact_lists);
-	array_list_flush(is_db->island_body_lists);
+	is_db->body_tail = 0;
+	is_db->contact_tail = 0;
+	is_db->body_compact = 0;
+	is_db->contact_compact = 0;
 }
 
 void is_db_clear_frame(struct island_database *is_db)
 {
 	is_db->possible_splits = NULL;
 	is_db->possible_splits_count = 0;
+	is_db->dirty = NULL;
+	is_db->dirty_count = 0;
 }
 
 void is_db_validate(const struct physics_pipeline *pipeline)
@@ -206,24 +182,20 @@ void is_db_validate(const struct physics_pipeline *pipeline)
 			kas_assert(count == is->body_count && "Body count of island should be equal to the number of bodies mapped to the island");
 	 
 			/* 2. verify body-island map  == island.bodies */
-			u32 list_length = 0; 
-			const struct is_index_entry *entry;
-			for (u32 index = is->body_first; index != ISLAND_NULL; index = entry->next)
+			kas_assert(is->body_offset + is->body_count <= is_db->body_tail);
+			const u32 *body = is_db->body + is->body_offset;
+			for (u32 j = 0; j < is->body_count; ++j)
 			{
-				list_length += 1;
-				entry = array_list_address(is_db->island_body_lists, index);
-				const struct rigid_body *b = pool_address(&pipeline->body_pool, entry->index);
+				const struct rigid_body *b = pool_address(&pipeline->body_pool, body[j]);
 				kas_assert(b->island_index == is_index && POOL_SLOT_ALLOCATED(b));
 			}
-			kas_assert(list_length == is->body_count);
 
 			/* 3. if island no contacts, assert body.contacts == NULL */
 			if (is->contact_count == 0)
 			{
 				kas_assert(is->body_count == 1);
-				entry = array_list_address(is_db->island_body_lists, is->body_first);
-				struct rigid_body *body = pool_address(&pipeline->body_pool, entry->index);
-				kas_assert(body && body->first_contact_index == NLL_NULL);
+				struct rigid_body *b = pool_address(&pipeline->body_pool, body[0]);
+				kas_assert(b && b->first_contact_index == NLL_NULL);
 			}
 			else
 			{
@@ -232,20 +204,18 @@ void is_db_validate(const struct physics_pipeline *pipeline)
 				 * 	1. check contact exist
 				 * 	2. check bodies in contact are mapped to island
 				 */
-				list_length = 0;
-				for (u32 index = is->contact_first; index != ISLAND_NULL; index = entry->next)
+				kas_assert(is->contact_offset + is->contact_count <= is_db->contact_tail);
+				const u32 *contact = is_db->contact + is->contact_offset;
+				for (u32 j = 0; j < is->contact_count; ++j)
 				{
-					list_length += 1;
-					entry = array_list_address(is_db->island_contact_lists, index);
-					struct contact *c = nll_address(&c_db->contact_net, entry->index);
+					struct contact *c = nll_address(&c_db->contact_net, contact[j]);
+					kas_assert(c != NULL);
+					kas_assert(POOL_SLOT_ALLOCATED(c));
 					const struct rigid_body *b1 = pool_address(&pipeline->body_pool, c->cm.i1);
 					const struct rigid_body *b2 = pool_address(&pipeline->body_pool, c->cm.i2);
-					kas_assert(POOL_SLOT_ALLOCATED(c));
-					kas_assert(c != NULL);
 					kas_assert((b1->island_index == is_index) || (b1->island_index == ISLAND_STATIC));
 					kas_assert((b2->island_index == is_index) || (b2->island_index == ISLAND_STATIC));
 				}
-				kas_assert(list_length == is->contact_count);
 			}
 		}
 		base += 64;
@@ -296,125 +266,366 @@ void is_db_tag_for_splitting(struct physics_pipeline *pipeline, const u32 body)
 	}
 }
 
-void is_db_merge_islands(struct physics_pipeline *pipeline, const u32 ci, const u32 b1, const u32 b2)
+struct is_merge_input
 {
-	const struct rigid_body *body1 = pool_address(&pipeline->body_pool, b1);
-	const struct rigid_body *body2 = pool_address(&pipeline->body_pool, b2);
+	const struct physics_pipeline *	pipeline;
+	u32 *				parent;		/* union-find forest over islands, parent[i] <= i */
+};
+
+/* 
+ * Lock-free find with path halving. Since a parent index never increases, any exchange that fails
+ * only means that some other thread already moved the node closer to its root.
+ */
+static u32 is_db_internal_find(u32 *parent, u32 i)
+{
+	u32 p = atomic_load_rlx_32(parent + i);
+	while (p != i)
+	{
+		const u32 gp = atomic_load_rlx_32(parent + p);
+		if (gp != p)
+		{
+			u32 cmp = p;
+			atomic_compare_exchange_rlx_32(parent + i, &cmp, gp);
+		}
+		i = gp;
+		p = atomic_load_rlx_32(parent + i);
+	}
+
+	return i;
+}
+
+/* Link the larger root under the smaller one, so every root ends up as the smallest island index in its set */
+static void is_db_internal_union(u32 *parent, u32 a, u32 b)
+{
+	while (1)
+	{
+		a = is_db_internal_find(parent, a);
+		b = is_db_internal_find(parent, b);
+		if (a == b)
+		{
+			return;
+		}
+
+		if (a < b)
+		{
+			const u32 tmp = a;
+			a = b;
+			b = tmp;
+		}
 
-	const u32 expand = body1->island_index;
-	const u32 merge = body2->island_index;
+		u32 cmp = a;
+		if (atomic_compare_exchange_rlx_32(parent + a, &cmp, b))
+		{
+			return;
+		}
+	}
+}
 
-	//fprintf(stderr, "merging islands (%u, %u) -> (%u)\n", expand, merge, merge);
+static void thread_island_union(void *task_addr)
+{
+	PROF_ZONE;
 
-	const u32 new_index = (u32) array_list_reserve_index(pipeline->is_db.island_contact_lists);
-	struct is_index_entry *new_contact = array_list_address(pipeline->is_db.island_contact_lists, new_index);
-	new_contact->index = ci;
+	struct task *task = task_addr;
+	const struct is_merge_input *input = task->input;
+	const struct physics_pipeline *pipeline = input->pipeline;
+	const u32 *contact = task->range->base;
 
-	/* new local contact within island */
-	if (expand == merge)
+	for (u64 i = 0; i < task->range->count; ++i)
 	{
-		struct island *is = array_list_address(pipeline->is_db.islands, expand);
-		kas_assert(is->contact_count != 0);
-		kas_assert(is->contact_last != ISLAND_NULL);
+		const struct contact *c = nll_address(&pipeline->c_db.contact_net, contact[i]);
+		const struct rigid_body *b1 = pool_address(&pipeline->body_pool, c->cm.i1);
+		const struct rigid_body *b2 = pool_address(&pipeline->body_pool, c->cm.i2);
+		if (b1->island_index != ISLAND_STATIC && b2->island_index != ISLAND_STATIC)
+		{
+			is_db_internal_union(input->parent, b1->island_index, b2->island_index);
+		}
+	}
+
+	PROF_ZONE_END;
+}
 
-		new_contact->next = is->contact_first;
-		is->contact_first = new_index;
-		is->contact_count += 1;	
+void is_db_merge_islands(struct arena *mem_frame, struct physics_pipeline *pipeline, const u32 *contact, const u32 contact_count)
+{
+	PROF_ZONE;
+
+	struct island_database *is_db = &pipeline->is_db;
+	if (!contact_count)
+	{
+		PROF_ZONE_END;
+		return;
 	}
-	/* new contact between distinct islands */
-	else
+
+	/* islands given new contacts, kept until their contact ranges are gathered in is_db_update_ranges */
+	const u32 island_count = is_db->islands->max_count;
+	is_db->dirty = arena_push(mem_frame, island_count * sizeof(u32));
+	is_db->dirty_count = 0;
+
+	arena_push_record(mem_frame);
+	struct is_merge_input input = 
+	{
+		.pipeline = pipeline,
+		.parent = arena_push(mem_frame, island_count * sizeof(u32)),
+	};
+	u32 *merged_body_count = arena_push(mem_frame, island_count * sizeof(u32));
+	struct bit_vec marked = bit_vec_alloc(mem_frame, island_count, 0, 0);
+
+	if (!is_db->dirty || !input.parent || !merged_body_count || !marked.bits)
+	{
+		log_string(T_PHYSICS, S_FATAL, "Out of memory in island merging, exiting.");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+
+	for (u32 i = 0; i < island_count; ++i)
 	{
-		struct island *is_expand = array_list_address(pipeline->is_db.islands, expand);
-		struct island *is_merge = array_list_address(pipeline->is_db.islands, merge);
+		input.parent[i] = i;
+	}
+
+	struct task_bundle *bundle = task_bundle_split_range(
+			mem_frame, 
+			&thread_island_union, 
+			g_task_ctx->worker_count, 
+			(void *) contact, 
+			contact_count, 
+			sizeof(u32), 
+			&input);
+	task_main_master_run_available_jobs();
+	task_bundle_wait(bundle);
+	task_bundle_release(bundle);
+
+	/* 
+	 * Compress the forest and sum up the body count of each root. Roots have smaller indices than the islands 
+	 * merged into them, so every root has already been compressed when we reach an island merged into it.
+	 */
+	u32 merge_count = 0;
+	u32 body_append = 0;
+	for (u32 i = 0; i < island_count; ++i)
+	{
+		if (!bit_vec_get_bit(&is_db->island_usage, i))
+		{
+			continue;
+		}
+
+		const u32 root = input.parent[input.parent[i]];
+		input.parent[i] = root;
+		struct island *is = array_list_address(is_db->islands, i);
+		if (root == i)
+		{
+			merged_body_count[i] = is->body_count;
+			continue;
+		}
 
+		merge_count += 1;
+		struct island *is_root = array_list_address(is_db->islands, root);
 		if (g_solver_config->sleep_enabled)
 		{
-			const u32 island_sleep_interrupted = 1 - ISLAND_AWAKE_BIT(is_merge)*ISLAND_AWAKE_BIT(is_expand)
-						+ ISLAND_TRY_SLEEP_BIT(is_merge) + ISLAND_TRY_SLEEP_BIT(is_expand);
-			kas_assert(!(ISLAND_AWAKE_BIT(is_merge) == 0 && ISLAND_AWAKE_BIT(is_expand) == 0));
+			const u32 island_sleep_interrupted = 1 - ISLAND_AWAKE_BIT(is)*ISLAND_AWAKE_BIT(is_root)
+						+ ISLAND_TRY_SLEEP_BIT(is) + ISLAND_TRY_SLEEP_BIT(is_root);
 			if (island_sleep_interrupted)
 			{
-				if (!ISLAND_AWAKE_BIT(is_expand))
+				if (!ISLAND_AWAKE_BIT(is_root))
 				{
-					PHYSICS_EVENT_ISLAND_AWAKE(pipeline, expand);	
+					PHYSICS_EVENT_ISLAND_AWAKE(pipeline, root);	
 				}
-				is_expand->flags = ISLAND_AWAKE | ISLAND_SLEEP_RESET;
+				is_root->flags = ISLAND_AWAKE | ISLAND_SLEEP_RESET;
 			}
 		}
 
-		struct is_index_entry *link = NULL;
-
-		is_expand->body_count += is_merge->body_count;
-		is_expand->contact_count += is_merge->contact_count + 1;
+		/* the first island merged into a root moves the root's own range as well */
+		body_append += (merged_body_count[root] == is_root->body_count) 
+			? is_root->body_count + is->body_count
+			: is->body_count;
+		merged_body_count[root] += is->body_count;
+	}
 
-		new_contact->next = is_expand->contact_first;
-		is_expand->contact_first = new_index;
-		is_expand->contact_last = (is_expand->contact_last == ISLAND_NULL)
-					? new_index
-					: is_expand->contact_last;
+	if (merge_count)
+	{
+		is_db_internal_reserve_range_memory(&is_db->body, &is_db->body_length, is_db->body_tail + body_append);
 
-		if (is_merge->contact_count > 0)
+		/* move the body range of every growing root to the tail, leaving room for the islands merged into it */
+		for (u32 i = 0; i < island_count; ++i)
 		{
-			link = array_list_address(pipeline->is_db.island_contact_lists, is_expand->contact_last);
-			kas_assert(link->next == ISLAND_NULL);
-			link->next = is_merge->contact_first;
-			is_expand->contact_last = is_merge->contact_last;
+			if (!bit_vec_get_bit(&is_db->island_usage, i) || input.parent[i] != i)
+			{
+				continue;
+			}
+
+			struct island *is = array_list_address(is_db->islands, i);
+			if (merged_body_count[i] != is->body_count)
+			{
+				memcpy(is_db->body + is_db->body_tail, is_db->body + is->body_offset, is->body_count * sizeof(u32));
+				is->body_offset = is_db->body_tail;
+				is_db->body_tail += merged_body_count[i];
+			}
 		}
 
-		link = array_list_address(pipeline->is_db.island_body_lists, is_expand->body_last);
-		kas_assert(link->next == ISLAND_NULL);
-		link->next = is_merge->body_first;
-		is_expand->body_last = is_merge->body_last;
+		/* append merged body ranges to their roots, only the bodies changing island have to be relabeled */
+		for (u32 i = 0; i < island_count; ++i)
+		{
+			const u32 root = input.parent[i];
+			if (!bit_vec_get_bit(&is_db->island_usage, i) || root == i)
+			{
+				continue;
+			}
+
+			struct island *is_root = array_list_address(is_db->islands, root);
+			struct island *is = array_list_address(is_db->islands, i);
+			const u32 *src = is_db->body + is->body_offset;
+			u32 *dst = is_db->body + is_root->body_offset + is_root->body_count;
+			for (u32 j = 0; j < is->body_count; ++j)
+			{
+				struct rigid_body *b = pool_address(&pipeline->body_pool, src[j]);
+				b->island_index = root;
+				dst[j] = src[j];
+			}
 
-		for (u32 i = is_merge->body_first; i != ISLAND_NULL; i = link->next)
+			is_root->body_count += is->body_count;
+			is_root->contact_count += is->contact_count;
+			is->body_count = 0;
+			is->contact_count = 0;
+			array_list_remove_index(is_db->islands, i);
+			bit_vec_set_bit(&is_db->island_usage, i, 0);
+			PHYSICS_EVENT_ISLAND_EXPANDED(pipeline, root);
+			PHYSICS_EVENT_ISLAND_REMOVED(pipeline, i);
+		}
+	}
+
+	for (u32 i = 0; i < contact_count; ++i)
+	{
+		const struct contact *c = nll_address(&pipeline->c_db.contact_net, contact[i]);
+		const struct rigid_body *b1 = pool_address(&pipeline->body_pool, c->cm.i1);
+		const struct rigid_body *b2 = pool_address(&pipeline->body_pool, c->cm.i2);
+		const u32 island = (b1->island_index != ISLAND_STATIC) ? b1->island_index : b2->island_index;
+		if (!bit_vec_get_bit(&marked, island))
 		{
-			link = array_list_address(pipeline->is_db.island_body_lists, i);
-			struct rigid_body *b = pool_address(&pipeline->body_pool, link->index);
-			b->island_index = expand;
+			bit_vec_set_bit(&marked, island, 1);
+			is_db->dirty[is_db->dirty_count++] = island;
 		}
+	}
+
+	arena_pop_record(mem_frame);
+	arena_pop_packed(mem_frame, (island_count - is_db->dirty_count) * sizeof(u32));
+	PROF_ZONE_END;
+}
 
-		is_merge->contact_first = ISLAND_NULL;
-		is_merge->body_first = ISLAND_NULL;
-		is_merge->contact_last = ISLAND_NULL;
-		is_merge->body_last = ISLAND_NULL;
-		is_merge->contact_count = 0;
-		is_merge->body_count = 0;
-		array_list_remove_index(pipeline->is_db.islands, merge);
-		bit_vec_set_bit(&pipeline->is_db.island_usage, merge, 0);
-		PHYSICS_EVENT_ISLAND_EXPANDED(pipeline, expand);
-		PHYSICS_EVENT_ISLAND_REMOVED(pipeline, merge);
+/* Return the body of the contact that is owned by the given island */
+static u32 is_db_internal_contact_island_body(const struct physics_pipeline *pipeline, const struct contact *c, const u32 island)
+{
+	const struct rigid_body *b1 = pool_address(&pipeline->body_pool, c->cm.i1);
+	return (b1->island_index == island) ? c->cm.i1 : c->cm.i2;
+}
+
+/* Copy all ranges, in island order, into fresh memory */
+static void is_db_internal_compact_ranges(struct island_database *is_db)
+{
+	PROF_ZONE;
+
+	u32 *body = malloc(is_db->body_length * sizeof(u32));
+	u32 *contact = malloc(is_db->contact_length * sizeof(u32));
+	if (!body || !contact)
+	{
+		log_string(T_PHYSICS, S_FATAL, "Failed to compact island range memory, exiting.");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
 	}
+
+	u32 body_tail = 0;
+	u32 contact_tail = 0;
+	for (u32 i = 0; i < is_db->islands->max_count; ++i)
+	{
+		if (bit_vec_get_bit(&is_db->island_usage, i))
+		{
+			struct island *is = array_list_address(is_db->islands, i);
+			memcpy(body + body_tail, is_db->body + is->body_offset, is->body_count * sizeof(u32));
+			memcpy(contact + contact_tail, is_db->contact + is->contact_offset, is->contact_count * sizeof(u32));
+			is->body_offset = body_tail;
+			is->contact_offset = contact_tail;
+			body_tail += is->body_count;
+			contact_tail += is->contact_count;
+		}
+	}
+
+	free(is_db->body);
+	free(is_db->contact);
+	is_db->body = body;
+	is_db->contact = contact;
+	is_db->body_tail = body_tail;
+	is_db->contact_tail = contact_tail;
+	is_db->body_compact = body_tail;
+	is_db->contact_compact = contact_tail;
+
+	PROF_ZONE_END;
 }
 
-void is_db_island_remove(struct physics_pipeline *pipeline, struct island *island)
+void is_db_update_ranges(struct arena *mem_frame, struct physics_pipeline *pipeline)
 {
-	struct is_index_entry *entry = NULL;
-	u32 i = island->contact_first; 
-	while (i != ISLAND_NULL)
+	PROF_ZONE;
+
+	struct island_database *is_db = &pipeline->is_db;
+	const u32 count = is_db->dirty_count + is_db->possible_splits_count;
+	if (count)
 	{
-		entry = array_list_address(pipeline->is_db.island_contact_lists, i);
-		const u32 tmp = entry->next;
-		entry->next = ISLAND_NULL;
-		entry->index = ISLAND_NULL;
-		array_list_remove_index(pipeline->is_db.island_contact_lists, i);
-		i = tmp;
+		arena_push_record(mem_frame);
+		u32 *island = arena_push(mem_frame, count * sizeof(u32));
+		struct bit_vec marked = bit_vec_alloc(mem_frame, is_db->islands->max_count, 0, 0);
+		if (!island || !marked.bits)
+		{
+			log_string(T_PHYSICS, S_FATAL, "Out of memory in island range update, exiting.");
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+
+		u32 island_count = 0;
+		for (u32 i = 0; i < count; ++i)
+		{
+			const u32 is_index = (i < is_db->dirty_count)
+				? is_db->dirty[i]
+				: is_db->possible_splits[i - is_db->dirty_count];
+			if (bit_vec_get_bit(&is_db->island_usage, is_index) && !bit_vec_get_bit(&marked, is_index))
+			{
+				bit_vec_set_bit(&marked, is_index, 1);
+				island[island_count++] = is_index;
+			}
+		}
+
+		for (u32 i = 0; i < island_count; ++i)
+		{
+			struct island *is = array_list_address(is_db->islands, island[i]);
+			const u32 *body = is_db->body + is->body_offset;
+			is->contact_offset = is_db->contact_tail;
+			for (u32 j = 0; j < is->body_count; ++j)
+			{
+				const struct rigid_body *b = pool_address(&pipeline->body_pool, body[j]);
+				u32 ci = b->first_contact_index;
+				while (ci != NLL_NULL)
+				{
+					const struct contact *c = nll_address(&pipeline->c_db.contact_net, ci);
+					const u32 side = (body[j] == CONTACT_KEY_TO_BODY_0(c->key)) ? 0 : 1;
+					const u32 neighbour = (side) ? CONTACT_KEY_TO_BODY_0(c->key) : CONTACT_KEY_TO_BODY_1(c->key);
+					const struct rigid_body *nb = pool_address(&pipeline->body_pool, neighbour);
+					/* contacts between two bodies of the island are gathered from their first body only */
+					if (side == 0 || nb->island_index == ISLAND_STATIC)
+					{
+						is_db_internal_reserve_range_memory(&is_db->contact, &is_db->contact_length, is_db->contact_tail + 1);
+						is_db->contact[is_db->contact_tail++] = ci;
+					}
+					ci = c->nll_next[side];
+				}
+			}
+			is->contact_count = is_db->contact_tail - is->contact_offset;
+		}
+
+		arena_pop_record(mem_frame);
 	}
 
-	i = island->body_first; 
-	while (i != ISLAND_NULL)
+	if (is_db->body_tail > 2*is_db->body_compact + IS_DB_RANGE_COMPACT_MIN
+		|| is_db->contact_tail > 2*is_db->contact_compact + IS_DB_RANGE_COMPACT_MIN)
 	{
-		entry = array_list_address(pipeline->is_db.island_body_lists, i);
-		const u32 tmp = entry->next;
-		entry->next = ISLAND_NULL;
-		entry->index = ISLAND_NULL;
-		array_list_remove_index(pipeline->is_db.island_body_lists, i);
-		i = tmp;
+		is_db_internal_compact_ranges(is_db);
 	}
 
-	island->contact_first = ISLAND_NULL;
-	island->body_first = ISLAND_NULL;
-	island->contact_last = ISLAND_NULL;
-	island->body_last = ISLAND_NULL;
+	PROF_ZONE_END;
+}
+
+void is_db_island_remove(struct physics_pipeline *pipeline, struct island *island)
+{
 	island->contact_count = 0;
 	island->body_count = 0;
 	array_list_remove(pipeline->is_db.islands, island);
@@ -428,188 +639,273 @@ void is_db_island_remove_body_resources(struct physics_pipeline *pipeline, const
 	kas_assert(bit_vec_get_bit(&pipeline->is_db.island_usage, island_index));
 
 	struct island *island = array_list_address(pipeline->is_db.islands, island_index);
-	struct is_index_entry *entry = NULL;
-	struct is_index_entry *prev = NULL;
-	u32 i = island->contact_first; 
-	u32 prev_i = ISLAND_NULL;
-	while (i != ISLAND_NULL)
-	{
-		entry = array_list_address(pipeline->is_db.island_contact_lists, i);
-		const u32 next = entry->next;
-		const struct contact *c = nll_address(&pipeline->c_db.contact_net, entry->index);
-		if (body == CONTACT_KEY_TO_BODY_0(c->key) || body == CONTACT_KEY_TO_BODY_1(c->key))
-		{
-			if (prev)
-			{
-				prev->next = entry->next;
-			}
-			else
-			{
-				island->contact_first = entry->next;
-			}
-			const u32 next = entry->next;
-			entry->next = ISLAND_NULL;
-			entry->index = ISLAND_NULL;
-			array_list_remove_index(pipeline->is_db.island_contact_lists, i);
-			island->contact_count -= 1;
-		}
-		else
+	u32 *contact = pipeline->is_db.contact + island->contact_offset;
+	u32 count = 0;
+	for (u32 i = 0; i < island->contact_count; ++i)
+	{
+		const struct contact *c = nll_address(&pipeline->c_db.contact_net, contact[i]);
+		if (body != CONTACT_KEY_TO_BODY_0(c->key) && body != CONTACT_KEY_TO_BODY_1(c->key))
 		{
-			prev_i = i;
-			prev = entry;
+			contact[count++] = contact[i];
 		}
-		i = next;
 	}
-	island->contact_last = prev_i;
+	island->contact_count = count;
 
-	i = island->body_first; 
-	prev_i = ISLAND_NULL;
-	prev = NULL;
-	while (i != ISLAND_NULL)
-	{
-		entry = array_list_address(pipeline->is_db.island_body_lists, i);
-		if (entry->index == body)
-		{
-			if (prev)
-			{
-				prev->next = entry->next;
-			}
-			else
-			{
-				island->body_first = entry->next;
-			}
-			entry->next = ISLAND_NULL;
-			entry->index = ISLAND_NULL;
-			array_list_remove_index(pipeline->is_db.island_body_lists, i);
-			island->body_count -= 1;
-			if (i == island->body_last)
-			{
-				island->body_last = prev_i;
-			}
-			break;
-		}	
-		prev_i = i;
-		prev = entry;
-		i = entry->next;
-	}
-	kas_assert(i != ISLAND_NULL);
+	u32 *island_body = pipeline->is_db.body + island->body_offset;
+	u32 i = 0;
+	for (; i < island->body_count && island_body[i] != body; ++i);
+	kas_assert(i < island->body_count);
+	island->body_count -= 1;
+	island_body[i] = island_body[island->body_count];
 
 	if (island->body_count == 0)
 	{
-		kas_assert(island->contact_first == ISLAND_NULL);
-		kas_assert(island->body_first == ISLAND_NULL);
-		kas_assert(island->contact_last == ISLAND_NULL);
-		kas_assert(island->body_last == ISLAND_NULL);
 		kas_assert(island->contact_count == 0);
-		kas_assert(island->body_count == 0);
 		array_list_remove_index(pipeline->is_db.islands, island_index);
 		bit_vec_set_bit(&pipeline->is_db.island_usage, island_index, 0);
 		PHYSICS_EVENT_ISLAND_REMOVED(pipeline, island_index);
 	}
 }
 
-void is_db_split_island(struct arena *mem_tmp, struct physics_pipeline *pipeline, const u32 island_to_split)
+struct island_split
 {
-	arena_push_record(mem_tmp);
+	u32	island;
+	u32	component_count;	/* number of connected components in island */
+	u32 *	body_count;		/* body count of each component 	*/
+	u32 *	contact_count;		/* contact count of each component 	*/
+};
+
+/*
+ * Find the connected components of the island and sort its body and contact ranges by component. Only the 
+ * island's own ranges, and the component entries of its own bodies, are written to, so islands can be split
+ * concurrently.
+ */
+static void is_db_internal_split_components(struct arena *mem, struct island_split *split, const struct physics_pipeline *pipeline, u32 *component)
+{
+	const struct island_database *is_db = &pipeline->is_db;
+	const struct island *is = array_list_address(is_db->islands, split->island);
+	u32 *body = is_db->body + is->body_offset;
+	u32 *contact = is_db->contact + is->contact_offset;
+
+	split->component_count = 0;
+	split->body_count = arena_push(mem, is->body_count * sizeof(u32));
+	split->contact_count = arena_push(mem, is->body_count * sizeof(u32));
+
+	arena_push_record(mem);
+	u32 *order = arena_push(mem, is->body_count * sizeof(u32));
+	u32 *stack = arena_push(mem, is->body_count * sizeof(u32));
+	u32 *sorted = arena_push(mem, is->contact_count * sizeof(u32));
+	if (!split->body_count || !split->contact_count || !order || !stack || (is->contact_count && !sorted))
+	{
+		log_string(T_PHYSICS, S_FATAL, "Out of memory in island splitting, exiting.");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
 
-	struct island *split = array_list_address(pipeline->is_db.islands, island_to_split);
-	//is_db_print_island(stderr, &pipeline->is_db, &pipeline->c_db, island_to_split, "SPLIT");
-	kas_assert(split->contact_count > 0);
-	u32 sc = 0;
-	u32 *body_stack = arena_push(mem_tmp, split->body_count * sizeof(u32));
-
-	struct is_index_entry *entry = NULL;
-	for (u32 i = split->body_first; i != ISLAND_NULL;)
-	{
-		entry = array_list_address(pipeline->is_db.island_body_lists, i);
-		u32 body = entry->index;
-		i = entry->next;
-		struct rigid_body *b = pool_address(&pipeline->body_pool, body);
-		/* 
-		 * Build new island from the connected component of the body under consideration, 
-		 * if we havn't already. We must add the contacts later, as to not add the same
-		 * contact twice.
-		 */
-		if (b->island_index == island_to_split)
-		{
-			/* TODO: Make thread-safe */
-			struct island *new_island = is_db_init_island_from_body(pipeline, body);
-
-			/* Body-Contact breadth-first search */
-			while (1)
+	for (u32 i = 0; i < is->body_count; ++i)
+	{
+		component[body[i]] = U32_MAX;
+	}
+
+	u32 order_count = 0;
+	for (u32 i = 0; i < is->body_count; ++i)
+	{
+		if (component[body[i]] != U32_MAX)
+		{
+			continue;
+		}
+
+		/* Body-Contact depth-first search */
+		const u32 k = split->component_count++;
+		const u32 first = order_count;
+		u32 sc = 0;
+		component[body[i]] = k;
+		stack[sc++] = body[i];
+		while (sc)
+		{
+			const u32 b = stack[--sc];
+			order[order_count++] = b;
+			const struct rigid_body *rb = pool_address(&pipeline->body_pool, b);
+			u32 ci = rb->first_contact_index;
+			while (ci != NLL_NULL)
 			{
-				b = pool_address(&pipeline->body_pool, body);
-				u32 ci = b->first_contact_index;
-				kas_assert(ci == NLL_NULL ||
-					((body == CONTACT_KEY_TO_BODY_0(((struct contact *) nll_address(&pipeline->c_db.contact_net, ci))->key)) 
-					 && ((struct contact *) nll_address(&pipeline->c_db.contact_net, ci))->nll_prev[0] == NLL_NULL) ||
-					((body == CONTACT_KEY_TO_BODY_1(((struct contact *) nll_address(&pipeline->c_db.contact_net, ci))->key)) 
-					 && ((struct contact *) nll_address(&pipeline->c_db.contact_net, ci))->nll_prev[1] == NLL_NULL));
-				while (ci != NLL_NULL)
+				const struct contact *c = nll_address(&pipeline->c_db.contact_net, ci);
+				const u32 neighbour = (b == c->cm.i1) ? c->cm.i2 : c->cm.i1;
+				const struct rigid_body *nb = pool_address(&pipeline->body_pool, neighbour);
+				if (nb->island_index == split->island && component[neighbour] == U32_MAX)
 				{
-					const struct contact *c = nll_address(&pipeline->c_db.contact_net, ci);
-					kas_assert(ci >= pipeline->c_db.contacts_frame_usage.bit_count ||  bit_vec_get_bit(&pipeline->c_db.contacts_frame_usage, ci) == 1)
-					
-					const u32 neighbour_index = (body == c->cm.i1) ? c->cm.i2 : c->cm.i1;
-					b = pool_address(&pipeline->body_pool, neighbour_index);
-					const u32 neighbour_island = b->island_index;
-
-					/* TODO: Make Thread-Safe */
-					if (neighbour_island == island_to_split)
-					{
-						/* TODO: Make Thread-Safe */
-						is_db_internal_add_body_to_island(pipeline, new_island, neighbour_index);
-						body_stack[sc++] = neighbour_index;
-						kas_assert(sc < split->body_count);
-					}
-					
-					ci = (body == CONTACT_KEY_TO_BODY_0(c->key))
-						? c->nll_next[0] 
-						: c->nll_next[1];
+					component[neighbour] = k;
+					stack[sc++] = neighbour;
 				}
 
-				if (sc)
-				{
-					body = body_stack[--sc];
-					continue;
-				}
-	
-				break;
+				ci = (b == CONTACT_KEY_TO_BODY_0(c->key))
+					? c->nll_next[0] 
+					: c->nll_next[1];
 			}
 		}
+
+		split->body_count[k] = order_count - first;
+		split->contact_count[k] = 0;
 	}
+	kas_assert(order_count == is->body_count);
 
-	/* create contact lists of new islands */
-	for (u32 i = split->contact_first; i != ISLAND_NULL;)
+	if (split->component_count > 1)
 	{
-		entry = array_list_address(pipeline->is_db.island_contact_lists, i);
-		i = entry->next;
-		const u32 index = entry->index;
+		memcpy(body, order, is->body_count * sizeof(u32));
 
-		if (index >= pipeline->c_db.contacts_frame_usage.bit_count || bit_vec_get_bit(&pipeline->c_db.contacts_frame_usage, index) == 1)
+		for (u32 i = 0; i < is->contact_count; ++i)
 		{
-			const struct contact *c = nll_address(&pipeline->c_db.contact_net, index);
-			kas_assert(POOL_SLOT_ALLOCATED(c));
-			const struct rigid_body *b1 = pool_address(&pipeline->body_pool, c->cm.i1);
-			const struct rigid_body *b2 = pool_address(&pipeline->body_pool, c->cm.i2);
-			const u32 island1 = b1->island_index;
-			const u32 island2 = b2->island_index;
-			struct island *is = (island1 != ISLAND_STATIC)
-				? array_list_address(pipeline->is_db.islands, island1)
-				: array_list_address(pipeline->is_db.islands, island2);
-			is_db_internal_add_contact_to_island(&pipeline->is_db, is, index);
+			const struct contact *c = nll_address(&pipeline->c_db.contact_net, contact[i]);
+			split->contact_count[component[is_db_internal_contact_island_body(pipeline, c, split->island)]] += 1;
 		}
+
+		u32 *offset = stack;
+		offset[0] = 0;
+		for (u32 k = 1; k < split->component_count; ++k)
+		{
+			offset[k] = offset[k-1] + split->contact_count[k-1];
+		}
+
+		for (u32 i = 0; i < is->contact_count; ++i)
+		{
+			const struct contact *c = nll_address(&pipeline->c_db.contact_net, contact[i]);
+			const u32 k = component[is_db_internal_contact_island_body(pipeline, c, split->island)];
+			sorted[offset[k]++] = contact[i];
+		}
+		memcpy(contact, sorted, is->contact_count * sizeof(u32));
 	}
+	else
+	{
+		split->contact_count[0] = is->contact_count;
+	}
+
+	arena_pop_record(mem);
+}
+
+/* The first component keeps the island, any other component is given a new island over its sub-ranges */
+static void is_db_internal_split_commit(struct physics_pipeline *pipeline, const struct island_split *split)
+{
+	struct island_database *is_db = &pipeline->is_db;
+	struct island *is = array_list_address(is_db->islands, split->island);
+	u32 body_offset = is->body_offset;
+	u32 contact_offset = is->contact_offset;
+
+	if (g_solver_config->sleep_enabled && !ISLAND_AWAKE_BIT(is))
+	{
+		PHYSICS_EVENT_ISLAND_AWAKE(pipeline, split->island);	
+	}
+	is->flags = g_solver_config->sleep_enabled * (ISLAND_AWAKE | ISLAND_SLEEP_RESET);
+	is->body_count = split->body_count[0];
+	is->contact_count = split->contact_count[0];
+
+	for (u32 k = 1; k < split->component_count; ++k)
+	{
+		body_offset += split->body_count[k-1];
+		contact_offset += split->contact_count[k-1];
+
+		const u32 is_index = is_db_internal_island_alloc(pipeline);
+		is = array_list_address(is_db->islands, is_index);
+		is->body_offset = body_offset;
+		is->contact_offset = contact_offset;
+		is->body_count = split->body_count[k];
+		is->contact_count = split->contact_count[k];
+
+		for (u32 i = 0; i < is->body_count; ++i)
+		{
+			struct rigid_body *b = pool_address(&pipeline->body_pool, is_db->body[body_offset + i]);
+			b->island_index = is_index;
+		}
+	}
+}
+
+void is_db_split_island(struct arena *mem_tmp, struct physics_pipeline *pipeline, const u32 island_to_split)
+{
+	arena_push_record(mem_tmp);
+
+	struct island_split split = { .island = island_to_split };
+	u32 *component = arena_push(mem_tmp, pipeline->body_pool.count_max * sizeof(u32));
+	is_db_internal_split_components(mem_tmp, &split, pipeline, component);
+	is_db_internal_split_commit(pipeline, &split);
 
-	/* TODO: Make thread safe */
-	/* Remove split island */
-	is_db_island_remove(pipeline, split);
 	arena_pop_record(mem_tmp);
 }
 
-static u32 *island_solve(struct arena *mem_frame, struct physics_pipeline *pipeline, struct island *is, const f32 timestep)
+struct is_split_input
+{
+	const struct physics_pipeline *	pipeline;
+	u32 *				component;	/* body -> connected component within its island */
+};
+
+static void thread_island_split(void *task_addr)
+{
+	PROF_ZONE;
+
+	struct task *task = task_addr;
+	const struct is_split_input *input = task->input;
+	struct island_split *split = task->range->base;
+
+	for (u64 i = 0; i < task->range->count; ++i)
+	{
+		is_db_internal_split_components(&task->executor->mem_frame, split + i, input->pipeline, input->component);
+	}
+
+	PROF_ZONE_END;
+}
+
+void is_db_split_islands(struct arena *mem_frame, struct physics_pipeline *pipeline)
+{
+	PROF_ZONE;
+
+	struct island_database *is_db = &pipeline->is_db;
+	if (!is_db->possible_splits_count)
+	{
+		PROF_ZONE_END;
+		return;
+	}
+
+	arena_push_record(mem_frame);
+
+	struct is_split_input input =
+	{
+		.pipeline = pipeline,
+		.component = arena_push(mem_frame, pipeline->body_pool.count_max * sizeof(u32)),
+	};
+	struct island_split *split = arena_push(mem_frame, is_db->possible_splits_count * sizeof(struct island_split));
+	if (!input.component || !split)
+	{
+		log_string(T_PHYSICS, S_FATAL, "Out of memory in island splitting, exiting.");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+
+	for (u32 i = 0; i < is_db->possible_splits_count; ++i)
+	{
+		split[i].island = is_db->possible_splits[i];
+	}
+
+	struct task_bundle *bundle = task_bundle_split_range(
+			mem_frame, 
+			&thread_island_split, 
+			g_task_ctx->worker_count, 
+			split, 
+			is_db->possible_splits_count, 
+			sizeof(struct island_split), 
+			&input);
+	task_main_master_run_available_jobs();
+	task_bundle_wait(bundle);
+	task_bundle_release(bundle);
+
+	/* commit in tag order, so that new island indices stay deterministic between runs */
+	for (u32 i = 0; i < is_db->possible_splits_count; ++i)
+	{
+		is_db_internal_split_commit(pipeline, split + i);
+	}
+
+	arena_pop_record(mem_frame);
+	PROF_ZONE_END;
+}
+
+static u32 *island_solve(struct arena *mem_frame, struct physics_pipeline *pipeline, struct island *is, const f32 timestep, const u32 parallel)
 {
-	u32 *bodies_simulated = arena_push(mem_frame, is->body_count*sizeof(u32));
+	u32 *bodies_simulated = pipeline->is_db.body + is->body_offset;
 	arena_push_record(mem_frame);
 
 	/* Important: Reserve extra space for static body defaults used in contact solver */
@@ -618,16 +914,10 @@ static u32 *island_solve(struct arena *mem_frame, struct physics_pipeline *pipel
 	is->body_index_map = arena_push(mem_frame, pipeline->body_pool.count_max * sizeof(u32));
 
 	/* init body and contact arrays */
-	struct is_index_entry *entry = NULL;
-	u32 k = is->body_first;
 	for (u32 i = 0; i < is->body_count; ++i)
 	{
-		entry = array_list_address(pipeline->is_db.island_body_lists, k);
-		struct rigid_body *b = pool_address(&pipeline->body_pool, entry->index);
-		bodies_simulated[i] = entry->index;
-		is->body_index_map[entry->index] = i;
-		is->bodies[i] = b;
-		k = entry->next;
+		is->body_index_map[bodies_simulated[i]] = i;
+		is->bodies[i] = pool_address(&pipeline->body_pool, bodies_simulated[i]);
 	}
 
 	if (g_solver_config->sleep_enabled && ISLAND_TRY_SLEEP_BIT(is))
@@ -643,12 +933,10 @@ static u32 *island_solve(struct arena *mem_frame, struct physics_pipeline *pipel
 	/* Island low energy state was interrupted, or island is simply awake */
 	else
 	{
-		k = is->contact_first;
+		const u32 *contact = pipeline->is_db.contact + is->contact_offset;
 		for (u32 i = 0; i < is->contact_count; ++i)
 		{
-			entry = array_list_address(pipeline->is_db.island_contact_lists, k);
-			is->contacts[i] = nll_address(&pipeline->c_db.contact_net, entry->index);
- 			k = entry->next;
+			is->contacts[i] = nll_address(&pipeline->c_db.contact_net, contact[i]);
 		}
 
 		/* init solver and velocity constraints */
@@ -660,13 +948,47 @@ static u32 *island_solve(struct arena *mem_frame, struct physics_pipeline *pipel
 			contact_solver_warmup(solver, is);
 		}
 
-		for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+		if (parallel)
 		{
-			contact_solver_iterate_velocity_constraints(solver);
+			contact_solver_init_wide_constraints(mem_frame, solver);
+			for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+			{
+				contact_solver_parallel_iterate_wide_velocity_constraints(mem_frame, solver);
+			}
+			contact_solver_store_wide_impulses(solver);
+		}
+		else if (g_solver_config->wide_solver)
+		{
+			contact_solver_init_wide_constraints(mem_frame, solver);
+			for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+			{
+				contact_solver_iterate_wide_velocity_constraints(solver);
+			}
+			contact_solver_store_wide_impulses(solver);
+		}
+		else
+		{
+			for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+			{
+				contact_solver_iterate_velocity_constraints(solver);
+			}
 		}
 
 		contact_solver_cache_impulse_data(solver, is);
 
+		/* integrate the orientations as one batch over a gathered copy of the body rotations */
+		quatptr rotation = arena_push(mem_frame, is->body_count * sizeof(quat));
+		if (is->body_count && !rotation)
+		{
+			log_string(T_PHYSICS, S_FATAL, "Out of memory in island solve, exiting.");
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+		for (u32 i = 0; i < is->body_count; ++i)
+		{
+			quat_copy(rotation[i], is->bodies[i]->rotation);
+		}
+		quat_batch_integrate(rotation, solver->angular_velocity, is->body_count, timestep);
+
 		/* integrate final solver velocities and update bodies and find lowest low_velocity time */
 		if (g_solver_config->sleep_enabled)
 		{
@@ -677,17 +999,8 @@ static u32 *island_solve(struct arena *mem_frame, struct physics_pipeline *pipel
 				vec3_translate_scaled(b->position, solver->linear_velocity[i], timestep);	
 				vec3_copy(b->velocity, solver->linear_velocity[i]);	
 
-				quat a_vel_quat, rot_delta;
 				vec3_copy(b->angular_velocity, solver->angular_velocity[i]);	
-				quat_set(a_vel_quat, 
-						solver->angular_velocity[i][0], 
-						solver->angular_velocity[i][1], 
-						solver->angular_velocity[i][2],
-					      	0.0f);
-				quat_mult(rot_delta, a_vel_quat, b->rotation);
-				quat_scale(rot_delta, timestep / 2.0f);
-				quat_translate(b->rotation, rot_delta);
-				quat_normalize(b->rotation);
+				quat_copy(b->rotation, rotation[i]);
 
 				/* Always set RB_AWAKE, if island should sleep, we set it later,
 				 * but the bodies may come in sleeping if island just woke up 
@@ -718,17 +1031,8 @@ static u32 *island_solve(struct arena *mem_frame, struct physics_pipeline *pipel
 				vec3_translate_scaled(b->position, solver->linear_velocity[i], timestep);	
 				vec3_copy(b->velocity, solver->linear_velocity[i]);	
 
-				quat a_vel_quat, rot_delta;
 				vec3_copy(b->angular_velocity, solver->angular_velocity[i]);	
-				quat_set(a_vel_quat, 
-						solver->angular_velocity[i][0], 
-						solver->angular_velocity[i][1], 
-						solver->angular_velocity[i][2],
-					      	0.0f);
-				quat_mult(rot_delta, a_vel_quat, b->rotation);
-				quat_scale(rot_delta, timestep / 2.0f);
-				quat_translate(b->rotation, rot_delta);
-				quat_normalize(b->rotation);
+				quat_copy(b->rotation, rotation[i]);
 			}
 		}
 	}
@@ -744,7 +1048,17 @@ void thread_island_solve(void *task_input)
 	struct task *t_ctx = task_input;
 	struct island_solve_input *args = t_ctx->input;
 	args->out->body_count = args->is->body_count;
-	args->out->bodies = island_solve(&t_ctx->executor->mem_frame, args->pipeline, args->is, args->timestep);
+	args->out->bodies = island_solve(&t_ctx->executor->mem_frame, args->pipeline, args->is, args->timestep, 0);
+
+	PROF_ZONE_END;
+}
+
+void island_solve_parallel(struct arena *mem_frame, struct island_solve_input *args)
+{
+	PROF_ZONE;
+
+	args->out->body_count = args->is->body_count;
+	args->out->bodies = island_solve(mem_frame, args->pipeline, args->is, args->timestep, 1);
 
 	PROF_ZONE_END;
 }
@@ -23,6 +23,7 @@
 
 #include "dynamics.h"
 #include "float32.h"
+#include "math_batch.h"
 
 const char *body_color_mode_str_buf[RB_COLOR_MODE_COUNT] = 
 {
@@ -43,12 +44,36 @@ static void thread_set_collision_debug(void *task_addr)
 	struct task *task = task_addr;
 	struct worker *worker = task->executor;
 	const struct physics_pipeline *pipeline = task->input;
-	tl_debug = pipeline->debug + kas_thread_self_index();
+	tl_debug = pipeline->debug + worker->index;
 
 	atomic_fetch_add_rel_32(&g_a_thread_counter, 1);
 	while (atomic_load_acq_32(&g_a_thread_counter) != pipeline->debug_count);
 }
 
+static u32 proxy_pair_index_in_previous_node(struct nll *net, void **prev_node, const void *cur_node, const u32 cur_index)
+{
+	kas_assert(cur_index <= 1);
+	const struct proxy_pair *pair = cur_node;
+	const u32 body = (cur_index) ? pair->id2 : pair->id1;
+
+	*prev_node = nll_address(net, pair->nll_prev[cur_index]);
+	const struct proxy_pair *prev = *prev_node;
+	kas_assert(pair->nll_prev[cur_index] == NLL_NULL || body == prev->id1 || body == prev->id2);
+	return (body == prev->id1) ? 0 : 1;
+}
+
+static u32 proxy_pair_index_in_next_node(struct nll *net, void **next_node, const void *cur_node, const u32 cur_index)
+{
+	kas_assert(cur_index <= 1);
+	const struct proxy_pair *pair = cur_node;
+	const u32 body = (cur_index) ? pair->id2 : pair->id1;
+
+	*next_node = nll_address(net, pair->nll_next[cur_index]);
+	const struct proxy_pair *next = *next_node;
+	kas_assert(pair->nll_next[cur_index] == NLL_NULL || body == next->id1 || body == next->id2);
+	return (body == next->id1) ? 0 : 1;
+}
+
 struct physics_pipeline	physics_pipeline_alloc(struct arena *mem, const u32 initial_size, const u64 ns_tick, const u64 frame_memory, struct string_database *shape_db, struct string_database *prefab_db)
 {
 	struct physics_pipeline pipeline =
@@ -67,6 +92,8 @@ struct physics_pipeline	physics_pipeline_alloc(struct arena *mem, const u32 init
 		init_solver_once = 1;
 		const u32 iteration_count = 10;
 		const u32 block_solver = 0; 
+		const u32 wide_solver = 1; 
+		const u32 split_island_body_count = 256;
 		const u32 warmup_solver = 1;
 		const vec3 gravity = { 0.0f, -GRAVITY_CONSTANT_DEFAULT, 0.0f };
        		const f32 baumgarte_constant = 0.1f;
@@ -79,7 +106,7 @@ struct physics_pipeline	physics_pipeline_alloc(struct arena *mem, const u32 init
 		const f32 sleep_time_threshold = 0.5f;
 		f32 sleep_linear_velocity_sq_limit = 0.001f*0.001f; 
 		f32 sleep_angular_velocity_sq_limit = 0.01f*0.01f*2.0f*F32_PI;
-		contact_solver_config_init(iteration_count, block_solver, warmup_solver, gravity, baumgarte_constant, max_condition, linear_dampening, angular_dampening, linear_slop, restitution_threshold, sleep_enabled, sleep_time_threshold, sleep_linear_velocity_sq_limit, sleep_angular_velocity_sq_limit);
+		contact_solver_config_init(iteration_count, block_solver, wide_solver, split_island_body_count, warmup_solver, gravity, baumgarte_constant, max_condition, linear_dampening, angular_dampening, linear_slop, restitution_threshold, sleep_enabled, sleep_time_threshold, sleep_linear_velocity_sq_limit, sleep_angular_velocity_sq_limit);
 
 	}
 
@@ -96,9 +123,16 @@ struct physics_pipeline	physics_pipeline_alloc(struct arena *mem, const u32 init
 	pipeline.margin = COLLISION_MARGIN_DEFAULT;
 
 	pipeline.dynamic_tree = dbvh_alloc(NULL, 2*initial_size, 1);
+	pipeline.static_tree = dbvh_alloc(NULL, 2*initial_size, 1);
+	pipeline.static_tree_dirty = 0;
+	pipeline.static_tree_edit_count = 0;
+	pipeline.proxy_move = stack_u32_alloc(NULL, initial_size, GROWABLE);
+	pipeline.proxy_pair_net = nll_alloc(NULL, initial_size, struct proxy_pair, proxy_pair_index_in_previous_node, proxy_pair_index_in_next_node, GROWABLE);
+	pipeline.proxy_pair_map = hash_map_alloc(NULL, initial_size, initial_size, GROWABLE);
+	pipeline.proxy_pair_overlap = vector_alloc(NULL, sizeof(struct dbvh_overlap), initial_size, VECTOR_GROWABLE);
 
 	pipeline.c_db = c_db_alloc(mem, initial_size);
-	pipeline.is_db = is_db_alloc(mem, initial_size);
+	pipeline.is_db = is_db_alloc(initial_size);
 	pipeline.shape_db = shape_db;
 
 	pipeline.body_color_mode = RB_COLOR_MODE_BODY;
@@ -123,8 +157,10 @@ struct physics_pipeline	physics_pipeline_alloc(struct arena *mem, const u32 init
 #ifdef KAS_PHYSICS_DEBUG
 	struct task_stream *stream = task_stream_init(&pipeline.frame);
 
-	pipeline.debug_count = g_arch_config->logical_core_count;
-	pipeline.debug = malloc(g_arch_config->logical_core_count * sizeof(struct collision_debug));
+	pipeline.debug_count = g_task_ctx->worker_count;
+	pipeline.debug = malloc(g_task_ctx->worker_count * sizeof(struct collision_debug));
+	/* the barrier counter is shared by every pipeline allocation */
+	atomic_store_rel_32(&g_a_thread_counter, 0);
 	for (u32 i = 0; i < pipeline.debug_count; ++i)
 	{
 		pipeline.debug[i].stack_segment = stack_visual_segment_alloc(NULL, 1024, GROWABLE);
@@ -151,6 +187,11 @@ void physics_pipeline_free(struct physics_pipeline *pipeline)
 	}
 #endif
 	bvh_free(&pipeline->dynamic_tree);
+	bvh_free(&pipeline->static_tree);
+	stack_u32_free(&pipeline->proxy_move);
+	nll_dealloc(&pipeline->proxy_pair_net);
+	hash_map_free(pipeline->proxy_pair_map);
+	vector_dealloc(&pipeline->proxy_pair_overlap);
 	c_db_free(&pipeline->c_db);
 	is_db_free(&pipeline->is_db);
 	pool_dealloc(&pipeline->body_pool);
@@ -169,6 +210,11 @@ static void internal_physics_pipeline_clear_frame(struct physics_pipeline *pipel
 	pipeline->proxy_overlap = NULL;
 	pipeline->cm_count = 0;
 	pipeline->cm = NULL;
+	pipeline->sat_cache_hit_count = 0;
+	pipeline->sat_cache_miss_count = 0;
+	pipeline->bullet_count = 0;
+	pipeline->bullet = NULL;
+	pipeline->ccd_hit_count = 0;
 
 	is_db_clear_frame(&pipeline->is_db);
 	c_db_clear_frame(&pipeline->c_db);
@@ -185,6 +231,13 @@ void physics_pipeline_flush(struct physics_pipeline *pipeline)
 	}
 #endif
 	dbvh_flush(&pipeline->dynamic_tree);
+	dbvh_flush(&pipeline->static_tree);
+	pipeline->static_tree_dirty = 0;
+	pipeline->static_tree_edit_count = 0;
+	stack_u32_flush(&pipeline->proxy_move);
+	nll_flush(&pipeline->proxy_pair_net);
+	hash_map_flush(pipeline->proxy_pair_map);
+	vector_flush(&pipeline->proxy_pair_overlap);
 	c_db_flush(&pipeline->c_db);
 	is_db_flush(&pipeline->is_db);
 	
@@ -221,17 +274,7 @@ static void rigid_body_update_local_box(struct rigid_body *body, const struct co
 
 	if (body->shape_type == COLLISION_SHAPE_CONVEX_HULL)
 	{
-		for (u32 i = 0; i < shape->hull.v_count; ++i)
-		{
-			mat3_vec_mul(v, rot, shape->hull.v[i]);
-			min[0] = f32_min(min[0], v[0]); 
-			min[1] = f32_min(min[1], v[1]);			
-			min[2] = f32_min(min[2], v[2]);			
-                                                   
-			max[0] = f32_max(max[0], v[0]);			
-			max[1] = f32_max(max[1], v[1]);			
-			max[2] = f32_max(max[2], v[2]);			
-		}
+		vec3_batch_bounds(min, max, shape->hull.v, shape->hull.v_count, rot);
 	}
 	else if (body->shape_type == COLLISION_SHAPE_SPHERE)
 	{
@@ -267,6 +310,55 @@ static void rigid_body_update_local_box(struct rigid_body *body, const struct co
 	vec3_add(body->local_box.center, min, body->local_box.hw);
 }
 
+static void internal_proxy_moved(struct physics_pipeline *pipeline, struct rigid_body *body, const u32 index)
+{
+	if ((body->flags & RB_PROXY_MOVED) == 0)
+	{
+		body->flags |= RB_PROXY_MOVED;
+		stack_u32_push(&pipeline->proxy_move, index);
+	}
+}
+
+static void rigid_body_proxy(struct AABB *proxy, const struct rigid_body *body)
+{
+	vec3_add(proxy->center, body->local_box.center, body->position);
+	if (body->shape_type == COLLISION_SHAPE_TRI_MESH)
+	{
+		vec3_copy(proxy->hw, body->local_box.hw);
+	}
+	else
+	{
+		vec3_set(proxy->hw, 
+			body->local_box.hw[0] + body->margin,
+			body->local_box.hw[1] + body->margin,
+			body->local_box.hw[2] + body->margin);
+	}
+}
+
+static const struct AABB *internal_body_proxy_bbox(const struct physics_pipeline *pipeline, const struct rigid_body *body)
+{
+	const struct bvh *tree = (body->flags & RB_DYNAMIC)
+		? &pipeline->dynamic_tree
+		: &pipeline->static_tree;
+	const struct bvh_node *node = pool_address(&tree->tree.pool, body->proxy);
+	return &node->bbox;
+}
+
+/* 
+ * Statics are inserted into and removed from the static tree incrementally; the binned SAH rebuild is deferred
+ * until the edits since the last rebuild are a large enough fraction of the tree to have degraded it.
+ */
+static void internal_static_tree_edited(struct physics_pipeline *pipeline)
+{
+	pipeline->static_tree_edit_count += 1;
+	const u32 leaf_count = bt_leaf_count(&pipeline->static_tree.tree);
+	if (pipeline->static_tree_edit_count >= STATIC_TREE_REBUILD_EDIT_MIN
+		&& STATIC_TREE_REBUILD_EDIT_FRACTION*pipeline->static_tree_edit_count >= leaf_count)
+	{
+		pipeline->static_tree_dirty = 1;
+	}
+}
+
 struct slot physics_pipeline_rigid_body_alloc(struct physics_pipeline *pipeline, struct rigid_body_prefab *prefab, const vec3 position, const quat rotation, const u32 entity)
 {
 	struct slot slot = pool_add(&pipeline->body_pool);
@@ -298,27 +390,23 @@ struct slot physics_pipeline_rigid_body_alloc(struct physics_pipeline *pipeline,
 	body->low_velocity_time = 0.0f;
 
 	rigid_body_update_local_box(body, shape);
-	struct AABB proxy;
-	vec3_add(proxy.center, body->local_box.center, body->position);
-	if (body->shape_type == COLLISION_SHAPE_TRI_MESH)
+	if (body->flags & RB_DYNAMIC)
 	{
-		vec3_print("center", body->local_box.center);
-		vec3_print("center", body->position);
-		vec3_set(proxy.hw, 
-			body->local_box.hw[0],
-			body->local_box.hw[1],
-			body->local_box.hw[2]);
+		struct AABB proxy;
+		rigid_body_proxy(&proxy, body);
+		body->proxy = dbvh_insert(&pipeline->dynamic_tree, slot.index, &proxy);
 	}
 	else
 	{
-		vec3_set(proxy.hw, 
-			body->local_box.hw[0] + body->margin,
-			body->local_box.hw[1] + body->margin,
-			body->local_box.hw[2] + body->margin);
+		struct AABB proxy;
+		rigid_body_proxy(&proxy, body);
+		body->proxy = dbvh_insert(&pipeline->static_tree, slot.index, &proxy);
+		internal_static_tree_edited(pipeline);
 	}
-	body->proxy = dbvh_insert(&pipeline->dynamic_tree, slot.index, &proxy);
+	internal_proxy_moved(pipeline, body, slot.index);
 
 	body->first_contact_index = NLL_NULL;
+	body->first_proxy_pair_index = NLL_NULL;
 	if (body->flags & RB_DYNAMIC)
 	{
 		is_db_init_island_from_body(pipeline, slot.index);
@@ -327,15 +415,73 @@ struct slot physics_pipeline_rigid_body_alloc(struct physics_pipeline *pipeline,
 	{
 		body->island_index = ISLAND_STATIC;
 	}
+	physics_pipeline_rigid_body_set_bullet(pipeline, slot.index, prefab->bullet);
 	
 	return slot;
 }
 
-static void internal_update_dynamic_tree(struct physics_pipeline *pipeline)
+/*
+ * Rebuild the static tree from its own leaves. Only static bodies are read or written, so the rebuild may run
+ * concurrently with the dynamic tree update; mem_tmp must not be the pipeline frame arena.
+ */
+static void internal_update_static_tree(struct arena *mem_tmp, struct physics_pipeline *pipeline)
+{
+	PROF_ZONE;
+	arena_push_record(mem_tmp);
+
+	const struct bvh_node *nodes = (struct bvh_node *) pipeline->static_tree.tree.pool.buf;
+	u32 count = bt_leaf_count(&pipeline->static_tree.tree);
+	struct AABB *bbox = arena_push(mem_tmp, count*sizeof(struct AABB));
+	u32 *id = arena_push(mem_tmp, count*sizeof(u32));
+	if (count && (!bbox || !id))
+	{
+		log_string(T_PHYSICS, S_FATAL, "out-of-memory in static tree rebuild, increase scratch arena size!");		
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+
+	count = 0;
+	for (u32 i = 0; i < pipeline->static_tree.tree.pool.count_max; ++i)
+	{
+		if (POOL_SLOT_ALLOCATED(nodes + i) && BT_IS_LEAF(nodes + i))
+		{
+			const struct rigid_body *b = pool_address(&pipeline->body_pool, nodes[i].bt_left);
+			rigid_body_proxy(bbox + count, b);
+			id[count++] = nodes[i].bt_left;
+		}
+	}
+
+	sbvh_build(mem_tmp, &pipeline->static_tree, bbox, id, count, STATIC_TREE_BIN_COUNT);
+
+	nodes = (struct bvh_node *) pipeline->static_tree.tree.pool.buf;
+	for (u32 i = 0; i < pipeline->static_tree.tree.pool.count_max; ++i)
+	{
+		if (POOL_SLOT_ALLOCATED(nodes + i) && BT_IS_LEAF(nodes + i))
+		{
+			struct rigid_body *b = pool_address(&pipeline->body_pool, nodes[i].bt_left);
+			b->proxy = (i32) i;
+		}
+	}
+
+	pipeline->static_tree_dirty = 0;
+	pipeline->static_tree_edit_count = 0;
+	arena_pop_record(mem_tmp);
+	PROF_ZONE_END;
+}
+
+static void thread_update_static_tree(void *task_addr)
+{
+	struct task *task = task_addr;
+	internal_update_static_tree(&task->executor->mem_scratch, task->input);
+}
+
+static void internal_update_dynamic_tree(struct arena *mem_frame, struct physics_pipeline *pipeline, const f32 delta)
 {
 	PROF_ZONE;
 	struct AABB world_AABB;
 
+	pipeline->bullet = arena_push(mem_frame, pipeline->body_pool.count * sizeof(u32));
+	pipeline->bullet_count = 0;
+
 	const u32 flags = RB_ACTIVE | RB_DYNAMIC | (g_solver_config->sleep_enabled * RB_AWAKE);
 	struct rigid_body *b = NULL;
 	for (u32 i = pipeline->body_non_marked_list.first; i != DLL_NULL; i = DLL_NEXT(b))
@@ -347,6 +493,17 @@ static void internal_update_dynamic_tree(struct physics_pipeline *pipeline)
 			rigid_body_update_local_box(b, shape);
 			vec3_add(world_AABB.center, b->local_box.center, b->position);
 			vec3_copy(world_AABB.hw, b->local_box.hw);
+			if (b->flags & RB_BULLET)
+			{
+				/* sweep the box over the predicted frame motion so that pairs along the path are found */
+				vec3 half_motion;
+				vec3_scale(half_motion, b->velocity, 0.5f * delta);
+				vec3_translate(world_AABB.center, half_motion);
+				vec3_abs(half_motion);
+				vec3_translate(world_AABB.hw, half_motion);
+				pipeline->bullet[pipeline->bullet_count++] = i;
+			}
+
 			const struct bvh_node *node = pool_address(&pipeline->dynamic_tree.tree.pool, b->proxy);
 			const struct AABB *proxy = &node->bbox;
 			if (!AABB_contains(proxy, &world_AABB))
@@ -356,23 +513,285 @@ static void internal_update_dynamic_tree(struct physics_pipeline *pipeline)
 				world_AABB.hw[2] += b->margin;
 				dbvh_remove(&pipeline->dynamic_tree, b->proxy);
 				b->proxy = dbvh_insert(&pipeline->dynamic_tree, i, &world_AABB);
+				internal_proxy_moved(pipeline, b, i);
+			}
+		}
+	}
+
+	if (pipeline->bullet)
+	{
+		arena_pop_packed(mem_frame, (pipeline->body_pool.count - pipeline->bullet_count) * sizeof(u32));
+	}
+
+	if (pipeline->bullet_count == 0)
+	{
+		pipeline->bullet = NULL;
+	}
+	PROF_ZONE_END;
+}
+
+/*
+ * Moved proxy query output, a packed u32 stream of entries (body, count, id_0, ..., id_{count-1}) where each id
+ * is a body whose proxy overlaps the moved body's proxy and which should form a pair with it.
+ */
+struct proxy_query_output
+{
+	u32 *	stream;
+	u32	len;
+};
+
+static void thread_query_moved_proxies(void *task_addr)
+{
+	PROF_ZONE;
+
+	struct task *task = task_addr;
+	struct worker *worker = task->executor;
+	const struct task_range *range = task->range;
+	const struct physics_pipeline *pipeline = task->input;
+	const u32 *moved = range->base;
+
+	struct proxy_query_output *out = arena_push(&worker->mem_frame, sizeof(struct proxy_query_output));
+	if (!out)
+	{
+		log_string(T_PHYSICS, S_FATAL, "out-of-memory in worker frame arena, increase arena size!");		
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+	out->stream = (u32 *) worker->mem_frame.stack_ptr;
+	out->len = 0;
+
+	for (u64 i = 0; i < range->count; ++i)
+	{
+		const struct rigid_body *body = pool_address(&pipeline->body_pool, moved[i]);
+		if (!POOL_SLOT_ALLOCATED(body))
+		{
+			continue;
+		}
+
+		/* dynamic vs dynamic and dynamic vs static pairs are found in separate passes; moved statics
+		 * (new or rebuilt) only need to find dynamic bodies. */
+		const struct AABB *proxy = internal_body_proxy_bbox(pipeline, body);
+		u32 *entry = arena_push_packed(&worker->mem_frame, 2*sizeof(u32));
+		if (!entry)
+		{
+			log_string(T_PHYSICS, S_FATAL, "out-of-memory in worker frame arena, increase arena size!");		
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+		u32 *id = (u32 *) worker->mem_frame.stack_ptr;
+		u32 overlap_count = dbvh_push_bbox_overlaps(&worker->mem_frame, &pipeline->dynamic_tree, proxy);
+		if (body->flags & RB_DYNAMIC)
+		{
+			overlap_count += dbvh_push_bbox_overlaps(&worker->mem_frame, &pipeline->static_tree, proxy);
+		}
+
+		/* compact in place; pairs of moved bodies are only emitted by the body with the smaller index */
+		u32 count = 0;
+		for (u32 j = 0; j < overlap_count; ++j)
+		{
+			const struct rigid_body *other = pool_address(&pipeline->body_pool, id[j]);
+			if (id[j] == moved[i]
+				|| ((other->flags & RB_PROXY_MOVED) && id[j] < moved[i])
+				|| ((body->flags | other->flags) & RB_DYNAMIC) == 0)
+			{
+				continue;
 			}
+			id[count++] = id[j];
+		}
+
+		if (count)
+		{
+			entry[0] = moved[i];
+			entry[1] = count;
+			arena_pop_packed(&worker->mem_frame, (overlap_count - count) * sizeof(u32));
+			out->len += 2 + count;
+		}
+		else
+		{
+			arena_pop_packed(&worker->mem_frame, (overlap_count + 2) * sizeof(u32));
 		}
 	}
+
+	task->output = out;
 	PROF_ZONE_END;
 }
 
+static u32 internal_proxy_pair_lookup(const struct physics_pipeline *pipeline, const u32 id1, const u32 id2)
+{
+	const u64 key = key_gen_u32_u32(id1, id2);
+	for (u32 i = hash_map_first(pipeline->proxy_pair_map, (u32) key); i != HASH_NULL; i = hash_map_next(pipeline->proxy_pair_map, i))
+	{
+		const struct proxy_pair *pair = nll_address(&pipeline->proxy_pair_net, i);
+		if (pair->id1 == id1 && pair->id2 == id2)
+		{
+			return i;
+		}
+	}
+
+	return NLL_NULL;
+}
+
+static void internal_proxy_pair_add(struct physics_pipeline *pipeline, const u32 id1, const u32 id2)
+{
+	struct rigid_body *b1 = pool_address(&pipeline->body_pool, id1);
+	struct rigid_body *b2 = pool_address(&pipeline->body_pool, id2);
+
+	const struct slot overlap_slot = vector_push(&pipeline->proxy_pair_overlap);
+	struct dbvh_overlap *overlap = overlap_slot.address;
+	overlap->id1 = id1;
+	overlap->id2 = id2;
+
+	struct proxy_pair cpy = { .id1 = id1, .id2 = id2, .overlap_index = overlap_slot.index };
+	const struct slot slot = nll_add(&pipeline->proxy_pair_net, &cpy, b1->first_proxy_pair_index, b2->first_proxy_pair_index);
+	b1->first_proxy_pair_index = slot.index;
+	b2->first_proxy_pair_index = slot.index;
+	hash_map_add(pipeline->proxy_pair_map, (u32) key_gen_u32_u32(id1, id2), slot.index);
+}
+
+static void internal_proxy_pair_remove(struct physics_pipeline *pipeline, const u32 index)
+{
+	struct proxy_pair *pair = nll_address(&pipeline->proxy_pair_net, index);
+	struct rigid_body *b1 = pool_address(&pipeline->body_pool, pair->id1);
+	struct rigid_body *b2 = pool_address(&pipeline->body_pool, pair->id2);
+
+	if (b1->first_proxy_pair_index == index)
+	{
+		b1->first_proxy_pair_index = pair->nll_next[0];
+	}
+
+	if (b2->first_proxy_pair_index == index)
+	{
+		b2->first_proxy_pair_index = pair->nll_next[1];
+	}
+
+	/* swap in the last overlap to keep the overlap array dense */
+	struct dbvh_overlap *overlap = (struct dbvh_overlap *) pipeline->proxy_pair_overlap.data;
+	const u32 last = pipeline->proxy_pair_overlap.next - 1;
+	if (pair->overlap_index != last)
+	{
+		struct proxy_pair *moved = nll_address(&pipeline->proxy_pair_net, internal_proxy_pair_lookup(pipeline, overlap[last].id1, overlap[last].id2));
+		moved->overlap_index = pair->overlap_index;
+		overlap[pair->overlap_index] = overlap[last];
+	}
+	vector_pop(&pipeline->proxy_pair_overlap);
+
+	hash_map_remove(pipeline->proxy_pair_map, (u32) key_gen_u32_u32(pair->id1, pair->id2), index);
+	nll_remove(&pipeline->proxy_pair_net, index);
+}
+
+static void internal_proxy_pair_remove_body(struct physics_pipeline *pipeline, const u32 body_index)
+{
+	const struct rigid_body *body = pool_address(&pipeline->body_pool, body_index);
+	while (body->first_proxy_pair_index != NLL_NULL)
+	{
+		internal_proxy_pair_remove(pipeline, body->first_proxy_pair_index);
+	}
+}
+
+/*
+ * Incremental broadphase: (1) query the proxies of the move buffer against the dynamic tree, (2) walk the pair
+ * lists of the moved bodies and remove any pair whose proxies no longer overlap, (3) add new pairs found in (1).
+ * Pairs of removed bodies are dropped on removal. The frame's proxy overlaps is the resulting dense pair array.
+ */
 static void internal_push_proxy_overlaps(struct arena *mem_frame, struct physics_pipeline *pipeline)
 {
 	PROF_ZONE;
-	pipeline->proxy_overlap = dbvh_push_overlap_pairs(mem_frame, &pipeline->proxy_overlap_count, &pipeline->dynamic_tree);
+
+	struct task_bundle *bundle = task_bundle_split_range(
+			mem_frame, 
+			&thread_query_moved_proxies, 
+			g_task_ctx->worker_count, 
+			pipeline->proxy_move.arr, 
+			pipeline->proxy_move.next, 
+			sizeof(u32), 
+			pipeline);
+
+	if (bundle)
+	{
+		task_main_master_run_available_jobs();
+		task_bundle_wait(bundle);
+	}
+
+	{
+		PROF_ZONE_NAMED("internal_update_persistent_pairs");
+		for (u32 i = 0; i < pipeline->proxy_move.next; ++i)
+		{
+			const struct rigid_body *body = pool_address(&pipeline->body_pool, pipeline->proxy_move.arr[i]);
+			if (!POOL_SLOT_ALLOCATED(body))
+			{
+				continue;
+			}
+
+			const u32 list = pipeline->proxy_move.arr[i];
+			u32 next;
+			for (u32 k = body->first_proxy_pair_index; k != NLL_NULL; k = next)
+			{
+				const struct proxy_pair *pair = nll_address(&pipeline->proxy_pair_net, k);
+				next = (pair->id1 == list) ? pair->nll_next[0] : pair->nll_next[1];
+				const struct rigid_body *b1 = pool_address(&pipeline->body_pool, pair->id1);
+				const struct rigid_body *b2 = pool_address(&pipeline->body_pool, pair->id2);
+				if (!AABB_test(internal_body_proxy_bbox(pipeline, b1), internal_body_proxy_bbox(pipeline, b2)))
+				{
+					internal_proxy_pair_remove(pipeline, k);
+				}
+			}
+		}
+		PROF_ZONE_END;
+	}
+
+	if (bundle)
+	{
+		PROF_ZONE_NAMED("internal_add_new_pairs");
+		for (u32 i = 0; i < bundle->task_count; ++i)
+		{
+			const struct proxy_query_output *out = (struct proxy_query_output *) atomic_load_acq_64(&bundle->tasks[i].output);
+			for (u32 j = 0; j < out->len; j += 2 + out->stream[j + 1])
+			{
+				const u32 body = out->stream[j];
+				const u32 count = out->stream[j + 1];
+				const u32 *id = out->stream + j + 2;
+				for (u32 k = 0; k < count; ++k)
+				{
+					const u32 id1 = (body < id[k]) ? body : id[k];
+					const u32 id2 = (body < id[k]) ? id[k] : body;
+					if (internal_proxy_pair_lookup(pipeline, id1, id2) == NLL_NULL)
+					{
+						internal_proxy_pair_add(pipeline, id1, id2);
+					}
+				}
+			}
+		}
+		task_bundle_release(bundle);
+		PROF_ZONE_END;
+	}
+
+	for (u32 i = 0; i < pipeline->proxy_move.next; ++i)
+	{
+		struct rigid_body *body = pool_address(&pipeline->body_pool, pipeline->proxy_move.arr[i]);
+		if (POOL_SLOT_ALLOCATED(body))
+		{
+			body->flags &= ~RB_PROXY_MOVED;
+		}
+	}
+	stack_u32_flush(&pipeline->proxy_move);
+
+	/* the pair array is left untouched until the next broadphase, so the frame can read it in place */
+	pipeline->proxy_overlap_count = pipeline->proxy_pair_overlap.next;
+	pipeline->proxy_overlap = (pipeline->proxy_overlap_count)
+		? (struct dbvh_overlap *) pipeline->proxy_pair_overlap.data
+		: NULL;
+
 	PROF_ZONE_END;
 }
 
 struct tpc_output
 {
 	struct collision_result *result;
+	u32 *contact;		/* contact index of result, or NLL_NULL if the contact must be reserved */
+	u32 *stage;		/* results with new sat caches, new contacts or new contact links */
 	u32 result_count;
+	u32 stage_count;
+	u32 cm_count;
+	u32 sat_cache_hit_count;
+	u32 sat_cache_miss_count;
 };
 
 static void thread_push_contacts(void *task_addr)
@@ -387,9 +806,16 @@ static void thread_push_contacts(void *task_addr)
 
 	struct tpc_output *out = arena_push(&worker->mem_frame, sizeof(struct tpc_output));
 	out->result_count = 0;
+	out->stage_count = 0;
+	out->cm_count = 0;
+	out->sat_cache_hit_count = 0;
+	out->sat_cache_miss_count = 0;
 	out->result = arena_push(&worker->mem_frame, range->count * sizeof(struct collision_result));
+	out->contact = arena_push(&worker->mem_frame, range->count * sizeof(u32));
+	out->stage = arena_push(&worker->mem_frame, range->count * sizeof(u32));
 
 	const f32 margin = (pipeline->margin_on) ? pipeline->margin : 0.0f;
+	const struct bit_vec *persistent_usage = &pipeline->c_db.contacts_persistent_usage;
 	const struct rigid_body *b1, *b2;
 
 	for (u64 i = 0; i < range->count; ++i)
@@ -397,35 +823,143 @@ static void thread_push_contacts(void *task_addr)
 		b1 = pool_address(&pipeline->body_pool, proxy_overlap[i].id1);
 		b2 = pool_address(&pipeline->body_pool, proxy_overlap[i].id2);
 
-		if (body_body_contact_manifold(&worker->mem_frame, out->result + out->result_count, pipeline, b1, b2, margin))
+		struct collision_result *result = out->result + out->result_count;
+		const u32 colliding = body_body_contact_manifold(&worker->mem_frame, result, pipeline, b1, b2, margin);
+		out->sat_cache_hit_count += (result->sat_query == SAT_CACHE_QUERY_HIT);
+		out->sat_cache_miss_count += (result->sat_query == SAT_CACHE_QUERY_MISS);
+		if (colliding)
 		{
-			out->result[out->result_count].manifold.i1 = proxy_overlap[i].id1;
-			out->result[out->result_count].manifold.i2 = proxy_overlap[i].id2;
+			result->manifold.i1 = proxy_overlap[i].id1;
+			result->manifold.i2 = proxy_overlap[i].id2;
 
 			//vec3 tmp;
 			//vec3_sub(tmp, b2->position, b1->position);
 
-			//if (vec3_dot(tmp, out->result[out->result_count].manifold.n) < 0)
+			//if (vec3_dot(tmp, result->manifold.n) < 0)
 			//{
-			//	vec3_mul_constant(out->result[out->result_count].manifold.n, -1.0f);
+			//	vec3_mul_constant(result->manifold.n, -1.0f);
 			//}
 
+			const u32 ci = c_db_update_persisting_contact(&pipeline->c_db, &result->manifold);
+			out->contact[out->result_count] = ci;
+			if (result->type == COLLISION_SAT_CACHE 
+				|| ci == NLL_NULL 
+				|| ci >= persistent_usage->bit_count 
+				|| bit_vec_get_bit(persistent_usage, ci) == 0)
+			{
+				out->stage[out->stage_count++] = out->result_count;
+			}
+			out->cm_count += 1;
 			out->result_count += 1;
 		}	
-		else if (out->result[out->result_count].type == COLLISION_SAT_CACHE)
+		else if (result->type == COLLISION_SAT_CACHE)
 		{
+			/* cache only, no contact */
+			result->manifold.v_count = 0;
+			out->contact[out->result_count] = NLL_NULL;
+			out->stage[out->stage_count++] = out->result_count;
 			out->result_count += 1;
 		}
 	}
 
-	arena_pop_packed(&worker->mem_frame, (range->count - out->result_count) * sizeof(struct collision_result));
+	arena_pop_packed(&worker->mem_frame, (range->count - out->stage_count) * sizeof(u32));
 
 	task->output = out;
 	PROF_ZONE_END;
 }
 
+struct tic_input
+{
+	struct physics_pipeline *	pipeline;
+	struct tpc_output **		out;		/* narrowphase output of shard */
+	u32 *				cm_offset;	/* offset of shard's manifolds in pipeline->cm */
+	struct c_db_link *		contact_link;
+	u32 *				sat_link;
+	u32				contact_link_count;
+	u32				sat_link_count;
+	u32				shard_count;
+};
+
+static void thread_insert_contacts(void *task_addr)
+{
+	PROF_ZONE;
+
+	struct task *task = task_addr;
+	const struct task_range *range = task->range;
+	struct tic_input *input = task->input;
+	const u32 shard = *(u32 *) range->base;
+
+	/* compact shard's manifolds into the frame's contact manifolds */
+	const struct tpc_output *out = input->out[shard];
+	struct contact_manifold *cm = input->pipeline->cm + input->cm_offset[shard];
+	for (u32 i = 0; i < out->result_count; ++i)
+	{
+		if (out->result[i].manifold.v_count)
+		{
+			*cm++ = out->result[i].manifold;
+		}
+	}
+
+	c_db_shard_link_contacts(input->pipeline, input->contact_link, input->contact_link_count, shard, input->shard_count);
+	sat_cache_shard_link(&input->pipeline->c_db, input->sat_link, input->sat_link_count, shard, input->shard_count);
+
+	PROF_ZONE_END;
+}
+
+/*
+ * Reserve any new contacts and sat caches in task order, which is also the order of the proxy overlaps,
+ * so that the resulting contact indices stays deterministic between runs. Persisting contacts have 
+ * already been updated by the narrowphase workers.
+ */
+static void internal_reserve_staged_contacts(struct physics_pipeline *pipeline, struct tic_input *input)
+{
+	PROF_ZONE;
+	input->contact_link_count = 0;
+	input->sat_link_count = 0;
+	pipeline->contact_new_count = 0;
+
+	const struct bit_vec *persistent_usage = &pipeline->c_db.contacts_persistent_usage;
+	for (u32 i = 0; i < input->shard_count; ++i)
+	{
+		const struct tpc_output *out = input->out[i];
+		for (u32 j = 0; j < out->stage_count; ++j)
+		{
+			const u32 ri = out->stage[j];
+			const struct collision_result *result = out->result + ri;
+			if (result->type == COLLISION_SAT_CACHE)
+			{
+				input->sat_link[input->sat_link_count++] = sat_cache_reserve(&pipeline->c_db, &result->sat_cache);
+			}
+
+			if (result->manifold.v_count)
+			{
+				u32 ci = out->contact[ri];
+				if (ci == NLL_NULL)
+				{
+					ci = c_db_reserve_contact(pipeline, result->manifold.i1, result->manifold.i2);
+					input->contact_link[input->contact_link_count].cm = &result->manifold;
+					input->contact_link[input->contact_link_count].index = ci;
+					input->contact_link_count += 1;
+				}
+
+				/* add to new links if needed */
+				if (ci >= persistent_usage->bit_count || bit_vec_get_bit(persistent_usage, ci) == 0)
+				{
+					pipeline->contact_new[pipeline->contact_new_count++] = ci;
+				}
+			}
+		}
+	}
+	PROF_ZONE_END;
+}
+
 static void internal_parallel_push_contacts(struct arena *mem_frame, struct physics_pipeline *pipeline)
 {
+	/* narrowphase workers set the frame usage of persisting contacts */
+	pipeline->c_db.contacts_frame_usage = bit_vec_alloc(mem_frame, pipeline->c_db.contacts_persistent_usage.bit_count, 0, 0);
+	kas_assert(pipeline->c_db.contacts_frame_usage.block_count == pipeline->c_db.contacts_persistent_usage.block_count);
+	kas_assert(pipeline->c_db.contacts_frame_usage.bit_count == pipeline->c_db.contacts_persistent_usage.bit_count);
+
 	struct task_bundle *bundle = task_bundle_split_range(
 			mem_frame, 
 			&thread_push_contacts, 
@@ -436,128 +970,85 @@ static void internal_parallel_push_contacts(struct arena *mem_frame, struct phys
 			pipeline);
 
 	PROF_ZONE;
-	pipeline->cm = (struct contact_manifold *) arena_push(mem_frame, pipeline->proxy_overlap_count * sizeof(struct contact_manifold));
-	arena_push_record(mem_frame);
-
+	pipeline->cm = NULL;
 	pipeline->cm_count = 0;
+	pipeline->contact_new = NULL;
+	pipeline->contact_new_count = 0;
+	pipeline->sat_cache_hit_count = 0;
+	pipeline->sat_cache_miss_count = 0;
 	if (bundle)
 	{	
 		task_main_master_run_available_jobs();
 		task_bundle_wait(bundle);
 
+		struct tic_input input = 
+		{ 
+			.pipeline = pipeline,
+			.shard_count = bundle->task_count,
+		};
+		input.out = arena_push(mem_frame, input.shard_count * sizeof(struct tpc_output *));
+		input.cm_offset = arena_push(mem_frame, input.shard_count * sizeof(u32));
+
+		/* prefix sum of the workers' manifold counts gives each shard its compaction offset */
+		u32 stage_count = 0;
 		for (u32 i = 0; i < bundle->task_count; ++i)
 		{
-			struct tpc_output *out = (struct tpc_output *) atomic_load_acq_64(&bundle->tasks[i].output);
-			for (u32 j = 0; j < out->result_count; ++j)
-			{
-				if (out->result[j].type == COLLISION_SAT_CACHE)
-				{
-					sat_cache_add(&pipeline->c_db, &out->result[j].sat_cache);
-					if (out->result[j].sat_cache.type != SAT_CACHE_SEPARATION)
-					{
-						pipeline->cm[pipeline->cm_count++] = out->result[j].manifold;
-					}
-				}
-				else
-				{
-					pipeline->cm[pipeline->cm_count++] = out->result[j].manifold;
-				}
-			}
+			input.out[i] = (struct tpc_output *) atomic_load_acq_64(&bundle->tasks[i].output);
+			input.cm_offset[i] = pipeline->cm_count;
+			pipeline->cm_count += input.out[i]->cm_count;
+			stage_count += input.out[i]->stage_count;
+			pipeline->sat_cache_hit_count += input.out[i]->sat_cache_hit_count;
+			pipeline->sat_cache_miss_count += input.out[i]->sat_cache_miss_count;
 		}
-	
 		task_bundle_release(bundle);
-	}
-	
-	arena_pop_record(mem_frame);
-	arena_pop_packed(mem_frame, (pipeline->proxy_overlap_count - pipeline->cm_count) * sizeof(struct contact_manifold));
 
-	pipeline->c_db.contacts_frame_usage = bit_vec_alloc(mem_frame, pipeline->c_db.contacts_persistent_usage.bit_count, 0, 0);
-	kas_assert(pipeline->c_db.contacts_frame_usage.block_count == pipeline->c_db.contacts_persistent_usage.block_count);
-	kas_assert(pipeline->c_db.contacts_frame_usage.bit_count == pipeline->c_db.contacts_persistent_usage.bit_count);
+		pipeline->cm = arena_push(mem_frame, pipeline->cm_count * sizeof(struct contact_manifold));
+		pipeline->contact_new = arena_push(mem_frame, stage_count * sizeof(u32));
+		arena_push_record(mem_frame);
 
-	pipeline->contact_new_count = 0;
-	pipeline->contact_new = (u32 *) mem_frame->stack_ptr;
-	//fprintf(stderr, "A: {");
-	{
-		PROF_ZONE_NAMED("internal_gather_real_contacts");
-		for (u32 i = 0; i < pipeline->cm_count; ++i)
+		input.contact_link = arena_push(mem_frame, stage_count * sizeof(struct c_db_link));
+		input.sat_link = arena_push(mem_frame, stage_count * sizeof(u32));
+		u32 *shard = arena_push(mem_frame, input.shard_count * sizeof(u32));
+		if ((stage_count && (!input.contact_link || !input.sat_link || !pipeline->contact_new))
+			|| (pipeline->cm_count && !pipeline->cm)
+			|| !shard)
 		{
-			const struct contact *c = c_db_add_contact(pipeline, pipeline->cm + i, pipeline->cm[i].i1, pipeline->cm[i].i2);
-			/* add to new links if needed */
-			const u32 index = (u32) nll_index(&pipeline->c_db.contact_net, c);
-			if (index >= pipeline->c_db.contacts_persistent_usage.bit_count
-				 || bit_vec_get_bit(&pipeline->c_db.contacts_persistent_usage, index) == 0)
-			{
-					pipeline->contact_new_count += 1;
-					arena_push_packed_memcpy(mem_frame, &index, sizeof(index));
-			}
-			//fprintf(stderr, " %u", index);
+			log_string(T_PHYSICS, S_FATAL, "Out of memory in contact insertion, exiting.");
+			fatal_cleanup_and_exit(kas_thread_self_tid());
 		}
-		PROF_ZONE_END;
-	}
-	//fprintf(stderr, " } ");
-
-	//if (bundle)
-	//{
-	//	//fprintf(stderr, "A: {");
-	//	for (u32 i = 0; i < bundle->task_count; ++i)
-	//	{
-	//		struct tpc_output *out = (struct tpc_output *) atomic_load_acq_64(&bundle->tasks[i].output);
-	//		for (u32 j = 0; j < out->cm_count; ++j)
-	//		{
-	//			const struct contact *c = c_db_add_contact(pipeline, out->cm + j, out->cm[j].i1, out->cm[j].i2);
-	//			/* add to new links if needed */
-	//			const u32 index = (u32) nll_index(&pipeline->c_db.contact_net, c);
-	//			if (index >= pipeline->c_db.contacts_persistent_usage.bit_count
-	//				 || bit_vec_get_bit(&pipeline->c_db.contacts_persistent_usage, index) == 0)
-	//			{
-	//					pipeline->contact_new_count += 1;
-	//					arena_push_packed_memcpy(mem_frame, &index, sizeof(index));
-	//			}
-	//			//fprintf(stderr, " %u", index);
-	//		}	
-	//	}
-	//	//fprintf(stderr, " } ");
-	//}
-	PROF_ZONE_END;
-}
 
-static void internal_merge_islands(struct arena *mem_frame, struct physics_pipeline *pipeline)
-{
-	PROF_ZONE;
-	for (u32 i = 0; i < pipeline->contact_new_count; ++i)
-	{
-		struct contact *c = nll_address(&pipeline->c_db.contact_net, pipeline->contact_new[i]);
-		const struct rigid_body *body1 = pool_address(&pipeline->body_pool, c->cm.i1);
-		const struct rigid_body *body2 = pool_address(&pipeline->body_pool, c->cm.i2);
-		const u32 is1 = body1->island_index;
-		const u32 is2 = body2->island_index;
-		const u32 d1 = (is1 != ISLAND_STATIC) ? 0x2 : 0x0;
-		const u32 d2 = (is2 != ISLAND_STATIC) ? 0x1 : 0x0;
-		switch (d1 | d2)
+		internal_reserve_staged_contacts(pipeline, &input);
+		c_db_shard_link_prepare(&pipeline->c_db);
+
+		for (u32 i = 0; i < input.shard_count; ++i)
 		{
-			/* dynamic-dynamic */
-			case 0x3: 
-			{
-				is_db_merge_islands(pipeline, pipeline->contact_new[i], c->cm.i1, c->cm.i2);
-			} break;
+			shard[i] = i;
+		}
 
-			/* dynamic-static */
-			case 0x2:
-			{
-				is_db_add_contact_to_island(&pipeline->is_db, is1, pipeline->contact_new[i]);
-			} break;
+		bundle = task_bundle_split_range(
+				mem_frame, 
+				&thread_insert_contacts, 
+				input.shard_count, 
+				shard,
+				input.shard_count,
+				sizeof(u32), 
+				&input);
+		task_main_master_run_available_jobs();
+		task_bundle_wait(bundle);
+		task_bundle_release(bundle);
 
-			/* static-dynamic */
-			case 0x1:
-			{
-				is_db_add_contact_to_island(&pipeline->is_db, is2, pipeline->contact_new[i]);
-			} break;
-		}
+		arena_pop_record(mem_frame);
+		arena_pop_packed(mem_frame, (stage_count - pipeline->contact_new_count) * sizeof(u32));
 	}
+
 	PROF_ZONE_END;
 }
 
+static void internal_merge_islands(struct arena *mem_frame, struct physics_pipeline *pipeline)
+{
+	is_db_merge_islands(mem_frame, pipeline, pipeline->contact_new, pipeline->contact_new_count);
+}
+
 static void internal_remove_contacts_and_tag_split_islands(struct arena *mem_frame, struct physics_pipeline *pipeline)
 {
 	PROF_ZONE;
@@ -627,12 +1118,8 @@ static void internal_remove_contacts_and_tag_split_islands(struct arena *mem_fra
 static void internal_split_islands(struct arena *mem_frame, struct physics_pipeline *pipeline)
 {
 	PROF_ZONE;
-	/* TODO: Parallelize island splitting */
-
-	for (u32 i = 0; i < pipeline->is_db.possible_splits_count; ++i)
-	{
-		is_db_split_island(mem_frame, pipeline, pipeline->is_db.possible_splits[i]);
-	}
+	is_db_update_ranges(mem_frame, pipeline);
+	is_db_split_islands(mem_frame, pipeline);
 
 	c_db_update_persistent_contacts_usage(&pipeline->c_db);
 
@@ -643,6 +1130,17 @@ static void internal_parallel_solve_islands(struct arena *mem_frame, struct phys
 {
 	PROF_ZONE;
 
+	/* 
+	 * Small islands are streamed out as one task per island. Large islands are then solved one at a time, with
+	 * every worker helping out on each island; workers waiting between the colors of a large island pick up
+	 * small islands meanwhile.
+	 */
+	const u32 split_islands = g_solver_config->wide_solver && g_task_ctx->worker_count > 1;
+	struct island_solve_input **small = arena_push(mem_frame, pipeline->is_db.islands->length * sizeof(struct island_solve_input *));
+	struct island_solve_input **large = arena_push(mem_frame, pipeline->is_db.islands->length * sizeof(struct island_solve_input *));
+	u32 small_count = 0;
+	u32 large_count = 0;
+
 	/* acquire any task resources */
 	struct task_stream *stream = task_stream_init(mem_frame);
 	struct island_solve_output *output = NULL;
@@ -678,7 +1176,14 @@ static void internal_parallel_solve_islands(struct arena *mem_frame, struct phys
 				args->is = is;
 				args->pipeline = pipeline;
 				args->timestep = delta;
-				task_stream_dispatch(mem_frame, stream, thread_island_solve, args);
+				if (split_islands && is->body_count >= g_solver_config->split_island_body_count)
+				{
+					large[large_count++] = args;
+				}
+				else
+				{
+					small[small_count++] = args;
+				}
 
 				next = &(*next)->next;
 			}
@@ -686,6 +1191,16 @@ static void internal_parallel_solve_islands(struct arena *mem_frame, struct phys
 		base += 64;
 	}
 
+	for (u32 i = 0; i < small_count; ++i)
+	{
+		task_stream_dispatch(mem_frame, stream, thread_island_solve, small[i]);
+	}
+
+	for (u32 i = 0; i < large_count; ++i)
+	{
+		island_solve_parallel(mem_frame, large[i]);
+	}
+
 	task_main_master_run_available_jobs();
 
 	/* spin wait until last job completes */
@@ -717,6 +1232,192 @@ static void internal_parallel_solve_islands(struct arena *mem_frame, struct phys
 	PROF_ZONE_END;
 }
 
+#define CCD_MAX_ITERATIONS	20
+#define CCD_MIN_TOLERANCE	0.0001f
+
+/*
+ * Conservative advancement of a translating bullet against a body at its end of frame pose. The bullet's
+ * rotation is kept fixed at its end of frame rotation. For convex pairs, the distance along the sweep is convex,
+ * so advancing until the tangent at the current distance reaches the target separation never overshoots the
+ * time of impact. Tri mesh distances are minimums over triangles, and we fall back to the full motion length as
+ * the closing speed. Returns the time of impact in [0, toi_max), or toi_max if no earlier impact is found.
+ */
+static f32 internal_bullet_time_of_impact(const struct physics_pipeline *pipeline, struct rigid_body *bullet, const struct rigid_body *other, const vec3 start, const vec3 motion, const f32 toi_max)
+{
+	const f32 target = g_solver_config->linear_slop;
+	const f32 tolerance = f32_max(0.25f * target, CCD_MIN_TOLERANCE);
+	const f32 motion_length = vec3_length(motion);
+
+	vec3 c1, c2, n;
+	f32 t = 0.0f;
+	vec3_copy(bullet->position, start);
+	f32 dist = body_body_distance(c1, c2, pipeline, bullet, other, 0.0f);
+	if (dist <= target + tolerance)
+	{
+		/* already touching at the start of the sweep, the discrete contact handles it */
+		return toi_max;
+	}
+
+	for (u32 iteration = 0; iteration < CCD_MAX_ITERATIONS; ++iteration)
+	{
+		f32 closing = motion_length;
+		if (other->shape_type != COLLISION_SHAPE_TRI_MESH)
+		{
+			vec3_sub(n, c2, c1);
+			closing = vec3_dot(motion, n) / vec3_length(n);
+		}
+
+		if (closing <= 0.0f)
+		{
+			return toi_max;
+		}
+
+		t += (dist - target) / closing;
+		if (t >= toi_max)
+		{
+			return toi_max;
+		}
+
+		vec3_copy(bullet->position, start);
+		vec3_translate_scaled(bullet->position, motion, t);
+		dist = body_body_distance(c1, c2, pipeline, bullet, other, 0.0f);
+		if (dist <= target + tolerance)
+		{
+			break;
+		}
+	}
+
+	/* iterations exhausted: t is still a conservative (early) time of impact */
+	return t;
+}
+
+struct ccd_output
+{
+	f32 *	toi;
+};
+
+static void thread_ccd_bullets(void *task_addr)
+{
+	PROF_ZONE;
+
+	struct task *task = task_addr;
+	struct worker *worker = task->executor;
+	const struct task_range *range = task->range;
+	const struct physics_pipeline *pipeline = task->input;
+	const f32 delta = (f32) pipeline->ns_tick / NSEC_PER_SEC;
+	const u32 *bullet = range->base;
+
+	struct ccd_output *out = arena_push(&worker->mem_frame, sizeof(struct ccd_output));
+	out->toi = arena_push(&worker->mem_frame, range->count * sizeof(f32));
+
+	struct AABB sweep;
+	vec3 start, motion, half_motion;
+	for (u64 i = 0; i < range->count; ++i)
+	{
+		out->toi[i] = 1.0f;
+		const struct rigid_body *body = pool_address(&pipeline->body_pool, bullet[i]);
+		if (g_solver_config->sleep_enabled && !RB_IS_AWAKE(body))
+		{
+			continue;
+		}
+
+		/* island_solve integrated position += velocity*delta, so the sweep is recovered exactly */
+		vec3_scale(motion, body->velocity, delta);
+		const f32 min_hw = f32_min(body->local_box.hw[0], f32_min(body->local_box.hw[1], body->local_box.hw[2]));
+		if (vec3_dot(motion, motion) <= min_hw*min_hw)
+		{
+			continue;
+		}
+
+		vec3_sub(start, body->position, motion);
+		vec3_scale(half_motion, motion, 0.5f);
+		vec3_add(sweep.center, start, body->local_box.center);
+		vec3_translate(sweep.center, half_motion);
+		vec3_abs(half_motion);
+		vec3_add(sweep.hw, body->local_box.hw, half_motion);
+		vec3_add_constant(sweep.hw, body->margin);
+
+		arena_push_record(&worker->mem_frame);
+		u32 *id = (u32 *) worker->mem_frame.stack_ptr;
+		u32 count = dbvh_push_bbox_overlaps(&worker->mem_frame, &pipeline->dynamic_tree, &sweep);
+		count += dbvh_push_bbox_overlaps(&worker->mem_frame, &pipeline->static_tree, &sweep);
+
+		struct rigid_body copy = *body;
+		for (u32 j = 0; j < count; ++j)
+		{
+			const struct rigid_body *other = pool_address(&pipeline->body_pool, id[j]);
+			/* 
+			 * bullet-bullet pairs are skipped: both bodies move, so a sweep against the other's end of frame
+			 * pose is meaningless; such pairs only get discrete contacts and may tunnel through each other.
+			 */
+			if (id[j] == bullet[i] || (other->flags & RB_BULLET))
+			{
+				continue;
+			}
+			out->toi[i] = internal_bullet_time_of_impact(pipeline, &copy, other, start, motion, out->toi[i]);
+		}
+		arena_pop_record(&worker->mem_frame);
+	}
+
+	task->output = out;
+	PROF_ZONE_END;
+}
+
+static void internal_ccd_bullets(struct arena *mem_frame, struct physics_pipeline *pipeline, const f32 delta)
+{
+	PROF_ZONE;
+
+	struct task_bundle *bundle = task_bundle_split_range(
+			mem_frame, 
+			&thread_ccd_bullets, 
+			g_task_ctx->worker_count, 
+			pipeline->bullet, 
+			pipeline->bullet_count, 
+			sizeof(u32), 
+			pipeline);
+
+	if (bundle)
+	{
+		task_main_master_run_available_jobs();
+		task_bundle_wait(bundle);
+
+		/* bullets are only moved back once every sweep is done, so sweeps never see partially updated poses */
+		vec3 motion;
+		for (u32 i = 0; i < bundle->task_count; ++i)
+		{
+			const struct ccd_output *out = (struct ccd_output *) atomic_load_acq_64(&bundle->tasks[i].output);
+			const u32 *bullet = bundle->tasks[i].range->base;
+			for (u32 j = 0; j < bundle->tasks[i].range->count; ++j)
+			{
+				if (out->toi[j] < 1.0f)
+				{
+					struct rigid_body *body = pool_address(&pipeline->body_pool, bullet[j]);
+					vec3_scale(motion, body->velocity, delta);
+					vec3_translate_scaled(body->position, motion, out->toi[j] - 1.0f);
+					pipeline->ccd_hit_count += 1;
+				}
+			}
+		}
+		task_bundle_release(bundle);
+	}
+
+	PROF_ZONE_END;
+}
+
+void physics_pipeline_rigid_body_set_bullet(struct physics_pipeline *pipeline, const u32 handle, const u32 bullet)
+{
+	struct rigid_body *b = pool_address(&pipeline->body_pool, handle);
+	kas_assert(POOL_SLOT_ALLOCATED(b));
+	if (bullet && (b->flags & RB_DYNAMIC) && b->shape_type != COLLISION_SHAPE_TRI_MESH)
+	{
+		b->flags |= RB_BULLET;
+	}
+	else
+	{
+		b->flags &= ~RB_BULLET;
+	}
+}
+
 void physics_pipeline_enable_sleeping(struct physics_pipeline *pipeline)
 {
 	assert(g_solver_config->sleep_enabled == 0);
@@ -773,6 +1474,8 @@ static void internal_update_contact_solver_config(struct physics_pipeline *pipel
 {
 	g_solver_config->warmup_solver = g_solver_config->pending_warmup_solver;
 	g_solver_config->block_solver = g_solver_config->pending_block_solver;
+	g_solver_config->wide_solver = g_solver_config->pending_wide_solver;
+	g_solver_config->split_island_body_count = g_solver_config->pending_split_island_body_count;
 	g_solver_config->iteration_count = g_solver_config->pending_iteration_count;
 	g_solver_config->linear_slop = g_solver_config->pending_linear_slop;
 	g_solver_config->baumgarte_constant = g_solver_config->pending_baumgarte_constant;
@@ -797,12 +1500,23 @@ static void physics_pipeline_rigid_body_dealloc(struct physics_pipeline *pipelin
 	kas_assert(POOL_SLOT_ALLOCATED(body));
 
 	string_database_dereference(pipeline->shape_db, body->shape_handle);
-	dbvh_remove(&pipeline->dynamic_tree, body->proxy);
+	internal_proxy_pair_remove_body(pipeline, handle);
+	if (body->flags & RB_DYNAMIC)
+	{
+		dbvh_remove(&pipeline->dynamic_tree, body->proxy);
+	}
+	else
+	{
+		dbvh_remove(&pipeline->static_tree, body->proxy);
+		internal_static_tree_edited(pipeline);
+	}
+
 	if (body->island_index != ISLAND_STATIC)
 	{
 		is_db_island_remove_body_resources(pipeline, body->island_index, handle);
 		c_db_remove_body_contacts(pipeline, handle);
-		if (bit_vec_get_bit(&pipeline->is_db.island_usage, body->island_index) && ((struct island *) array_list_address(pipeline->is_db.islands, body->island_index))->contact_count > 0)
+		const struct island *is = array_list_address(pipeline->is_db.islands, body->island_index);
+		if (bit_vec_get_bit(&pipeline->is_db.island_usage, body->island_index) && (is->contact_count > 0 || is->body_count > 1))
 		{
 			is_db_split_island(&pipeline->frame, pipeline, body->island_index);
 		}
@@ -815,39 +1529,17 @@ static void physics_pipeline_rigid_body_dealloc(struct physics_pipeline *pipelin
 		for (u32 i = 0; i < island_count; ++i)
 		{
 			struct island *is = array_list_address(pipeline->is_db.islands, island[i]);
-			struct is_index_entry *prev = NULL;
-			struct is_index_entry *entry;
-			u32 prev_index = ISLAND_NULL;
-			u32 index = is->contact_first;
-			do 
+			u32 *contact = pipeline->is_db.contact + is->contact_offset;
+			u32 count = 0;
+			for (u32 j = 0; j < is->contact_count; ++j)
 			{
-				entry = array_list_address(pipeline->is_db.island_contact_lists, index);
-				const u32 next = entry->next;
-				if (bit_vec_get_bit(&pipeline->c_db.contacts_persistent_usage, entry->index) == 0)
+				if (bit_vec_get_bit(&pipeline->c_db.contacts_persistent_usage, contact[j]))
 				{
-					if (prev)
-					{
-						prev->next = entry->next;
-					}
-					else
-					{
-						is->contact_first = entry->next;
-					}
-					entry->next = ISLAND_NULL;
-					entry->index = ISLAND_NULL;
-					array_list_remove_index(pipeline->is_db.island_contact_lists, index);
-					is->contact_count -= 1;
+					contact[count++] = contact[j];
 				}
-				else
-				{
-					prev_index = index;
-					prev = entry;
-				}
-				index = next;
-			} 
-			while (index != ISLAND_NULL);
+			}
 
-			is->contact_last = prev_index;
+			is->contact_count = count;
 			if (is->contact_count > 0)
 			{
 				is_db_split_island(&pipeline->frame, pipeline, island[i]);
@@ -899,7 +1591,19 @@ void internal_physics_pipeline_simulate_frame(struct physics_pipeline *pipeline,
 	internal_update_contact_solver_config(pipeline);
 
 	/* broadphase => narrowphase => solve => integrate */
-	internal_update_dynamic_tree(pipeline);
+	struct task_bundle *static_tree_bundle = NULL;
+	if (pipeline->static_tree_dirty)
+	{
+		/* the static tree is rebuilt on any free worker while we update the dynamic tree */
+		static_tree_bundle = task_bundle_alloc_task(&pipeline->frame, thread_update_static_tree, pipeline);
+		task_bundle_submit(static_tree_bundle);
+	}
+	internal_update_dynamic_tree(&pipeline->frame, pipeline, delta);
+	if (static_tree_bundle)
+	{
+		task_bundle_wait(static_tree_bundle);
+		task_bundle_release(static_tree_bundle);
+	}
 	internal_push_proxy_overlaps(&pipeline->frame, pipeline);
 	internal_parallel_push_contacts(&pipeline->frame, pipeline);
 
@@ -907,6 +1611,7 @@ void internal_physics_pipeline_simulate_frame(struct physics_pipeline *pipeline,
 	internal_remove_contacts_and_tag_split_islands(&pipeline->frame, pipeline);
 	internal_split_islands(&pipeline->frame, pipeline);
 	internal_parallel_solve_islands(&pipeline->frame, pipeline, delta);
+	internal_ccd_bullets(&pipeline->frame, pipeline, delta);
 
 	PHYSICS_PIPELINE_VALIDATE(pipeline);
 }
@@ -926,11 +1631,12 @@ void physics_pipeline_tick(struct physics_pipeline *pipeline)
 	PROF_ZONE_END;
 }
 
-u32f32 physics_pipeline_raycast_parameter(struct arena *mem_tmp, const struct physics_pipeline *pipeline, const struct ray *ray)
+static u32f32 internal_bvh_raycast_parameter(struct arena *mem_tmp, const struct physics_pipeline *pipeline, const struct bvh *bvh, const struct ray *ray, const u32f32 hit)
 {
 	arena_push_record(mem_tmp);
 
-	struct bvh_raycast_info info = bvh_raycast_init(mem_tmp, &pipeline->dynamic_tree, ray);
+	struct bvh_raycast_info info = bvh_raycast_init(mem_tmp, bvh, ray);
+	info.hit = hit;
 	while (info.hit_queue.count)
 	{
 		const u32f32 tuple = min_queue_fixed_pop(&info.hit_queue);
@@ -960,6 +1666,14 @@ u32f32 physics_pipeline_raycast_parameter(struct arena *mem_tmp, const struct ph
 	return info.hit;
 }
 
+u32f32 physics_pipeline_raycast_parameter(struct arena *mem_tmp, const struct physics_pipeline *pipeline, const struct ray *ray)
+{
+	u32f32 hit = u32f32_inline(U32_MAX, F32_INFINITY);
+	hit = internal_bvh_raycast_parameter(mem_tmp, pipeline, &pipeline->dynamic_tree, ray, hit);
+	hit = internal_bvh_raycast_parameter(mem_tmp, pipeline, &pipeline->static_tree, ray, hit);
+	return hit;
+}
+
 struct physics_event *physics_pipeline_event_push(struct physics_pipeline *pipeline)
 {
 	struct slot slot = pool_add(&pipeline->event_pool);
@@ -1196,6 +1910,7 @@ void prefab_statics_setup(struct rigid_body_prefab *prefab, struct collision_sha
 			{
 				vec3_translate(shape->hull.v[i], com);
 			}
+			dcel_vertex_soa_sync(&shape->hull);
 		}
 
 		f32 integrals[10] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; 
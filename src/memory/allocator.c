@@ -55,15 +55,23 @@ void arena_remove_record(struct arena *ar)
 	}
 }
 
+/* memory left that is backed by pages; a growable arena poisons its memory as it is committed */
+static u64 arena_committed_left(const struct arena *ar)
+{
+	return (ar->commit_end) 
+		? (u64) (ar->commit_end - ar->stack_ptr) 
+		: ar->mem_left;
+}
+
 struct arena arena_record_and_unpoison(struct arena *arena_addr)
 {
-	UNPOISON_ADDRESS(arena_addr->stack_ptr, arena_addr->mem_left);
+	UNPOISON_ADDRESS(arena_addr->stack_ptr, arena_committed_left(arena_addr));
 	return *arena_addr;	
 }
 
 struct arena arena_record_release_and_poison(struct arena *record_addr)
 {
-	POISON_ADDRESS(record_addr->stack_ptr, record_addr->mem_left);
+	POISON_ADDRESS(record_addr->stack_ptr, arena_committed_left(record_addr));
 	return *record_addr;
 }
 
@@ -88,15 +96,85 @@ struct arena arena_alloc(const u64 size)
 	return ar;
 }
 
+struct arena arena_alloc_growable(const u64 size)
+{
+	struct arena ar = { 0 };
+
+	const u64 reserve_size = ((size + ARENA_COMMIT_SIZE - 1) / ARENA_COMMIT_SIZE) * ARENA_COMMIT_SIZE;
+	ar.stack_ptr = virtual_memory_reserve_uncommitted(reserve_size);
+	if (ar.stack_ptr)
+	{
+		ar.mem_size = reserve_size;
+		ar.mem_left = reserve_size;
+		ar.commit_end = ar.stack_ptr;
+	}
+
+	return ar;
+}
+
+/* commit growable arena memory up to at least end */
+static u32 arena_commit(struct arena *ar, const u8 *end)
+{
+	u8 *base = ar->stack_ptr - (ar->mem_size - ar->mem_left);
+	const u64 commit_size = ((u64) (end - base) + ARENA_COMMIT_SIZE - 1) / ARENA_COMMIT_SIZE * ARENA_COMMIT_SIZE;
+	if (!virtual_memory_commit(ar->commit_end, (u64) (base + commit_size - ar->commit_end)))
+	{
+		return 0;
+	}
+
+	POISON_ADDRESS(ar->commit_end, (u64) (base + commit_size - ar->commit_end));
+	ar->commit_end = base + commit_size;
+	return 1;
+}
+
+/* decommit memory of a growable arena left over from a spike; called on flush with the flushed high-water mark */
+static void arena_decommit_spike(struct arena *ar, u8 *base, const u64 high_water)
+{
+	const u64 committed = (u64) (ar->commit_end - base);
+	if (2*high_water >= committed)
+	{
+		ar->decommit_streak = 0;
+		ar->mem_recent_high_water = 0;
+		return;
+	}
+
+	ar->mem_recent_high_water = (high_water > ar->mem_recent_high_water) ? high_water : ar->mem_recent_high_water;
+	if (++ar->decommit_streak == ARENA_DECOMMIT_FLUSHES)
+	{
+		const u64 keep = (2*ar->mem_recent_high_water + ARENA_COMMIT_SIZE - 1) / ARENA_COMMIT_SIZE * ARENA_COMMIT_SIZE;
+		if (keep < committed)
+		{
+			virtual_memory_decommit(base + keep, committed - keep);
+			ar->commit_end = base + keep;
+		}
+		ar->decommit_streak = 0;
+		ar->mem_recent_high_water = 0;
+	}
+}
+
+u64 arena_high_water(const struct arena *ar)
+{
+	const u64 used = ar->mem_size - ar->mem_left;
+	return (used > ar->mem_high_water) ? used : ar->mem_high_water;
+}
+
+u64 arena_committed(const struct arena *ar)
+{
+	return (ar->commit_end)
+		? (u64) (ar->commit_end - (ar->stack_ptr - (ar->mem_size - ar->mem_left)))
+		: ar->mem_size;
+}
+
 void arena_free(struct arena *ar)
 {
+	UNPOISON_ADDRESS(ar->stack_ptr - (ar->mem_size - ar->mem_left), arena_committed(ar));
 	ar->stack_ptr -= ar->mem_size - ar->mem_left;
-	UNPOISON_ADDRESS(ar->stack_ptr, ar->mem_size);
 	virtual_memory_release(ar->stack_ptr, ar->mem_size);
 	ar->mem_size = 0;
 	ar->mem_left = 0;
 	ar->stack_ptr = NULL;
 	ar->record = NULL;
+	ar->commit_end = NULL;
 }
 
 static u32 count = 0;
@@ -131,10 +209,16 @@ void arena_flush(struct arena* ar)
 {
 	if (ar)
 	{
+		const u64 high_water = arena_high_water(ar);
 		ar->stack_ptr -= ar->mem_size - ar->mem_left;
 		ar->mem_left = ar->mem_size;
+		ar->mem_high_water = 0;
 		ar->record = NULL;
-		POISON_ADDRESS(ar->stack_ptr, ar->mem_left);
+		POISON_ADDRESS(ar->stack_ptr, arena_committed_left(ar));
+		if (ar->commit_end)
+		{
+			arena_decommit_spike(ar, ar->stack_ptr, high_water);
+		}
 	}
 }
 
@@ -142,6 +226,9 @@ void arena_pop_packed(struct arena *ar, const u64 mem_to_pop)
 {
 	kas_assert_string(ar->mem_size - ar->mem_left >= mem_to_pop, "Trying to pop memory outside of arena");
 
+	/* usage only peaks right before it shrinks, so the high-water mark is kept up to date here and on flush */
+	ar->mem_high_water = arena_high_water(ar);
+
 	ar->stack_ptr -= mem_to_pop;
 	ar->mem_left += mem_to_pop;
 	POISON_ADDRESS(ar->stack_ptr, mem_to_pop);
@@ -159,6 +246,12 @@ void *arena_push_aligned(struct arena *ar, const u64 size, const u64 alignment)
 
 		if (ar->mem_left >= size + push_alignment) 
 		{
+			if (ar->commit_end && ar->stack_ptr + push_alignment + size > ar->commit_end 
+					&& !arena_commit(ar, ar->stack_ptr + push_alignment + size))
+			{
+				return NULL;
+			}
+
 			UNPOISON_ADDRESS(ar->stack_ptr + push_alignment, size);
 			alloc_addr = ar->stack_ptr + push_alignment;
 			ar->mem_left -= size + push_alignment;
@@ -197,9 +290,22 @@ struct allocation_array arena_push_aligned_all(struct arena *ar, const u64 slot_
 	struct allocation_array array = { .len = 0, .addr = NULL, .mem_pushed = 0 };
 	const u64 mod = ((u64) ar->stack_ptr) & (alignment - 1);
 	const u64 push_alignment = (!!mod) * (alignment - mod);
-	if (push_alignment + slot_size <= ar->mem_left)
+
+	/* a growable arena hands out what it has committed, with at least ARENA_COMMIT_SIZE bytes of it left */
+	u64 mem_left = ar->mem_left;
+	if (ar->commit_end)
+	{
+		if ((u64) (ar->commit_end - ar->stack_ptr) < ARENA_COMMIT_SIZE
+			&& !arena_commit(ar, ar->stack_ptr + ((ar->mem_left < ARENA_COMMIT_SIZE) ? ar->mem_left : ARENA_COMMIT_SIZE)))
+		{
+			return array;
+		}
+		mem_left = arena_committed_left(ar);
+	}
+
+	if (push_alignment + slot_size <= mem_left)
 	{
-		array.len = (ar->mem_left - push_alignment) / slot_size;
+		array.len = (mem_left - push_alignment) / slot_size;
 		array.addr = ar->stack_ptr + push_alignment;
 		UNPOISON_ADDRESS(ar->stack_ptr + push_alignment, array.len * slot_size);
 		array.mem_pushed = push_alignment + array.len * slot_size;
@@ -53,15 +53,28 @@ struct arena_record
 };
 
 /* arena - Contiguous memory aligned to MEMORY_ALIGNMENT. Any allocation, unless specifically packed, 
- * 	   is aligned to DEFAULT_MEMORY_ALIGNMENT */
+ * 	   is aligned to DEFAULT_MEMORY_ALIGNMENT 
+ *
+ * A growable arena reserves address space only, and commits it in ARENA_COMMIT_SIZE steps as pushes reach
+ * past the committed end, so it may grow to gigabytes without moving. On flush, memory committed beyond
+ * twice the recent high-water mark is decommitted once ARENA_DECOMMIT_FLUSHES flushes in a row have stayed
+ * below it, returning the memory of a spike.
+ */
 struct arena 
 {
 	u8 * 			stack_ptr;
 	u64 			mem_size;
 	u64 			mem_left;
 	struct arena_record *	record;		/* NULL == no record */
+	u64			mem_high_water;	/* most memory in use since the last flush, see arena_high_water */
+	u8 *			commit_end;	/* growable arena: end of committed memory, NULL == all committed */
+	u64			mem_recent_high_water; /* growable arena: high-water mark over the current decommit streak */
+	u32			decommit_streak; /* growable arena: consecutive flushes using less than half of committed */
 };
 
+#define ARENA_COMMIT_SIZE	((u64) 1024*1024)	/* commit granularity of growable arenas */
+#define ARENA_DECOMMIT_FLUSHES	64			/* flushes below half of committed before decommit */
+
 /* setup arena using global block allocator */
 struct arena	arena_alloc_1MB(void);
 /*  global block allocator free wrapper */
@@ -76,6 +89,12 @@ void 		arena_remove_record(struct arena *ar);
 
 /* If allocation failed, return arena = { 0 } */
 struct arena	arena_alloc(const u64 size);
+/* reserve size bytes of address space for a growable arena; If allocation failed, return arena = { 0 } */
+struct arena	arena_alloc_growable(const u64 size);
+/* return the most memory in use since the last flush */
+u64		arena_high_water(const struct arena *ar);
+/* return the committed memory of the arena */
+u64		arena_committed(const struct arena *ar);
 /* free heap memory and set *ar = empty_arena */
 void		arena_free(struct arena *ar);
 /* flush contents, reset stack to start of stack */
@@ -59,6 +59,8 @@
 
 #include "ticket_factory.h"
 
+#define LOG_SPIN_ROUNDS	64	/* busy-wait rounds before a blocked logger starts yielding */
+
 static utf8 systems[T_COUNT];
 static utf8 severities[S_COUNT];
 
@@ -143,12 +145,27 @@ static void log_try_write_to_disk(void)
 	}
 }
 
+/* pause while the writer is likely to finish soon, then give up the time slice */
+static void log_backoff(const u32 round)
+{
+	if (round < LOG_SPIN_ROUNDS)
+	{
+		kas_cpu_relax();
+	}
+	else
+	{
+		kas_thread_yield();
+	}
+}
+
 static void internal_write_to_disk(void)
 {
 	/* spin until all tickets have finished and the messages have been written to disk */
+	u32 round = 0;
 	while (atomic_load_acq_32(&g_log.tf->a_serve) != atomic_load_acq_32(&g_log.tf->a_next))
 	{
 		log_try_write_to_disk();
+		log_backoff(round++);
 	}
 }
 
@@ -174,6 +191,7 @@ void log_write_message(const enum system_id system, const enum severity_id sever
 	/* spin until a new msg slot is up for grabs for us to publish */
 	u32 ticket;
 	u32 ret;
+	u32 round = 0;
 	while (!(ret = ticket_factory_try_get_ticket(&ticket, g_log.tf)))
 	{
 		/* If we fail to get a ticket after the shutdown process has started, 
@@ -182,6 +200,7 @@ void log_write_message(const enum system_id system, const enum severity_id sever
 		 * log_shutdown();
 		 */
 		log_try_write_to_disk();
+		log_backoff(round++);
 	}
 
 	if (ret == TICKET_FACTORY_CLOSED) { return; }
@@ -29,6 +29,8 @@ struct array_list_intrusive *g_gl_state_list = NULL;
 u32 g_gl_state = U32_MAX;
 struct pool g_binding_pool = { 0 };
 
+struct gl_call_counter g_gl_frame_calls = { 0 };
+
 u32 			tx_in_use = 0;	/* number of texture names currently allocated (glGen*, glDel*) */
 struct array_list *	tx_list = NULL;
 
@@ -136,8 +138,30 @@ static void gl_state_assert_texture_unit(void)
 	gl_state->func.glActiveTexture(tx_unit_active);
 }
 
+static void gl_state_assert_bindings(void)
+{
+	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
+	GLint program, vao, array_buffer, element_array_buffer, viewport[4];
+	gl_state->func.glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	gl_state->func.glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vao);
+	gl_state->func.glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &array_buffer);
+	gl_state->func.glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_array_buffer);
+	gl_state->func.glGetIntegerv(GL_VIEWPORT, viewport);
+
+	kas_assert(gl_state->depth == gl_state->func.glIsEnabled(GL_DEPTH_TEST));
+	kas_assert((GLint) gl_state->program == program);
+	kas_assert((GLint) gl_state->vao == vao);
+	kas_assert(gl_state->array_buffer == U32_MAX || (GLint) gl_state->array_buffer == array_buffer);
+	kas_assert(gl_state->element_array_buffer == U32_MAX || (GLint) gl_state->element_array_buffer == element_array_buffer);
+	kas_assert(gl_state->viewport[2] < 0 || (gl_state->viewport[0] == viewport[0]
+				&& gl_state->viewport[1] == viewport[1]
+				&& gl_state->viewport[2] == viewport[2]
+				&& gl_state->viewport[3] == viewport[3]));
+}
+
 void gl_state_assert(void)
 {
+	gl_state_assert_bindings();
 	gl_state_assert_blending();
 	gl_state_assert_culling();
 	gl_state_assert_texture_unit();
@@ -196,7 +220,22 @@ void kas_glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alph
 void kas_glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
 {
 	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
-	gl_state->func.glViewport(x, y, width, height);
+	if (gl_state->viewport[0] != x
+			|| gl_state->viewport[1] != y
+			|| gl_state->viewport[2] != width
+			|| gl_state->viewport[3] != height)
+	{
+		gl_state->func.glViewport(x, y, width, height);
+		gl_state->viewport[0] = x;
+		gl_state->viewport[1] = y;
+		gl_state->viewport[2] = width;
+		gl_state->viewport[3] = height;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
+	}
 }
 
 void kas_glGenBuffers(GLsizei n, GLuint *buffers)
@@ -208,7 +247,27 @@ void kas_glGenBuffers(GLsizei n, GLuint *buffers)
 void kas_glBindBuffer(GLenum target, GLuint buffer)
 {
 	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
-	gl_state->func.glBindBuffer(target, buffer);
+	GLuint *binding = NULL;
+	switch (target)
+	{
+		case GL_ARRAY_BUFFER: { binding = &gl_state->array_buffer; } break;
+		case GL_ELEMENT_ARRAY_BUFFER: { binding = &gl_state->element_array_buffer; } break;
+		default: { } break;
+	}
+
+	if (binding && *binding == buffer)
+	{
+		g_gl_frame_calls.skipped += 1;
+	}
+	else
+	{
+		gl_state->func.glBindBuffer(target, buffer);
+		if (binding)
+		{
+			*binding = buffer;
+		}
+		g_gl_frame_calls.issued += 1;
+	}
 }
 
 void kas_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage)
@@ -227,6 +286,63 @@ void kas_glDeleteBuffers(GLsizei n, const GLuint *buffers)
 {
 	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
 	gl_state->func.glDeleteBuffers(n, buffers);
+
+	/* 
+	 * the current context falls back to buffer 0, while other contexts keep the deleted buffer bound; 
+	 * their cached bindings are invalidated so that a reused buffer name is not skipped. 
+	 */
+	for (u32 c = 0; c < g_gl_state_list->max_count; ++c)
+	{
+		struct gl_state *local_state = array_list_intrusive_address(g_gl_state_list, c);
+		if (!local_state->header.allocated)
+		{
+			continue;
+		}
+
+		const GLuint unbound = (c == g_gl_state) ? 0 : U32_MAX;
+		for (GLsizei i = 0; i < n; ++i)
+		{
+			if (local_state->array_buffer == buffers[i])
+			{
+				local_state->array_buffer = unbound;
+			}
+
+			if (local_state->element_array_buffer == buffers[i])
+			{
+				local_state->element_array_buffer = unbound;
+			}
+		}
+	}
+}
+
+void *kas_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access)
+{
+	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
+	return gl_state->func.glMapBufferRange(target, offset, length, access);
+}
+
+GLboolean kas_glUnmapBuffer(GLenum target)
+{
+	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
+	return gl_state->func.glUnmapBuffer(target);
+}
+
+GLsync kas_glFenceSync(GLenum condition, GLbitfield flags)
+{
+	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
+	return gl_state->func.glFenceSync(condition, flags);
+}
+
+GLenum kas_glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout)
+{
+	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
+	return gl_state->func.glClientWaitSync(sync, flags, timeout);
+}
+
+void kas_glDeleteSync(GLsync sync)
+{
+	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
+	gl_state->func.glDeleteSync(sync);
 }
 
 void kas_glDrawArrays(GLenum mode, GLint first, GLsizei count)
@@ -263,12 +379,31 @@ void kas_glDeleteVertexArrays(GLsizei n, const GLuint *arrays)
 {
 	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
 	gl_state->func.glDeleteVertexArrays(n, arrays);
+	for (GLsizei i = 0; i < n; ++i)
+	{
+		if (arrays[i] == gl_state->vao)
+		{
+			gl_state->vao = 0;
+			gl_state->element_array_buffer = U32_MAX;
+		}
+	}
 }
 
 void kas_glBindVertexArray(GLuint array)
 {
 	struct gl_state *gl_state = array_list_intrusive_address(g_gl_state_list, g_gl_state);
-	gl_state->func.glBindVertexArray(array);
+	if (gl_state->vao != array)
+	{
+		/* the element array binding is vertex array state, unknown until rebound */
+		gl_state->func.glBindVertexArray(array);
+		gl_state->vao = array;
+		gl_state->element_array_buffer = U32_MAX;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
+	}
 }
 
 void kas_glEnableVertexAttribArray(GLuint index)
@@ -551,6 +686,11 @@ void kas_glDisableBlending(void)
 	{
 		gl_state->func.glDisable(GL_BLEND);
 		gl_state->blend = 0;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -561,6 +701,11 @@ void kas_glEnableBlending(void)
 	{
 		gl_state->func.glEnable(GL_BLEND);
 		gl_state->blend = 1;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -572,6 +717,11 @@ void kas_glBlendEquation(const GLenum eq)
 		gl_state->func.glBlendEquation(eq);
 		gl_state->eq_rgb = eq;
 		gl_state->eq_a = eq;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -583,6 +733,11 @@ void kas_glBlendEquationSeparate(const GLenum eq_rgb, const GLenum eq_a)
 		gl_state->func.glBlendEquationSeparate(eq_rgb, eq_a);
 		gl_state->eq_rgb = eq_rgb;
 		gl_state->eq_a = eq_a;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -599,6 +754,11 @@ void kas_glBlendFunc(const GLenum sfactor, const GLenum dfactor)
 		gl_state->func_s_a = sfactor;
 		gl_state->func_d_rgb = dfactor;
 		gl_state->func_d_a = dfactor;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -615,6 +775,11 @@ void kas_glBlendFuncSeparate(const GLenum srcRGB, const GLenum dstRGB, const GLe
 		gl_state->func_s_a = srcAlpha;
 		gl_state->func_d_rgb = dstRGB;
 		gl_state->func_d_a = dstAlpha;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -625,6 +790,11 @@ void kas_glEnableFaceCulling(void)
 	{
 		gl_state->cull_face = 1;
 		gl_state->func.glEnable(GL_CULL_FACE);
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -635,6 +805,11 @@ void kas_glDisableFaceCulling(void)
 	{
 		gl_state->cull_face = 0;
 		gl_state->func.glDisable(GL_CULL_FACE);
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -645,6 +820,11 @@ void kas_glCullFace(const GLenum mode)
 	{
 		gl_state->cull_mode = mode;
 		gl_state->func.glCullFace(mode);
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -655,6 +835,11 @@ void kas_glFrontFace(const GLenum mode)
 	{
 		gl_state->face_front = mode;
 		gl_state->func.glFrontFace(mode);
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -666,6 +851,11 @@ void kas_glActiveTexture(const GLenum tx_unit)
 	{
 		gl_state->tx_unit_active = i;
 		gl_state->func.glActiveTexture(tx_unit);
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -760,9 +950,12 @@ void kas_glBindTexture(const GLenum target, const GLuint tx)
 
 	if (prev_tx == tx)
 	{
+		g_gl_frame_calls.skipped += 1;
 		return;
 	}
 
+	g_gl_frame_calls.issued += 1;
+
 	if (prev_tx)
 	{
 		struct gl_texture *texture = array_list_address(tx_list, prev_tx);
@@ -944,6 +1137,11 @@ void kas_glEnableDepthTesting(void)
 	{
 		gl_state->func.glEnable(GL_DEPTH_TEST);
 		gl_state->depth = 1;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -954,6 +1152,11 @@ void kas_glDisableDepthTesting(void)
 	{
 		gl_state->func.glDisable(GL_DEPTH_TEST);
 		gl_state->depth = 0;
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -976,6 +1179,11 @@ void kas_glUseProgram(GLuint program)
 	{
 		gl_state->program = program;
 		gl_state->func.glUseProgram(program);
+		g_gl_frame_calls.issued += 1;
+	}
+	else
+	{
+		g_gl_frame_calls.skipped += 1;
 	}
 }
 
@@ -1079,6 +1287,19 @@ u32 gl_state_alloc(void)
 	gl_state->depth = 0;
 	kas_glEnableDepthTesting();
 
+	gl_state->vao = U32_MAX;
+	kas_glBindVertexArray(0);
+
+	gl_state->array_buffer = U32_MAX;
+	gl_state->element_array_buffer = U32_MAX;
+	kas_glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	/* a negative width is never set, so the first viewport call is always issued */
+	gl_state->viewport[0] = 0;
+	gl_state->viewport[1] = 0;
+	gl_state->viewport[2] = -1;
+	gl_state->viewport[3] = -1;
+
 	gl_state->tx_unit_active = g_gl_limits->tx_unit_count;
 	kas_glActiveTexture(GL_TEXTURE0 + 0);
 	kas_assert(gl_state->tx_unit_active == 0);
@@ -106,18 +106,36 @@ void r_compile_shader(u32 *prg, const char *v_filepath, const char *f_filepath)
 	kas_glDeleteShader(f_sh);
 }
 
-void r_color_buffer_layout_setter(void)
+static const char *r_uniform_name[UNIFORM_COUNT] =
+{
+	"aspect_ratio",
+	"view",
+	"perspective",
+	"light_position",
+	"resolution",
+	"texture",
+};
+
+static void r_program_resolve_uniforms(struct r_program *program)
+{
+	for (u32 i = 0; i < UNIFORM_COUNT; ++i)
+	{
+		program->uniform[i] = (GLint) kas_glGetUniformLocation(program->gl_program, r_uniform_name[i]);
+	}
+}
+
+void r_color_buffer_layout_setter(const u64 offset)
 {
 	kas_glEnableVertexAttribArray(0);
 	kas_glEnableVertexAttribArray(1);
 
 	const u64 stride = sizeof(vec3) + sizeof(vec4);
 
-	kas_glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (GLsizei)  stride, 0);
-	kas_glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, (GLsizei)  stride, (void *)(sizeof(vec3)));
+	kas_glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (GLsizei)  stride, (void *)(offset));
+	kas_glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, (GLsizei)  stride, (void *)(offset + sizeof(vec3)));
 }
 
-void r_lightning_buffer_layout_setter(void)
+void r_lightning_buffer_layout_setter(const u64 offset)
 {
 	kas_glEnableVertexAttribArray(0);
 	kas_glEnableVertexAttribArray(1);
@@ -125,9 +143,9 @@ void r_lightning_buffer_layout_setter(void)
 
 	const u64 stride = 2*sizeof(vec3) + sizeof(vec4);
 
-	kas_glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (GLsizei)  stride, 0);
-	kas_glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, (GLsizei)  stride, (void *)(sizeof(vec3)));
-	kas_glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, (GLsizei)  stride, (void *)(sizeof(vec3) + sizeof(vec4)));
+	kas_glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, (GLsizei)  stride, (void *)(offset));
+	kas_glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, (GLsizei)  stride, (void *)(offset + sizeof(vec3)));
+	kas_glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, (GLsizei)  stride, (void *)(offset + sizeof(vec3) + sizeof(vec4)));
 }
 
 void r_init(struct arena *mem_persistent, const u64 ns_tick, const u64 frame_size, const u64 core_unit_count, struct string_database *mesh_database)
@@ -135,6 +153,8 @@ void r_init(struct arena *mem_persistent, const u64 ns_tick, const u64 frame_siz
 	g_r_core->frames_elapsed = 0;	
 	g_r_core->ns_elapsed = 0;	
 	g_r_core->ns_tick = ns_tick;	
+	g_r_core->mesh_page_count = 0;
+	g_r_core->frame_upload_bytes = 0;
 
 	r_compile_shader(&g_r_core->program[PROGRAM_UI].gl_program, vertex_ui, fragment_ui);
 	g_r_core->program[PROGRAM_UI].shared_stride = S_UI_STRIDE;
@@ -160,6 +180,11 @@ void r_init(struct arena *mem_persistent, const u64 ns_tick, const u64 frame_siz
 	g_r_core->program[PROGRAM_LIGHTNING].buffer_shared_layout_setter = NULL;
 	g_r_core->program[PROGRAM_LIGHTNING].buffer_local_layout_setter = r_lightning_buffer_layout_setter;
 
+	for (u32 i = 0; i < PROGRAM_COUNT; ++i)
+	{
+		r_program_resolve_uniforms(g_r_core->program + i);
+	}
+
 	g_r_core->frame = arena_alloc(frame_size); 
 	if (g_r_core->frame.mem_size == 0)
 	{
@@ -167,6 +192,8 @@ void r_init(struct arena *mem_persistent, const u64 ns_tick, const u64 frame_siz
 		fatal_cleanup_and_exit(0);
 	}
 
+	r_stream_init(&g_r_core->stream);
+
 	g_r_core->proxy3d_hierarchy = hierarchy_index_alloc(NULL, core_unit_count, sizeof(struct r_proxy3d), HI_GROWABLE);
 	if (g_r_core->proxy3d_hierarchy == NULL)
 	{
@@ -189,6 +216,7 @@ void r_init(struct arena *mem_persistent, const u64 ns_tick, const u64 frame_siz
 
 	g_r_core->mesh_database = mesh_database; 
 	struct r_mesh *stub = string_database_address(g_r_core->mesh_database, STRING_DATABASE_STUB_INDEX);
+	r_mesh_init(stub);
 	r_mesh_set_stub_box(stub);
 
 
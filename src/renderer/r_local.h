@@ -62,9 +62,9 @@
 
 void r_ui_draw(struct ui *ui);
 /* ui program gl buffer shared instace data layout setter  */
-void r_ui_buffer_shared_layout_setter(void);
+void r_ui_buffer_shared_layout_setter(const u64 offset);
 /* ui program gl buffer local vertex layout setter  */
-void r_ui_buffer_local_layout_setter(void);
+void r_ui_buffer_local_layout_setter(const u64 offset);
 
 /********************************************************
  *			r_init.c			*
@@ -78,6 +78,67 @@ void 	r_compile_shader(u32 *prg, const char *v_filepath, const char *f_filepath)
  *			r_camera.c			*
  ********************************************************/
 
+/********************************************************
+ *			r_stream.c			*
+ ********************************************************/
+
+/*
+ * r_stream - streaming storage for data regenerated each frame (ui quads, instance data, debug meshes). The
+ * stream owns a vbo and an ebo, each split into R_STREAM_REGION_COUNT frame regions. A drawn frame sub-allocates
+ * linearly from its region, which is mapped while a window's draw data is generated and fenced once the window
+ * has been drawn; the region is reused R_STREAM_REGION_COUNT frames later, after waiting on its fences.
+ *
+ * WebGL2 has neither buffer mapping nor blocking fences, so on the web (R_STREAM_ORPHAN) draw data is staged in
+ * the frame arena and uploaded into orphaned buffer storage instead, once per window.
+ */
+#if __OS__ == __WEB__
+#define R_STREAM_ORPHAN
+#endif
+
+#define R_STREAM_REGION_COUNT		3
+#define R_STREAM_VERTEX_REGION_SIZE	(4*1024*1024)	/* initial region sizes, regions grow to fit a frame */
+#define R_STREAM_INDEX_REGION_SIZE	(256*1024)
+#define R_STREAM_FENCE_MAX		8		/* max fences (drawn windows) per region */
+#define R_STREAM_ALIGNMENT		16
+
+struct r_stream_buffer
+{
+	GLuint	handle;
+	GLenum	target;
+	u64	region_size;
+	u64	used;		/* bytes used in the current region */
+	u64	mapped_offset;	/* buffer offset of the mapped range */
+	u64	mapped_size;
+	u64	mapped_used;	/* bytes pushed onto the mapped range */
+	u8 *	mapped;		/* address of the mapped range, or NULL */
+};
+
+struct r_stream
+{
+	struct r_stream_buffer	vertex;		/* GL_ARRAY_BUFFER data */
+	struct r_stream_buffer	index;		/* GL_ELEMENT_ARRAY_BUFFER data */
+	GLuint			vao;		/* element array buffers are vertex array state; bound while mapped */
+	GLsync			fence[R_STREAM_REGION_COUNT][R_STREAM_FENCE_MAX];
+	u32			fence_count[R_STREAM_REGION_COUNT];
+	u32			region;		/* region of the current frame */
+};
+
+/* allocate stream buffers; the root gl context must be current */
+void	r_stream_init(struct r_stream *stream);
+/* begin a new drawn frame: advance to the next region and wait until the gpu has finished reading from it */
+void	r_stream_frame_begin(struct r_stream *stream);
+/* map vertex_size and index_size bytes (sums of r_stream_size) of the current region for writing */
+void	r_stream_map(struct r_stream *stream, const u64 vertex_size, const u64 index_size);
+/* unmap (or upload) the data written since r_stream_map; must be called before drawing */
+void	r_stream_unmap(struct r_stream *stream);
+/* fence the current window's draws reading from the current region */
+void	r_stream_window_end(struct r_stream *stream);
+/* Return bytes reserved in the stream for an allocation of the given size */
+u64	r_stream_size(const u64 size);
+/* push size bytes onto the mapped range, returning the write address (NULL if size == 0) and setting offset 
+ * to the buffer offset of the data. */
+void *	r_stream_push(struct r_stream_buffer *buf, u64 *offset, const u64 size);
+
 /********************************************************
  *			r_core.c			*
  ********************************************************/
@@ -85,13 +146,27 @@ void 	r_compile_shader(u32 *prg, const char *v_filepath, const char *f_filepath)
 /*
  * r_program - gl program related info. Indexable by r_program_id and initalized at startup
  */
+/* uniforms used by the programs, locations are resolved once after linking */
+enum r_uniform
+{
+	UNIFORM_ASPECT_RATIO,
+	UNIFORM_VIEW,
+	UNIFORM_PERSPECTIVE,
+	UNIFORM_LIGHT_POSITION,
+	UNIFORM_RESOLUTION,
+	UNIFORM_TEXTURE,
+	UNIFORM_COUNT
+};
+
 struct r_program
 {
 	u32	gl_program;				/* opengl program id */
+	GLint	uniform[UNIFORM_COUNT];			/* uniform locations, -1 if not used by the program */
 	u64	shared_stride;
 	u64	local_stride;
-	void	(* buffer_shared_layout_setter)(void);	/* opengl buffer shared (instanced) layout setter */
-	void	(* buffer_local_layout_setter)(void);	/* opengl buffer local layout setter */
+	/* layout setters of the bound buffer, with the first vertex or instance at the given byte offset */
+	void	(* buffer_shared_layout_setter)(const u64 offset);	/* opengl buffer shared (instanced) layout setter */
+	void	(* buffer_local_layout_setter)(const u64 offset);	/* opengl buffer local layout setter */
 };
 
 /*
@@ -102,6 +177,32 @@ struct r_texture
 	GLuint	handle;	
 };
 
+/*
+ * r_mesh_page - gpu storage shared by resident meshes. Vertex and index data are sub-allocated linearly from the
+ * page's vbo and ebo. Released ranges at the top of the page are reused directly, other released ranges are 
+ * reclaimed by compacting the page, and the page is rewound once all of its meshes have been released.
+ */
+#define R_MESH_PAGE_SIZE	(4*1024*1024)	/* default vbo and ebo size of a page, larger meshes get their own page */
+#define R_MESH_PAGE_MAX		64
+#define R_MESH_ALIGNMENT	16
+
+struct r_mesh_page
+{
+	GLuint	vbo;
+	GLuint	ebo;
+	u64	vertex_size;
+	u64	index_size;
+	u64	vertex_used;
+	u64	index_used;
+	u64	vertex_free;	/* released vertex bytes below vertex_used */
+	u64	index_free;	/* released index bytes below index_used */
+	u32	mesh_count;	/* resident meshes in page */
+};
+
+/* make the mesh resident (uploading its data if it is not resident) and return its page. 
+ * Index data is uploaded through GL_ELEMENT_ARRAY_BUFFER, so a vertex array must be bound. */
+const struct r_mesh_page *	r_mesh_gpu_acquire(struct r_mesh *mesh);
+
  /*
  * r_core - core render state; 
  */
@@ -122,6 +223,11 @@ struct r_core
 	struct pool		unit_pool;
 
 	struct string_database *mesh_database;		/* mesh storage (external) */
+	struct r_mesh_page	mesh_page[R_MESH_PAGE_MAX];
+	u32			mesh_page_count;
+
+	struct r_stream		stream;			/* per-frame draw data */
+	u64			frame_upload_bytes;	/* bytes uploaded to the gpu during the last drawn frame */
 
 	struct hierarchy_index *proxy3d_hierarchy;	/* proxy3d storage */
 	u32			proxy3d_root;
@@ -145,9 +251,9 @@ void	r_core_flush(void);
 #define L_PROXY3D_STRIDE			(2*sizeof(vec3))
 
 /* proxy3d opengl buffer local layout setter */
-void 	r_proxy3d_buffer_local_layout_setter(void);
+void 	r_proxy3d_buffer_local_layout_setter(const u64 offset);
 /* proxy3d opengl buffer shared layout setter */
-void 	r_proxy3d_buffer_shared_layout_setter(void);
+void 	r_proxy3d_buffer_shared_layout_setter(const u64 offset);
 /* generate speculative positions */
 void 	r_proxy3d_hierarchy_speculate(struct arena *mem, const u64 ns_time);
 
@@ -174,6 +280,15 @@ struct gl_limits
 
 extern struct gl_limits *g_gl_limits;
 
+/* state changing calls passed to the driver and redundant calls skipped by the gl_state cache */
+struct gl_call_counter
+{
+	u64	issued;
+	u64	skipped;
+};
+
+extern struct gl_call_counter g_gl_frame_calls;	/* counts of the last drawn frame */
+
 struct gl_state
 {
 	struct array_list_intrusive_node	header;
@@ -188,6 +303,14 @@ struct gl_state
 	/* program */
 	u32 			program;
 
+	/* vertex array and buffer bindings, U32_MAX if unknown */
+	GLuint			vao;
+	GLuint			array_buffer;
+	GLuint			element_array_buffer;	/* state of the bound vao */
+
+	/* viewport, negative width if unknown */
+	GLint			viewport[4];
+
 	/* culling */
 	u32			cull_face;
 	GLenum			cull_mode;
@@ -257,6 +380,11 @@ void 	kas_glBindBuffer(GLenum target, GLuint buffer);
 void 	kas_glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage);
 void 	kas_glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,  const void *data);
 void 	kas_glDeleteBuffers(GLsizei n, const GLuint *buffers);
+void *	kas_glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+GLboolean kas_glUnmapBuffer(GLenum target);
+GLsync	kas_glFenceSync(GLenum condition, GLbitfield flags);
+GLenum	kas_glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+void	kas_glDeleteSync(GLsync sync);
 
 GLuint 	kas_glCreateProgram(void);
 void 	kas_glLinkProgram(GLuint program);
@@ -391,7 +391,9 @@ static void r_led_draw(const struct led *led)
 	}
 	hierarchy_index_iterator_release(&it);
 
-	if (led->physics.draw_dbvh)
+	/* the pipeline belongs to the physics thread while it is active */
+	const u32 physics_owned = !led->physics_thread.active;
+	if (physics_owned && led->physics.draw_dbvh)
 	{
 		const u64 material = r_material_construct(PROGRAM_COLOR, MESH_NONE, TEXTURE_NONE);
 		const u64 depth = 0x7fffff;
@@ -410,12 +412,28 @@ static void r_led_draw(const struct led *led)
 		}
 	}
 
-	if (led->physics.draw_sbvh)
+	if (physics_owned && led->physics.draw_sbvh)
 	{
 
 		const u64 material = r_material_construct(PROGRAM_COLOR, MESH_NONE, TEXTURE_NONE);
 		const u64 depth = 0x7fffff;
 		const u64 cmd = r_command_key(R_CMD_SCREEN_LAYER_GAME, depth, R_CMD_TRANSPARENCY_ADDITIVE, material, R_CMD_PRIMITIVE_LINE, R_CMD_NON_INSTANCED, R_CMD_ARRAYS);
+		if (bt_node_count(&led->physics.static_tree.tree))
+		{
+			quat rotation;
+			const vec3 translation = { 0 };
+			vec3 axis = { 0.0f, 1.0f, 0.0f };
+			const f32 angle = 0.0f;
+			axis_angle_to_quaternion(rotation, axis, angle);
+			struct r_mesh *mesh = bvh_mesh(&g_r_core->frame, &led->physics.static_tree, translation, rotation, led->physics.sbvh_color);
+			if (mesh)
+			{
+				struct r_instance *instance = r_instance_add_non_cached(cmd);
+				instance->type = R_INSTANCE_MESH;
+				instance->mesh = mesh;
+			}
+		}
+
 		struct rigid_body *body = NULL;
 		for (u32 i = led->physics.body_non_marked_list.first; i != DLL_NULL; i = DLL_NEXT(body))
 		{
@@ -437,7 +455,7 @@ static void r_led_draw(const struct led *led)
 
 	}
 
-	if (led->physics.draw_bounding_box)
+	if (physics_owned && led->physics.draw_bounding_box)
 	{
 		const u64 material = r_material_construct(PROGRAM_COLOR, MESH_NONE, TEXTURE_NONE);
 		const u64 depth = 0x7fffff;
@@ -451,7 +469,7 @@ static void r_led_draw(const struct led *led)
 		}
 	}
 
-	if (led->physics.draw_lines)
+	if (physics_owned && led->physics.draw_lines)
 	{
 		const u64 material = r_material_construct(PROGRAM_COLOR, MESH_NONE, TEXTURE_NONE);
 		const u64 depth = 0x7fffff;
@@ -465,7 +483,7 @@ static void r_led_draw(const struct led *led)
 		}
 	}
 
-	if (led->physics.draw_manifold)
+	if (physics_owned && led->physics.draw_manifold)
 	{
 
 		const u64 material = r_material_construct(PROGRAM_COLOR, MESH_NONE, TEXTURE_NONE);
@@ -501,35 +519,25 @@ static void internal_r_proxy3d_uniforms(const struct led *led, const u32 window)
 	perspective_matrix(perspective, cam->aspect_ratio, cam->fov_x, cam->fz_near, cam->fz_far);
 	view_matrix(view, cam->position, cam->left, cam->up, cam->forward);
 	
-	kas_glUseProgram(g_r_core->program[PROGRAM_PROXY3D].gl_program);
-	GLint aspect_ratio_addr, view_addr, perspective_addr, light_position_addr;
-	aspect_ratio_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_PROXY3D].gl_program, "aspect_ratio");
-	view_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_PROXY3D].gl_program, "view");
-	perspective_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_PROXY3D].gl_program, "perspective");
-	light_position_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_PROXY3D].gl_program, "light_position");
-	kas_glUniform1f(aspect_ratio_addr, (f32) cam->aspect_ratio);
-	kas_glUniform3f(light_position_addr, cam->position[0], cam->position[1], cam->position[2]);
-	kas_glUniformMatrix4fv(perspective_addr, 1, GL_FALSE, (f32 *) perspective);
-	kas_glUniformMatrix4fv(view_addr, 1, GL_FALSE, (f32 *) view);
-
-	kas_glUseProgram(g_r_core->program[PROGRAM_LIGHTNING].gl_program);
-	aspect_ratio_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_LIGHTNING].gl_program, "aspect_ratio");
-	view_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_LIGHTNING].gl_program, "view");
-	perspective_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_LIGHTNING].gl_program, "perspective");
-	light_position_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_LIGHTNING].gl_program, "light_position");
-	kas_glUniform1f(aspect_ratio_addr, (f32) cam->aspect_ratio);
-	kas_glUniform3f(light_position_addr, cam->position[0], cam->position[1], cam->position[2]);
-	kas_glUniformMatrix4fv(perspective_addr, 1, GL_FALSE, (f32 *) perspective);
-	kas_glUniformMatrix4fv(view_addr, 1, GL_FALSE, (f32 *) view);
-	
+	const struct r_program *program = g_r_core->program + PROGRAM_PROXY3D;
+	kas_glUseProgram(program->gl_program);
+	kas_glUniform1f(program->uniform[UNIFORM_ASPECT_RATIO], (f32) cam->aspect_ratio);
+	kas_glUniform3f(program->uniform[UNIFORM_LIGHT_POSITION], cam->position[0], cam->position[1], cam->position[2]);
+	kas_glUniformMatrix4fv(program->uniform[UNIFORM_PERSPECTIVE], 1, GL_FALSE, (f32 *) perspective);
+	kas_glUniformMatrix4fv(program->uniform[UNIFORM_VIEW], 1, GL_FALSE, (f32 *) view);
+
+	program = g_r_core->program + PROGRAM_LIGHTNING;
+	kas_glUseProgram(program->gl_program);
+	kas_glUniform1f(program->uniform[UNIFORM_ASPECT_RATIO], (f32) cam->aspect_ratio);
+	kas_glUniform3f(program->uniform[UNIFORM_LIGHT_POSITION], cam->position[0], cam->position[1], cam->position[2]);
+	kas_glUniformMatrix4fv(program->uniform[UNIFORM_PERSPECTIVE], 1, GL_FALSE, (f32 *) perspective);
+	kas_glUniformMatrix4fv(program->uniform[UNIFORM_VIEW], 1, GL_FALSE, (f32 *) view);
 	
-	kas_glUseProgram(g_r_core->program[PROGRAM_COLOR].gl_program);
-	aspect_ratio_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_COLOR].gl_program, "aspect_ratio");
-	view_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_COLOR].gl_program, "view");
-	perspective_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_COLOR].gl_program, "perspective");
-	kas_glUniform1f(aspect_ratio_addr, (f32) cam->aspect_ratio);
-	kas_glUniformMatrix4fv(perspective_addr, 1, GL_FALSE, (f32 *) perspective);
-	kas_glUniformMatrix4fv(view_addr, 1, GL_FALSE, (f32 *) view);
+	program = g_r_core->program + PROGRAM_COLOR;
+	kas_glUseProgram(program->gl_program);
+	kas_glUniform1f(program->uniform[UNIFORM_ASPECT_RATIO], (f32) cam->aspect_ratio);
+	kas_glUniformMatrix4fv(program->uniform[UNIFORM_PERSPECTIVE], 1, GL_FALSE, (f32 *) perspective);
+	kas_glUniformMatrix4fv(program->uniform[UNIFORM_VIEW], 1, GL_FALSE, (f32 *) view);
 }
 
 static void internal_r_ui_uniforms(const u32 window)
@@ -537,9 +545,11 @@ static void internal_r_ui_uniforms(const u32 window)
 	vec2u32 resolution;
 	system_window_size(resolution, window);
 
-	kas_glUseProgram(g_r_core->program[PROGRAM_UI].gl_program);
-	GLint resolution_addr = kas_glGetUniformLocation(g_r_core->program[PROGRAM_UI].gl_program, "resolution");
-	kas_glUniform2f(resolution_addr, (f32) resolution[0], (f32) resolution[1]);
+	/* ui textures are always bound to texture unit 0 */
+	const struct r_program *program = g_r_core->program + PROGRAM_UI;
+	kas_glUseProgram(program->gl_program);
+	kas_glUniform2f(program->uniform[UNIFORM_RESOLUTION], (f32) resolution[0], (f32) resolution[1]);
+	kas_glUniform1i(program->uniform[UNIFORM_TEXTURE], 0);
 }
 
 static void r_scene_render(const struct led *led, const u32 window)
@@ -607,12 +617,8 @@ static void r_scene_render(const struct led *led, const u32 window)
 		{
 			case PROGRAM_UI:
 			{
-				u32 tx_index = 0;
-				kas_glActiveTexture(GL_TEXTURE0 + tx_index);
-				//TODO setup compile time arrays as with g_r_core->program[program].gl_program (?????)
+				kas_glActiveTexture(GL_TEXTURE0 + 0);
 				kas_glBindTexture(GL_TEXTURE_2D, g_r_core->texture[texture].handle);
-				const i32 texture_addr = kas_glGetUniformLocation(g_r_core->program[program].gl_program, "texture");
-				kas_glUniform1i(texture_addr, tx_index);
 				kas_glViewport(0, 0, (i32) sys_win->size[0], (i32) sys_win->size[1]); 
 			} break;
 
@@ -642,74 +648,72 @@ static void r_scene_render(const struct led *led, const u32 window)
 		for (u32 i = 0; i < b->buffer_count; ++i)
 		{	
 			struct r_buffer *buf = b->buffer_array[i];
-			kas_glGenBuffers(1, &buf->local_vbo);
-			kas_glBindBuffer(GL_ARRAY_BUFFER, buf->local_vbo);
-			kas_glBufferData(GL_ARRAY_BUFFER, buf->local_size, buf->local_data, GL_STATIC_DRAW);
-			g_r_core->program[program].buffer_local_layout_setter();
+
+			/* resident mesh data is bound in place, frame data is bound at its offset in the stream buffers */
+			const struct r_mesh_page *page = NULL;
+			if (buf->mesh)
+			{
+				page = r_mesh_gpu_acquire(buf->mesh);
+				kas_glBindBuffer(GL_ARRAY_BUFFER, page->vbo);
+				g_r_core->program[program].buffer_local_layout_setter(buf->mesh->gpu_vertex_offset);
+			}
+			else
+			{
+				kas_glBindBuffer(GL_ARRAY_BUFFER, g_r_core->stream.vertex.handle);
+				g_r_core->program[program].buffer_local_layout_setter(buf->local_offset);
+			}
+
+			if (b->instanced)
+			{
+				kas_glBindBuffer(GL_ARRAY_BUFFER, g_r_core->stream.vertex.handle);
+				g_r_core->program[program].buffer_shared_layout_setter(buf->shared_offset);
+			}
 
 			if (!b->elements)
 			{
-					//fprintf(stderr, "\t\tDrawing Array: buf[%u], vbuf[%lu]\n", 
-					//		i,
-					//		buf->local_size);
+				const u32 vertex_count = (buf->mesh)
+					? buf->mesh->vertex_count
+					: buf->local_size / g_r_core->program[program].local_stride;
 
 				if (!b->instanced)
 				{
-					kas_glDrawArrays(mode, 0, buf->local_size / g_r_core->program[program].local_stride);
+					kas_glDrawArrays(mode, 0, vertex_count);
 				}
 				else
 				{
-					kas_glGenBuffers(1, &buf->shared_vbo);
-					kas_glBindBuffer(GL_ARRAY_BUFFER, buf->shared_vbo);
-					kas_glBufferData(GL_ARRAY_BUFFER, buf->shared_size, buf->shared_data, GL_STATIC_DRAW);
-					g_r_core->program[program].buffer_shared_layout_setter();
-
-					kas_glDrawArraysInstanced(mode, 0, buf->local_size / g_r_core->program[program].local_stride, buf->instance_count);
-					kas_glDeleteBuffers(1, &buf->shared_vbo);
-
+					kas_glDrawArraysInstanced(mode, 0, vertex_count, buf->instance_count);
 				}
 			}
 			else
 			{
-				kas_glGenBuffers(1, &buf->ebo);
-				kas_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buf->ebo);
-				kas_glBufferData(GL_ELEMENT_ARRAY_BUFFER, buf->index_count * sizeof(u32), buf->index_data, GL_STATIC_DRAW);
-				if (!b->instanced)
+				const void *indices = NULL;
+				if (page)
 				{
-					//fprintf(stderr, "\t\tDrawing Regular: buf[%u], vbuf[%lu], index_count: %u\n", 
-					//		i,
-					//		buf->local_size,
-					//		buf->index_count);
+					kas_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->ebo);
+					indices = (void *) buf->mesh->gpu_index_offset;
+				}
+				else
+				{
+					kas_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_r_core->stream.index.handle);
+					indices = (void *) buf->index_offset;
+				}
 
-					kas_glDrawElements(mode, buf->index_count, GL_UNSIGNED_INT, 0);
+				if (!b->instanced)
+				{
+					kas_glDrawElements(mode, buf->index_count, GL_UNSIGNED_INT, indices);
 				}
 				else
 				{
-					//fprintf(stderr, "\t\tDrawing Instanced: buf[%u], sbuf[%lu], vbuf[%lu], index_count: %u, instace_count: %u\n", 
-					//		i,
-					//		buf->shared_size,
-					//		buf->local_size,
-					//		buf->index_count,
-					//		buf->instance_count);
-
-					kas_glGenBuffers(1, &buf->shared_vbo);
-					kas_glBindBuffer(GL_ARRAY_BUFFER, buf->shared_vbo);
-					kas_glBufferData(GL_ARRAY_BUFFER, buf->shared_size, buf->shared_data, GL_STATIC_DRAW);
-					g_r_core->program[program].buffer_shared_layout_setter();
-
-					kas_glDrawElementsInstanced(mode, buf->index_count, GL_UNSIGNED_INT, 0, buf->instance_count);
-					kas_glDeleteBuffers(1, &buf->shared_vbo);
+					kas_glDrawElementsInstanced(mode, buf->index_count, GL_UNSIGNED_INT, indices, buf->instance_count);
 				}	
 			}
-
-			kas_glDeleteBuffers(1, &buf->local_vbo);
-			kas_glDeleteBuffers(1, &buf->ebo);
 		}
 
 		kas_glDeleteVertexArrays(1, &vao);
 		PROF_ZONE_END;
 	}
 
+	r_stream_window_end(&g_r_core->stream);
 	system_window_swap_gl_buffers(window);
 	GL_STATE_ASSERT;
 	PROF_ZONE_END;
@@ -728,6 +732,10 @@ void r_led_main(const struct led *led)
 			struct arena tmp = arena_alloc_1MB();
 
 			g_r_core->frames_elapsed += frames_elapsed_since_last_draw;
+			g_r_core->frame_upload_bytes = 0;
+			g_gl_frame_calls.issued = 0;
+			g_gl_frame_calls.skipped = 0;
+			r_stream_frame_begin(&g_r_core->stream);
 
 			//fprintf(stderr, "led ns: %lu\n", led->ns);
 			//fprintf(stderr, "r   ns: %lu\n", g_r_core->ns_elapsed);
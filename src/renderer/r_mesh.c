@@ -61,6 +61,15 @@ u32 stub_indices[] =
 	16 + 1, 16 + 4, 16 + 7, 16 + 1, 16 + 7, 16 + 2,
 };
 
+void r_mesh_init(struct r_mesh *mesh)
+{
+	mesh->gpu_page = U32_MAX;
+	mesh->gpu_vertex_offset = 0;
+	mesh->gpu_index_offset = 0;
+	mesh->gpu_vertex_size = 0;
+	mesh->gpu_index_size = 0;
+}
+
 void r_mesh_set_stub_box(struct r_mesh *mesh_stub)
 {
 	mesh_stub->index_max_used = 16 + 7;
@@ -69,6 +78,7 @@ void r_mesh_set_stub_box(struct r_mesh *mesh_stub)
 	mesh_stub->vertex_count = sizeof(stub_vertices) / sizeof(stub_vertices[0]);
 	mesh_stub->vertex_data = stub_vertices;
 	mesh_stub->local_stride = sizeof(stub_vertices[0]);
+	r_mesh_invalidate(mesh_stub);
 }
 
 static void internal_r_mesh_set_sphere(u32 *b_i, u8 *vertex_data, u32 *index_data, const f32 radius, const vec3 translation, const u32 refinement)
@@ -181,6 +191,7 @@ void r_mesh_set_sphere(struct arena *mem, struct r_mesh *mesh, const f32 radius,
 	mesh->vertex_count = vertex_count;
 	mesh->vertex_data = (void *) vertex_data;
 	mesh->local_stride = vertex_size;
+	r_mesh_invalidate(mesh);
 }
 
 void r_mesh_set_capsule(struct arena *mem, struct r_mesh *mesh, const f32 half_height, const f32 radius, const u32 refinement)
@@ -326,6 +337,7 @@ void r_mesh_set_hull(struct arena *mem, struct r_mesh *mesh, const struct dcel *
 	}
 
 	mesh->index_max_used = m_i - 1;
+	r_mesh_invalidate(mesh);
 }
 
 void r_mesh_set_tri_mesh(struct arena *mem, struct r_mesh *mesh, const struct tri_mesh *tri_mesh)
@@ -360,4 +372,214 @@ void r_mesh_set_tri_mesh(struct arena *mem, struct r_mesh *mesh, const struct tr
 
 	mesh->index_max_used = 0;
 	//mesh->index_max_used = mesh->index_count-1;
+	r_mesh_invalidate(mesh);
+}
+
+void r_mesh_gpu_release(struct r_mesh *mesh)
+{
+	if (mesh->gpu_page == U32_MAX)
+	{
+		return;
+	}
+
+	struct r_mesh_page *page = g_r_core->mesh_page + mesh->gpu_page;
+	kas_assert(page->mesh_count);
+	page->mesh_count -= 1;
+	if (page->mesh_count == 0)
+	{
+		page->vertex_used = 0;
+		page->index_used = 0;
+		page->vertex_free = 0;
+		page->index_free = 0;
+	}
+	else
+	{
+		/* ranges at the top of the page are reused directly, holes are reused once the page is compacted */
+		if (mesh->gpu_vertex_offset + mesh->gpu_vertex_size == page->vertex_used)
+		{
+			page->vertex_used = mesh->gpu_vertex_offset;
+		}
+		else
+		{
+			page->vertex_free += mesh->gpu_vertex_size;
+		}
+
+		if (mesh->gpu_index_offset + mesh->gpu_index_size == page->index_used)
+		{
+			page->index_used = mesh->gpu_index_offset;
+		}
+		else
+		{
+			page->index_free += mesh->gpu_index_size;
+		}
+	}
+	mesh->gpu_page = U32_MAX;
+}
+
+void r_mesh_invalidate(struct r_mesh *mesh)
+{
+	r_mesh_gpu_release(mesh);
+}
+
+static u64 r_mesh_gpu_size(const u64 size)
+{
+	return (size + R_MESH_ALIGNMENT - 1) & ~((u64) R_MESH_ALIGNMENT - 1);
+}
+
+/* place the mesh at the top of the page and upload its data */
+static void r_mesh_page_upload(const u32 pi, struct r_mesh *mesh)
+{
+	struct r_mesh_page *page = g_r_core->mesh_page + pi;
+	const u64 vertex_size = mesh->vertex_count * mesh->local_stride;
+	const u64 index_size = mesh->index_count * sizeof(u32);
+
+	mesh->gpu_page = pi;
+	mesh->gpu_vertex_offset = page->vertex_used;
+	mesh->gpu_index_offset = page->index_used;
+	mesh->gpu_vertex_size = r_mesh_gpu_size(vertex_size);
+	mesh->gpu_index_size = r_mesh_gpu_size(index_size);
+	kas_assert(page->vertex_used + mesh->gpu_vertex_size <= page->vertex_size);
+	kas_assert(page->index_used + mesh->gpu_index_size <= page->index_size);
+	page->vertex_used += mesh->gpu_vertex_size;
+	page->index_used += mesh->gpu_index_size;
+	page->mesh_count += 1;
+
+	if (vertex_size)
+	{
+		kas_glBindBuffer(GL_ARRAY_BUFFER, page->vbo);
+		kas_glBufferSubData(GL_ARRAY_BUFFER, (GLintptr) mesh->gpu_vertex_offset, (GLsizeiptr) vertex_size, mesh->vertex_data);
+	}
+
+	if (index_size)
+	{
+		kas_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->ebo);
+		kas_glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, (GLintptr) mesh->gpu_index_offset, (GLsizeiptr) index_size, mesh->index_data);
+	}
+
+	g_r_core->frame_upload_bytes += vertex_size + index_size;
+}
+
+/* rewind the page and either re-upload its meshes back to back (compaction) or make them non-resident (eviction) */
+static void r_mesh_page_rebuild(const u32 pi, const u32 evict)
+{
+	PROF_ZONE;
+
+	struct r_mesh_page *page = g_r_core->mesh_page + pi;
+	page->vertex_used = 0;
+	page->index_used = 0;
+	page->vertex_free = 0;
+	page->index_free = 0;
+	page->mesh_count = 0;
+
+	/* the stub is not part of the database's allocated list */
+	struct string_database *db = g_r_core->mesh_database;
+	for (u32 i = STRING_DATABASE_STUB_INDEX; i != DLL_NULL; )
+	{
+		struct r_mesh *mesh = string_database_address(db, i);
+		i = (i == STRING_DATABASE_STUB_INDEX) ? db->allocated_dll.first : DB_NEXT(mesh);
+		if (mesh->gpu_page == pi)
+		{
+			if (evict)
+			{
+				mesh->gpu_page = U32_MAX;
+			}
+			else
+			{
+				r_mesh_page_upload(pi, mesh);
+			}
+		}
+	}
+
+	PROF_ZONE_END;
+}
+
+static void r_mesh_page_buffer_alloc(struct r_mesh_page *page)
+{
+	kas_glBindBuffer(GL_ARRAY_BUFFER, page->vbo);
+	kas_glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) page->vertex_size, NULL, GL_STATIC_DRAW);
+	kas_glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, page->ebo);
+	kas_glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) page->index_size, NULL, GL_STATIC_DRAW);
+}
+
+/* return a page with room for the given reserves; pages are, in order of preference, used as is, allocated,
+ * compacted, or evicted (the page with the least resident data, growing it if necessary). */
+static u32 r_mesh_page_get(const u64 vertex_reserve, const u64 index_reserve)
+{
+	for (u32 pi = 0; pi < g_r_core->mesh_page_count; ++pi)
+	{
+		const struct r_mesh_page *page = g_r_core->mesh_page + pi;
+		if (page->vertex_used + vertex_reserve <= page->vertex_size 
+				&& page->index_used + index_reserve <= page->index_size)
+		{
+			return pi;
+		}
+	}
+
+	if (g_r_core->mesh_page_count < R_MESH_PAGE_MAX)
+	{
+		const u32 pi = g_r_core->mesh_page_count++;
+		struct r_mesh_page *page = g_r_core->mesh_page + pi;
+		page->vertex_size = (vertex_reserve > R_MESH_PAGE_SIZE) ? vertex_reserve : R_MESH_PAGE_SIZE;
+		page->index_size = (index_reserve > R_MESH_PAGE_SIZE) ? index_reserve : R_MESH_PAGE_SIZE;
+		page->vertex_used = 0;
+		page->index_used = 0;
+		page->vertex_free = 0;
+		page->index_free = 0;
+		page->mesh_count = 0;
+		kas_glGenBuffers(1, &page->vbo);
+		kas_glGenBuffers(1, &page->ebo);
+		r_mesh_page_buffer_alloc(page);
+		return pi;
+	}
+
+	u32 victim = 0;
+	u64 victim_resident = U64_MAX;
+	for (u32 pi = 0; pi < g_r_core->mesh_page_count; ++pi)
+	{
+		const struct r_mesh_page *page = g_r_core->mesh_page + pi;
+		const u64 vertex_resident = page->vertex_used - page->vertex_free;
+		const u64 index_resident = page->index_used - page->index_free;
+		if (vertex_resident + vertex_reserve <= page->vertex_size 
+				&& index_resident + index_reserve <= page->index_size)
+		{
+			r_mesh_page_rebuild(pi, 0);
+			return pi;
+		}
+
+		if (vertex_resident + index_resident < victim_resident)
+		{
+			victim = pi;
+			victim_resident = vertex_resident + index_resident;
+		}
+	}
+
+	log_string(T_RENDERER, S_WARNING, "Out of gpu mesh pages, evicting resident meshes.");
+	r_mesh_page_rebuild(victim, 1);
+	struct r_mesh_page *page = g_r_core->mesh_page + victim;
+	if (page->vertex_size < vertex_reserve || page->index_size < index_reserve)
+	{
+		page->vertex_size = (vertex_reserve > page->vertex_size) ? vertex_reserve : page->vertex_size;
+		page->index_size = (index_reserve > page->index_size) ? index_reserve : page->index_size;
+		r_mesh_page_buffer_alloc(page);
+	}
+
+	return victim;
+}
+
+const struct r_mesh_page *r_mesh_gpu_acquire(struct r_mesh *mesh)
+{
+	if (mesh->gpu_page != U32_MAX)
+	{
+		return g_r_core->mesh_page + mesh->gpu_page;
+	}
+
+	PROF_ZONE;
+
+	const u64 vertex_reserve = r_mesh_gpu_size(mesh->vertex_count * mesh->local_stride);
+	const u64 index_reserve = r_mesh_gpu_size(mesh->index_count * sizeof(u32));
+	const u32 pi = r_mesh_page_get(vertex_reserve, index_reserve);
+	r_mesh_page_upload(pi, mesh);
+
+	PROF_ZONE_END;
+	return g_r_core->mesh_page + pi;
 }
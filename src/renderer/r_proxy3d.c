@@ -19,25 +19,25 @@
 
 #include "r_local.h"
 
-void r_proxy3d_buffer_local_layout_setter(void)
+void r_proxy3d_buffer_local_layout_setter(const u64 offset)
 {
 	kas_glEnableVertexAttribArray(3);
 	kas_glEnableVertexAttribArray(4);
 
-	kas_glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, L_PROXY3D_STRIDE, (void *) L_PROXY3D_POSITION_OFFSET);
-	kas_glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, L_PROXY3D_STRIDE, (void *) L_PROXY3D_NORMAL_OFFSET);
+	kas_glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, L_PROXY3D_STRIDE, (void *) (offset + L_PROXY3D_POSITION_OFFSET));
+	kas_glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, L_PROXY3D_STRIDE, (void *) (offset + L_PROXY3D_NORMAL_OFFSET));
 }
 
-void r_proxy3d_buffer_shared_layout_setter(void)
+void r_proxy3d_buffer_shared_layout_setter(const u64 offset)
 {
 
 	kas_glEnableVertexAttribArray(0);
 	kas_glEnableVertexAttribArray(1);
 	kas_glEnableVertexAttribArray(2);
 
-	kas_glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, S_PROXY3D_STRIDE, (void *) S_PROXY3D_TRANSLATION_BLEND_OFFSET);
-	kas_glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, S_PROXY3D_STRIDE, (void *) S_PROXY3D_ROTATION_OFFSET);
-	kas_glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, S_PROXY3D_STRIDE, (void *) S_PROXY3D_COLOR_OFFSET);
+	kas_glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, S_PROXY3D_STRIDE, (void *) (offset + S_PROXY3D_TRANSLATION_BLEND_OFFSET));
+	kas_glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, S_PROXY3D_STRIDE, (void *) (offset + S_PROXY3D_ROTATION_OFFSET));
+	kas_glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, S_PROXY3D_STRIDE, (void *) (offset + S_PROXY3D_COLOR_OFFSET));
 
 	kas_glVertexAttribDivisor(0, 1);
 	kas_glVertexAttribDivisor(1, 1);
@@ -324,9 +324,6 @@ struct r_instance *	r_instance_add_non_cached(const u64 cmd); /* add non cached
 struct r_buffer
 {
 	struct r_buffer *	next;
-	u32 			shared_vbo;
-	u32 			local_vbo;
-	u32 			ebo;
 
 	u64			shared_size;	/* total size of shared data in bucket (instanced) */
 	u64			local_size;	/* total size of all vertices in bucket (vertex)   */
@@ -336,6 +333,10 @@ struct r_buffer
 	u8 *			shared_data;	/* buf[shared_size] 	*/
 	u8 *			local_data;	/* buf[local_size] 	*/
 	u32 *			index_data;	/* u32[index_count]	*/
+	struct r_mesh *		mesh;		/* if set, local and index data are the mesh's resident gpu data */
+	u64			shared_offset;	/* offsets of streamed data in the renderer's stream buffers */
+	u64			local_offset;
+	u64			index_offset;
 
 	/* draw command range [c_l, c_h]  related to buffer */
 	u32			c_l;			
@@ -436,10 +437,27 @@ struct r_mesh
 	u32				vertex_count;   	
 	void *				vertex_data;		/* vertex_data[vertex_count] */
 	u64				local_stride;
+
+	/* gpu residency, see r_mesh_gpu_acquire */
+	u32				gpu_page;		/* residency page holding the data, or U32_MAX */
+	u64				gpu_vertex_offset;	/* byte offset of vertex data in the page's vbo */
+	u64				gpu_index_offset;	/* byte offset of index data in the page's ebo */
+	u64				gpu_vertex_size;	/* bytes reserved for vertex data in the page's vbo */
+	u64				gpu_index_size;		/* bytes reserved for index data in the page's ebo */
 };
 
+/* initiate a new mesh as non-resident; must be called before the mesh is set up */
+void		r_mesh_init(struct r_mesh *mesh);
+/* mark the mesh's vertex or index data as changed; its gpu memory is released and the data is re-uploaded 
+ * the next time it is drawn */
+void		r_mesh_invalidate(struct r_mesh *mesh);
+/* release the mesh's gpu memory; must be called before the mesh is removed from its database */
+void		r_mesh_gpu_release(struct r_mesh *mesh);
+
 /**************** TEMPORARY: quick and dirty mesh generation *****************/
 
+/* The r_mesh_set_* functions (re)set an initiated mesh and invalidate its gpu data */
+
 /* setup mesh stub */
 void 		r_mesh_set_stub_box(struct r_mesh *mesh_stub);
 /* setup mesh from sphere parameters */
@@ -20,6 +20,11 @@
 #include <string.h>
 
 #include "r_local.h"
+#include "sort.h"
+
+#define R_SCENE_RADIX_SORT_MIN		256	/* fewer new commands are merge sorted */
+#define R_SCENE_PARALLEL_DRAW_DATA_MIN	128	/* fewer commands generate their draw data serially */
+#define R_SCENE_DRAW_DATA_SPLIT		4	/* draw data tasks per worker, commands vary a lot in cost */
 
 struct r_scene *g_scene = NULL;
 
@@ -74,30 +79,6 @@ void r_scene_frame_begin(void)
 	arena_flush(g_scene->mem_frame);
 }
 
-/* merge unit [left, mid-1], [mid, right-1] => tmp => copy back to unit */
-static void internal_r_command_merge(struct r_command *r_cmd, struct r_command *tmp, const u32 left, const u32 mid, const u32 right)
-{
-	u32 l = left;
-	u32 r = mid;
-	const u32 count = right - left;
-
-	for (u32 i = left; i < right; ++i)
-	{
-		if (r < right && (l >= mid || r_cmd[r].key > r_cmd[l].key))
-		{
-			tmp[i] = r_cmd[r];
-			r += 1;
-		}
-		else
-		{
-			tmp[i] = r_cmd[l];
-			l += 1;
-		}
-	}
-
-	memcpy(r_cmd + left, tmp + left, count * sizeof(struct r_command));
-}
-
 #ifdef KAS_DEBUG
 
 void r_scene_assert_cmd_sorted(void)
@@ -144,30 +125,25 @@ static void r_scene_sort_commands_and_prune_instances(void)
 
 	g_scene->cmd_frame = arena_push(g_scene->mem_frame, g_scene->cmd_frame_count * sizeof(struct r_command));
 	arena_push_record(g_scene->mem_frame);
-	struct r_command *cmd_new = arena_push(g_scene->mem_frame, g_scene->cmd_new_count * sizeof(struct r_command));
-	struct r_command *cmd_tmp = arena_push(g_scene->mem_frame, g_scene->cmd_new_count * sizeof(struct r_command));
+	struct sort_entry *cmd_new = arena_push(g_scene->mem_frame, g_scene->cmd_new_count * sizeof(struct sort_entry));
+	struct sort_entry *cmd_tmp = arena_push(g_scene->mem_frame, g_scene->cmd_new_count * sizeof(struct sort_entry));
 	struct r_instance *new_instance = array_list_intrusive_address(g_scene->instance_list, g_scene->instance_new_first);
 	for (u32 i = 0; i < g_scene->cmd_new_count; ++i)
 	{
-		cmd_new[i] = *new_instance->cmd;
+		/* commands are drawn in descending key order; sorts are ascending and stable */
+		cmd_new[i].key = ~new_instance->cmd->key;
+		cmd_new[i].value = new_instance->cmd->instance;
 		new_instance = array_list_intrusive_address(g_scene->instance_list, new_instance->header.next);
 	}
 
 	/* Sort newly added commands */
-	for (u32 width = 2; width/2 < g_scene->cmd_new_count; width *= 2)
+	if (g_scene->cmd_new_count < R_SCENE_RADIX_SORT_MIN)
 	{
-		u32 i = 0;
-		for (; i + width <= g_scene->cmd_new_count; i += width)
-		{
-			//fprintf(stderr, "merging       : [%u, %u] and [%u, %u]\n", i, i + width/2 - 1, i + width/2, i + width - 1);
-			internal_r_command_merge(cmd_new, cmd_tmp, i, i + width/2, i + width);
-		}
-
-		if (i + width/2 < g_scene->cmd_new_count)
-		{
-			internal_r_command_merge(cmd_new, cmd_tmp, i, i + width/2, g_scene->cmd_new_count);
-			//fprintf(stderr, "merging (last): [%u, %u] and [%u, %u]\n", i, i + width/2 - 1, i + width/2, add_count-1);
-		}
+		sort_merge(cmd_new, cmd_tmp, g_scene->cmd_new_count);
+	}
+	else
+	{
+		sort_radix_parallel(g_scene->mem_frame, cmd_new, cmd_tmp, g_scene->cmd_new_count);
 	}
 
 	/* (3) sort key_cache with new keys, remove any untouched instances */
@@ -195,17 +171,17 @@ static void r_scene_sort_commands_and_prune_instances(void)
 			}
 		}
 
-		if (cache_i >= g_scene->cmd_cache_count) 
-		{
-			g_scene->cmd_frame[i] = cmd_new[new_i++];
-		}
-		else if (new_i >= g_scene->cmd_new_count || g_scene->cmd_cache[cache_i].key >= cmd_new[new_i].key)
+		if (cache_i < g_scene->cmd_cache_count 
+			&& (new_i >= g_scene->cmd_new_count || g_scene->cmd_cache[cache_i].key >= ~cmd_new[new_i].key))
 		{
 			g_scene->cmd_frame[i] = g_scene->cmd_cache[cache_i++];
 		}
 		else
 		{
-			g_scene->cmd_frame[i] = cmd_new[new_i++];
+			g_scene->cmd_frame[i].key = ~cmd_new[new_i].key;
+			g_scene->cmd_frame[i].instance = (u32) cmd_new[new_i].value;
+			g_scene->cmd_frame[i].allocated = 1;
+			new_i += 1;
 		}
 
 		struct r_instance *instance = array_list_intrusive_address(g_scene->instance_list, g_scene->cmd_frame[i].instance);
@@ -250,6 +226,10 @@ void r_buffer_constructor_buffer_alloc(struct r_buffer_constructor *constructor,
 	buf->shared_size = 0;
 	buf->index_count = 0;
 	buf->instance_count = 0;
+	buf->mesh = NULL;
+	buf->shared_offset = 0;
+	buf->local_offset = 0;
+	buf->index_offset = 0;
 
 	if (constructor->count == 0)
 	{
@@ -364,9 +344,10 @@ void r_scene_generate_bucket_list(void)
 			case R_INSTANCE_PROXY3D:
 			{
 				const struct r_proxy3d *proxy = r_proxy3d_address(instance->unit);
-				const struct r_mesh *mesh = string_database_address(g_r_core->mesh_database, proxy->mesh);
+				struct r_mesh *mesh = string_database_address(g_r_core->mesh_database, proxy->mesh);
 				buf_constructor.last->index_count = mesh->index_count;
 				buf_constructor.last->local_size = mesh->vertex_count * L_PROXY3D_STRIDE;
+				buf_constructor.last->mesh = mesh;
 				r_buffer_constructor_buffer_add_size(&buf_constructor, 
 						0,
 						S_PROXY3D_STRIDE,
@@ -400,331 +381,336 @@ void r_scene_generate_bucket_list(void)
 	g_scene->frame_bucket_list = start->next;
 }
 
-static void r_scene_bucket_generate_draw_data(struct r_bucket *b)
+/* write the instance data of the command into its reserved draw data */
+static void r_scene_command_generate_draw_data(const struct r_command *r_cmd, u8 *data)
 {
-	PROF_ZONE;
-
 	const vec4 zero4 = { 0.0f, 0.0f, 0.0f, 0.0f };
 	const vec3 zero3 = { 0.0f, 0.0f, 0.0f };
 
-	const struct r_command *r_cmd = g_scene->cmd_frame + b->c_l;
 	const struct r_instance *instance = array_list_intrusive_address(g_scene->instance_list, r_cmd->instance);
-
-	for (u32 bi = 0; bi < b->buffer_count; bi++)
-	{	
-		struct r_buffer *buf = b->buffer_array[bi];
-		switch (instance->type)
+	switch (instance->type)
+	{
+		case R_INSTANCE_UI:
 		{
-			case R_INSTANCE_UI:
+			u8 *shared_data = data;
+			const struct ui_draw_bucket *ui_b = instance->ui_bucket;
+			struct ui_draw_node *draw_node = ui_b->list;
+			if (UI_CMD_LAYER_GET(ui_b->cmd) == UI_CMD_LAYER_TEXT)
 			{
-				buf->shared_data = arena_push(g_scene->mem_frame, buf->shared_size);
-				buf->local_data = arena_push(g_scene->mem_frame, buf->local_size);
-				buf->index_data = arena_push(g_scene->mem_frame, buf->index_count * sizeof(u32));
-
-				u8 *shared_data = buf->shared_data;
-				u8 *local_data = buf->local_data;
-
-				buf->index_data[0] = 0;
-				buf->index_data[1] = 1;
-				buf->index_data[2] = 2;
-				buf->index_data[3] = 0;
-				buf->index_data[4] = 2;
-				buf->index_data[5] = 3;
-
-				for (u32 i = buf->c_l; i <= buf->c_h; ++i)
+				for (u32 i = 0; i < ui_b->count; )
 				{
-					r_cmd = g_scene->cmd_frame + i;
-					instance = array_list_intrusive_address(g_scene->instance_list, r_cmd->instance);
-
-					const struct ui_draw_bucket *ui_b = instance->ui_bucket;
-					struct ui_draw_node *draw_node = ui_b->list;
-					if (UI_CMD_LAYER_GET(ui_b->cmd) == UI_CMD_LAYER_TEXT)
+					const struct ui_node *n = hierarchy_index_address(g_ui->node_hierarchy, draw_node->index);
+					draw_node = draw_node->next;
+					const vec4 visible_rect =
 					{
-						for (u32 i = 0; i < ui_b->count; )
-						{
-							const struct ui_node *n = hierarchy_index_address(g_ui->node_hierarchy, draw_node->index);
-							draw_node = draw_node->next;
-							const vec4 visible_rect =
-							{
-								(n->pixel_visible[AXIS_2_X].high + n->pixel_visible[AXIS_2_X].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_Y].high + n->pixel_visible[AXIS_2_Y].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_X].high - n->pixel_visible[AXIS_2_X].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_Y].high - n->pixel_visible[AXIS_2_Y].low) / 2.0f,
-							};
-
-							vec2 global_offset;
-							switch (n->text_align_x)
-							{
-								case ALIGN_X_CENTER: 
-								{ 
-									global_offset[0] = n->pixel_position[0] + (n->pixel_size[0] - n->layout_text->width) / 2.0f; 
-								} break;
-
-								case ALIGN_LEFT: 
-								{ 
-									global_offset[0] = n->pixel_position[0] + n->text_pad[0]; 
-								} break;
-
-								case ALIGN_RIGHT: 
-								{ 
-									global_offset[0] = n->pixel_position[0] + n->pixel_size[0] - n->text_pad[0] - n->layout_text->width; 
-								} break;
-							}	
-
-							switch (n->text_align_y)
-							{
-								case ALIGN_Y_CENTER: 
-								{ 
-									global_offset[1] = n->pixel_position[1] + (n->pixel_size[1] + n->font->linespace*n->layout_text->line_count) / 2.0f; 
-								} break;
-
-								case ALIGN_TOP: 
-								{ 
-									global_offset[1] = n->pixel_position[1] + n->pixel_size[1] - n->text_pad[1]; 
-								} break;
-
-								case ALIGN_BOTTOM: 
-								{ 
-									global_offset[1] = n->pixel_position[1] + n->font->linespace*n->layout_text->line_count + n->text_pad[1]; 
-								} break;
-							}
-
-							global_offset[0] = f32_round(global_offset[0]);
-							global_offset[1] = f32_round(global_offset[1]);
-
-							struct text_line *line = n->layout_text->line;
-							for (u32 l = 0; l < n->layout_text->line_count; ++l, line = line->next)
-							{
-								vec2 global_baseline =
-								{
-									global_offset[0],
-									global_offset[1] - n->font->ascent - l*n->font->linespace,
-								};
-									
-								i += line->glyph_count;
-								for (u32 t = 0; t < line->glyph_count; ++t)
-								{
-									const struct font_glyph *glyph = glyph_lookup(n->font, line->glyph[t].codepoint);
-									const vec2 local_offset = 
-									{ 
-										global_baseline[0] + (f32) glyph->bearing[0] + line->glyph[t].x,
-										global_baseline[1] + (f32) glyph->bearing[1],
-									};
-
-									const vec4 glyph_rect =
-									{
-										(2*local_offset[0] + (f32) glyph->size[0]) / 2.0f,
-										(2*local_offset[1] - (f32) glyph->size[1]) / 2.0f,
-										(f32) glyph->size[0] / 2.0f,
-										(f32) glyph->size[1] / 2.0f,
-									};	
-
-									const vec4 uv_rect = 
-									{
-										(glyph->tr[0] + glyph->bl[0]) / 2.0f,
-										(glyph->tr[1] + glyph->bl[1]) / 2.0f,
-										(glyph->tr[0] - glyph->bl[0]) / 2.0f,
-										(glyph->tr[1] - glyph->bl[1]) / 2.0f,
-									};
-
-									memcpy(shared_data + S_NODE_RECT_OFFSET, glyph_rect, sizeof(vec4));
-									memcpy(shared_data + S_VISIBLE_RECT_OFFSET, visible_rect, sizeof(vec4));
-									memcpy(shared_data + S_UV_RECT_OFFSET, uv_rect, sizeof(vec4));
-									memcpy(shared_data + S_BACKGROUND_COLOR_OFFSET, zero4, sizeof(vec4));
-									memcpy(shared_data + S_BORDER_COLOR_OFFSET, zero4, sizeof(vec4));
-									memcpy(shared_data + S_SPRITE_COLOR_OFFSET, n->sprite_color, sizeof(vec4));
-									memcpy(shared_data + S_EXTRA_OFFSET, zero3, sizeof(vec3));
-									memset(shared_data + S_GRADIENT_COLOR_BR_OFFSET, 0, 4*sizeof(vec4));
-									shared_data += S_UI_STRIDE;
-								}
-							}
-						}
-					}
-					else if (UI_CMD_LAYER_GET(ui_b->cmd) == UI_CMD_LAYER_TEXT_SELECTION)
+						(n->pixel_visible[AXIS_2_X].high + n->pixel_visible[AXIS_2_X].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_Y].high + n->pixel_visible[AXIS_2_Y].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_X].high - n->pixel_visible[AXIS_2_X].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_Y].high - n->pixel_visible[AXIS_2_Y].low) / 2.0f,
+					};
+
+					vec2 global_offset;
+					switch (n->text_align_x)
 					{
-						for (u32 i = 0; i < ui_b->count; ++i)
-						{
-							const struct ui_text_selection *sel = g_ui->frame_stack_text_selection.arr + draw_node->index;
-							const struct ui_node *n = sel->node;
-							draw_node = draw_node->next;
+						case ALIGN_X_CENTER: 
+						{ 
+							global_offset[0] = n->pixel_position[0] + (n->pixel_size[0] - n->layout_text->width) / 2.0f; 
+						} break;
+
+						case ALIGN_LEFT: 
+						{ 
+							global_offset[0] = n->pixel_position[0] + n->text_pad[0]; 
+						} break;
+
+						case ALIGN_RIGHT: 
+						{ 
+							global_offset[0] = n->pixel_position[0] + n->pixel_size[0] - n->text_pad[0] - n->layout_text->width; 
+						} break;
+					}	
+
+					switch (n->text_align_y)
+					{
+						case ALIGN_Y_CENTER: 
+						{ 
+							global_offset[1] = n->pixel_position[1] + (n->pixel_size[1] + n->font->linespace*n->layout_text->line_count) / 2.0f; 
+						} break;
+
+						case ALIGN_TOP: 
+						{ 
+							global_offset[1] = n->pixel_position[1] + n->pixel_size[1] - n->text_pad[1]; 
+						} break;
+
+						case ALIGN_BOTTOM: 
+						{ 
+							global_offset[1] = n->pixel_position[1] + n->font->linespace*n->layout_text->line_count + n->text_pad[1]; 
+						} break;
+					}
 
-							vec2 global_offset;
-							switch (n->text_align_x)
-							{
-								case ALIGN_X_CENTER: 
-								{ 
-									global_offset[0] = n->pixel_position[0] + (n->pixel_size[0] - n->layout_text->width) / 2.0f; 
-								} break;
-
-								case ALIGN_LEFT: 
-								{ 
-									global_offset[0] = n->pixel_position[0] + n->text_pad[0]; 
-								} break;
-
-								case ALIGN_RIGHT: 
-								{ 
-									global_offset[0] = n->pixel_position[0] + n->pixel_size[0] - n->text_pad[0] - n->layout_text->width; 
-								} break;
-							}	
-
-							switch (n->text_align_y)
-							{
-								case ALIGN_Y_CENTER: 
-								{ 
-									global_offset[1] = n->pixel_position[1] + (n->pixel_size[1] + n->font->linespace*n->layout_text->line_count) / 2.0f; 
-								} break;
-
-								case ALIGN_TOP: 
-								{ 
-									global_offset[1] = n->pixel_position[1] + n->pixel_size[1] - n->text_pad[1]; 
-								} break;
-
-								case ALIGN_BOTTOM: 
-								{ 
-									global_offset[1] = n->pixel_position[1] + n->font->linespace*n->layout_text->line_count + n->text_pad[1]; 
-								} break;
-							}
-
-							global_offset[0] = f32_round(global_offset[0]);
-							global_offset[1] = f32_round(global_offset[1]);
-
-							struct text_line *line = sel->layout->line;
-							kas_assert(sel->layout->line_count == 1);
-							kas_assert(sel->high <= line->glyph_count + 1);
-
-							const struct font_glyph *glyph = glyph_lookup(n->font, (u32) ' ');
-							f32 height = n->font->linespace;
-							f32 width = glyph->advance;
-							if (sel->low != sel->high)
-							{
-								width += line->glyph[sel->high-1].x - line->glyph[sel->low].x;	
-							}
+					global_offset[0] = f32_round(global_offset[0]);
+					global_offset[1] = f32_round(global_offset[1]);
 
-							if (0 < sel->low && sel->low <= line->glyph_count)
-							{
-								const struct font_glyph *end_glyph = glyph_lookup(n->font, line->glyph[sel->low-1].codepoint);
-								global_offset[0] += line->glyph[sel->low-1].x + end_glyph->advance;
-							}
+					struct text_line *line = n->layout_text->line;
+					for (u32 l = 0; l < n->layout_text->line_count; ++l, line = line->next)
+					{
+						vec2 global_baseline =
+						{
+							global_offset[0],
+							global_offset[1] - n->font->ascent - l*n->font->linespace,
+						};
+							
+						i += line->glyph_count;
+						for (u32 t = 0; t < line->glyph_count; ++t)
+						{
+							const struct font_glyph *glyph = glyph_lookup(n->font, line->glyph[t].codepoint);
+							const vec2 local_offset = 
+							{ 
+								global_baseline[0] + (f32) glyph->bearing[0] + line->glyph[t].x,
+								global_baseline[1] + (f32) glyph->bearing[1],
+							};
 
-							const vec4 highlight_rect =
+							const vec4 glyph_rect =
 							{
-								(2*global_offset[0] + width) / 2.0f,
-								(2*global_offset[1] - height) / 2.0f,
-								width / 2.0f,
-								height / 2.0f,
+								(2*local_offset[0] + (f32) glyph->size[0]) / 2.0f,
+								(2*local_offset[1] - (f32) glyph->size[1]) / 2.0f,
+								(f32) glyph->size[0] / 2.0f,
+								(f32) glyph->size[1] / 2.0f,
 							};	
 
-							const vec4 visible_rect =
-							{
-								(n->pixel_visible[AXIS_2_X].high + n->pixel_visible[AXIS_2_X].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_Y].high + n->pixel_visible[AXIS_2_Y].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_X].high - n->pixel_visible[AXIS_2_X].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_Y].high - n->pixel_visible[AXIS_2_Y].low) / 2.0f,
-							};
-	
-							const struct sprite *spr = g_sprite + n->sprite;
 							const vec4 uv_rect = 
 							{
-								(spr->tr[0] + spr->bl[0]) / 2.0f,
-								(spr->tr[1] + spr->bl[1]) / 2.0f,
-								(spr->tr[0] - spr->bl[0]) / 2.0f,
-								(spr->tr[1] - spr->bl[1]) / 2.0f,
+								(glyph->tr[0] + glyph->bl[0]) / 2.0f,
+								(glyph->tr[1] + glyph->bl[1]) / 2.0f,
+								(glyph->tr[0] - glyph->bl[0]) / 2.0f,
+								(glyph->tr[1] - glyph->bl[1]) / 2.0f,
 							};
 
-							memcpy(shared_data + S_NODE_RECT_OFFSET, highlight_rect, sizeof(vec4));
+							memcpy(shared_data + S_NODE_RECT_OFFSET, glyph_rect, sizeof(vec4));
 							memcpy(shared_data + S_VISIBLE_RECT_OFFSET, visible_rect, sizeof(vec4));
 							memcpy(shared_data + S_UV_RECT_OFFSET, uv_rect, sizeof(vec4));
-							memcpy(shared_data + S_BACKGROUND_COLOR_OFFSET, sel->color, sizeof(vec4));
+							memcpy(shared_data + S_BACKGROUND_COLOR_OFFSET, zero4, sizeof(vec4));
 							memcpy(shared_data + S_BORDER_COLOR_OFFSET, zero4, sizeof(vec4));
-							memcpy(shared_data + S_SPRITE_COLOR_OFFSET, zero4, sizeof(vec4));
+							memcpy(shared_data + S_SPRITE_COLOR_OFFSET, n->sprite_color, sizeof(vec4));
 							memcpy(shared_data + S_EXTRA_OFFSET, zero3, sizeof(vec3));
 							memset(shared_data + S_GRADIENT_COLOR_BR_OFFSET, 0, 4*sizeof(vec4));
 							shared_data += S_UI_STRIDE;
 						}
 					}
-					else
+				}
+			}
+			else if (UI_CMD_LAYER_GET(ui_b->cmd) == UI_CMD_LAYER_TEXT_SELECTION)
+			{
+				for (u32 i = 0; i < ui_b->count; ++i)
+				{
+					const struct ui_text_selection *sel = g_ui->frame_stack_text_selection.arr + draw_node->index;
+					const struct ui_node *n = sel->node;
+					draw_node = draw_node->next;
+
+					vec2 global_offset;
+					switch (n->text_align_x)
 					{
-						for (u32 i = 0; i < ui_b->count; ++i)
-						{
-							const struct ui_node *n = hierarchy_index_address(g_ui->node_hierarchy, draw_node->index);
-							draw_node = draw_node->next;
-							const struct sprite *spr = g_sprite + n->sprite;
-							const vec4 node_rect =
-							{
-								n->pixel_position[0] + n->pixel_size[0] / 2.0f,
-								n->pixel_position[1] + n->pixel_size[1] / 2.0f,
-								n->pixel_size[0] / 2.0f,
-								n->pixel_size[1] / 2.0f,
-							};
+						case ALIGN_X_CENTER: 
+						{ 
+							global_offset[0] = n->pixel_position[0] + (n->pixel_size[0] - n->layout_text->width) / 2.0f; 
+						} break;
+
+						case ALIGN_LEFT: 
+						{ 
+							global_offset[0] = n->pixel_position[0] + n->text_pad[0]; 
+						} break;
+
+						case ALIGN_RIGHT: 
+						{ 
+							global_offset[0] = n->pixel_position[0] + n->pixel_size[0] - n->text_pad[0] - n->layout_text->width; 
+						} break;
+					}	
+
+					switch (n->text_align_y)
+					{
+						case ALIGN_Y_CENTER: 
+						{ 
+							global_offset[1] = n->pixel_position[1] + (n->pixel_size[1] + n->font->linespace*n->layout_text->line_count) / 2.0f; 
+						} break;
+
+						case ALIGN_TOP: 
+						{ 
+							global_offset[1] = n->pixel_position[1] + n->pixel_size[1] - n->text_pad[1]; 
+						} break;
+
+						case ALIGN_BOTTOM: 
+						{ 
+							global_offset[1] = n->pixel_position[1] + n->font->linespace*n->layout_text->line_count + n->text_pad[1]; 
+						} break;
+					}
 
-							const vec4 visible_rect =
-							{
-								(n->pixel_visible[AXIS_2_X].high + n->pixel_visible[AXIS_2_X].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_Y].high + n->pixel_visible[AXIS_2_Y].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_X].high - n->pixel_visible[AXIS_2_X].low) / 2.0f,
-								(n->pixel_visible[AXIS_2_Y].high - n->pixel_visible[AXIS_2_Y].low) / 2.0f,
-							};
+					global_offset[0] = f32_round(global_offset[0]);
+					global_offset[1] = f32_round(global_offset[1]);
 
-							const vec4 uv_rect = 
-							{
-								(spr->tr[0] + spr->bl[0]) / 2.0f,
-								(spr->tr[1] + spr->bl[1]) / 2.0f,
-								(spr->tr[0] - spr->bl[0]) / 2.0f,
-								(spr->tr[1] - spr->bl[1]) / 2.0f,
-							};
+					struct text_line *line = sel->layout->line;
+					kas_assert(sel->layout->line_count == 1);
+					kas_assert(sel->high <= line->glyph_count + 1);
 
+					const struct font_glyph *glyph = glyph_lookup(n->font, (u32) ' ');
+					f32 height = n->font->linespace;
+					f32 width = glyph->advance;
+					if (sel->low != sel->high)
+					{
+						width += line->glyph[sel->high-1].x - line->glyph[sel->low].x;	
+					}
 
-							const vec3 extra = { n->border_size, n->corner_radius, n->edge_softness };
-							memcpy(shared_data + S_NODE_RECT_OFFSET, node_rect, sizeof(vec4));
-							memcpy(shared_data + S_VISIBLE_RECT_OFFSET, visible_rect, sizeof(vec4));
-							memcpy(shared_data + S_UV_RECT_OFFSET, uv_rect, sizeof(vec4));
-							memcpy(shared_data + S_BACKGROUND_COLOR_OFFSET, n->background_color, sizeof(vec4));
-							memcpy(shared_data + S_BORDER_COLOR_OFFSET, n->border_color, sizeof(vec4));
-							memcpy(shared_data + S_SPRITE_COLOR_OFFSET, n->sprite_color, sizeof(vec4));
-							memcpy(shared_data + S_EXTRA_OFFSET, extra, sizeof(vec3));
-							memcpy(shared_data + S_GRADIENT_COLOR_BR_OFFSET, n->gradient_color, 4*sizeof(vec4));
-							shared_data += S_UI_STRIDE;
-						}
+					if (0 < sel->low && sel->low <= line->glyph_count)
+					{
+						const struct font_glyph *end_glyph = glyph_lookup(n->font, line->glyph[sel->low-1].codepoint);
+						global_offset[0] += line->glyph[sel->low-1].x + end_glyph->advance;
 					}
+
+					const vec4 highlight_rect =
+					{
+						(2*global_offset[0] + width) / 2.0f,
+						(2*global_offset[1] - height) / 2.0f,
+						width / 2.0f,
+						height / 2.0f,
+					};	
+
+					const vec4 visible_rect =
+					{
+						(n->pixel_visible[AXIS_2_X].high + n->pixel_visible[AXIS_2_X].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_Y].high + n->pixel_visible[AXIS_2_Y].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_X].high - n->pixel_visible[AXIS_2_X].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_Y].high - n->pixel_visible[AXIS_2_Y].low) / 2.0f,
+					};
+	
+					const struct sprite *spr = g_sprite + n->sprite;
+					const vec4 uv_rect = 
+					{
+						(spr->tr[0] + spr->bl[0]) / 2.0f,
+						(spr->tr[1] + spr->bl[1]) / 2.0f,
+						(spr->tr[0] - spr->bl[0]) / 2.0f,
+						(spr->tr[1] - spr->bl[1]) / 2.0f,
+					};
+
+					memcpy(shared_data + S_NODE_RECT_OFFSET, highlight_rect, sizeof(vec4));
+					memcpy(shared_data + S_VISIBLE_RECT_OFFSET, visible_rect, sizeof(vec4));
+					memcpy(shared_data + S_UV_RECT_OFFSET, uv_rect, sizeof(vec4));
+					memcpy(shared_data + S_BACKGROUND_COLOR_OFFSET, sel->color, sizeof(vec4));
+					memcpy(shared_data + S_BORDER_COLOR_OFFSET, zero4, sizeof(vec4));
+					memcpy(shared_data + S_SPRITE_COLOR_OFFSET, zero4, sizeof(vec4));
+					memcpy(shared_data + S_EXTRA_OFFSET, zero3, sizeof(vec3));
+					memset(shared_data + S_GRADIENT_COLOR_BR_OFFSET, 0, 4*sizeof(vec4));
+					shared_data += S_UI_STRIDE;
+				}
+			}
+			else
+			{
+				for (u32 i = 0; i < ui_b->count; ++i)
+				{
+					const struct ui_node *n = hierarchy_index_address(g_ui->node_hierarchy, draw_node->index);
+					draw_node = draw_node->next;
+					const struct sprite *spr = g_sprite + n->sprite;
+					const vec4 node_rect =
+					{
+						n->pixel_position[0] + n->pixel_size[0] / 2.0f,
+						n->pixel_position[1] + n->pixel_size[1] / 2.0f,
+						n->pixel_size[0] / 2.0f,
+						n->pixel_size[1] / 2.0f,
+					};
+
+					const vec4 visible_rect =
+					{
+						(n->pixel_visible[AXIS_2_X].high + n->pixel_visible[AXIS_2_X].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_Y].high + n->pixel_visible[AXIS_2_Y].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_X].high - n->pixel_visible[AXIS_2_X].low) / 2.0f,
+						(n->pixel_visible[AXIS_2_Y].high - n->pixel_visible[AXIS_2_Y].low) / 2.0f,
+					};
+
+					const vec4 uv_rect = 
+					{
+						(spr->tr[0] + spr->bl[0]) / 2.0f,
+						(spr->tr[1] + spr->bl[1]) / 2.0f,
+						(spr->tr[0] - spr->bl[0]) / 2.0f,
+						(spr->tr[1] - spr->bl[1]) / 2.0f,
+					};
+
+
+					const vec3 extra = { n->border_size, n->corner_radius, n->edge_softness };
+					memcpy(shared_data + S_NODE_RECT_OFFSET, node_rect, sizeof(vec4));
+					memcpy(shared_data + S_VISIBLE_RECT_OFFSET, visible_rect, sizeof(vec4));
+					memcpy(shared_data + S_UV_RECT_OFFSET, uv_rect, sizeof(vec4));
+					memcpy(shared_data + S_BACKGROUND_COLOR_OFFSET, n->background_color, sizeof(vec4));
+					memcpy(shared_data + S_BORDER_COLOR_OFFSET, n->border_color, sizeof(vec4));
+					memcpy(shared_data + S_SPRITE_COLOR_OFFSET, n->sprite_color, sizeof(vec4));
+					memcpy(shared_data + S_EXTRA_OFFSET, extra, sizeof(vec3));
+					memcpy(shared_data + S_GRADIENT_COLOR_BR_OFFSET, n->gradient_color, 4*sizeof(vec4));
+					shared_data += S_UI_STRIDE;
 				}
+			}
+		} break;
+
+		case R_INSTANCE_PROXY3D:
+		{
+			const struct r_proxy3d *proxy = r_proxy3d_address(instance->unit);
+			memcpy(data + S_PROXY3D_TRANSLATION_BLEND_OFFSET, proxy->spec_position, sizeof(vec3));
+			memcpy(data + S_PROXY3D_TRANSLATION_BLEND_OFFSET + sizeof(vec3), &proxy->blend, sizeof(f32));
+			memcpy(data + S_PROXY3D_ROTATION_OFFSET, proxy->spec_rotation, sizeof(quat));
+			memcpy(data + S_PROXY3D_COLOR_OFFSET, proxy->color, sizeof(vec4));
+		} break;
+
+		case R_INSTANCE_MESH:
+		{
+			memcpy(data, instance->mesh->vertex_data, instance->mesh->vertex_count * instance->mesh->local_stride);
+		} break;
+
+		default:
+		{
+			kas_assert_string(0, "Unimplemented instance type in draw call generation");
+		} break;
+	}
+}
+
+/*
+ * Reserve the stream ranges of the bucket's buffers and set draw_data[i] to where command i writes its instance 
+ * data. Commands are laid out in order within their buffer, so no two commands share output memory and the 
+ * draw data can be generated in any order.
+ */
+static void r_scene_bucket_reserve_draw_data(struct r_bucket *b, u8 **draw_data)
+{
+	const struct r_command *r_cmd = g_scene->cmd_frame + b->c_l;
+	const struct r_instance *instance = array_list_intrusive_address(g_scene->instance_list, r_cmd->instance);
+
+	for (u32 bi = 0; bi < b->buffer_count; bi++)
+	{	
+		struct r_buffer *buf = b->buffer_array[bi];
+		u8 *data = NULL;
+		switch (instance->type)
+		{
+			case R_INSTANCE_UI:
+			{
+				buf->shared_data = r_stream_push(&g_r_core->stream.vertex, &buf->shared_offset, buf->shared_size);
+				buf->local_data = r_stream_push(&g_r_core->stream.vertex, &buf->local_offset, buf->local_size);
+				buf->index_data = r_stream_push(&g_r_core->stream.index, &buf->index_offset, buf->index_count * sizeof(u32));
+
+				buf->index_data[0] = 0;
+				buf->index_data[1] = 1;
+				buf->index_data[2] = 2;
+				buf->index_data[3] = 0;
+				buf->index_data[4] = 2;
+				buf->index_data[5] = 3;
+				data = buf->shared_data;
 			} break;
 
 			case R_INSTANCE_PROXY3D:
 			{
-				const struct r_proxy3d *proxy = r_proxy3d_address(instance->unit);
-				const struct r_mesh *mesh = string_database_address(g_r_core->mesh_database, proxy->mesh);
-				buf->shared_data = arena_push(g_scene->mem_frame, buf->shared_size);
-				buf->local_data = mesh->vertex_data;
-				buf->index_data = mesh->index_data;
-
-				u8 *shared_data = buf->shared_data;
-				for (u32 i = buf->c_l; i <= buf->c_h; ++i)
-				{
-					r_cmd = g_scene->cmd_frame + i;
-					instance = array_list_intrusive_address(g_scene->instance_list, r_cmd->instance);
-					proxy = r_proxy3d_address(instance->unit);
-
-					memcpy(shared_data + S_PROXY3D_TRANSLATION_BLEND_OFFSET, proxy->spec_position, sizeof(vec3));
-					memcpy(shared_data + S_PROXY3D_TRANSLATION_BLEND_OFFSET + sizeof(vec3), &proxy->blend, sizeof(f32));
-					memcpy(shared_data + S_PROXY3D_ROTATION_OFFSET, proxy->spec_rotation, sizeof(quat));
-					memcpy(shared_data + S_PROXY3D_COLOR_OFFSET, proxy->color, sizeof(vec4));
-					shared_data += S_PROXY3D_STRIDE;
-				}
+				buf->shared_data = r_stream_push(&g_r_core->stream.vertex, &buf->shared_offset, buf->shared_size);
+				buf->local_data = buf->mesh->vertex_data;
+				buf->index_data = buf->mesh->index_data;
+				data = buf->shared_data;
 			} break;
 
 			case R_INSTANCE_MESH:
 			{
 				buf->shared_data = NULL;
 				buf->index_data = NULL;
-				buf->local_data = arena_push(g_scene->mem_frame, buf->local_size);
-				u8 *local_data = buf->local_data;
-				for (u32 i = buf->c_l; i <= buf->c_h; ++i)
-				{
-					r_cmd = g_scene->cmd_frame + i;
-					instance = array_list_intrusive_address(g_scene->instance_list, r_cmd->instance);
-					memcpy(local_data, instance->mesh->vertex_data, instance->mesh->vertex_count * instance->mesh->local_stride);
-					local_data += instance->mesh->vertex_count * instance->mesh->local_stride;
-				}
+				buf->local_data = r_stream_push(&g_r_core->stream.vertex, &buf->local_offset, buf->local_size);
+				data = buf->local_data;
 			} break;
 
 			default:
@@ -732,6 +718,34 @@ static void r_scene_bucket_generate_draw_data(struct r_bucket *b)
 				kas_assert_string(0, "Unimplemented instance type in draw call generation");
 			} break;
 		}
+
+		for (u32 i = buf->c_l; i <= buf->c_h; ++i)
+		{
+			r_cmd = g_scene->cmd_frame + i;
+			instance = array_list_intrusive_address(g_scene->instance_list, r_cmd->instance);
+			draw_data[i] = data;
+			switch (instance->type)
+			{
+				case R_INSTANCE_UI: { data += instance->ui_bucket->count*S_UI_STRIDE; } break;
+				case R_INSTANCE_PROXY3D: { data += S_PROXY3D_STRIDE; } break;
+				case R_INSTANCE_MESH: { data += instance->mesh->vertex_count * instance->mesh->local_stride; } break;
+				default: { } break;
+			}
+		}
+	}
+}
+
+static void thread_r_scene_generate_draw_data(void *task_addr)
+{
+	PROF_ZONE;
+
+	struct task *task = task_addr;
+	u8 **draw_data = task->input;
+	const struct r_command *r_cmd = task->range->base;
+	const u32 first = (u32) (r_cmd - g_scene->cmd_frame);
+	for (u32 i = 0; i < task->range->count; ++i)
+	{
+		r_scene_command_generate_draw_data(r_cmd + i, draw_data[first + i]);
 	}
 
 	PROF_ZONE_END;
@@ -743,10 +757,61 @@ void r_scene_frame_end(void)
 
 	r_scene_sort_commands_and_prune_instances();
 	r_scene_generate_bucket_list();
+
+	/* draw data is written directly into the mapped stream buffers; resident meshes only stream instance data */
+	u64 vertex_size = 0;
+	u64 index_size = 0;
 	for (struct r_bucket *b = g_scene->frame_bucket_list; b; b = b->next)
 	{
-		r_scene_bucket_generate_draw_data(b);
+		for (u32 bi = 0; bi < b->buffer_count; ++bi)
+		{
+			const struct r_buffer *buf = b->buffer_array[bi];
+			vertex_size += r_stream_size(buf->shared_size);
+			if (!buf->mesh)
+			{
+				vertex_size += r_stream_size(buf->local_size);
+				index_size += r_stream_size(buf->index_count * sizeof(u32));
+			}
+		}
 	}
+
+	u8 **draw_data = arena_push(g_scene->mem_frame, g_scene->cmd_frame_count * sizeof(u8 *));
+	r_stream_map(&g_r_core->stream, vertex_size, index_size);
+	for (struct r_bucket *b = g_scene->frame_bucket_list; b; b = b->next)
+	{
+		r_scene_bucket_reserve_draw_data(b, draw_data);
+	}
+
+	/* the render thread may not own a worker while another thread holds the master worker */
+	struct task_bundle *bundle = NULL;
+	if (g_scene->cmd_frame_count >= R_SCENE_PARALLEL_DRAW_DATA_MIN && task_worker_self() != NULL)
+	{
+		bundle = task_bundle_split_range(
+				g_scene->mem_frame,
+				&thread_r_scene_generate_draw_data,
+				R_SCENE_DRAW_DATA_SPLIT * g_task_ctx->worker_count,
+				g_scene->cmd_frame,
+				g_scene->cmd_frame_count,
+				sizeof(struct r_command),
+				draw_data);
+	}
+
+	if (bundle)
+	{
+		task_main_master_run_available_jobs();
+		task_bundle_wait(bundle);
+		task_bundle_release(bundle);
+	}
+	else
+	{
+		/* too few commands, no worker or no bundle available: generate serially */
+		for (u32 i = 0; i < g_scene->cmd_frame_count; ++i)
+		{
+			r_scene_command_generate_draw_data(g_scene->cmd_frame + i, draw_data[i]);
+		}
+	}
+	r_stream_unmap(&g_r_core->stream);
+
 	PROF_ZONE_END;
 }
 
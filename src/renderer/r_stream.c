@@ -0,0 +1,235 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+#include "r_local.h"
+
+#define R_STREAM_FENCE_TIMEOUT_NS	(1000*1000*1000)
+
+static void r_stream_buffer_storage(struct r_stream_buffer *buf)
+{
+	kas_glBindBuffer(buf->target, buf->handle);
+#if defined(R_STREAM_ORPHAN)
+	kas_glBufferData(buf->target, (GLsizeiptr) buf->region_size, NULL, GL_STREAM_DRAW);
+#else
+	kas_glBufferData(buf->target, (GLsizeiptr) (R_STREAM_REGION_COUNT*buf->region_size), NULL, GL_STREAM_DRAW);
+#endif
+}
+
+static void r_stream_buffer_init(struct r_stream_buffer *buf, const GLenum target, const u64 region_size)
+{
+	buf->target = target;
+	buf->region_size = region_size;
+	buf->used = 0;
+	buf->mapped_offset = 0;
+	buf->mapped_size = 0;
+	buf->mapped_used = 0;
+	buf->mapped = NULL;
+	kas_glGenBuffers(1, &buf->handle);
+	r_stream_buffer_storage(buf);
+}
+
+void r_stream_init(struct r_stream *stream)
+{
+	/* the ebo's first binding must be to GL_ELEMENT_ARRAY_BUFFER on WebGL2, so set it up within a vertex array */
+	kas_glGenVertexArrays(1, &stream->vao);
+	kas_glBindVertexArray(stream->vao);
+	r_stream_buffer_init(&stream->vertex, GL_ARRAY_BUFFER, R_STREAM_VERTEX_REGION_SIZE);
+	r_stream_buffer_init(&stream->index, GL_ELEMENT_ARRAY_BUFFER, R_STREAM_INDEX_REGION_SIZE);
+	kas_glBindVertexArray(0);
+	kas_glDeleteVertexArrays(1, &stream->vao);
+	stream->vao = 0;
+
+	stream->region = 0;
+	for (u32 i = 0; i < R_STREAM_REGION_COUNT; ++i)
+	{
+		stream->fence_count[i] = 0;
+	}
+}
+
+u64 r_stream_size(const u64 size)
+{
+	return (size + R_STREAM_ALIGNMENT - 1) & ~((u64) R_STREAM_ALIGNMENT - 1);
+}
+
+#if !defined(R_STREAM_ORPHAN)
+
+static void r_stream_fence_wait(GLsync fence)
+{
+	GLenum status;
+	do
+	{
+		status = kas_glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, R_STREAM_FENCE_TIMEOUT_NS);
+	} while (status == GL_TIMEOUT_EXPIRED);
+
+	if (status == GL_WAIT_FAILED)
+	{
+		log_string(T_RENDERER, S_ERROR, "Failed to wait on stream region fence");
+	}
+}
+
+#endif
+
+void r_stream_frame_begin(struct r_stream *stream)
+{
+	PROF_ZONE;
+#if !defined(R_STREAM_ORPHAN)
+	stream->region = (stream->region + 1) % R_STREAM_REGION_COUNT;
+	for (u32 i = 0; i < stream->fence_count[stream->region]; ++i)
+	{
+		GLsync fence = stream->fence[stream->region][i];
+		r_stream_fence_wait(fence);
+		kas_glDeleteSync(fence);
+	}
+	stream->fence_count[stream->region] = 0;
+#endif
+	stream->vertex.used = 0;
+	stream->index.used = 0;
+	PROF_ZONE_END;
+}
+
+static void r_stream_buffer_map(struct r_stream_buffer *buf, const u32 region, const u64 size)
+{
+	buf->mapped_size = size;
+	buf->mapped_used = 0;
+	buf->mapped = NULL;
+	if (size == 0)
+	{
+		return;
+	}
+
+#if defined(R_STREAM_ORPHAN)
+	(void) region;
+	/* every window uploads into fresh storage */
+	buf->used = 0;
+	buf->mapped_offset = 0;
+	buf->mapped = arena_push(&g_r_core->frame, size);
+	if (!buf->mapped)
+	{
+		log_string(T_RENDERER, S_FATAL, "Failed to allocate stream staging memory, exiting.");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+#else
+	if (buf->used + size > buf->region_size)
+	{
+		/* orphan the current storage; draws already issued keep reading from it */
+		u64 region_size = 2*buf->region_size;
+		while (region_size < size)
+		{
+			region_size *= 2;
+		}
+		log(T_RENDERER, S_NOTE, "growing stream buffer regions from %luB to %luB", buf->region_size, region_size);
+		buf->region_size = region_size;
+		buf->used = 0;
+		r_stream_buffer_storage(buf);
+	}
+
+	buf->mapped_offset = region*buf->region_size + buf->used;
+	kas_glBindBuffer(buf->target, buf->handle);
+	buf->mapped = kas_glMapBufferRange(buf->target
+			, (GLintptr) buf->mapped_offset
+			, (GLsizeiptr) size
+			, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (!buf->mapped)
+	{
+		log_string(T_RENDERER, S_FATAL, "Failed to map stream buffer, exiting.");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+#endif
+}
+
+static void r_stream_buffer_unmap(struct r_stream_buffer *buf)
+{
+	if (!buf->mapped)
+	{
+		return;
+	}
+
+	kas_glBindBuffer(buf->target, buf->handle);
+#if defined(R_STREAM_ORPHAN)
+	if (buf->region_size < buf->mapped_used)
+	{
+		buf->region_size = buf->mapped_used;
+	}
+	r_stream_buffer_storage(buf);
+	kas_glBufferSubData(buf->target, 0, (GLsizeiptr) buf->mapped_used, buf->mapped);
+#else
+	if (kas_glUnmapBuffer(buf->target) == GL_FALSE)
+	{
+		/* storage was lost (e.g. display mode change); the frame's stream data is undefined */
+		log_string(T_RENDERER, S_WARNING, "stream buffer storage corrupted while mapped");
+	}
+#endif
+	buf->used += buf->mapped_used;
+	g_r_core->frame_upload_bytes += buf->mapped_used;
+	buf->mapped = NULL;
+}
+
+void r_stream_map(struct r_stream *stream, const u64 vertex_size, const u64 index_size)
+{
+	PROF_ZONE;
+	kas_glGenVertexArrays(1, &stream->vao);
+	kas_glBindVertexArray(stream->vao);
+	r_stream_buffer_map(&stream->vertex, stream->region, vertex_size);
+	r_stream_buffer_map(&stream->index, stream->region, index_size);
+	PROF_ZONE_END;
+}
+
+void r_stream_unmap(struct r_stream *stream)
+{
+	PROF_ZONE;
+	r_stream_buffer_unmap(&stream->vertex);
+	r_stream_buffer_unmap(&stream->index);
+	kas_glBindVertexArray(0);
+	kas_glDeleteVertexArrays(1, &stream->vao);
+	stream->vao = 0;
+	PROF_ZONE_END;
+}
+
+void *r_stream_push(struct r_stream_buffer *buf, u64 *offset, const u64 size)
+{
+	*offset = buf->mapped_offset + buf->mapped_used;
+	if (size == 0)
+	{
+		return NULL;
+	}
+
+	kas_assert(buf->mapped_used + r_stream_size(size) <= buf->mapped_size);
+	void *addr = buf->mapped + buf->mapped_used;
+	buf->mapped_used += r_stream_size(size);
+	return addr;
+}
+
+void r_stream_window_end(struct r_stream *stream)
+{
+#if !defined(R_STREAM_ORPHAN)
+	GLsync fence = kas_glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	if (stream->fence_count[stream->region] < R_STREAM_FENCE_MAX)
+	{
+		stream->fence[stream->region][stream->fence_count[stream->region]++] = fence;
+	}
+	else
+	{
+		/* out of fence slots, wait for the window's draws immediately */
+		r_stream_fence_wait(fence);
+		kas_glDeleteSync(fence);
+	}
+#else
+	(void) stream;
+#endif
+}
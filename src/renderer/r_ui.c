@@ -66,7 +66,7 @@ void r_ui_draw(struct ui *ui)
 	}
 }
 
-void r_ui_buffer_shared_layout_setter(void)
+void r_ui_buffer_shared_layout_setter(const u64 offset)
 {
 	kas_glEnableVertexAttribArray(0);
 	kas_glEnableVertexAttribArray(1);
@@ -80,17 +80,17 @@ void r_ui_buffer_shared_layout_setter(void)
 	kas_glEnableVertexAttribArray(9);
 	kas_glEnableVertexAttribArray(10);
 
-	kas_glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_NODE_RECT_OFFSET);
-	kas_glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_VISIBLE_RECT_OFFSET);
-	kas_glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_UV_RECT_OFFSET);
-	kas_glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_BACKGROUND_COLOR_OFFSET);
-	kas_glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_BORDER_COLOR_OFFSET);
-	kas_glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_SPRITE_COLOR_OFFSET);
-	kas_glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_EXTRA_OFFSET);
-	kas_glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_GRADIENT_COLOR_BR_OFFSET);
-	kas_glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_GRADIENT_COLOR_TR_OFFSET);
-	kas_glVertexAttribPointer(9, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_GRADIENT_COLOR_TL_OFFSET);
-	kas_glVertexAttribPointer(10, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)S_GRADIENT_COLOR_BL_OFFSET);
+	kas_glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_NODE_RECT_OFFSET));
+	kas_glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_VISIBLE_RECT_OFFSET));
+	kas_glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_UV_RECT_OFFSET));
+	kas_glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_BACKGROUND_COLOR_OFFSET));
+	kas_glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_BORDER_COLOR_OFFSET));
+	kas_glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_SPRITE_COLOR_OFFSET));
+	kas_glVertexAttribPointer(6, 3, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_EXTRA_OFFSET));
+	kas_glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_GRADIENT_COLOR_BR_OFFSET));
+	kas_glVertexAttribPointer(8, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_GRADIENT_COLOR_TR_OFFSET));
+	kas_glVertexAttribPointer(9, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_GRADIENT_COLOR_TL_OFFSET));
+	kas_glVertexAttribPointer(10, 4, GL_FLOAT, GL_FALSE, S_UI_STRIDE, (void *)(offset + S_GRADIENT_COLOR_BL_OFFSET));
 
 	kas_glVertexAttribDivisor(0, 1);
 	kas_glVertexAttribDivisor(1, 1);
@@ -105,6 +105,6 @@ void r_ui_buffer_shared_layout_setter(void)
 	kas_glVertexAttribDivisor(10, 1);
 }
 
-void r_ui_buffer_local_layout_setter(void)
+void r_ui_buffer_local_layout_setter(const u64 offset)
 {
 }
@@ -18,6 +18,8 @@
 */
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
 #include <sys/sysinfo.h>
 #include <cpuid.h>
 #include "linux_local.h"
@@ -28,6 +30,7 @@ void 		(*kas_cpuid_ex)(u32 *eax, u32 *ebx, u32 *ecx, u32 *edx, const u32 functio
 u32  		(*system_logical_core_count)(void);
 u64  		(*system_pagesize)(void);
 pid		(*system_pid)(void);
+u32		(*system_cpu_topology)(struct kas_logical_core *topology, const u32 logical_core_count);
 
 static void linux_kas_cpuid(u32 *eax, u32 *ebx, u32 *ecx, u32 *edx, const u32 function)
 {
@@ -67,6 +70,190 @@ static u32 linux_logical_core_count(void)
 	return (u32) count;
 }
 
+/* read the leading unsigned integer of a sysfs file */
+static u32 linux_sysfs_read_u32(u32 *val, const char *path)
+{
+	const int fd = open(path, O_RDONLY);
+	if (fd == -1)
+	{
+		return 0;
+	}
+
+	char buf[32];
+	const ssize_t size = read(fd, buf, sizeof(buf));
+	close(fd);
+
+	u32 digits = 0;
+	*val = 0;
+	for (ssize_t i = 0; i < size && '0' <= buf[i] && buf[i] <= '9'; ++i, ++digits)
+	{
+		*val = 10*(*val) + (u32) (buf[i] - '0');
+	}
+
+	return digits > 0;
+}
+
+struct linux_cpu_range
+{
+	u32	first;
+	u32	last;
+};
+
+/* parse a sysfs cpu list, e.g. "0-3,8-11", into at most max_count ranges; returns the number of ranges read. */
+static u32 linux_sysfs_read_cpu_list(struct linux_cpu_range *range, const u32 max_count, const char *path)
+{
+	const int fd = open(path, O_RDONLY);
+	if (fd == -1)
+	{
+		return 0;
+	}
+
+	char buf[512];
+	const ssize_t size = read(fd, buf, sizeof(buf));
+	close(fd);
+
+	u32 count = 0;
+	ssize_t i = 0;
+	while (i < size && count < max_count && '0' <= buf[i] && buf[i] <= '9')
+	{
+		u32 bound[2] = { 0, 0 };
+		for (u32 b = 0; b < 2; ++b)
+		{
+			for (; i < size && '0' <= buf[i] && buf[i] <= '9'; ++i)
+			{
+				bound[b] = 10*bound[b] + (u32) (buf[i] - '0');
+			}
+
+			if (b == 0 && i < size && buf[i] == '-')
+			{
+				i += 1;
+			}
+			else if (b == 0)
+			{
+				bound[1] = bound[0];
+				break;
+			}
+		}
+
+		range[count].first = bound[0];
+		range[count].last = bound[1];
+		count += 1;
+		if (i < size && buf[i] == ',')
+		{
+			i += 1;
+		}
+	}
+
+	return count;
+}
+
+/* index of the online cpu with the given os id, or U32_MAX; online ids are sorted */
+static u32 linux_cpu_index(const struct kas_logical_core *topology, const u32 logical_core_count, const u32 id)
+{
+	u32 low = 0;
+	u32 high = logical_core_count;
+	while (low < high)
+	{
+		const u32 mid = low + (high - low) / 2;
+		if (topology[mid].id < id)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return (low < logical_core_count && topology[low].id == id) ? low : U32_MAX;
+}
+
+/* index of the first online cpu in the sysfs cpu list, or U32_MAX */
+static u32 linux_sysfs_read_first_online_cpu(const struct kas_logical_core *topology, const u32 logical_core_count, const char *path)
+{
+	struct linux_cpu_range range[64];
+	const u32 range_count = linux_sysfs_read_cpu_list(range, sizeof(range) / sizeof(range[0]), path);
+	for (u32 r = 0; r < range_count; ++r)
+	{
+		for (u32 id = range[r].first; id <= range[r].last; ++id)
+		{
+			const u32 index = linux_cpu_index(topology, logical_core_count, id);
+			if (index != U32_MAX)
+			{
+				return index;
+			}
+		}
+	}
+
+	return U32_MAX;
+}
+
+/* 
+ * Online cpu ids need not be 0..n-1 (e.g. with hotplugged or isolated cpus), so logical core i is the i:th id in
+ * the online list, and the sibling and cache lists are mapped back to logical core indices.
+ */
+static u32 linux_cpu_topology(struct kas_logical_core *topology, const u32 logical_core_count)
+{
+	struct linux_cpu_range range[64];
+	const u32 range_count = linux_sysfs_read_cpu_list(range, sizeof(range) / sizeof(range[0]), "/sys/devices/system/cpu/online");
+	u32 online_count = 0;
+	for (u32 r = 0; r < range_count; ++r)
+	{
+		online_count += (range[r].first <= range[r].last) ? range[r].last - range[r].first + 1 : 0;
+	}
+
+	if (online_count != logical_core_count)
+	{
+		return 0;
+	}
+
+	u32 i = 0;
+	for (u32 r = 0; r < range_count; ++r)
+	{
+		for (u32 id = range[r].first; id <= range[r].last; ++id)
+		{
+			topology[i++].id = id;
+		}
+	}
+
+	char path[128];
+	for (u32 cpu = 0; cpu < logical_core_count; ++cpu)
+	{
+		struct kas_logical_core *lc = topology + cpu;
+		snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/topology/thread_siblings_list", lc->id);
+		lc->core = linux_sysfs_read_first_online_cpu(topology, logical_core_count, path);
+		if (lc->core == U32_MAX)
+		{
+			return 0;
+		}
+
+		/* cores without a reported L2/L3 get private caches */
+		lc->l2 = lc->core;
+		lc->l3 = lc->core;
+		for (u32 index = 0; index < 8; ++index)
+		{
+			u32 level;
+			snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/level", lc->id, index);
+			if (!linux_sysfs_read_u32(&level, path))
+			{
+				break;
+			}
+
+			if (level == 2 || level == 3)
+			{
+				snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", lc->id, index);
+				const u32 shared = linux_sysfs_read_first_online_cpu(topology, logical_core_count, path);
+				if (shared != U32_MAX)
+				{
+					*((level == 2) ? &lc->l2 : &lc->l3) = shared;
+				}
+			}
+		}
+	}
+
+	return 1;
+}
+
 static u64 linux_pagesize(void)
 {
 	return (u64) getpagesize();
@@ -96,6 +283,36 @@ void virtual_memory_release(void *addr, const u64 size)
 	}
 }
 
+void *virtual_memory_reserve_uncommitted(const u64 size)
+{
+	void *addr = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (addr == MAP_FAILED)
+	{
+		LOG_SYSTEM_ERROR(S_ERROR);	
+		addr = NULL;
+	}
+	return addr;
+}
+
+u32 virtual_memory_commit(void *addr, const u64 size)
+{
+	if (mprotect(addr, size, PROT_READ | PROT_WRITE) == -1)
+	{
+		LOG_SYSTEM_ERROR(S_ERROR);	
+		return 0;
+	}
+	return 1;
+}
+
+void virtual_memory_decommit(void *addr, const u64 size)
+{
+	/* drop the pages before revoking access, so the range is backed by nothing */
+	if (madvise(addr, size, MADV_DONTNEED) == -1 || mprotect(addr, size, PROT_NONE) == -1)
+	{
+		LOG_SYSTEM_ERROR(S_ERROR);	
+	}
+}
+
 void os_arch_init_func_ptrs(void)
 {
 	kas_cpuid = &linux_kas_cpuid;
@@ -103,4 +320,5 @@ void os_arch_init_func_ptrs(void)
 	system_logical_core_count = &linux_logical_core_count;
 	system_pagesize = &linux_pagesize;
 	system_pid = &linux_pid;
+	system_cpu_topology = &linux_cpu_topology;
 }
@@ -20,6 +20,9 @@
 #include <semaphore.h>
 #include <errno.h>
 #include <stdio.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include "linux_local.h"
 #include "sys_public.h"
 
@@ -87,3 +90,26 @@ u32 semaphore_trywait(semaphore *sem)
 
 	return success;
 }
+
+void futex_wait(u32 *addr, const u32 expected)
+{
+	if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0) == -1)
+	{
+		/* EAGAIN: *addr != expected, EINTR: interrupted; both are spurious wake ups to the caller */
+		if (errno != EAGAIN && errno != EINTR)
+		{
+			LOG_SYSTEM_ERROR(S_FATAL);
+			assert(0);
+		}
+	}
+}
+
+void futex_wake(u32 *addr, const u32 count)
+{
+	const int wake_count = (count > I32_MAX) ? I32_MAX : (int) count;
+	if (syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, wake_count, NULL, NULL, 0) == -1)
+	{
+		LOG_SYSTEM_ERROR(S_FATAL);
+		assert(0);
+	}
+}
@@ -50,7 +50,8 @@ static void *kas_thread_clone_start(void *void_thr)
 	thr->gtid = getpid();
 	thr->tid = gettid();
 	thr->index = atomic_fetch_add_rlx_32(&a_index_counter, 1);
-	PROF_THREAD_NAMED(thread_profiler_id[thr->index]);
+	/* indices keep growing when the task context is re-created */
+	PROF_THREAD_NAMED(thread_profiler_id[thr->index % (sizeof(thread_profiler_id) / sizeof(thread_profiler_id[0]))]);
 	thr->start(thr);
 
 	return NULL;
@@ -187,3 +188,34 @@ u32 kas_thread_self_index(void)
 {
 	return self->index;
 }
+
+u32 kas_thread_self_set_affinity(const u32 logical_core)
+{
+	cpu_set_t cpuset;
+	CPU_ZERO(&cpuset);
+	if (logical_core == U32_MAX)
+	{
+		for (u32 i = 0; i < g_arch_config->logical_core_count; ++i)
+		{
+			if (g_arch_config->topology[i].id < CPU_SETSIZE)
+			{
+				CPU_SET(g_arch_config->topology[i].id, &cpuset);
+			}
+		}
+	}
+	else if (logical_core < g_arch_config->logical_core_count && g_arch_config->topology[logical_core].id < CPU_SETSIZE)
+	{
+		CPU_SET(g_arch_config->topology[logical_core].id, &cpuset);
+	}
+	else
+	{
+		return 0;
+	}
+
+	return pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) == 0;
+}
+
+void kas_thread_yield(void)
+{
+	sched_yield();
+}
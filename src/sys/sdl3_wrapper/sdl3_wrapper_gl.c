@@ -103,6 +103,13 @@ void sdl3_wrapper_gl_functions_init(struct gl_functions *func)
 	func->glBufferData = LOAD_PROC(glBufferData);
 	func->glBufferSubData = LOAD_PROC(glBufferSubData);
 	func->glDeleteBuffers = LOAD_PROC(glDeleteBuffers);
+#if __OS__ != __WEB__
+	func->glMapBufferRange = LOAD_PROC(glMapBufferRange);
+	func->glUnmapBuffer = LOAD_PROC(glUnmapBuffer);
+	func->glFenceSync = LOAD_PROC(glFenceSync);
+	func->glClientWaitSync = LOAD_PROC(glClientWaitSync);
+	func->glDeleteSync = LOAD_PROC(glDeleteSync);
+#endif
 	func->glDrawElements = LOAD_PROC(glDrawElements);
 	func->glDrawArrays = LOAD_PROC(glDrawArrays);
 	func->glDrawArraysInstanced = LOAD_PROC(glDrawArraysInstanced);
@@ -42,6 +42,7 @@ static void kas_arch_config_log(void)
 	log(T_SYSTEM, S_NOTE, "cpu signature - %k", &config.vendor_string);
 	log(T_SYSTEM, S_NOTE, "cpu - %k", &config.processor_string);
 	log(T_SYSTEM, S_NOTE, "logical core count - %u", config.logical_core_count);
+	log(T_SYSTEM, S_NOTE, "physical core count - %u", config.physical_core_count);
 	log(T_SYSTEM, S_NOTE, "cacheline size - %luB", config.cacheline);
 
 	log(T_SYSTEM, S_NOTE, "sse : Supported(%s)", (config.sse) ? yes : no);
@@ -375,11 +376,79 @@ static u32 internal_get_intel_arch_config(struct arena *mem)
 	return 1;
 }
 
+/* replace raw ids (logical core numbers) with dense ids in order of first appearance */
+static u32 kas_arch_topology_densify(u32 *remap, u32 *id, const u32 stride)
+{
+	const u32 count = config.logical_core_count;
+	for (u32 i = 0; i < count; ++i)
+	{
+		remap[i] = U32_MAX;
+	}
+
+	u32 dense_count = 0;
+	for (u32 i = 0; i < count; ++i)
+	{
+		u32 *raw = id + i*stride;
+		if (remap[*raw] == U32_MAX)
+		{
+			remap[*raw] = dense_count++;
+		}
+		*raw = remap[*raw];
+	}
+
+	return dense_count;
+}
+
+static void kas_arch_topology_init(struct arena *mem)
+{
+	const u32 count = config.logical_core_count;
+	config.topology = arena_push(mem, count * sizeof(struct kas_logical_core));
+	for (u32 i = 0; i < count; ++i)
+	{
+		config.topology[i].id = i;
+	}
+
+	u32 known = system_cpu_topology(config.topology, count);
+	for (u32 i = 0; known && i < count; ++i)
+	{
+		known = config.topology[i].core < count && config.topology[i].l2 < count && config.topology[i].l3 < count;
+	}
+
+	if (!known)
+	{
+		log_string(T_SYSTEM, S_WARNING, "Failed to retrieve cpu topology; assuming one physical core per logical core");
+		for (u32 i = 0; i < count; ++i)
+		{
+			config.topology[i].core = i;
+			config.topology[i].l2 = i;
+			config.topology[i].l3 = 0;
+		}
+	}
+
+	arena_push_record(mem);
+	u32 *remap = arena_push(mem, count * sizeof(u32));
+	const u32 stride = sizeof(struct kas_logical_core) / sizeof(u32);
+	config.physical_core_count = kas_arch_topology_densify(remap, &config.topology[0].core, stride);
+	kas_arch_topology_densify(remap, &config.topology[0].l2, stride);
+	kas_arch_topology_densify(remap, &config.topology[0].l3, stride);
+	arena_pop_record(mem);
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		config.topology[i].smt = 0;
+		for (u32 j = 0; j < i; ++j)
+		{
+			config.topology[i].smt += (config.topology[j].core == config.topology[i].core);
+		}
+	}
+}
+
 u32 kas_arch_config_init(struct arena *mem)
 {
 	os_arch_init_func_ptrs();
 
 	config.logical_core_count = system_logical_core_count();
+	kas_arch_topology_init(mem);
 	config.pagesize = system_pagesize(); 
 	config.cacheline = 64; //TODO
 	config.pid = system_pid();
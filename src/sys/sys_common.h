@@ -45,6 +45,16 @@ enum arch_type
 	ARCH_AMD64,
 };
 
+/* topology of a logical core; ids are dense, i.e. in [0, count of the unit), except the os id */
+struct kas_logical_core
+{
+	u32	id;		/* os id of the logical core, used for thread affinity */
+	u32	core;		/* physical core */
+	u32	smt;		/* index among the SMT siblings of the physical core */
+	u32	l2;		/* logical cores sharing an L2 cache share the id */
+	u32	l3;		/* logical cores sharing an L3 cache share the id */
+};
+
 struct kas_arch_config
 {
 	utf8 	vendor_string;
@@ -52,6 +62,8 @@ struct kas_arch_config
 
 	enum arch_type 	type;
 	u32		logical_core_count;
+	u32		physical_core_count;
+	struct kas_logical_core *topology;	/* [logical_core_count] */
 	pid		pid;
 
 	u64		pagesize;	/* bytes */
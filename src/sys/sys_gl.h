@@ -49,6 +49,11 @@ typedef void 		(APIENTRY *type_glBindBuffer)(GLenum, GLuint);
 typedef void 		(APIENTRY *type_glBufferData)(GLenum, GLsizeiptr, const void *, GLenum);
 typedef void 		(APIENTRY *type_glBufferSubData)(GLenum, GLintptr, GLsizeiptr,  const void *);
 typedef void 		(APIENTRY *type_glDeleteBuffers)(GLsizei, const GLuint *);
+typedef void *		(APIENTRY *type_glMapBufferRange)(GLenum, GLintptr, GLsizeiptr, GLbitfield);
+typedef GLboolean	(APIENTRY *type_glUnmapBuffer)(GLenum);
+typedef GLsync		(APIENTRY *type_glFenceSync)(GLenum, GLbitfield);
+typedef GLenum		(APIENTRY *type_glClientWaitSync)(GLsync, GLbitfield, GLuint64);
+typedef void		(APIENTRY *type_glDeleteSync)(GLsync);
 typedef void 		(APIENTRY *type_glGenVertexArrays)(GLsizei, GLuint *);
 typedef void 		(APIENTRY *type_glBindVertexArray)(GLuint array);
 typedef void 		(APIENTRY *type_glDeleteVertexArrays)(GLsizei, const GLuint *arrays);
@@ -140,6 +145,11 @@ struct gl_functions
 	type_glBufferData		glBufferData;
 	type_glBufferSubData		glBufferSubData;
 	type_glDeleteBuffers		glDeleteBuffers;
+	type_glMapBufferRange		glMapBufferRange;	/* not loaded on the web, WebGL2 has no buffer mapping */
+	type_glUnmapBuffer		glUnmapBuffer;		/* not loaded on the web */
+	type_glFenceSync		glFenceSync;		/* not loaded on the web */
+	type_glClientWaitSync		glClientWaitSync;	/* not loaded on the web */
+	type_glDeleteSync		glDeleteSync;		/* not loaded on the web */
 	type_glGenVertexArrays		glGenVertexArrays;
 	type_glBindVertexArray		glBindVertexArray;
 	type_glDeleteVertexArrays	glDeleteVertexArrays;
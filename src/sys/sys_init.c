@@ -20,6 +20,7 @@
 #include "sys_local.h"
 #include "log.h"
 #include "dtoa.h"
+#include "math_batch.h"
 
 static struct kas_sys_env g_sys_env_storage = { 0 };
 struct kas_sys_env *g_sys_env = &g_sys_env_storage;
@@ -51,6 +52,23 @@ void system_resources_init(struct arena *mem)
 		fatal_cleanup_and_exit(0);
 	}
 
+	/* widest batch math kernels supported by both the build and the cpu */
+	enum math_isa isa = MATH_ISA_SCALAR;
+	if (math_isa_compiled(MATH_ISA_SIMD128))
+	{
+		isa = MATH_ISA_SIMD128;
+	}
+	else if (g_arch_config->avx2 && g_arch_config->avx && math_isa_compiled(MATH_ISA_AVX2))
+	{
+		isa = MATH_ISA_AVX2;
+	}
+	else if (g_arch_config->sse4_1 && math_isa_compiled(MATH_ISA_SSE4_1))
+	{
+		isa = MATH_ISA_SSE4_1;
+	}
+	math_batch_init(isa);
+	log(T_SYSTEM, S_NOTE, "batch math kernels: %s", math_isa_cstr[g_math_isa]);
+
 	/* must initalize stuff in multithreaded dtoa/strtod */
 	dmg_dtoa_init(g_arch_config->logical_core_count);
 
@@ -72,11 +90,13 @@ void system_resources_init(struct arena *mem)
 
 	global_thread_block_allocators_alloc(count_256B, count_1MB);
 	system_graphics_init();
-	task_context_init(mem, g_arch_config->logical_core_count);
+	task_context_init(mem, g_arch_config->logical_core_count, TASK_AFFINITY_NONE);
 }
 
 void system_resources_cleanup(void)
 {
+	task_context_log_wait_counters();
+	task_context_log_frame_memory();
 	task_context_destroy(g_task_ctx);
 	system_graphics_destroy();
 	global_thread_block_allocators_free();
@@ -36,6 +36,9 @@ extern void 	(*kas_cpuid)(u32 *eax, u32 *ebx, u32 *ecx, u32 *edx, const u32 func
 extern void 	(*kas_cpuid_ex)(u32 *eax, u32 *ebx, u32 *ecx, u32 *edx, const u32 function, const u32 subfunction);
 /* return logical core count  */
 extern u32  	(*system_logical_core_count)(void);
+/* fill topology[logical_core_count] with ids of the first logical core sharing the core/L2/L3 (smt is not set),
+ * returns 1 on success, 0 if the topology is unknown. */
+extern u32	(*system_cpu_topology)(struct kas_logical_core *topology, const u32 logical_core_count);
 /* return system pagesize */
 extern u64	(*system_pagesize)(void);
 extern pid	(*system_pid)(void);
@@ -47,6 +47,13 @@
 void *	virtual_memory_reserve(const u64 size);
 /* free reserved virtual memory */
 void 	virtual_memory_release(void *addr, const u64 size);
+/* returns reserved page aligned address space on success, NULL on failure. Nothing is committed; pages must be 
+ * committed using virtual_memory_commit before use, and the address space is freed using virtual_memory_release. */
+void *	virtual_memory_reserve_uncommitted(const u64 size);
+/* commit page aligned range of reserved address space; returns 1 on success, 0 on failure. */
+u32	virtual_memory_commit(void *addr, const u64 size);
+/* return the memory of a page aligned committed range to the system; the range stays reserved. */
+void	virtual_memory_decommit(void *addr, const u64 size);
 
 /************************************************************************/
 /* 				System Environment			*/
@@ -386,8 +393,20 @@ tid	kas_thread_tid(const kas_thread *thr);
 tid 	kas_thread_self_tid(void);
 /* return index of thread (each created thread increments the global index counter) */
 u32	kas_thread_index(const kas_thread *thr);
+/* pin calling thread to the given logical core, or let it run on any core if logical_core == U32_MAX. 
+ * returns 1 on success, 0 otherwise. */
+u32	kas_thread_self_set_affinity(const u32 logical_core);
 /* return index of caller */ 
 u32	kas_thread_self_index(void);
+/* give up the rest of the caller's time slice */
+void	kas_thread_yield(void);
+
+/* spin-wait hint; lets the sibling hyperthread run and saves power while busy waiting */
+#if (__COMPILER__ == __EMSCRIPTEN__)
+	#define kas_cpu_relax()
+#else
+	#define kas_cpu_relax()	_mm_pause()
+#endif
 
 /* Initiate the semaphore with a given value; NOTE: initiating an already initiated semphore is UB */
 void 	semaphore_init(semaphore *sem, const u32 val); 
@@ -400,11 +419,16 @@ u32 	semaphore_wait(semaphore *sem);
 /* return 1 on successful lock aquisition, 0 otherwise. */
 u32 	semaphore_trywait(semaphore *sem);	
 
+/* block while *addr == expected, or until woken up; spurious wake ups may happen */
+void	futex_wait(u32 *addr, const u32 expected);
+/* wake up at most count threads blocked in futex_wait on addr */
+void	futex_wake(u32 *addr, const u32 count);
+
 /************************************************************************/
 /* 			       Task System				*/
 /************************************************************************/
 
-#include "fifo_spmc.h"
+#include "deque_ws.h"
 
 /* NOTE: WE ASSUME MASTER THREAD/WORKER HAS ID AND INDEX 0. */
 
@@ -412,21 +436,65 @@ extern struct task_context *g_task_ctx;
 
 typedef void (*TASK)(void *);
 
+/*
+ * Every worker owns a work-stealing deque. Tasks are pushed onto the deque of the thread that creates them,
+ * so any task may spawn and wait on sub-tasks. An idle worker first pops its own deque (newest first), then
+ * steals the oldest task of randomly chosen victims. Failing that, it backs off: it spins with a pause hint for
+ * spin_rounds rounds, yields for yield_rounds rounds, and finally parks on a futex until new work is pushed.
+ *
+ * Waiting on a stream or bundle never blocks; the waiting thread keeps running available tasks until the
+ * batch completes (help-while-waiting). Thus, a task that waits may run unrelated tasks on the same worker,
+ * and those may leave their outputs on top of mem_frame. A task must therefore not pop mem_frame, by record
+ * or packed pop, past a wait. Memory that is only needed up to the end of the task, such as the stream or
+ * bundle of a fork/join, goes in mem_scratch instead: every task pops all of its mem_scratch allocations before
+ * returning, so the arena stays LIFO and records may span waits.
+ */
 struct worker
 {
 	//TODO Cacheline alignment 
-	struct arena	mem_frame;		/* Cleared at start of every frame */	
+	struct arena	mem_frame;		/* Cleared at start of every frame, growable */	
+	struct arena	mem_scratch;		/* Task scoped, emptied by every task before it returns, growable */
+	struct deque_ws *tasks;			/* tasks spawned on this worker, popped by owner, stolen by others */
 	kas_thread *	thr;
+	u64		steal_state;		/* xorshift state for choosing victims */
+	u32		index;
+	u32		logical_core;		/* pinned logical core, or U32_MAX */
+	u32		neighbour_first;	/* workers [neighbour_first, neighbour_first + neighbour_count) share */
+	u32		neighbour_count;	/* an L3 cache with this worker and are preferred as victims */
+	u64		a_ns_spin;		/* time spent spinning or yielding without work */
+	u64		a_ns_park;		/* time spent parked */
+	u64		a_park_count;
+	u64		a_mem_frame_high_water;	/* most mem_frame memory in use during the last flushed frame */
+	u64		a_mem_frame_peak;	/* most mem_frame memory in use during any frame */
 	u32 		a_mem_frame_clear;	/* atomic sync-point: if set, on next task run flush mem_frame. */
+#ifdef KAS_TASK_TIMELINE
+	struct task_timeline *timeline;		/* recent events of the worker, written by the worker only */
+#endif
 };
 
-/* Task bundle: set of tasks commited at the same time. */
+/* 
+ * Task bundle: set of tasks commited at the same time. Bundles are allocated in the caller's task lifetime
+ * memory, so any number of bundles may be in flight. A bundle may depend on other bundles, in which case its
+ * tasks are published by whichever thread completes its last dependency. Bundles with dependencies form a task
+ * graph; waiting is only needed on the bundles whose results the caller consumes.
+ */
 struct task_bundle 
 {
-	semaphore 	bundle_completed;
 	struct task *	tasks;
 	u32 		task_count;
-	u32 		a_tasks_left;
+	u32 		a_tasks_left;		/* unfinished tasks + 1 until the bundle's tasks are published, 
+						   + 1 for every completing dependency still notifying us */
+	u32 		a_dependencies_left;	/* unfinished dependencies + 1 until the bundle is submitted */
+	u32 		a_completed;		/* set once every task has run and dependents have been notified */
+	u64 		a_dependents;		/* (struct task_bundle_link *) list of bundles to notify on completion */
+};
+
+#define TASK_BUNDLE_LINK_CLOSED	((u64) 1)	/* a_dependents of a completed bundle */
+
+struct task_bundle_link
+{
+	struct task_bundle_link *	next;
+	struct task_bundle *		bundle;
 };
 
 struct task_range 
@@ -458,54 +526,161 @@ struct task
 					 * */
 };
 
+/*
+ * Worker placement. Pinned workers are ordered by their L3, L2 and physical core, so workers with adjacent
+ * indices share caches. Tasks split from the same range are spawned on one worker, and thieves try their
+ * cache neighbours first, so neighbouring tasks (e.g. adjacent island ranges) tend to stay within an L3.
+ */
+enum task_affinity
+{
+	TASK_AFFINITY_NONE,		/* workers run on any core */
+	TASK_AFFINITY_LOGICAL,		/* one pinned worker per logical core */
+	TASK_AFFINITY_PHYSICAL,		/* one pinned worker per physical core; SMT siblings are left idle */
+};
+
 /* TODO Beware: Make sure to not false-share data between threads here, pad any structs if needed. */
 struct task_context
 {
-	struct task_bundle bundle; /* TODO: Temporary */
-	struct fifo_spmc *tasks;
 	struct worker *workers;
+	u32 a_wake_epoch;		/* futex word idle workers park on, bumped on every wake up */
+	u32 a_parked;			/* workers parked or about to park */
 	u32 worker_count;
+	u32 spin_rounds;		/* failed rounds an idle worker spins before yielding */
+	u32 yield_rounds;		/* failed rounds an idle worker yields before parking */
+	enum task_affinity affinity;
 };
 
-/* Init task_context, setup threads inside task_main */
-void 	task_context_init(struct arena *mem_persistent, const u32 thread_count);
+/* Init task_context with at most thread_count workers placed according to affinity, setup threads inside task_main */
+void 	task_context_init(struct arena *mem_persistent, const u32 thread_count, const enum task_affinity affinity);
 /* Destory resources */
 void 	task_context_destroy(struct task_context *ctx);
-/* Clear any frame resources held by the task context and it's workers */
+/* Clear any frame resources held by the task context and it's workers; ignored unless called by the master thread */
 void	task_context_frame_clear(void);
+/* Set the back off policy of idle workers; waiters never park, they keep yielding after the spin rounds */
+void	task_context_set_wait_policy(const u32 spin_rounds, const u32 yield_rounds);
+/* Log the spin and park counters of every worker */
+void	task_context_log_wait_counters(void);
+/* Log the frame memory high-water marks of every worker */
+void	task_context_log_frame_memory(void);
 /* main loop for slave workers */
 void  	task_main(kas_thread *thr);
 /* master worker runs any available work */
 void 	task_main_master_run_available_jobs(void);
+/* 
+ * Make the calling thread the master thread, i.e. the owner of worker 0, taking over its pinned core. Only one
+ * thread may own the master worker at a time; the previous owner must have released it, and the hand over must
+ * be synchronized by the caller. 
+ */
+void	task_context_master_acquire(void);
+/* Release the master worker; the calling thread may not dispatch tasks until it acquires the master again */
+void	task_context_master_release(void);
+/* return the worker of the calling thread */
+struct worker *	task_worker_self(void);
 
 /*********************** Task Streams ***********************/ 
 
 /*
  * Simple lock-free data structure for continuously dispatching and keeping track of work. Every task dispatched
- * using api will increment a_completed on completion. 
+ * using api will increment a_completed on completion. A stream may be used from within a task to fork
+ * sub-tasks and join on them.
  */
 struct task_stream
 {
 	u32 a_completed;	/* atomic completed tasks counter */
-	u32 task_count;		/* owned by main-thread 	  */
+	u32 task_count;		/* owned by the dispatching thread */
 };
 
 /* acquire resources (if any) */
 struct task_stream *	task_stream_init(struct arena *mem);
-/* Dispatch task for workers to immediately pick up */
+/* Dispatch task onto the calling worker's deque for workers to immediately pick up */
 void 			task_stream_dispatch(struct arena *mem, struct task_stream *stream, TASK func, void *args);
-/* spin inside method until  a_completed == total */
+/* run available tasks, backing off when there are none, until a_completed == total */
 void			task_stream_spin_wait(struct task_stream *stream);	
 /* cleanup resources (if any) */
 void			task_stream_cleanup(struct task_stream *stream);
 
 /*********************** Task Bundles ***********************/ 
 
-/* Split input range into split_count iterable intervals. task is then run iterably, and TODO: what do we return? */
+/* Split input range into split_count iterable intervals and submit them. Returns NULL if input_count == 0. */
 struct task_bundle *	task_bundle_split_range(struct arena *mem_task_lifetime, TASK task, const u32 split_count, void *inputs, const u64 input_count, const u64 input_element_size, void *shared_arguments);
-/* Blocked wait on bundle complete */
+/* same as task_bundle_split_range, but the bundle is not submitted; an empty range gives a bundle without tasks */
+struct task_bundle *	task_bundle_alloc_range(struct arena *mem_task_lifetime, TASK task, const u32 split_count, void *inputs, const u64 input_count, const u64 input_element_size, void *shared_arguments);
+/* allocate an unsubmitted bundle consisting of a single task */
+struct task_bundle *	task_bundle_alloc_task(struct arena *mem_task_lifetime, TASK task, void *input);
+/* bundle may not start before dependency completes. Must be called before bundle is submitted, and the link
+ * allocated in mem_task_lifetime must live until bundle completes. */
+void			task_bundle_depend(struct arena *mem_task_lifetime, struct task_bundle *bundle, struct task_bundle *dependency);
+/* submit bundle; its tasks are published once every dependency has completed */
+void			task_bundle_submit(struct task_bundle *bundle);
+/* submit a single task that runs once bundle completes, and return its bundle */
+struct task_bundle *	task_bundle_continuation(struct arena *mem_task_lifetime, struct task_bundle *bundle, TASK task, void *input);
+/* run available tasks, backing off when there are none, until the bundle completes */
 void			task_bundle_wait(struct task_bundle *bundle);
-/* Clear and release task bundle for reallocation */
+/* Release completed task bundle, its memory is owned by mem_task_lifetime */
 void			task_bundle_release(struct task_bundle *bundle);
 
+/*
+ * Task timeline: with KAS_TASK_TIMELINE defined, every worker records its task runs, waits, parks and profiler
+ * zones into a lock-free ring of the last TIMELINE_EVENT_COUNT events. Events are stamped with rdtsc and are
+ * converted using time_ns_from_tsc when read. The master worker marks the start of each frame in
+ * task_context_frame_clear. Without KAS_TASK_TIMELINE, the recording macros compile to nothing.
+ */
+#ifdef KAS_TASK_TIMELINE
+
+#define TIMELINE_EVENT_COUNT	8192	/* power of two */
+
+enum timeline_event_type
+{
+	TIMELINE_FRAME,		/* start of frame */
+	TIMELINE_TASK_BEGIN,	/* arg: index of the worker whose deque the task was taken from */
+	TIMELINE_TASK_END,
+	TIMELINE_WAIT_BEGIN,	/* help-while-waiting on a bundle or stream */
+	TIMELINE_WAIT_END,
+	TIMELINE_PARK_BEGIN,
+	TIMELINE_PARK_END,
+	TIMELINE_ZONE_BEGIN,	/* name: profiler zone name */
+	TIMELINE_ZONE_END,	/* arg: index of the matching TIMELINE_ZONE_BEGIN (low 32 bits) */
+};
+
+struct timeline_event
+{
+	u64		tsc;
+	const char *	name;
+	u32		type;
+	u32		arg;
+};
+
+/* 
+ * ring slot of an event; a_seq is 2*index + 1 while event index is being written and 2*index + 2 once it is
+ * published, so readers can discard slots that were overwritten during the copy.
+ */
+struct timeline_slot
+{
+	u64	a_seq;
+	u64	a_tsc;
+	u64	a_name;
+	u32	a_type;
+	u32	a_arg;
+};
+
+struct task_timeline
+{
+	u64			a_head;		/* number of events ever recorded */
+	struct timeline_slot	slot[TIMELINE_EVENT_COUNT];
+};
+
+/* record an event on the calling worker's timeline; ignored on threads that are not task workers */
+void	task_timeline_record(const enum timeline_event_type type, const char *name, const u32 arg);
+/* copy the recorded events of a worker, oldest first, into event[TIMELINE_EVENT_COUNT]; returns the event count.
+ * Events overwritten during the copy are dropped, so every copied event is intact. */
+u32	task_timeline_copy(struct timeline_event *event, const u32 worker);
+
+#define TASK_TIMELINE_RECORD(type, name, arg)	task_timeline_record(type, name, arg)
+
+#else
+
+#define TASK_TIMELINE_RECORD(type, name, arg)
+
+#endif
+
 #endif
@@ -24,11 +24,76 @@
 struct task_context t_ctx;
 struct task_context *g_task_ctx = &t_ctx;
 
+kas_thread_local struct worker *tl_worker = NULL;
+
 u32 a_startup_complete = 0;
 
-static void worker_init(struct worker *w)
+#define TASK_MAX_COUNT		1024	/* per worker deque */
+#define TASK_SPIN_ROUNDS	64	/* default failed rounds over all victims an idle worker spins before yielding */
+#define TASK_YIELD_ROUNDS	16	/* default failed rounds an idle worker yields before parking */
+#define TASK_STACK_SIZE		(64*1024)
+#if __OS__ == __WEB__
+#define TASK_FRAME_RESERVE	((u64) 16*1024*1024)		/* wasm reservations are committed at once */
+#define TASK_SCRATCH_RESERVE	((u64) 4*1024*1024)
+#else
+#define TASK_FRAME_RESERVE	((u64) 4*1024*1024*1024)	/* frame arena address space per worker */
+#define TASK_SCRATCH_RESERVE	((u64) 256*1024*1024)		/* scratch arena address space per worker */
+#endif
+
+/* worker deques outlive task contexts, so that reinitialising a context does not grow mem_persistent */
+static struct deque_ws **	worker_deque = NULL;
+static u32			worker_deque_count = 0;
+
+static struct deque_ws *worker_deque_get(const u32 index)
+{
+	if (index >= worker_deque_count)
+	{
+		struct deque_ws **deque = realloc(worker_deque, (index + 1) * sizeof(struct deque_ws *));
+		if (!deque)
+		{
+			log_string(T_SYSTEM, S_FATAL, "Failed to allocate task worker deques");
+			fatal_cleanup_and_exit(kas_thread_self_tid());
+		}
+		worker_deque = deque;
+
+		for (; worker_deque_count <= index; ++worker_deque_count)
+		{
+			worker_deque[worker_deque_count] = deque_ws_init(NULL, TASK_MAX_COUNT);
+			if (!worker_deque[worker_deque_count])
+			{
+				log_string(T_SYSTEM, S_FATAL, "Failed to allocate task worker deques");
+				fatal_cleanup_and_exit(kas_thread_self_tid());
+			}
+		}
+	}
+
+	/* the previous context drained every deque before its workers exited */
+	kas_assert(deque_ws_count(worker_deque[index]) == 0);
+	return worker_deque[index];
+}
+
+static void worker_init(struct arena *mem_persistent, struct worker *w, const u32 index, const u32 logical_core)
 {
-	w->mem_frame = arena_alloc_1MB();
+	w->mem_frame = arena_alloc_growable(TASK_FRAME_RESERVE);
+	if (!w->mem_frame.stack_ptr)
+	{
+		log_string(T_SYSTEM, S_FATAL, "Failed to reserve task worker frame memory");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+	w->mem_scratch = arena_alloc_growable(TASK_SCRATCH_RESERVE);
+	if (!w->mem_scratch.stack_ptr)
+	{
+		log_string(T_SYSTEM, S_FATAL, "Failed to reserve task worker scratch memory");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+	w->tasks = worker_deque_get(index);
+	w->index = index;
+	w->logical_core = logical_core;
+	w->steal_state = 0x9e3779b97f4a7c15ull * (index + 1);
+#ifdef KAS_TASK_TIMELINE
+	w->timeline = arena_push(mem_persistent, sizeof(struct task_timeline));
+	atomic_store_rel_64(&w->timeline->a_head, 0);
+#endif
 }
 
 static void worker_exit(void *void_task)
@@ -37,29 +102,40 @@ static void worker_exit(void *void_task)
 	kas_thread_exit(task->executor->thr);
 }
 
-static void task_run(struct task *task_info, struct worker *w)
+static void task_bundle_complete(struct task_bundle *bundle);
+
+/* victim is the index of the worker whose deque the task was taken from */
+static void task_run(struct task *task_info, struct worker *w, const u32 victim)
 {
 	if (atomic_load_acq_32(&w->a_mem_frame_clear))
 	{
+		const u64 high_water = arena_high_water(&w->mem_frame);
+		atomic_store_rlx_64(&w->a_mem_frame_high_water, high_water);
+		if (high_water > atomic_load_rlx_64(&w->a_mem_frame_peak))
+		{
+			atomic_store_rlx_64(&w->a_mem_frame_peak, high_water);
+		}
 		arena_flush(&w->mem_frame);
 		atomic_store_rel_32(&w->a_mem_frame_clear, 0);
 	}
 
 	task_info->executor = w;
+#ifdef KAS_ASSERT_DEBUG
+	const u8 *scratch = w->mem_scratch.stack_ptr;
+#endif
+	TASK_TIMELINE_RECORD(TIMELINE_TASK_BEGIN, NULL, victim);
 	task_info->task(task_info);
+	TASK_TIMELINE_RECORD(TIMELINE_TASK_END, NULL, victim);
+	kas_assert_string(w->mem_scratch.stack_ptr == scratch, "task returned without popping its mem_scratch allocations");
 
 	switch (task_info->batch_type)
 	{
 		case TASK_BATCH_BUNDLE:
 		{
-			/* ThreadSanitizer screams if we use anything less than ACQ_REL or SEQ_CST. Can the sanitizer not
-			 * assume that the compiler won't reorder the native semaphore calls? 
-			 * TODO: Investigate more.
-			 */
 			struct task_bundle *bundle = task_info->batch;
 			if (atomic_sub_fetch_seq_cst_32(&bundle->a_tasks_left, 1) == 0)
 			{
-				semaphore_post(&bundle->bundle_completed);
+				task_bundle_complete(bundle);
 			}
 		} break;
 
@@ -71,6 +147,122 @@ static void task_run(struct task *task_info, struct worker *w)
 	}
 }
 
+/* try to steal once from every other worker in [first, first + count) starting at a random victim */
+static struct task *task_steal(struct worker *w, u32 *victim_stolen, const u32 first, const u32 count)
+{
+	w->steal_state ^= w->steal_state << 13;
+	w->steal_state ^= w->steal_state >> 7;
+	w->steal_state ^= w->steal_state << 17;
+	u32 victim = first + (u32) (w->steal_state % count);
+	for (u32 i = 0; i < count; ++i)
+	{
+		if (victim != w->index)
+		{
+			struct task *task = deque_ws_steal(g_task_ctx->workers[victim].tasks);
+			if (task)
+			{
+				*victim_stolen = victim;
+				return task;
+			}
+		}
+		victim = (victim + 1 == first + count) ? first : victim + 1;
+	}
+
+	return NULL;
+}
+
+/* pop own deque, otherwise steal from the workers sharing our L3, and finally from anyone. victim is set to the
+ * index of the worker the task was taken from. */
+static struct task *task_find(struct worker *w, u32 *victim)
+{
+	*victim = w->index;
+	struct task *task = deque_ws_pop(w->tasks);
+	if (!task && 1 < w->neighbour_count && w->neighbour_count < g_task_ctx->worker_count)
+	{
+		task = task_steal(w, victim, w->neighbour_first, w->neighbour_count);
+	}
+
+	return (task) ? task : task_steal(w, victim, 0, g_task_ctx->worker_count);
+}
+
+/* wake up at most count parked workers, if any */
+static void task_wake(const u32 count)
+{
+	/* 
+	 * RMW instead of a load; the pushes must be visible before we look at a_parked, or we could miss a
+	 * worker that is just about to park.
+	 */
+	if (atomic_fetch_add_seq_cst_32(&g_task_ctx->a_parked, 0))
+	{
+		atomic_fetch_add_seq_cst_32(&g_task_ctx->a_wake_epoch, 1);
+		futex_wake(&g_task_ctx->a_wake_epoch, count);
+	}
+}
+
+/* push task onto the calling worker's deque without waking anyone, returns 0 if the task was run inline */
+static u32 task_push_no_wake(struct task *task)
+{
+	struct worker *w = tl_worker;
+	kas_assert_string(w, "task pushed from a thread that is not a task worker");
+	if (deque_ws_try_push(w->tasks, task))
+	{
+		return 1;
+	}
+
+	/* deque full, run the task inline */
+	task_run(task, w, w->index);
+	return 0;
+}
+
+static void task_push(struct task *task)
+{
+	if (task_push_no_wake(task))
+	{
+		task_wake(1);
+	}
+}
+
+/* 
+ * back off after a failed round of looking for work: pause while round < spin_rounds, then yield. Returns 1
+ * once the yield rounds are spent as well; idle workers park at that point, waiters keep yielding.
+ */
+static u32 task_backoff(const u32 round)
+{
+	if (round < g_task_ctx->spin_rounds)
+	{
+		kas_cpu_relax();
+		return 0;
+	}
+
+	kas_thread_yield();
+	return round + 1 >= g_task_ctx->spin_rounds + g_task_ctx->yield_rounds;
+}
+
+static void task_park(struct worker *w)
+{
+	atomic_fetch_add_seq_cst_32(&g_task_ctx->a_parked, 1);
+	const u32 epoch = atomic_load_seq_cst_32(&g_task_ctx->a_wake_epoch);
+
+	/* work pushed before our announcement must be found here, work pushed after bumps the epoch */
+	u32 victim;
+	struct task *task = task_find(w, &victim);
+	if (!task)
+	{
+		const u64 ns_park_start = time_ns();
+		TASK_TIMELINE_RECORD(TIMELINE_PARK_BEGIN, NULL, 0);
+		futex_wait(&g_task_ctx->a_wake_epoch, epoch);
+		TASK_TIMELINE_RECORD(TIMELINE_PARK_END, NULL, 0);
+		atomic_fetch_add_rlx_64(&w->a_ns_park, time_ns() - ns_park_start);
+		atomic_fetch_add_rlx_64(&w->a_park_count, 1);
+	}
+	atomic_fetch_sub_seq_cst_32(&g_task_ctx->a_parked, 1);
+
+	if (task)
+	{
+		task_run(task, w, victim);
+	}
+}
+
 void task_main(kas_thread *thr)
 {
 	struct worker *w = kas_thread_args(thr);
@@ -79,74 +271,159 @@ void task_main(kas_thread *thr)
 	while (atomic_load_acq_32(&a_startup_complete) == 0);
 
 	w->thr = thr;
+	tl_worker = w;
+	if (w->logical_core != U32_MAX && !kas_thread_self_set_affinity(w->logical_core))
+	{
+		log(T_SYSTEM, S_WARNING, "Failed to pin task worker %u to logical core %u", w->index, w->logical_core);
+	}
 	atomic_fetch_add_seq_cst_32(&a_startup_complete, 1);
 	log_string(T_SYSTEM, S_NOTE, "task_worker setup finalized");
 
+	/* If there is work, we plow through it continuously */
+	u32 round = 0;
+	u64 ns_idle_start = 0;
+	u32 victim;
 	while (1)
 	{
-		/* If there is work, we plow through it continuously */
-		while (semaphore_trywait(&g_task_ctx->tasks->able_for_reservation))
+		struct task *task = task_find(w, &victim);
+		if (task)
 		{
-			task_run(fifo_spmc_pop(g_task_ctx->tasks), w);
+			if (round)
+			{
+				atomic_fetch_add_rlx_64(&w->a_ns_spin, time_ns() - ns_idle_start);
+				round = 0;
+			}
+			task_run(task, w, victim);
 		}
+		else
+		{
+			if (round == 0)
+			{
+				ns_idle_start = time_ns();
+			}
 
-		/* No more work, we go to sleep and wait until we aquire new work.
-		 * Spurious wake ups may happen, so we keep this in a loop.
-		 */
-		while (!semaphore_wait(&g_task_ctx->tasks->able_for_reservation));
+			if (task_backoff(round++))
+			{
+				/* No more work, we park and wait until new work is pushed. */
+				atomic_fetch_add_rlx_64(&w->a_ns_spin, time_ns() - ns_idle_start);
+				round = 0;
+				task_park(w);
+			}
+		}
+	}
+}
 
-		task_run(fifo_spmc_pop(g_task_ctx->tasks), w);
-	};
+struct worker *task_worker_self(void)
+{
+	return tl_worker;
 }
 
 void task_main_master_run_available_jobs(void)
 {
 	struct worker *master = g_task_ctx->workers + 0;
-	while (semaphore_trywait(&g_task_ctx->tasks->able_for_reservation))
+	kas_assert_string(tl_worker == master, "master jobs run from a thread not owning the master worker");
+	struct task *task;
+	u32 victim;
+	while ((task = task_find(master, &victim)))
 	{
-		task_run(fifo_spmc_pop(g_task_ctx->tasks), master);
+		task_run(task, master, victim);
 	}
 }
 
-static struct task_bundle task_bundle_init()
+/* sort key (L3, L2, physical core, SMT sibling) of a logical core */
+static u64 task_placement_key(const u32 logical_core)
 {
-	struct task_bundle bundle = { 0 };
-	semaphore_init(&bundle.bundle_completed, 0);
-	return bundle;
+	const struct kas_logical_core *lc = g_arch_config->topology + logical_core;
+	return ((u64) lc->l3 << 48) | ((u64) lc->l2 << 32) | ((u64) lc->core << 16) | (u64) lc->smt;
 }
 
-static void task_bundle_destroy(struct task_bundle *bundle)
+/* fill order with the logical cores to pin workers on, sorted so that adjacent cores share caches. returns count */
+static u32 task_placement_order(u32 *order, const enum task_affinity affinity)
 {
-	semaphore_destroy(&bundle->bundle_completed);
+	u32 count = 0;
+	for (u32 i = 0; i < g_arch_config->logical_core_count; ++i)
+	{
+		if (affinity == TASK_AFFINITY_PHYSICAL && g_arch_config->topology[i].smt != 0)
+		{
+			continue;
+		}
+
+		const u64 key = task_placement_key(i);
+		u32 j = count++;
+		for (; j > 0 && key < task_placement_key(order[j-1]); --j)
+		{
+			order[j] = order[j-1];
+		}
+		order[j] = i;
+	}
+
+	return count;
 }
 
-void task_context_init(struct arena *mem_persistent, const u32 thread_count)
+void task_context_init(struct arena *mem_persistent, const u32 thread_count, const enum task_affinity affinity)
 {
-	//TODO 
-	const u64 stack_size = 64*1024;
-	#define TASK_MAX_COUNT 1024
+	u32 worker_count = thread_count;
+	u32 *order = NULL;
+	if (affinity != TASK_AFFINITY_NONE)
+	{
+		order = arena_push(mem_persistent, g_arch_config->logical_core_count * sizeof(u32));
+		const u32 core_count = task_placement_order(order, affinity);
+		worker_count = (core_count < thread_count) ? core_count : thread_count;
+	}
+	else if (g_task_ctx->affinity != TASK_AFFINITY_NONE)
+	{
+		/* the main thread was pinned by the previous context */
+		kas_thread_self_set_affinity(U32_MAX);
+	}
+
 	struct task_context ctx = 
 	{ 
 		.workers = NULL,
-		.worker_count = thread_count,
+		.worker_count = worker_count,
+		.spin_rounds = TASK_SPIN_ROUNDS,
+		.yield_rounds = TASK_YIELD_ROUNDS,
+		.affinity = affinity,
 	};
 
-	log(T_SYSTEM, S_NOTE, "Task system worker count: %u", thread_count);
+	log(T_SYSTEM, S_NOTE, "Task system worker count: %u", worker_count);
 
 	*g_task_ctx = ctx;
-	g_task_ctx->bundle = task_bundle_init();
-	g_task_ctx->workers = arena_push(mem_persistent, thread_count * sizeof(struct worker));	
-	g_task_ctx->tasks = fifo_spmc_init(mem_persistent, TASK_MAX_COUNT);
+	g_task_ctx->workers = arena_push_zero(mem_persistent, worker_count * sizeof(struct worker));	
+	atomic_store_rel_32(&g_task_ctx->a_wake_epoch, 0);
+	atomic_store_rel_32(&g_task_ctx->a_parked, 0);
+
+	for (u32 i = 0; i < worker_count; ++i)
+	{
+		worker_init(mem_persistent, g_task_ctx->workers + i, i, (order) ? order[i] : U32_MAX);
+	}
 
-	for (u32 i = 0; i < thread_count; ++i)
+	/* neighbours are the contiguous run of workers pinned to cores sharing our L3; unpinned workers share all */
+	for (u32 i = 0; i < worker_count; ++i)
 	{
-		worker_init(g_task_ctx->workers + i);
+		struct worker *w = g_task_ctx->workers + i;
+		w->neighbour_first = (order && i > 0 && g_arch_config->topology[order[i]].l3 == g_arch_config->topology[order[i-1]].l3)
+			? g_task_ctx->workers[i-1].neighbour_first
+			: (order) ? i : 0;
+	}
+
+	for (u32 i = worker_count; i > 0; --i)
+	{
+		struct worker *w = g_task_ctx->workers + i - 1;
+		w->neighbour_count = (i < worker_count && g_task_ctx->workers[i].neighbour_first == w->neighbour_first)
+			? g_task_ctx->workers[i].neighbour_count
+			: i - w->neighbour_first;
 	}
 
 	/* NOTE: worker 0: reserved for main thread */
-	for (u32 i = 1; i < thread_count; ++i)
+	tl_worker = g_task_ctx->workers + 0;
+	if (order && !kas_thread_self_set_affinity(order[0]))
+	{
+		log(T_SYSTEM, S_WARNING, "Failed to pin main thread to logical core %u", order[0]);
+	}
+
+	for (u32 i = 1; i < worker_count; ++i)
 	{
-		kas_thread_clone(mem_persistent, task_main, g_task_ctx->workers + i, stack_size);
+		kas_thread_clone(mem_persistent, task_main, g_task_ctx->workers + i, TASK_STACK_SIZE);
 	}
 
 	atomic_store_rel_32(&a_startup_complete, 1);
@@ -154,22 +431,84 @@ void task_context_init(struct arena *mem_persistent, const u32 thread_count)
 	while ((u32) atomic_load_seq_cst_32(&a_startup_complete) < g_task_ctx->worker_count);
 }
 
+void task_context_master_acquire(void)
+{
+	struct worker *master = g_task_ctx->workers + 0;
+	kas_assert(tl_worker == NULL);
+	tl_worker = master;
+	if (master->logical_core != U32_MAX && !kas_thread_self_set_affinity(master->logical_core))
+	{
+		log(T_SYSTEM, S_WARNING, "Failed to pin master thread to logical core %u", master->logical_core);
+	}
+}
+
+void task_context_master_release(void)
+{
+	struct worker *master = g_task_ctx->workers + 0;
+	kas_assert(tl_worker == master);
+	tl_worker = NULL;
+	if (master->logical_core != U32_MAX)
+	{
+		kas_thread_self_set_affinity(U32_MAX);
+	}
+}
+
 void task_context_frame_clear(void)
 {
+	/* frame boundaries belong to the master thread; worker frames are in use while it is in the middle of one */
+	if (tl_worker != g_task_ctx->workers + 0)
+	{
+		return;
+	}
+
+	TASK_TIMELINE_RECORD(TIMELINE_FRAME, NULL, 0);
 	for (u32 i = 0; i < g_task_ctx->worker_count; ++i)
 	{
 		atomic_store_rel_32(&g_task_ctx->workers[i].a_mem_frame_clear, 1);
 	}
 }
 
+void task_context_set_wait_policy(const u32 spin_rounds, const u32 yield_rounds)
+{
+	/* plain stores; workers pick up the new policy at their own pace */
+	g_task_ctx->spin_rounds = spin_rounds;
+	g_task_ctx->yield_rounds = yield_rounds;
+}
+
+void task_context_log_wait_counters(void)
+{
+	for (u32 i = 0; i < g_task_ctx->worker_count; ++i)
+	{
+		struct worker *w = g_task_ctx->workers + i;
+		log(T_SYSTEM, S_NOTE, "task worker %u - spin: %lums, parked: %lums (%lu times)", 
+				i, 
+				atomic_load_rlx_64(&w->a_ns_spin) / 1000000, 
+				atomic_load_rlx_64(&w->a_ns_park) / 1000000, 
+				atomic_load_rlx_64(&w->a_park_count));
+	}
+}
+
+void task_context_log_frame_memory(void)
+{
+	for (u32 i = 0; i < g_task_ctx->worker_count; ++i)
+	{
+		struct worker *w = g_task_ctx->workers + i;
+		log(T_SYSTEM, S_NOTE, "task worker %u - frame memory peak: %luKB, last frame: %luKB", 
+				i, 
+				atomic_load_rlx_64(&w->a_mem_frame_peak) / 1024, 
+				atomic_load_rlx_64(&w->a_mem_frame_high_water) / 1024);
+	}
+}
+
 void task_context_destroy(struct task_context *ctx)
 {
 	struct task *exit_tasks = malloc(ctx->worker_count * sizeof(struct task));
 
+	/* each worker exits inside the first exit task it runs, so every worker picks up exactly one */
 	for (u32 i = 1; i < ctx->worker_count; ++i)
 	{
 		exit_tasks[i].task = &worker_exit;
-		fifo_spmc_push(ctx->tasks, exit_tasks + i);
+		task_push(exit_tasks + i);
 	}
 
 	for (u32 i = 1; i < ctx->worker_count; ++i)
@@ -180,26 +519,91 @@ void task_context_destroy(struct task_context *ctx)
 
 	for (u32 i = 0; i < ctx->worker_count; ++i)
 	{
-		arena_free_1MB(&ctx->workers[i].mem_frame);
+		arena_free(&ctx->workers[i].mem_frame);
+		arena_free(&ctx->workers[i].mem_scratch);
 	}
 
-	
-	task_bundle_destroy(&ctx->bundle);
-	fifo_spmc_destroy(ctx->tasks);
 	free(exit_tasks);
+	atomic_store_rel_32(&a_startup_complete, 0);
 }
 
-struct task_bundle *task_bundle_split_range(struct arena *mem_task_lifetime, TASK task, const u32 split_count, void *inputs, const u64 input_count, const u64 input_element_size, void *shared_arguments)
+/* every dependency has completed, publish the bundle's tasks */
+static void task_bundle_start(struct task_bundle *bundle)
+{
+	/* Sync points, we release the deque entry, thieves aquire it => threads will see all previous writes */
+	u32 pushed = 0;
+	for (u32 i = 0; i < bundle->task_count; ++i)
+	{
+		pushed += task_push_no_wake(bundle->tasks + i);
+	}
+
+	/* one batched wake up for the whole bundle */
+	if (pushed)
+	{
+		task_wake(pushed);
+	}
+
+	/* drop the start reference, bundles without tasks complete here */
+	if (atomic_sub_fetch_seq_cst_32(&bundle->a_tasks_left, 1) == 0)
+	{
+		task_bundle_complete(bundle);
+	}
+}
+
+static void task_bundle_complete(struct task_bundle *bundle)
+{
+	/* close the dependent list; dependencies added from now on see the bundle as completed */
+	u64 head = atomic_load_acq_64(&bundle->a_dependents);
+	while (!atomic_compare_exchange_seq_cst_64(&bundle->a_dependents, &head, TASK_BUNDLE_LINK_CLOSED));
+
+	/*
+	 * hold every dependent open until we are done: a dependent may otherwise start, run and complete before
+	 * we return, after which its waiter may release the memory of the whole graph, including this bundle.
+	 */
+	for (struct task_bundle_link *link = (struct task_bundle_link *) head; link; link = link->next)
+	{
+		atomic_add_fetch_seq_cst_32(&link->bundle->a_tasks_left, 1);
+	}
+
+	for (struct task_bundle_link *link = (struct task_bundle_link *) head; link; link = link->next)
+	{
+		if (atomic_sub_fetch_seq_cst_32(&link->bundle->a_dependencies_left, 1) == 0)
+		{
+			task_bundle_start(link->bundle);
+		}
+	}
+
+	/* last access to the bundle; waiters may release its memory after this point */
+	atomic_store_rel_32(&bundle->a_completed, 1);
+
+	/* links live until their dependent completes, so read ahead before dropping the hold */
+	struct task_bundle_link *next;
+	for (struct task_bundle_link *link = (struct task_bundle_link *) head; link; link = next)
+	{
+		next = link->next;
+		struct task_bundle *dependent = link->bundle;
+		if (atomic_sub_fetch_seq_cst_32(&dependent->a_tasks_left, 1) == 0)
+		{
+			task_bundle_complete(dependent);
+		}
+	}
+}
+
+struct task_bundle *task_bundle_alloc_range(struct arena *mem_task_lifetime, TASK task, const u32 split_count, void *inputs, const u64 input_count, const u64 input_element_size, void *shared_arguments)
 {
 	const u32 tasks_per_range = (u32) input_count / split_count;
 	u32 extra_tasks = input_count % split_count;
 	const u32 splits = (tasks_per_range) ? split_count : extra_tasks;
 
-	if (!splits) { return NULL; }
-
-	struct task_bundle *bundle = &g_task_ctx->bundle;
+	struct task_bundle *bundle = arena_push(mem_task_lifetime, sizeof(struct task_bundle));
 	struct task_range *range = arena_push(mem_task_lifetime, splits * sizeof(struct task_range));
-	bundle->tasks = arena_push(mem_task_lifetime, splits * sizeof(struct task));
+	struct task *tasks = arena_push(mem_task_lifetime, splits * sizeof(struct task));
+	if (!bundle || (splits && (!range || !tasks)))
+	{
+		log_string(T_SYSTEM, S_FATAL, "Failed to allocate task bundle memory");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+	bundle->tasks = tasks;
 	bundle->task_count = splits;
 
 	u64 offset = 0;
@@ -221,29 +625,141 @@ struct task_bundle *task_bundle_split_range(struct arena *mem_task_lifetime, TAS
 		atomic_store_rel_64(&bundle->tasks[i].batch, bundle);
 	}
 
-	atomic_store_rel_32(&bundle->a_tasks_left, splits);
-	/* Sync points, we release tasks->data, threads aquire tasks->data => threads will see all previous writes */
-	for (u32 i = 0; i < splits; ++i)
+	atomic_store_rel_32(&bundle->a_tasks_left, splits + 1);
+	atomic_store_rel_32(&bundle->a_dependencies_left, 1);
+	atomic_store_rel_32(&bundle->a_completed, 0);
+	atomic_store_rel_64(&bundle->a_dependents, 0);
+
+	return bundle;
+}
+
+struct task_bundle *task_bundle_alloc_task(struct arena *mem_task_lifetime, TASK task, void *input)
+{
+	struct task_bundle *bundle = arena_push(mem_task_lifetime, sizeof(struct task_bundle));
+	struct task *tasks = arena_push(mem_task_lifetime, sizeof(struct task));
+	if (!bundle || !tasks)
 	{
-		fifo_spmc_push(g_task_ctx->tasks, bundle->tasks + i);
+		log_string(T_SYSTEM, S_FATAL, "Failed to allocate task bundle memory");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
 	}
+	bundle->tasks = tasks;
+	bundle->task_count = 1;
+	bundle->tasks[0].task = task;
+	bundle->tasks[0].input = input;
+	bundle->tasks[0].range = NULL;
+	bundle->tasks[0].batch_type = TASK_BATCH_BUNDLE;
+	atomic_store_rel_64(&bundle->tasks[0].batch, bundle);
+
+	atomic_store_rel_32(&bundle->a_tasks_left, 2);
+	atomic_store_rel_32(&bundle->a_dependencies_left, 1);
+	atomic_store_rel_32(&bundle->a_completed, 0);
+	atomic_store_rel_64(&bundle->a_dependents, 0);
 
 	return bundle;
 }
 
+void task_bundle_depend(struct arena *mem_task_lifetime, struct task_bundle *bundle, struct task_bundle *dependency)
+{
+	struct task_bundle_link *link = arena_push(mem_task_lifetime, sizeof(struct task_bundle_link));
+	if (!link)
+	{
+		log_string(T_SYSTEM, S_FATAL, "Failed to allocate task bundle memory");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
+	link->bundle = bundle;
+
+	/* bundle is not yet submitted, so its submit reference keeps the count above zero */
+	atomic_fetch_add_seq_cst_32(&bundle->a_dependencies_left, 1);
+
+	u64 head = atomic_load_acq_64(&dependency->a_dependents);
+	while (1)
+	{
+		if (head == TASK_BUNDLE_LINK_CLOSED)
+		{
+			/* dependency already completed */
+			atomic_fetch_sub_seq_cst_32(&bundle->a_dependencies_left, 1);
+			break;
+		}
+
+		link->next = (struct task_bundle_link *) head;
+		if (atomic_compare_exchange_seq_cst_64(&dependency->a_dependents, &head, (u64) link))
+		{
+			break;
+		}
+	}
+}
+
+void task_bundle_submit(struct task_bundle *bundle)
+{
+	if (atomic_sub_fetch_seq_cst_32(&bundle->a_dependencies_left, 1) == 0)
+	{
+		task_bundle_start(bundle);
+	}
+}
+
+struct task_bundle *task_bundle_continuation(struct arena *mem_task_lifetime, struct task_bundle *bundle, TASK task, void *input)
+{
+	struct task_bundle *continuation = task_bundle_alloc_task(mem_task_lifetime, task, input);
+	task_bundle_depend(mem_task_lifetime, continuation, bundle);
+	task_bundle_submit(continuation);
+	return continuation;
+}
+
+struct task_bundle *task_bundle_split_range(struct arena *mem_task_lifetime, TASK task, const u32 split_count, void *inputs, const u64 input_count, const u64 input_element_size, void *shared_arguments)
+{
+	if (input_count == 0) { return NULL; }
+
+	struct task_bundle *bundle = task_bundle_alloc_range(mem_task_lifetime, task, split_count, inputs, input_count, input_element_size, shared_arguments);
+	task_bundle_submit(bundle);
+	return bundle;
+}
+
 void task_bundle_wait(struct task_bundle *bundle)
 {
-	while (!semaphore_wait(&bundle->bundle_completed));
+	struct worker *w = tl_worker;
+	u32 round = 0;
+	u64 ns_idle_start = 0;
+	u32 victim;
+	TASK_TIMELINE_RECORD(TIMELINE_WAIT_BEGIN, NULL, 0);
+	while (!atomic_load_acq_32(&bundle->a_completed))
+	{
+		struct task *task = task_find(w, &victim);
+		if (task)
+		{
+			if (round)
+			{
+				atomic_fetch_add_rlx_64(&w->a_ns_spin, time_ns() - ns_idle_start);
+				round = 0;
+			}
+			task_run(task, w, victim);
+		}
+		else
+		{
+			ns_idle_start = (round == 0) ? time_ns() : ns_idle_start;
+			task_backoff(round++);
+		}
+	}
+	TASK_TIMELINE_RECORD(TIMELINE_WAIT_END, NULL, 0);
+
+	if (round)
+	{
+		atomic_fetch_add_rlx_64(&w->a_ns_spin, time_ns() - ns_idle_start);
+	}
 }
 
 void task_bundle_release(struct task_bundle *bundle)
 {
-	atomic_store_rel_32(&bundle->a_tasks_left, 0);
+	kas_assert_string(atomic_load_acq_32(&bundle->a_completed), "task bundle released before completion");
 }
 
 struct task_stream *task_stream_init(struct arena *mem)
 {
 	struct task_stream *stream = arena_push(mem, sizeof(struct task_stream));
+	if (!stream)
+	{
+		log_string(T_SYSTEM, S_FATAL, "Failed to allocate task stream memory");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
 	atomic_store_rel_32(&stream->a_completed, 0);
 	stream->task_count = 0;
 
@@ -253,22 +769,128 @@ struct task_stream *task_stream_init(struct arena *mem)
 void task_stream_dispatch(struct arena *mem, struct task_stream *stream, TASK func, void *args)
 {
 	struct task *task = arena_push(mem, sizeof(struct task));
+	if (!task)
+	{
+		log_string(T_SYSTEM, S_FATAL, "Failed to allocate task stream memory");
+		fatal_cleanup_and_exit(kas_thread_self_tid());
+	}
 	task->task = func;
 	task->input = args;
 	task->batch_type = TASK_BATCH_STREAM;
 	task->batch = stream;
 	
 	stream->task_count += 1;
-	fifo_spmc_push(g_task_ctx->tasks, task);
+	task_push(task);
 }
 
 void task_stream_spin_wait(struct task_stream *stream)
 {
-	while ((u32) atomic_load_acq_32(&stream->a_completed) < stream->task_count);
+	struct worker *w = tl_worker;
+	u32 round = 0;
+	u64 ns_idle_start = 0;
+	u32 victim;
+	TASK_TIMELINE_RECORD(TIMELINE_WAIT_BEGIN, NULL, 0);
+	while ((u32) atomic_load_acq_32(&stream->a_completed) < stream->task_count)
+	{
+		struct task *task = task_find(w, &victim);
+		if (task)
+		{
+			if (round)
+			{
+				atomic_fetch_add_rlx_64(&w->a_ns_spin, time_ns() - ns_idle_start);
+				round = 0;
+			}
+			task_run(task, w, victim);
+		}
+		else
+		{
+			ns_idle_start = (round == 0) ? time_ns() : ns_idle_start;
+			task_backoff(round++);
+		}
+	}
+	TASK_TIMELINE_RECORD(TIMELINE_WAIT_END, NULL, 0);
+
+	if (round)
+	{
+		atomic_fetch_add_rlx_64(&w->a_ns_spin, time_ns() - ns_idle_start);
+	}
 }
 
 void task_stream_cleanup(struct task_stream *stream)
 {
 	const u32 finished = (atomic_load_acq_32(&stream->a_completed) == stream->task_count);
-	kas_assert_string(finished, "Bad use of task stream, when (and only) the main thread enters task_stream_cleanup, all tasks must have been dispatched and completed.");
+	kas_assert_string(finished, "Bad use of task stream, when (and only) the dispatching thread enters task_stream_cleanup, all tasks must have been dispatched and completed.");
 }
+
+#ifdef KAS_TASK_TIMELINE
+
+void task_timeline_record(const enum timeline_event_type type, const char *name, const u32 arg)
+{
+	struct worker *w = tl_worker;
+	if (!w)
+	{
+		return;
+	}
+
+	/* 
+	 * single producer; the fields are release stores, so a reader that sees any of them also sees the slot
+	 * marked as being written, and the final release of a_seq publishes the event.
+	 */
+	struct task_timeline *timeline = w->timeline;
+	const u64 head = atomic_load_rlx_64(&timeline->a_head);
+	struct timeline_slot *slot = timeline->slot + (head & (TIMELINE_EVENT_COUNT - 1));
+	atomic_store_rlx_64(&slot->a_seq, 2*head + 1);
+	atomic_store_rel_64(&slot->a_tsc, rdtsc());
+	atomic_store_rel_64(&slot->a_name, (u64) name);
+	atomic_store_rel_32(&slot->a_type, (u32) type);
+	atomic_store_rel_32(&slot->a_arg, arg);
+	atomic_store_rel_64(&slot->a_seq, 2*head + 2);
+	atomic_store_rel_64(&timeline->a_head, head + 1);
+}
+
+u32 task_timeline_zone_begin(const char *name)
+{
+	struct worker *w = tl_worker;
+	const u32 zone = (w) ? (u32) atomic_load_rlx_64(&w->timeline->a_head) : 0;
+	task_timeline_record(TIMELINE_ZONE_BEGIN, name, 0);
+	return zone;
+}
+
+void task_timeline_zone_end(const u32 zone)
+{
+	task_timeline_record(TIMELINE_ZONE_END, NULL, zone);
+}
+
+u32 task_timeline_copy(struct timeline_event *event, const u32 worker)
+{
+	struct task_timeline *timeline = g_task_ctx->workers[worker].timeline;
+	const u64 head = atomic_load_acq_64(&timeline->a_head);
+	const u64 first = (head > TIMELINE_EVENT_COUNT) ? head - TIMELINE_EVENT_COUNT : 0;
+
+	/* 
+	 * the writer may lap us during the copy; a slot is intact if it holds the expected index both before and
+	 * after its fields are read. The acquire loads of the fields order the second load of a_seq after them,
+	 * and seeing a field of a newer event implies seeing that event's in-progress sequence number.
+	 */
+	u32 count = 0;
+	for (u64 i = first; i < head; ++i)
+	{
+		const struct timeline_slot *slot = timeline->slot + (i & (TIMELINE_EVENT_COUNT - 1));
+		const u64 seq = 2*i + 2;
+		if (atomic_load_acq_64(&slot->a_seq) != seq)
+		{
+			continue;
+		}
+
+		struct timeline_event *e = event + count;
+		e->tsc = atomic_load_acq_64(&slot->a_tsc);
+		e->name = (const char *) atomic_load_acq_64(&slot->a_name);
+		e->type = atomic_load_acq_32(&slot->a_type);
+		e->arg = atomic_load_acq_32(&slot->a_arg);
+		count += (atomic_load_rlx_64(&slot->a_seq) == seq);
+	}
+
+	return count;
+}
+
+#endif
@@ -28,6 +28,7 @@ void 		(*kas_cpuid_ex)(u32 *eax, u32 *ebx, u32 *ecx, u32 *edx, const u32 functio
 u32  		(*system_logical_core_count)(void);
 u64  		(*system_pagesize)(void);
 pid		(*system_pid)(void);
+u32		(*system_cpu_topology)(struct kas_logical_core *topology, const u32 logical_core_count);
 
 /*
  * returns number of logical (threads) available for the user
@@ -81,6 +82,27 @@ void virtual_memory_release(void *addr, const u64 size)
 	}
 }
 
+/* wasm memory can only grow; reserved memory is usable at once and is never given back */
+void *virtual_memory_reserve_uncommitted(const u64 size)
+{
+	return virtual_memory_reserve(size);
+}
+
+u32 virtual_memory_commit(void *addr, const u64 size)
+{
+	return 1;
+}
+
+void virtual_memory_decommit(void *addr, const u64 size)
+{
+}
+
+/* browsers do not expose the cpu topology */
+static u32 wasm_cpu_topology(struct kas_logical_core *topology, const u32 logical_core_count)
+{
+	return 0;
+}
+
 pid wasm_pid(void)
 {
 	return 0;
@@ -93,4 +115,5 @@ void os_arch_init_func_ptrs(void)
 	system_logical_core_count = &wasm_logical_core_count;
 	system_pagesize = &wasm_pagesize;
 	system_pid = &wasm_pid;
+	system_cpu_topology = &wasm_cpu_topology;
 }
@@ -19,6 +19,8 @@
 
 #include <semaphore.h>
 #include <errno.h>
+#include <math.h>
+#include <emscripten/threading.h>
 #include "wasm_local.h"
 #include "sys_public.h"
 
@@ -83,3 +85,15 @@ u32 semaphore_trywait(semaphore *sem)
 
 	return success;
 }
+
+void futex_wait(u32 *addr, const u32 expected)
+{
+	/* -EWOULDBLOCK and -ETIMEDOUT are spurious wake ups to the caller */
+	emscripten_futex_wait(addr, expected, INFINITY);
+}
+
+void futex_wake(u32 *addr, const u32 count)
+{
+	const int wake_count = (count > I32_MAX) ? I32_MAX : (int) count;
+	emscripten_futex_wake(addr, wake_count);
+}
@@ -47,7 +47,8 @@ static void *kas_thread_clone_start(void *void_thr)
 	struct kas_thread *thr = void_thr;
 	thr->tid = gettid();
 	thr->index = atomic_fetch_add_rlx_32(&a_index_counter, 1);
-	PROF_THREAD_NAMED(thread_profiler_id[thr->index]);
+	/* indices keep growing when the task context is re-created */
+	PROF_THREAD_NAMED(thread_profiler_id[thr->index % (sizeof(thread_profiler_id) / sizeof(thread_profiler_id[0]))]);
 	thr->start(thr);
 
 	return NULL;
@@ -182,3 +183,14 @@ u32 kas_thread_self_index(void)
 {
 	return self->index;
 }
+
+u32 kas_thread_self_set_affinity(const u32 logical_core)
+{
+	/* web workers can not be pinned */
+	return 0;
+}
+
+void kas_thread_yield(void)
+{
+	sched_yield();
+}
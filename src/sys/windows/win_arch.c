@@ -19,12 +19,14 @@
 
 #include "win_local.h"
 #include <intrin.h>
+#include <stddef.h>
 
 void 		(*kas_cpuid)(u32 *eax, u32 *ebx, u32 *ecx, u32 *edx, const u32 function);
 void 		(*kas_cpuid_ex)(u32 *eax, u32 *ebx, u32 *ecx, u32 *edx, const u32 function, const u32 subfunction);
 u32  		(*system_logical_core_count)(void);
 u64  		(*system_pagesize)(void);
 pid		(*system_pid)(void);
+u32		(*system_cpu_topology)(struct kas_logical_core *topology, const u32 logical_core_count);
 
 static void win_kas_cpuid(u32 *eax, u32 *ebx, u32 *ecx, u32 *edx, const u32 function)
 {
@@ -53,6 +55,66 @@ static u32 win_logical_core_count(void)
 	return (u32) info.dwNumberOfProcessors;
 }
 
+/* set id of every logical core in mask (processor group 0) to the first logical core in mask */
+static void win_topology_set_id(struct kas_logical_core *topology, const u32 logical_core_count, const ULONG_PTR mask, const u64 id_offset)
+{
+	u32 first = U32_MAX;
+	for (u32 i = 0; i < logical_core_count && i < 64; ++i)
+	{
+		if (mask & ((ULONG_PTR) 1 << i))
+		{
+			first = (first == U32_MAX) ? i : first;
+			*(u32 *) ((u8 *) (topology + i) + id_offset) = first;
+		}
+	}
+}
+
+static u32 win_cpu_topology(struct kas_logical_core *topology, const u32 logical_core_count)
+{
+	DWORD size = 0;
+	GetLogicalProcessorInformation(NULL, &size);
+	SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info = malloc(size);
+	if (info == NULL || !GetLogicalProcessorInformation(info, &size))
+	{
+		free(info);
+		return 0;
+	}
+
+	for (u32 i = 0; i < logical_core_count; ++i)
+	{
+		topology[i].core = U32_MAX;
+		topology[i].l2 = U32_MAX;
+		topology[i].l3 = U32_MAX;
+	}
+
+	const u32 count = size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+	for (u32 i = 0; i < count; ++i)
+	{
+		if (info[i].Relationship == RelationProcessorCore)
+		{
+			win_topology_set_id(topology, logical_core_count, info[i].ProcessorMask, offsetof(struct kas_logical_core, core));
+		}
+		else if (info[i].Relationship == RelationCache && info[i].Cache.Level == 2)
+		{
+			win_topology_set_id(topology, logical_core_count, info[i].ProcessorMask, offsetof(struct kas_logical_core, l2));
+		}
+		else if (info[i].Relationship == RelationCache && info[i].Cache.Level == 3)
+		{
+			win_topology_set_id(topology, logical_core_count, info[i].ProcessorMask, offsetof(struct kas_logical_core, l3));
+		}
+	}
+	free(info);
+
+	/* cores without a reported L2/L3 get private caches */
+	for (u32 i = 0; i < logical_core_count; ++i)
+	{
+		topology[i].l2 = (topology[i].l2 == U32_MAX) ? topology[i].core : topology[i].l2;
+		topology[i].l3 = (topology[i].l3 == U32_MAX) ? topology[i].core : topology[i].l3;
+	}
+
+	return 1;
+}
+
 static u64 win_system_pagesize(void)
 {
 	SYSTEM_INFO info;
@@ -72,6 +134,7 @@ void os_arch_init_func_ptrs(void)
 	system_logical_core_count = &win_logical_core_count;
 	system_pagesize = &win_system_pagesize;
 	system_pid = &win_pid;
+	system_cpu_topology = &win_cpu_topology;
 }
 
 /* returns reserved page aligned virtual memory on success, NULL on failure. */
@@ -94,3 +157,33 @@ void virtual_memory_release(void *addr, const u64 garbage)
 		log_system_error(S_ERROR);	
 	}
 }
+
+void *virtual_memory_reserve_uncommitted(const u64 size)
+{
+	void *addr = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+	if (addr == NULL)
+	{
+		log_system_error(S_ERROR);	
+	}
+
+	return addr;
+}
+
+u32 virtual_memory_commit(void *addr, const u64 size)
+{
+	if (VirtualAlloc(addr, size, MEM_COMMIT, PAGE_READWRITE) == NULL)
+	{
+		log_system_error(S_ERROR);	
+		return 0;
+	}
+
+	return 1;
+}
+
+void virtual_memory_decommit(void *addr, const u64 size)
+{
+	if (VirtualFree(addr, size, MEM_DECOMMIT) == 0)
+	{
+		log_system_error(S_ERROR);	
+	}
+}
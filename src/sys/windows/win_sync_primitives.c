@@ -85,3 +85,27 @@ u32 semaphore_trywait(semaphore *sem)
 
 	return success;
 }
+
+void futex_wait(u32 *addr, const u32 expected)
+{
+	u32 cmp = expected;
+	if (!WaitOnAddress(addr, &cmp, sizeof(u32), INFINITE))
+	{
+		log_system_error(S_FATAL);
+		fatal_cleanup_and_exit(0);
+	}
+}
+
+void futex_wake(u32 *addr, const u32 count)
+{
+	if (count >= g_arch_config->logical_core_count)
+	{
+		WakeByAddressAll(addr);
+		return;
+	}
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		WakeByAddressSingle(addr);
+	}
+}
@@ -41,7 +41,8 @@ DWORD WINAPI kas_thread_clone_start(LPVOID void_thr)
 	struct kas_thread *thr = void_thr;
 	thr->tid = GetCurrentThreadId();
 	thr->index = atomic_fetch_add_rlx_32(&a_index_counter, 1);
-	PROF_THREAD_NAMED(thread_profiler_id[thr->index]);
+	/* indices keep growing when the task context is re-created */
+	PROF_THREAD_NAMED(thread_profiler_id[thr->index % (sizeof(thread_profiler_id) / sizeof(thread_profiler_id[0]))]);
 	thr->start(thr);
 
 	return 0;
@@ -177,3 +178,31 @@ u32 kas_thread_self_index(void)
 {
 	return self->index;
 }
+
+u32 kas_thread_self_set_affinity(const u32 logical_core)
+{
+	DWORD_PTR mask;
+	if (logical_core == U32_MAX)
+	{
+		DWORD_PTR system_mask;
+		if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &system_mask))
+		{
+			return 0;
+		}
+	}
+	else if (logical_core < 8*sizeof(DWORD_PTR))
+	{
+		mask = (DWORD_PTR) 1 << logical_core;
+	}
+	else
+	{
+		return 0;
+	}
+
+	return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
+void kas_thread_yield(void)
+{
+	SwitchToThread();
+}
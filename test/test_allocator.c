@@ -201,6 +201,56 @@ void malloc_stress_test(void *void_input)
 	}
 }
 
+/*
+ * growable arena used as a frame arena: frames touching 256KB each, one of them spiking to 64MB and followed by
+ * ARENA_DECOMMIT_FLUSHES frames. Measures commit on growth and the decommit after the spike.
+ */
+#define ARENA_SPIKE_FRAME	16
+#define ARENA_FRAME_COUNT	(ARENA_SPIKE_FRAME + 1 + ARENA_DECOMMIT_FLUSHES)
+#define ARENA_FRAME_SIZE	(256*1024)
+#define ARENA_SPIKE_SIZE	(64*1024*1024)
+#define ARENA_PUSH_SIZE		(64*1024)
+
+void *arena_growable_frames_init(void)
+{
+	struct arena *ar = malloc(sizeof(struct arena));
+	*ar = arena_alloc_growable((u64) 1024*1024*1024);
+	return ar;
+}
+
+void arena_growable_frames_free(void *args)
+{
+	arena_free(args);
+	free(args);
+}
+
+void arena_growable_frames_test(void *args)
+{
+	struct arena *ar = args;
+	for (u32 frame = 0; frame < ARENA_FRAME_COUNT; ++frame)
+	{
+		const u64 frame_size = (frame == ARENA_SPIKE_FRAME) ? ARENA_SPIKE_SIZE : ARENA_FRAME_SIZE;
+		for (u64 pushed = 0; pushed < frame_size; pushed += ARENA_PUSH_SIZE)
+		{
+			u8 *buf = arena_push(ar, ARENA_PUSH_SIZE);
+			buf[0] = 1;
+			buf[ARENA_PUSH_SIZE-1] = 1;
+		}
+		kas_assert_string(arena_committed(ar) >= frame_size, "growable arena should commit memory as it grows");
+		arena_flush(ar);
+
+		/* the spike stays committed until ARENA_DECOMMIT_FLUSHES small frames in a row have been flushed */
+		if (frame > ARENA_SPIKE_FRAME && frame - ARENA_SPIKE_FRAME < ARENA_DECOMMIT_FLUSHES)
+		{
+			kas_assert_string(arena_committed(ar) >= ARENA_SPIKE_SIZE, "growable arena decommitted before the streak ended");
+		}
+		else if (frame > ARENA_SPIKE_FRAME)
+		{
+			kas_assert_string(arena_committed(ar) <= 2*ARENA_FRAME_SIZE + ARENA_COMMIT_SIZE, "growable arena should decommit its spike");
+		}
+	}
+}
+
 struct serial_test allocator_serial_test[] =
 {
 	{
@@ -211,6 +261,15 @@ struct serial_test allocator_serial_test[] =
 		.test_reset = NULL,
 		.test_free = NULL,
 	},
+
+	{
+		.id = "arena_growable_frames_64MB_spike",
+		.size = (ARENA_FRAME_COUNT - 1) * ARENA_FRAME_SIZE + ARENA_SPIKE_SIZE,
+		.test = &arena_growable_frames_test,
+		.test_init = &arena_growable_frames_init,
+		.test_reset = NULL,
+		.test_free = &arena_growable_frames_free,
+	},
 };
 
 struct parallel_test allocator_parallel_test[] =
@@ -259,6 +318,138 @@ struct performance_suite storage_performance_allocator_suite =
 	.parallel_test_count = sizeof(allocator_parallel_test) / sizeof(allocator_parallel_test[0]),
 	.serial_test = allocator_serial_test,
 	.serial_test_count = sizeof(allocator_serial_test) / sizeof(allocator_serial_test[0]),
+	.counters = 1,
 };
 
 struct performance_suite *allocator_performance_suite = &storage_performance_allocator_suite;
+
+/********************************** Growable Arena Correctness **********************************/
+
+#define GROWABLE_TEST_RESERVE	(64*ARENA_COMMIT_SIZE)
+
+static u64 growable_test_commit_ceil(const u64 size)
+{
+	return (size + ARENA_COMMIT_SIZE - 1) / ARENA_COMMIT_SIZE * ARENA_COMMIT_SIZE;
+}
+
+/*
+ * A growable arena commits in ARENA_COMMIT_SIZE steps as it grows. After a spike, it keeps its memory committed
+ * until exactly ARENA_DECOMMIT_FLUSHES small flushes in a row, and then recommits as it grows again.
+ */
+static struct test_output arena_growable_commit_decommit(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	struct arena ar = arena_alloc_growable(GROWABLE_TEST_RESERVE);
+	TEST_NOT_ZERO(ar.stack_ptr);
+	TEST_EQUAL(GROWABLE_TEST_RESERVE, ar.mem_size);
+	TEST_EQUAL(0, arena_committed(&ar));
+
+	u64 used = 0;
+	while (used < GROWABLE_TEST_RESERVE / 2)
+	{
+		const u64 size = rng_u64_range(1, 3*ARENA_COMMIT_SIZE / 2);
+		u8 *buf = arena_push_packed(&ar, size);
+		TEST_NOT_ZERO(buf);
+		buf[0] = 1;
+		buf[size-1] = 1;
+		used += size;
+		TEST_EQUAL(growable_test_commit_ceil(used), arena_committed(&ar));
+	}
+
+	/* the spike's own flush keeps its memory */
+	const u64 spike_committed = arena_committed(&ar);
+	arena_flush(&ar);
+	TEST_EQUAL(spike_committed, arena_committed(&ar));
+
+	const u64 small_size = ARENA_COMMIT_SIZE / 4;
+	for (u32 flush = 1; flush <= ARENA_DECOMMIT_FLUSHES; ++flush)
+	{
+		u8 *buf = arena_push_packed(&ar, small_size);
+		TEST_NOT_ZERO(buf);
+		buf[small_size-1] = 1;
+		arena_flush(&ar);
+
+		const u64 expected = (flush < ARENA_DECOMMIT_FLUSHES)
+			? spike_committed
+			: growable_test_commit_ceil(2*small_size);
+		TEST_EQUAL(expected, arena_committed(&ar));
+	}
+
+	/* decommitted memory is committed again on demand */
+	u8 *buf = arena_push_packed(&ar, 3*ARENA_COMMIT_SIZE);
+	TEST_NOT_ZERO(buf);
+	buf[0] = 1;
+	buf[3*ARENA_COMMIT_SIZE-1] = 1;
+	TEST_EQUAL(3*ARENA_COMMIT_SIZE, arena_committed(&ar));
+
+	arena_free(&ar);
+
+	return output;
+}
+
+/*
+ * arena_push_aligned_all on a growable arena hands out its committed memory, committing ARENA_COMMIT_SIZE more
+ * when less is left, and never commits past the reserve.
+ */
+static struct test_output arena_growable_push_aligned_all(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	const u64 reserve = 4*ARENA_COMMIT_SIZE;
+	struct arena ar = arena_alloc_growable(reserve);
+	TEST_NOT_ZERO(ar.stack_ptr);
+
+	struct allocation_array array = arena_push_aligned_all(&ar, 16, 16);
+	TEST_EQUAL(ARENA_COMMIT_SIZE / 16, array.len);
+	TEST_EQUAL(ARENA_COMMIT_SIZE, array.mem_pushed);
+	TEST_EQUAL(ARENA_COMMIT_SIZE, arena_committed(&ar));
+	memset(array.addr, 1, array.len * 16);
+
+	/* misaligned stack with less than ARENA_COMMIT_SIZE committed left; the padding is pushed as well */
+	TEST_NOT_ZERO(arena_push_packed(&ar, 3));
+	TEST_EQUAL(2*ARENA_COMMIT_SIZE, arena_committed(&ar));
+	u8 *prev_stack_ptr = ar.stack_ptr;
+	array = arena_push_aligned_all(&ar, 16, 64);
+	TEST_NOT_ZERO(array.addr);
+	TEST_EQUAL(0, (u64) array.addr & 63);
+	TEST_EQUAL(3*ARENA_COMMIT_SIZE, arena_committed(&ar));
+	TEST_EQUAL((u64) ((u8 *) array.addr - prev_stack_ptr) + array.len * 16, array.mem_pushed);
+	TEST_EQUAL(ar.stack_ptr, prev_stack_ptr + array.mem_pushed);
+	TEST_TRUE(arena_committed(&ar) - (ar.mem_size - ar.mem_left) < 16);
+	memset(array.addr, 1, array.len * 16);
+
+	/* up to the reserve limit: only what is left of the reserve is committed and handed out */
+	const u64 tail = 100;
+	TEST_NOT_ZERO(arena_push_packed(&ar, ar.mem_left - tail));
+	array = arena_push_aligned_all(&ar, 16, 1);
+	TEST_EQUAL(tail / 16, array.len);
+	TEST_EQUAL(reserve, arena_committed(&ar));
+	memset(array.addr, 1, array.len * 16);
+
+	array = arena_push_aligned_all(&ar, 16, 1);
+	TEST_EQUAL(0, array.len);
+	TEST_ZERO(array.addr);
+	TEST_EQUAL(tail % 16, ar.mem_left);
+	TEST_EQUAL(reserve, arena_committed(&ar));
+	TEST_ZERO(arena_push_packed(&ar, 16));
+
+	arena_free(&ar);
+
+	return output;
+}
+
+static struct test_output (*allocator_tests[])(struct test_environment *) =
+{
+	arena_growable_commit_decommit,
+	arena_growable_push_aligned_all,
+};
+
+struct suite m_allocator_suite =
+{
+	.id = "allocator",
+	.unit_test = allocator_tests,
+	.unit_test_count = sizeof(allocator_tests) / sizeof(allocator_tests[0]),
+};
+
+struct suite *allocator_suite = &m_allocator_suite;
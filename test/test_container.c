@@ -18,10 +18,13 @@
 */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "test_local.h"
 #include "array_list.h"
 #include "hierarchy_index.h"
+#include "sort.h"
 
 static struct test_output array_list_slot_size(struct test_environment *env)
 {
@@ -435,6 +438,157 @@ static struct test_output hierarchy_index_add_remove_sub_hierarchy_recursive(str
 	return output;
 }
 
+#define SORT_TEST_COUNT		100000
+
+/* keys laid out like render command keys: a few varying bit fields, many duplicates */
+static u64 sort_test_key(void)
+{
+	const u64 screen = rng_u64_range(0, 1);
+	const u64 depth = rng_u64_range(0, (1 << 23) - 1);
+	const u64 transparency = rng_u64_range(0, 2);
+	const u64 material = rng_u64_range(0, 15) << 12;
+	const u64 flags = rng_u64_range(0, 7);
+	return (screen << 58) | (depth << 35) | (transparency << 33) | (material << 3) | flags;
+}
+
+static void sort_test_fill(struct sort_entry *entry, const u32 count)
+{
+	for (u32 i = 0; i < count; ++i)
+	{
+		entry[i].key = sort_test_key();
+		entry[i].value = i;
+	}
+}
+
+static struct test_output sort_radix_merge_equal(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	const u32 count = 2*SORT_RADIX_PARALLEL_MIN + 17;
+	struct sort_entry *merge = arena_push(env->mem_1, count*sizeof(struct sort_entry));
+	struct sort_entry *radix = arena_push(env->mem_1, count*sizeof(struct sort_entry));
+	struct sort_entry *parallel = arena_push(env->mem_1, count*sizeof(struct sort_entry));
+	struct sort_entry *tmp = arena_push(env->mem_1, count*sizeof(struct sort_entry));
+
+	sort_test_fill(merge, count);
+	/* force duplicate keys so stability is tested */
+	for (u32 i = 0; i < count; i += 3)
+	{
+		merge[i].key = merge[i / 2].key;
+	}
+	memcpy(radix, merge, count*sizeof(struct sort_entry));
+	memcpy(parallel, merge, count*sizeof(struct sort_entry));
+
+	sort_merge(merge, tmp, count);
+	sort_radix(radix, tmp, count);
+	sort_radix_parallel(env->mem_1, parallel, tmp, count);
+
+	for (u32 i = 0; i < count; ++i)
+	{
+		if (i)
+		{
+			TEST_TRUE(merge[i-1].key < merge[i].key
+				|| (merge[i-1].key == merge[i].key && merge[i-1].value < merge[i].value));
+		}
+		TEST_EQUAL(merge[i].key, radix[i].key);
+		TEST_EQUAL(merge[i].value, radix[i].value);
+		TEST_EQUAL(merge[i].key, parallel[i].key);
+		TEST_EQUAL(merge[i].value, parallel[i].value);
+	}
+
+	return output;
+}
+
+struct sort_test_input
+{
+	struct arena		mem;
+	struct sort_entry	*input;
+	struct sort_entry	*entry;
+	struct sort_entry	*tmp;
+};
+
+static void *sort_test_init(void)
+{
+	struct sort_test_input *args = malloc(sizeof(struct sort_test_input));
+	args->mem = arena_alloc(16*1024*1024);
+	args->input = arena_push(&args->mem, SORT_TEST_COUNT*sizeof(struct sort_entry));
+	args->entry = arena_push(&args->mem, SORT_TEST_COUNT*sizeof(struct sort_entry));
+	args->tmp = arena_push(&args->mem, SORT_TEST_COUNT*sizeof(struct sort_entry));
+	sort_test_fill(args->input, SORT_TEST_COUNT);
+	return args;
+}
+
+static void sort_test_reset(void *args)
+{
+	struct sort_test_input *input = args;
+	memcpy(input->entry, input->input, SORT_TEST_COUNT*sizeof(struct sort_entry));
+	task_context_frame_clear();
+}
+
+static void sort_test_free(void *args)
+{
+	struct sort_test_input *input = args;
+	arena_free(&input->mem);
+	free(input);
+}
+
+static void sort_merge_test(void *args)
+{
+	struct sort_test_input *input = args;
+	sort_merge(input->entry, input->tmp, SORT_TEST_COUNT);
+}
+
+static void sort_radix_test(void *args)
+{
+	struct sort_test_input *input = args;
+	sort_radix(input->entry, input->tmp, SORT_TEST_COUNT);
+}
+
+static void sort_radix_parallel_test(void *args)
+{
+	struct sort_test_input *input = args;
+	sort_radix_parallel(&input->mem, input->entry, input->tmp, SORT_TEST_COUNT);
+}
+
+struct serial_test sort_serial_test[] =
+{
+	{ 
+		.id = "sort_merge_100k", 
+		.size = SORT_TEST_COUNT*sizeof(struct sort_entry),
+		.test = &sort_merge_test,
+		.test_init = &sort_test_init,
+		.test_reset = &sort_test_reset,
+		.test_free = &sort_test_free,
+	},
+
+	{ 
+		.id = "sort_radix_100k", 
+		.size = SORT_TEST_COUNT*sizeof(struct sort_entry),
+		.test = &sort_radix_test,
+		.test_init = &sort_test_init,
+		.test_reset = &sort_test_reset,
+		.test_free = &sort_test_free,
+	},
+
+	{ 
+		.id = "sort_radix_parallel_100k", 
+		.size = SORT_TEST_COUNT*sizeof(struct sort_entry),
+		.test = &sort_radix_parallel_test,
+		.test_init = &sort_test_init,
+		.test_reset = &sort_test_reset,
+		.test_free = &sort_test_free,
+	},
+};
+
+struct performance_suite storage_performance_sort_suite =
+{
+	.id = "Sort Performance",
+	.serial_test = sort_serial_test,
+	.serial_test_count = sizeof(sort_serial_test) / sizeof(sort_serial_test[0]),
+};
+
+struct performance_suite *sort_performance_suite = &storage_performance_sort_suite;
+
 static struct test_output (*array_list_tests[])(struct test_environment *) =
 {
 	array_list_slot_size,
@@ -449,6 +603,11 @@ static struct test_output(*hierarchy_index_tests[])(struct test_environment *) =
 	hierarchy_index_add_remove_sub_hierarchy_recursive,
 };
 
+static struct test_output(*sort_tests[])(struct test_environment *) =
+{
+	sort_radix_merge_equal,
+};
+
 struct suite m_array_list_suite =
 {
 	.id = "array_list",
@@ -463,7 +622,15 @@ struct suite m_hierarchy_index_suite =
 	.unit_test_count = sizeof(hierarchy_index_tests) / sizeof(hierarchy_index_tests[0]),
 };
 
+struct suite m_sort_suite =
+{
+	.id = "sort",
+	.unit_test = sort_tests,
+	.unit_test_count = sizeof(sort_tests) / sizeof(sort_tests[0]),
+};
+
 struct suite *array_list_suite = &m_array_list_suite;
 struct suite *hierarchy_index_suite = &m_hierarchy_index_suite;
+struct suite *sort_suite = &m_sort_suite;
 
 
@@ -44,6 +44,27 @@ enum repetition_tester_state
 	RT_ERROR,
 };
 
+/* performance counters sampled within timed regions (linux perf events) */
+enum rt_counter
+{
+	RT_COUNTER_PAGE_FAULTS,
+	RT_COUNTER_BRANCH_MISSES,
+	RT_COUNTER_CACHE_MISSES,		/* last level cache misses */
+	RT_COUNTER_FRONTEND_STALLED_CYCLES,
+	RT_COUNTER_BACKEND_STALLED_CYCLES,
+	RT_COUNTER_CYCLES,			/* core cycles of the counted threads */
+	RT_COUNTER_COUNT
+};
+
+enum rt_counter_scope
+{
+	RT_COUNTERS_NONE,			/* timing only */
+	RT_COUNTERS_THREAD,			/* count events of the calling thread */
+	RT_COUNTERS_WORKERS,			/* count events of the calling (master) thread and every task worker */
+};
+
+struct rt_counter_group;
+
 struct repetition_tester
 {
 	u64 time;
@@ -54,6 +75,7 @@ struct repetition_tester
 	u32 enter_count;
 	u32 exit_count;
 	u32 print : 1;
+	u32 counters_scaled : 1;	/* some counters were multiplexed and scaled by time enabled / time running */
 
 	u64 bytes_to_process;
 	u64 tsc_retry_max;	/* maximum tsc since last new best iteration before we end the test */
@@ -65,61 +87,33 @@ struct repetition_tester
 	u64 tsc_iteration_max;
 	u64 tsc_iteration_min;
 
-	u64 cycles_in_current_test;
-	u64 cycles_min_time;
-	u64 cycles_max_time;
-	u64 cycles;
-	
-	u64 page_faults_in_current_test;
-	u64 page_faults_min_time;
-	u64 page_faults_max_time; /* page fault count on max count */
-	u64 page_faults;
-
-	u64 branch_misses_in_current_test;
-	u64 branch_misses_min_time;
-	u64 branch_misses_max_time;
-	u64 branch_misses;
-
-	u64 frontend_stalled_cycles_in_current_test;
-	u64 frontend_stalled_cycles_min_time;
-	u64 frontend_stalled_cycles_max_time;
-	u64 frontend_stalled_cycles;
-
-	u64 backend_stalled_cycles_in_current_test;
-	u64 backend_stalled_cycles_min_time;
-	u64 backend_stalled_cycles_max_time;
-	u64 backend_stalled_cycles;
-	
-#ifdef __linux__
-
-#define NUM_EVENTS 5
-#define PAGE_FAULT_SAMPLING_PERIOD 1		/* counter period for new update */
-#define BRANCH_MISSES_SAMPLING_PERIOD 1000
-	u64 event_count;
-	u64 pf_id; /* page faults, event group leader */
-	u64 bm_id; /* branch_misses */
-	u64 fnt_id; /* frontend stall cycles */
-	u64 bck_id; /* backend stall cycles */
-	u64 cyc_id;  /* non-cpu-frequency-scaled cycles */
-	i32 pf_fd; 
-	i32 bm_fd;  
-	i32 fnt_fd;
-	i32 bck_fd;
-	i32 cyc_fd;
-#endif
+	u64 counter_in_current_test[RT_COUNTER_COUNT];
+	u64 counter_min_time[RT_COUNTER_COUNT];	/* counters of the fastest iteration */
+	u64 counter_max_time[RT_COUNTER_COUNT];	/* counters of the slowest iteration */
+	u64 counter[RT_COUNTER_COUNT];		/* counters summed over all iterations */
+
+	u32 counter_available;			/* (1 << enum rt_counter) set if the counter is sampled */
+	u32 group_count;
+	struct rt_counter_group *group;		/* one event group per counted thread */
 };
 
 i32 rt_is_testing(struct repetition_tester *tester);
-void rt_wave(struct repetition_tester *tester, const u64 bytes_to_process, const u64 tsc_freq, const u64 tsc_retry_max, const u32 print);
+void rt_wave(struct repetition_tester *tester, const u64 bytes_to_process, const u64 tsc_freq, const u64 tsc_retry_max, const u32 print, const enum rt_counter_scope scope);
 void rt_begin_time(struct repetition_tester *tester);
 void rt_end_time(struct repetition_tester *tester);
 void rt_print_statistics(const struct repetition_tester *tester, FILE *file);
+/* release any performance counters held by the tester */
+void rt_cleanup(struct repetition_tester *tester);
 
 
 extern struct performance_suite *hash_performance_suite;
 extern struct performance_suite *rng_performance_suite;
 extern struct performance_suite *serialize_performance_suite;
 extern struct performance_suite *allocator_performance_suite;
+extern struct performance_suite *physics_performance_suite;
+extern struct performance_suite *task_performance_suite;
+extern struct performance_suite *math_performance_suite;
+extern struct performance_suite *sort_performance_suite;
 
 struct serial_test
 {
@@ -155,17 +149,25 @@ struct performance_suite
 	const const u32 		serial_test_count;
 	const struct parallel_test	*parallel_test;
 	const const u32 		parallel_test_count;
+	const u32			counters;	/* sample performance counters in the suite's tests */
 };
 
 
 /********************************** Correctness Testing  ************************************/
 
 
+extern struct suite *allocator_suite;
 extern struct suite *array_list_suite;
 extern struct suite *hierarchy_index_suite;
+extern struct suite *sort_suite;
+extern struct suite *physics_suite;
 extern struct suite *math_suite;
 extern struct suite *kas_string_suite;
 extern struct suite *serialize_suite;
+extern struct suite *task_suite;
+
+/* destroy the task context and create a new one with the given worker count and placement */
+void test_task_context_reinit(const u32 thread_count, const enum task_affinity affinity);
 
 struct test_output
 {
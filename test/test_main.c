@@ -124,7 +124,7 @@ static void run_performance_suite(struct performance_suite *suite)
 			? suite->serial_test[i].test_init()
 			: NULL;
 
-		rt_wave(&tester, suite->serial_test[i].size, freq_rdtsc(), max_time_without_improvement, 1);
+		rt_wave(&tester, suite->serial_test[i].size, freq_rdtsc(), max_time_without_improvement, 1, (suite->counters) ? RT_COUNTERS_THREAD : RT_COUNTERS_NONE);
 		do
 		{
 			rng_push_state();
@@ -145,6 +145,7 @@ static void run_performance_suite(struct performance_suite *suite)
 			suite->serial_test[i].test_free(args);
 		}
 		rt_print_statistics(&tester, stdout);
+		rt_cleanup(&tester);
 	}
 
 	struct arena mem = arena_alloc_1MB();
@@ -166,7 +167,7 @@ static void run_performance_suite(struct performance_suite *suite)
 				: NULL;
 		}
 
-		rt_wave(&tester, suite->parallel_test[i].size, freq_rdtsc(), max_time_without_improvement, 1);
+		rt_wave(&tester, suite->parallel_test[i].size, freq_rdtsc(), max_time_without_improvement, 1, (suite->counters) ? RT_COUNTERS_WORKERS : RT_COUNTERS_NONE);
 		do
 		{
 			rng_push_state();
@@ -203,6 +204,7 @@ static void run_performance_suite(struct performance_suite *suite)
 		}
 
 		rt_print_statistics(&tester, stdout);
+		rt_cleanup(&tester);
 	}
 	arena_free_1MB(&mem);
 }
@@ -230,13 +232,21 @@ void test_main(void)
 #if defined(KAS_TEST_CORRECTNESS)
 	run_suite(kas_string_suite, &env, 1);
 	run_suite(serialize_suite, &env, 1);
+	run_suite(allocator_suite, &env, 1);
 	run_suite(array_list_suite, &env, 1);
 	run_suite(hierarchy_index_suite, &env, 1);
-	//run_suite(math_suite, &env, 1);
+	run_suite(sort_suite, &env, 1);
+	run_suite(physics_suite, &env, 1);
+	run_suite(task_suite, &env, 1);
+	run_suite(math_suite, &env, 1);
 #elif defined(KAS_TEST_PERFORMANCE)
 	run_performance_suite(hash_performance_suite);
 	//run_performance_suite(rng_performance_suite);
 	//run_performance_suite(allocator_performance_suite);
 	//run_performance_suite(serialize_performance_suite);
+	//run_performance_suite(physics_performance_suite);
+	//run_performance_suite(task_performance_suite);
+	//run_performance_suite(math_performance_suite);
+	//run_performance_suite(sort_performance_suite);
 #endif
 }
@@ -21,10 +21,15 @@
 #include <math.h>
 #include <float.h>
 #include <fenv.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "test_local.h"
 #include "kas_math.h"
 #include "matrix.h"
+#include "math_batch.h"
+#include "geometry.h"
+#include "kas_random.h"
 
 static struct test_output matrix_inverse_assert(struct test_environment *env)
 {
@@ -60,10 +65,187 @@ static struct test_output matrix_inverse_assert(struct test_environment *env)
 		assert(1.0f - eps <= I4[i][i] && I4[i][i] <= 1.0f + eps);
 		for (u32 j = i+1; j < 4; ++j)
 		{
-			assert(-eps <= I3[i][j] && I3[j][i] <= eps);
+			assert(-eps <= I4[i][j] && I4[j][i] <= eps);
+		}
+	}
+
+
+	return output;
+}
+
+/* isas that can run on this machine: the isa selected at startup is the widest supported one, and implies the narrower x86 ones */
+static u32 math_isa_runnable(const enum math_isa isa, const enum math_isa widest)
+{
+	if (!math_isa_compiled(isa))
+	{
+		return 0;
+	}
+
+	switch (isa)
+	{
+		case MATH_ISA_SCALAR: { return 1; }
+		case MATH_ISA_SIMD128: { return widest == MATH_ISA_SIMD128; }
+		default: { return widest != MATH_ISA_SIMD128 && isa <= widest; }
+	}
+}
+
+static void random_unit_quat(quat q)
+{
+	quat_set(q, rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f));
+	quat_normalize(q);
+}
+
+static struct test_output math_batch_isa_equal_assert(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	const enum math_isa widest = g_math_isa;
+	const u32 max_count = 67;
+
+	arena_push_record(env->mem_1);
+	vec3ptr v = arena_push(env->mem_1, max_count * sizeof(vec3));
+	vec3ptr w = arena_push(env->mem_1, max_count * sizeof(vec3));
+	vec3ptr ref = arena_push(env->mem_1, max_count * sizeof(vec3));
+	vec3ptr out = arena_push(env->mem_1, max_count * sizeof(vec3));
+	quatptr q = arena_push(env->mem_1, max_count * sizeof(quat));
+	quatptr q_ref = arena_push(env->mem_1, max_count * sizeof(quat));
+	quatptr q_out = arena_push(env->mem_1, max_count * sizeof(quat));
+	f32 *soa = arena_push(env->mem_1, 3 * max_count * sizeof(f32));
+
+	for (u32 count = 1; count <= max_count; ++count)
+	{
+		mat3 rot;
+		quat r;
+		vec3 translation, dir, ref_min, ref_max;
+		random_unit_quat(r);
+		quat_to_mat3(rot, r);
+		vec3_set(translation, rng_f32_range(-10.0f, 10.0f), rng_f32_range(-10.0f, 10.0f), rng_f32_range(-10.0f, 10.0f));
+		vec3_set(dir, rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f));
+		for (u32 i = 0; i < count; ++i)
+		{
+			vec3_set(v[i], rng_f32_range(-10.0f, 10.0f), rng_f32_range(-10.0f, 10.0f), rng_f32_range(-10.0f, 10.0f));
+			vec3_set(w[i], rng_f32_range(-4.0f, 4.0f), rng_f32_range(-4.0f, 4.0f), rng_f32_range(-4.0f, 4.0f));
+			random_unit_quat(q[i]);
+		}
+		/* duplicate the first vertex at the end, support must return the first maximum */
+		vec3_copy(v[count-1], v[0]);
+		for (u32 i = 0; i < count; ++i)
+		{
+			soa[0*count + i] = v[i][0];
+			soa[1*count + i] = v[i][1];
+			soa[2*count + i] = v[i][2];
+		}
+
+		vec3_batch_transform_scalar(ref, v, count, rot, translation);
+		vec3_batch_bounds_scalar(ref_min, ref_max, v, count, rot);
+		const u32 ref_support = vec3_batch_support_scalar(v, count, dir);
+		memcpy(q_ref, q, count * sizeof(quat));
+		quat_batch_integrate_scalar(q_ref, w, count, 1.0f / 60.0f);
+
+		for (enum math_isa isa = 0; isa < MATH_ISA_COUNT; ++isa)
+		{
+			if (!math_isa_runnable(isa, widest))
+			{
+				continue;
+			}
+
+			vec3 min, max;
+			math_batch_init(isa);
+			vec3_batch_transform(out, v, count, rot, translation);
+			vec3_batch_bounds(min, max, v, count, rot);
+			const u32 support = vec3_batch_support(v, count, dir);
+			memcpy(q_out, q, count * sizeof(quat));
+			quat_batch_integrate(q_out, w, count, 1.0f / 60.0f);
+
+			/* kernels must be bit-identical to the scalar kernels */
+			TEST_EQUAL(0, memcmp(out, ref, count * sizeof(vec3)));
+			TEST_EQUAL(0, memcmp(min, ref_min, sizeof(vec3)));
+			TEST_EQUAL(0, memcmp(max, ref_max, sizeof(vec3)));
+			TEST_EQUAL(ref_support, support);
+			TEST_EQUAL(0, memcmp(q_out, q_ref, count * sizeof(quat)));
+
+			/* in-place transform */
+			memcpy(out, v, count * sizeof(vec3));
+			vec3_batch_transform(out, out, count, rot, translation);
+			TEST_EQUAL(0, memcmp(out, ref, count * sizeof(vec3)));
+
+			/* SoA kernels must agree with the AoS kernels */
+			vec3_soa_batch_transform(out, soa + 0*count, soa + 1*count, soa + 2*count, count, rot, translation);
+			TEST_EQUAL(0, memcmp(out, ref, count * sizeof(vec3)));
+			TEST_EQUAL(ref_support, vec3_soa_batch_support(soa + 0*count, soa + 1*count, soa + 2*count, count, dir));
+		}
+	}
+
+	math_batch_init(widest);
+	arena_pop_record(env->mem_1);
+
+	return output;
+}
+
+static struct test_output dcel_hill_climb_support_assert(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	const enum math_isa widest = g_math_isa;
+	const u32 point_count[] = { 256, 12 };
+
+	arena_push_record(env->mem_1);
+	for (u32 h = 0; h < sizeof(point_count) / sizeof(point_count[0]); ++h)
+	{
+		vec3ptr p = arena_push(env->mem_1, point_count[h] * sizeof(vec3));
+		for (u32 i = 0; i < point_count[h]; ++i)
+		{
+			/* points on an ellipsoid, every fourth point pulled inside the hull */
+			vec3 d;
+			vec3_set(d, rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f));
+			const f32 len = (i % 4 == 0) ? 0.5f : 1.0f;
+			vec3_normalize(d, d);
+			vec3_set(p[i], 1.0f*len*d[0], 2.0f*len*d[1], 3.0f*len*d[2]);
+		}
+
+		/* the large hull is hill climbed, the small one goes through the SoA support kernel */
+		const struct dcel hull = dcel_convex_hull(env->mem_1, p, point_count[h], 100.0f*F32_EPSILON);
+		TEST_EQUAL(h == 0, hull.v_count >= DCEL_HILL_CLIMB_MIN_VERTEX_COUNT);
+		TEST_NOT_ZERO(hull.v_edge);
+		TEST_NOT_ZERO(hull.v_soa);
+
+		vec3ptr ref = arena_push(env->mem_1, hull.v_count * sizeof(vec3));
+		vec3ptr out = arena_push(env->mem_1, hull.v_count * sizeof(vec3));
+		for (enum math_isa isa = 0; isa < MATH_ISA_COUNT; ++isa)
+		{
+			if (!math_isa_runnable(isa, widest))
+			{
+				continue;
+			}
+			math_batch_init(isa);
+
+			u32 hint = 0;
+			for (u32 i = 0; i < 1024; ++i)
+			{
+				vec3 dir;
+				vec3_set(dir, rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f));
+
+				/* hill climbing must reach the global maximum of the linear scan */
+				const u32 linear = vec3_batch_support_scalar(hull.v, hull.v_count, dir);
+				hint = dcel_vertex_support(&hull, (constvec3ptr) hull.v, dir, hint);
+				TEST_EQUAL(vec3_dot(dir, hull.v[linear]), vec3_dot(dir, hull.v[hint]));
+			}
+
+			/* transforming the SoA copy must match the AoS vertices */
+			mat3 rot;
+			quat r;
+			vec3 translation;
+			random_unit_quat(r);
+			quat_to_mat3(rot, r);
+			vec3_set(translation, rng_f32_range(-10.0f, 10.0f), rng_f32_range(-10.0f, 10.0f), rng_f32_range(-10.0f, 10.0f));
+			vec3_batch_transform_scalar(ref, hull.v, hull.v_count, rot, translation);
+			dcel_vertex_transform(out, &hull, rot, translation);
+			TEST_EQUAL(0, memcmp(out, ref, hull.v_count * sizeof(vec3)));
 		}
+		math_batch_init(widest);
 	}
 
+	arena_pop_record(env->mem_1);
 
 	return output;
 }
@@ -71,6 +253,8 @@ static struct test_output matrix_inverse_assert(struct test_environment *env)
 static struct test_output (*math_tests[])(struct test_environment *) =
 {
 	matrix_inverse_assert,
+	math_batch_isa_equal_assert,
+	dcel_hill_climb_support_assert,
 };
 
 struct suite m_math_suite =
@@ -81,3 +265,159 @@ struct suite m_math_suite =
 };
 
 struct suite *math_suite = &m_math_suite;
+
+/********************************** Batch Kernel Performance **********************************/
+
+#define MATH_BATCH_PERF_COUNT	4096
+
+struct math_batch_perf
+{
+	enum math_isa	isa_restore;
+	vec3ptr		v;
+	f32 *		soa;
+	vec3ptr		out;
+	vec3ptr		w;
+	quatptr		q;
+	quatptr		q_init;
+	mat3		rot;
+	vec3		translation;
+	vec3		dir;
+};
+
+static void *math_batch_perf_init(const enum math_isa isa)
+{
+	struct math_batch_perf *perf = malloc(sizeof(struct math_batch_perf));
+	perf->isa_restore = g_math_isa;
+	perf->v = malloc(MATH_BATCH_PERF_COUNT * sizeof(vec3));
+	perf->soa = malloc(3 * MATH_BATCH_PERF_COUNT * sizeof(f32));
+	perf->out = malloc(MATH_BATCH_PERF_COUNT * sizeof(vec3));
+	perf->w = malloc(MATH_BATCH_PERF_COUNT * sizeof(vec3));
+	perf->q = malloc(MATH_BATCH_PERF_COUNT * sizeof(quat));
+	perf->q_init = malloc(MATH_BATCH_PERF_COUNT * sizeof(quat));
+
+	quat r;
+	random_unit_quat(r);
+	quat_to_mat3(perf->rot, r);
+	vec3_set(perf->translation, 1.0f, 2.0f, 3.0f);
+	vec3_set(perf->dir, rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f), rng_f32_range(-1.0f, 1.0f));
+	for (u32 i = 0; i < MATH_BATCH_PERF_COUNT; ++i)
+	{
+		vec3_set(perf->v[i], rng_f32_range(-10.0f, 10.0f), rng_f32_range(-10.0f, 10.0f), rng_f32_range(-10.0f, 10.0f));
+		vec3_set(perf->w[i], rng_f32_range(-4.0f, 4.0f), rng_f32_range(-4.0f, 4.0f), rng_f32_range(-4.0f, 4.0f));
+		random_unit_quat(perf->q_init[i]);
+		perf->soa[0*MATH_BATCH_PERF_COUNT + i] = perf->v[i][0];
+		perf->soa[1*MATH_BATCH_PERF_COUNT + i] = perf->v[i][1];
+		perf->soa[2*MATH_BATCH_PERF_COUNT + i] = perf->v[i][2];
+	}
+	memcpy(perf->q, perf->q_init, MATH_BATCH_PERF_COUNT * sizeof(quat));
+
+	if (!math_isa_runnable(isa, perf->isa_restore))
+	{
+		fprintf(stdout, "\t\t%s is not available, measuring %s\n", math_isa_cstr[isa], math_isa_cstr[MATH_ISA_SCALAR]);
+		math_batch_init(MATH_ISA_SCALAR);
+	}
+	else
+	{
+		math_batch_init(isa);
+	}
+
+	return perf;
+}
+
+static void *math_batch_perf_init_scalar(void) { return math_batch_perf_init(MATH_ISA_SCALAR); }
+static void *math_batch_perf_init_sse4_1(void) { return math_batch_perf_init(MATH_ISA_SSE4_1); }
+static void *math_batch_perf_init_avx2(void) { return math_batch_perf_init(MATH_ISA_AVX2); }
+static void *math_batch_perf_init_simd128(void) { return math_batch_perf_init(MATH_ISA_SIMD128); }
+
+static void math_batch_perf_reset(void *args)
+{
+	struct math_batch_perf *perf = args;
+	memcpy(perf->q, perf->q_init, MATH_BATCH_PERF_COUNT * sizeof(quat));
+}
+
+static void math_batch_perf_free(void *args)
+{
+	struct math_batch_perf *perf = args;
+	math_batch_init(perf->isa_restore);
+	free(perf->v);
+	free(perf->soa);
+	free(perf->out);
+	free(perf->w);
+	free(perf->q);
+	free(perf->q_init);
+	free(perf);
+}
+
+static void vec3_batch_transform_test(void *args)
+{
+	struct math_batch_perf *perf = args;
+	vec3_batch_transform(perf->out, perf->v, MATH_BATCH_PERF_COUNT, perf->rot, perf->translation);
+}
+
+static void vec3_batch_bounds_test(void *args)
+{
+	struct math_batch_perf *perf = args;
+	vec3_batch_bounds(perf->out[0], perf->out[1], perf->v, MATH_BATCH_PERF_COUNT, perf->rot);
+}
+
+static void vec3_batch_support_test(void *args)
+{
+	struct math_batch_perf *perf = args;
+	perf->out[0][0] = (f32) vec3_batch_support(perf->v, MATH_BATCH_PERF_COUNT, perf->dir);
+}
+
+static void vec3_soa_batch_transform_test(void *args)
+{
+	struct math_batch_perf *perf = args;
+	const f32 *soa = perf->soa;
+	vec3_soa_batch_transform(perf->out, soa, soa + MATH_BATCH_PERF_COUNT, soa + 2*MATH_BATCH_PERF_COUNT, MATH_BATCH_PERF_COUNT, perf->rot, perf->translation);
+}
+
+static void vec3_soa_batch_support_test(void *args)
+{
+	struct math_batch_perf *perf = args;
+	const f32 *soa = perf->soa;
+	perf->out[0][0] = (f32) vec3_soa_batch_support(soa, soa + MATH_BATCH_PERF_COUNT, soa + 2*MATH_BATCH_PERF_COUNT, MATH_BATCH_PERF_COUNT, perf->dir);
+}
+
+static void quat_batch_integrate_test(void *args)
+{
+	struct math_batch_perf *perf = args;
+	quat_batch_integrate(perf->q, perf->w, MATH_BATCH_PERF_COUNT, 1.0f / 60.0f);
+}
+
+#define MATH_BATCH_SERIAL_TEST(kernel, bytes, isa)			\
+	{								\
+		.id = #kernel "_" #isa,					\
+		.size = (bytes),					\
+		.test = &kernel##_test,					\
+		.test_init = &math_batch_perf_init_##isa,		\
+		.test_reset = &math_batch_perf_reset,			\
+		.test_free = &math_batch_perf_free,			\
+	}
+
+#define MATH_BATCH_SERIAL_TESTS(kernel, bytes)				\
+	MATH_BATCH_SERIAL_TEST(kernel, bytes, scalar),			\
+	MATH_BATCH_SERIAL_TEST(kernel, bytes, sse4_1),			\
+	MATH_BATCH_SERIAL_TEST(kernel, bytes, avx2),			\
+	MATH_BATCH_SERIAL_TEST(kernel, bytes, simd128)
+
+struct serial_test math_serial_test[] =
+{
+	MATH_BATCH_SERIAL_TESTS(vec3_batch_transform, MATH_BATCH_PERF_COUNT*sizeof(vec3)),
+	MATH_BATCH_SERIAL_TESTS(vec3_batch_bounds, MATH_BATCH_PERF_COUNT*sizeof(vec3)),
+	MATH_BATCH_SERIAL_TESTS(vec3_batch_support, MATH_BATCH_PERF_COUNT*sizeof(vec3)),
+	MATH_BATCH_SERIAL_TESTS(vec3_soa_batch_transform, MATH_BATCH_PERF_COUNT*sizeof(vec3)),
+	MATH_BATCH_SERIAL_TESTS(vec3_soa_batch_support, MATH_BATCH_PERF_COUNT*sizeof(vec3)),
+	MATH_BATCH_SERIAL_TESTS(quat_batch_integrate, MATH_BATCH_PERF_COUNT*(sizeof(vec3) + sizeof(quat))),
+};
+
+struct performance_suite storage_performance_math_suite =
+{
+	.id = "Math Batch Kernel Performance",
+	.serial_test = math_serial_test,
+	.serial_test_count = sizeof(math_serial_test) / sizeof(math_serial_test[0]),
+	.counters = 1,
+};
+
+struct performance_suite *math_performance_suite = &storage_performance_math_suite;
@@ -0,0 +1,1547 @@
+/*
+==========================================================================
+    Copyright (C) 2025 Axel Sandstedt 
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+#include <math.h>
+
+#include "test_local.h"
+#include "collision.h"
+#include "dynamics.h"
+#include "sort.h"
+
+struct broadphase_input
+{
+	struct bvh	bvh;
+	struct arena	mem;
+	u32		body_count;
+};
+
+static void *broadphase_init(const u32 body_count)
+{
+	struct broadphase_input *input = malloc(sizeof(struct broadphase_input));
+	input->body_count = body_count;
+	input->bvh = dbvh_alloc(NULL, 2*body_count, GROWABLE);
+	input->mem = arena_alloc(64*1024*1024);
+
+	/* keep the box density fixed so that the expected overlap count per body is independent of body_count */
+	const f32 side = 2.0f * cbrtf((f32) body_count);
+	struct AABB bbox;
+	for (u32 i = 0; i < body_count; ++i)
+	{
+		bbox.center[0] = rng_f32_range(0.0f, side);
+		bbox.center[1] = rng_f32_range(0.0f, side);
+		bbox.center[2] = rng_f32_range(0.0f, side);
+		bbox.hw[0] = rng_f32_range(0.25f, 0.75f);
+		bbox.hw[1] = rng_f32_range(0.25f, 0.75f);
+		bbox.hw[2] = rng_f32_range(0.25f, 0.75f);
+		dbvh_insert(&input->bvh, i, &bbox);
+	}
+
+	return input;
+}
+
+static void broadphase_reset(void *args)
+{
+	struct broadphase_input *input = args;
+	arena_flush(&input->mem);
+	task_context_frame_clear();
+}
+
+static void broadphase_free(void *args)
+{
+	struct broadphase_input *input = args;
+	bvh_free(&input->bvh);
+	arena_free(&input->mem);
+	free(input);
+}
+
+static void *broadphase_1k_init(void) { return broadphase_init(1000); }
+static void *broadphase_10k_init(void) { return broadphase_init(10000); }
+static void *broadphase_100k_init(void) { return broadphase_init(100000); }
+
+static void broadphase_serial_overlap_test(void *args)
+{
+	struct broadphase_input *input = args;
+	u32 count;
+	dbvh_push_overlap_pairs(&input->mem, &count, &input->bvh);
+}
+
+static void broadphase_parallel_overlap_test(void *args)
+{
+	struct broadphase_input *input = args;
+	u32 count;
+	dbvh_parallel_push_overlap_pairs(&input->mem, &count, &input->bvh);
+}
+
+struct scene
+{
+	struct physics_pipeline	pipeline;
+	struct string_database	shape_db;
+	struct string_database	prefab_db;
+	struct arena		mem;
+};
+
+static struct rigid_body_prefab *scene_shape_prefab_add(struct scene *scene, const char *id, const struct collision_shape *shape, const u32 dynamic)
+{
+	struct slot slot = string_database_add_and_alias(&scene->shape_db, utf8_cstr(&scene->mem, id));
+	struct collision_shape *new_shape = slot.address;
+	new_shape->type = shape->type;
+	new_shape->center_of_mass_localized = shape->center_of_mass_localized;
+	switch (shape->type)
+	{
+		case COLLISION_SHAPE_SPHERE: { new_shape->sphere = shape->sphere; } break;
+		case COLLISION_SHAPE_CAPSULE: { new_shape->capsule = shape->capsule; } break;
+		case COLLISION_SHAPE_CONVEX_HULL: { new_shape->hull = shape->hull; } break;
+		case COLLISION_SHAPE_TRI_MESH: { new_shape->mesh_bvh = shape->mesh_bvh; } break;
+		default: { kas_assert_string(0, "unexpected collision shape type"); } break;
+	}
+	const u32 shape_handle = slot.index;
+
+	slot = string_database_add_and_alias(&scene->prefab_db, utf8_cstr(&scene->mem, id));
+	struct rigid_body_prefab *prefab = slot.address;
+	prefab->shape = shape_handle;
+	prefab->density = 1.0f;
+	prefab->restitution = 0.0f;
+	prefab->friction = 0.5f;
+	prefab->dynamic = dynamic;
+	prefab->bullet = 0;
+	if (shape->type == COLLISION_SHAPE_TRI_MESH)
+	{
+		/* meshes are static only, so their mass properties are never used */
+		kas_assert(!dynamic);
+		prefab->mass = 0.0f;
+		memset(prefab->inertia_tensor, 0, sizeof(mat3));
+		memset(prefab->inv_inertia_tensor, 0, sizeof(mat3));
+	}
+	else
+	{
+		prefab_statics_setup(prefab, new_shape, prefab->density);
+	}
+
+	return prefab;
+}
+
+static struct rigid_body_prefab *scene_prefab_add(struct scene *scene, const char *id, const vec3 hw, const u32 dynamic)
+{
+	const struct collision_shape shape = 
+	{
+		.type = COLLISION_SHAPE_CONVEX_HULL,
+		.hull = dcel_box(&scene->mem, hw),
+	};
+
+	return scene_shape_prefab_add(scene, id, &shape, dynamic);
+}
+
+/* empty pipeline at 60Hz with sleeping disabled */
+static struct scene *scene_alloc(const u32 initial_size)
+{
+	struct scene *scene = calloc(1, sizeof(struct scene));
+	scene->mem = arena_alloc(16*1024*1024);
+	scene->shape_db = string_database_alloc(NULL, 32, 32, struct collision_shape, GROWABLE);
+	scene->prefab_db = string_database_alloc(NULL, 32, 32, struct rigid_body_prefab, GROWABLE);
+	scene->pipeline = physics_pipeline_alloc(NULL, initial_size, NSEC_PER_SEC / (u64) 60, 64*1024*1024, &scene->shape_db, &scene->prefab_db);
+	/* the pending setting is applied on tick, so it must be cleared as well for sleeping to stay disabled */
+	if (g_solver_config->sleep_enabled)
+	{
+		physics_pipeline_disable_sleeping(&scene->pipeline);
+	}
+	g_solver_config->pending_sleep_enabled = 0;
+	return scene;
+}
+
+static void scene_free(struct scene *scene)
+{
+	g_solver_config->sleep_enabled = 1;
+	g_solver_config->pending_sleep_enabled = 1;
+	physics_pipeline_free(&scene->pipeline);
+	string_database_free(&scene->prefab_db);
+	string_database_free(&scene->shape_db);
+	arena_free(&scene->mem);
+	free(scene);
+}
+
+/*
+ * Box stack scene shared by the solver, sat cache and tick fixtures: stack_count stacks of unit boxes, spacing 
+ * apart along x and centered on x = 0, each stack_height high with gap between neighbouring boxes (a negative gap
+ * makes them overlap). The ground top is at y = 0.
+ */
+static void scene_box_stack_position(vec3 position, const u32 stack_count, const f32 spacing, const f32 gap, const u32 s, const u32 h)
+{
+	vec3_set(position, spacing*((f32) s - 0.5f*(f32) (stack_count - 1)), 0.5f + gap + (1.0f + gap)*h, 0.0f);
+}
+
+/*
+ * Add the box stacks, on a static ground if ground is set. The scene must be empty, so the ground is body 0 and 
+ * box (s, h) is body s*stack_height + h after the returned index of box (0, 0).
+ */
+static u32 scene_box_stacks(struct scene *scene, const u32 stack_count, const u32 stack_height, const f32 spacing, const f32 gap, const u32 ground)
+{
+	const quat identity = { 0.0f, 0.0f, 0.0f, 1.0f };
+	if (ground)
+	{
+		struct rigid_body_prefab *prefab = scene_prefab_add(scene, "ground", vec3_inline(0.5f*spacing*stack_count + 1.0f, 0.5f, 4.0f), 0);
+		physics_pipeline_rigid_body_alloc(&scene->pipeline, prefab, vec3_inline(0.0f, -0.5f, 0.0f), identity, 0);
+	}
+
+	struct rigid_body_prefab *box = scene_prefab_add(scene, "box", vec3_inline(0.5f, 0.5f, 0.5f), 1);
+	u32 first = U32_MAX;
+	for (u32 s = 0; s < stack_count; ++s)
+	{
+		for (u32 h = 0; h < stack_height; ++h)
+		{
+			vec3 position;
+			scene_box_stack_position(position, stack_count, spacing, gap, s, h);
+			const struct slot slot = physics_pipeline_rigid_body_alloc(&scene->pipeline, box, position, identity, 0);
+			first = (first == U32_MAX) ? slot.index : first;
+			kas_assert(slot.index == first + s*stack_height + h);
+		}
+	}
+
+	return first;
+}
+
+struct solver_input
+{
+	struct scene *		scene;
+	struct island		is;
+	struct contact *	contacts;
+	struct arena		mem;
+};
+
+/* the island of the resting box stack scene, with a contact between each box and whatever is below it */
+static struct solver_input *solver_init(const u32 stack_count, const u32 stack_height)
+{
+	struct solver_input *input = calloc(1, sizeof(struct solver_input));
+	input->mem = arena_alloc(64*1024*1024);
+
+	const vec3 gravity = { 0.0f, -GRAVITY_CONSTANT_DEFAULT, 0.0f };
+	contact_solver_config_init(10, 0, 0, U32_MAX, 1, gravity, 0.1f, 1000.0f, 0.1f, 0.1f, 0.001f, 0.001f, 0, 0.5f, 0.001f*0.001f, 0.01f*0.01f*2.0f*F32_PI);
+
+	const u32 body_count = stack_count*stack_height;
+	input->scene = scene_alloc((u32) power_of_two_ceil(body_count + 1));
+	const u32 first = scene_box_stacks(input->scene, stack_count, stack_height, 2.0f, 0.0f, 1);
+	const u32 ground_index = 0;
+
+	input->contacts = calloc(body_count, sizeof(struct contact));
+	input->is.body_count = body_count;
+	input->is.contact_count = body_count;
+	input->is.bodies = malloc((body_count + 1) * sizeof(struct rigid_body *));
+	input->is.contacts = malloc(body_count * sizeof(struct contact *));
+	input->is.body_index_map = malloc((body_count + 1) * sizeof(u32));
+
+	const vec2 corner[4] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f } };
+	u32 k = 0;
+	for (u32 s = 0; s < stack_count; ++s)
+	{
+		u32 below = ground_index;
+		for (u32 h = 0; h < stack_height; ++h, ++k)
+		{
+			const u32 index = first + k;
+			struct rigid_body *b = pool_address(&input->scene->pipeline.body_pool, index);
+			input->is.bodies[k] = b;
+			input->is.body_index_map[index] = k;
+
+			struct contact *c = input->contacts + k;
+			c->cm.i1 = below;
+			c->cm.i2 = index;
+			c->cm.v_count = 4;
+			vec3_set(c->cm.n, 0.0f, 1.0f, 0.0f);
+			for (u32 j = 0; j < 4; ++j)
+			{
+				vec3_set(c->cm.v[j], b->position[0] + corner[j][0], b->position[1] - 0.5f, corner[j][1]);
+				c->cm.depth[j] = 0.005f;
+			}
+			input->is.contacts[k] = c;
+			below = index;
+		}
+	}
+
+	return input;
+}
+
+static void solver_reset(void *args)
+{
+	struct solver_input *input = args;
+	arena_flush(&input->mem);
+}
+
+static void solver_free(void *args)
+{
+	struct solver_input *input = args;
+	scene_free(input->scene);
+	arena_free(&input->mem);
+	free(input->is.bodies);
+	free(input->is.contacts);
+	free(input->is.body_index_map);
+	free(input->contacts);
+	free(input);
+}
+
+static void *solver_64x16_init(void) { return solver_init(64, 16); }
+static void *solver_256x16_init(void) { return solver_init(256, 16); }
+
+static void solver_scalar_test(void *args)
+{
+	struct solver_input *input = args;
+	struct contact_solver *solver = contact_solver_init_body_data(&input->mem, &input->is, 1.0f / 60.0f);
+	contact_solver_init_velocity_constraints(&input->mem, solver, &input->scene->pipeline, &input->is);
+	for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+	{
+		contact_solver_iterate_velocity_constraints(solver);
+	}
+}
+
+static void solver_wide_test(void *args)
+{
+	struct solver_input *input = args;
+	struct contact_solver *solver = contact_solver_init_body_data(&input->mem, &input->is, 1.0f / 60.0f);
+	contact_solver_init_velocity_constraints(&input->mem, solver, &input->scene->pipeline, &input->is);
+	contact_solver_init_wide_constraints(&input->mem, solver);
+	for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+	{
+		contact_solver_iterate_wide_velocity_constraints(solver);
+	}
+	contact_solver_store_wide_impulses(solver);
+}
+
+static void solver_parallel_test(void *args)
+{
+	struct solver_input *input = args;
+	struct contact_solver *solver = contact_solver_init_body_data(&input->mem, &input->is, 1.0f / 60.0f);
+	contact_solver_init_velocity_constraints(&input->mem, solver, &input->scene->pipeline, &input->is);
+	contact_solver_init_wide_constraints(&input->mem, solver);
+	for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+	{
+		contact_solver_parallel_iterate_wide_velocity_constraints(&input->mem, solver);
+	}
+	contact_solver_store_wide_impulses(solver);
+}
+
+struct sat_cache_input
+{
+	struct scene *	scene;
+	struct arena	mem;
+	u32		stack_count;
+	u32		stack_height;
+	u64		hit_count;
+	u64		miss_count;
+};
+
+#define SAT_CACHE_STACK_SPACING	2.0f
+#define SAT_CACHE_STACK_GAP	-0.005f
+
+/* jitter the resting boxes slightly, as the solver would between frames */
+static void sat_cache_jitter(struct sat_cache_input *input)
+{
+	u32 k = 0;
+	for (u32 s = 0; s < input->stack_count; ++s)
+	{
+		for (u32 h = 0; h < input->stack_height; ++h, ++k)
+		{
+			struct rigid_body *b = pool_address(&input->scene->pipeline.body_pool, k);
+			scene_box_stack_position(b->position, input->stack_count, SAT_CACHE_STACK_SPACING, SAT_CACHE_STACK_GAP, s, h);
+			b->position[0] += rng_f32_range(-0.001f, 0.001f);
+			b->position[1] += rng_f32_range(-0.001f, 0.001f);
+			b->position[2] += rng_f32_range(-0.001f, 0.001f);
+		}
+	}
+}
+
+/* the box stack scene without ground and with overlapping neighbours, which keep persistent sat caches */
+static void *sat_cache_init(const u32 stack_count, const u32 stack_height)
+{
+	struct sat_cache_input *input = calloc(1, sizeof(struct sat_cache_input));
+	input->mem = arena_alloc(64*1024*1024);
+	input->stack_count = stack_count;
+	input->stack_height = stack_height;
+
+	input->scene = scene_alloc((u32) power_of_two_ceil(stack_count*stack_height));
+	/* without ground, box (s, h) is body s*stack_height + h */
+	scene_box_stacks(input->scene, stack_count, stack_height, SAT_CACHE_STACK_SPACING, SAT_CACHE_STACK_GAP, 0);
+	sat_cache_jitter(input);
+	arena_push_record(&input->mem);
+
+	/* warm up: let the full SAT create the caches */
+	struct physics_pipeline *pipeline = &input->scene->pipeline;
+	struct collision_result result;
+	for (u32 i = 0; i < stack_count*stack_height; ++i)
+	{
+		if (i % stack_height == stack_height - 1) { continue; }
+
+		const struct rigid_body *b1 = pool_address(&pipeline->body_pool, i);
+		const struct rigid_body *b2 = pool_address(&pipeline->body_pool, i+1);
+		body_body_contact_manifold(&input->mem, &result, pipeline, b1, b2, 0.0f);
+		if (result.type == COLLISION_SAT_CACHE)
+		{
+			sat_cache_add(&pipeline->c_db, &result.sat_cache);
+		}
+	}
+
+	return input;
+}
+
+static void sat_cache_reset(void *args)
+{
+	struct sat_cache_input *input = args;
+	arena_pop_record(&input->mem);
+	arena_push_record(&input->mem);
+	sat_cache_jitter(input);
+}
+
+static void sat_cache_free(void *args)
+{
+	struct sat_cache_input *input = args;
+	scene_free(input->scene);
+	arena_free(&input->mem);
+	free(input);
+}
+
+static void *sat_cache_64x16_init(void) { return sat_cache_init(64, 16); }
+
+/* query every resting neighbour pair once, counting sat cache hits and misses */
+static void sat_cache_query_stacks(struct sat_cache_input *input)
+{
+	const struct physics_pipeline *pipeline = &input->scene->pipeline;
+	struct collision_result result;
+	for (u32 i = 0; i < input->stack_count*input->stack_height; ++i)
+	{
+		if (i % input->stack_height == input->stack_height - 1) { continue; }
+
+		const struct rigid_body *b1 = pool_address(&pipeline->body_pool, i);
+		const struct rigid_body *b2 = pool_address(&pipeline->body_pool, i+1);
+		body_body_contact_manifold(&input->mem, &result, pipeline, b1, b2, 0.0f);
+		input->hit_count += (result.sat_query == SAT_CACHE_QUERY_HIT);
+		input->miss_count += (result.sat_query == SAT_CACHE_QUERY_MISS);
+	}
+}
+
+static void sat_cache_resting_stacks_test(void *args)
+{
+	sat_cache_query_stacks(args);
+}
+
+/* 
+ * The box stack scene under the given worker placement. Every stack is its own island, so a tick exercises the
+ * parallel narrowphase and island solve.
+ */
+static void *placement_init(const u32 stack_count, const u32 stack_height, const enum task_affinity affinity)
+{
+	test_task_context_reinit(g_arch_config->logical_core_count, affinity);
+
+	struct scene *scene = scene_alloc(8192);
+	scene_box_stacks(scene, stack_count, stack_height, 2.0f, 0.0f, 1);
+
+	/* warm up: let the stacks settle and the contact database fill */
+	for (u32 i = 0; i < 60; ++i)
+	{
+		physics_pipeline_tick(&scene->pipeline);
+	}
+
+	return scene;
+}
+
+static void placement_reset(void *args)
+{
+}
+
+static void placement_free(void *args)
+{
+	scene_free(args);
+
+	test_task_context_reinit(g_arch_config->logical_core_count, TASK_AFFINITY_NONE);
+}
+
+static void *placement_none_256x8_init(void) { return placement_init(256, 8, TASK_AFFINITY_NONE); }
+static void *placement_logical_256x8_init(void) { return placement_init(256, 8, TASK_AFFINITY_LOGICAL); }
+static void *placement_physical_256x8_init(void) { return placement_init(256, 8, TASK_AFFINITY_PHYSICAL); }
+
+static void placement_tick_test(void *args)
+{
+	struct scene *scene = args;
+	physics_pipeline_tick(&scene->pipeline);
+}
+
+struct serial_test physics_serial_test[] =
+{
+	{
+		.id = "dbvh_serial_overlap_pairs_1k",
+		.size = 1000 * sizeof(struct bvh_node),
+		.test = &broadphase_serial_overlap_test,
+		.test_init = &broadphase_1k_init,
+		.test_reset = &broadphase_reset,
+		.test_free = &broadphase_free,
+	},
+
+	{
+		.id = "dbvh_parallel_overlap_pairs_1k",
+		.size = 1000 * sizeof(struct bvh_node),
+		.test = &broadphase_parallel_overlap_test,
+		.test_init = &broadphase_1k_init,
+		.test_reset = &broadphase_reset,
+		.test_free = &broadphase_free,
+	},
+
+	{
+		.id = "dbvh_serial_overlap_pairs_10k",
+		.size = 10000 * sizeof(struct bvh_node),
+		.test = &broadphase_serial_overlap_test,
+		.test_init = &broadphase_10k_init,
+		.test_reset = &broadphase_reset,
+		.test_free = &broadphase_free,
+	},
+
+	{
+		.id = "dbvh_parallel_overlap_pairs_10k",
+		.size = 10000 * sizeof(struct bvh_node),
+		.test = &broadphase_parallel_overlap_test,
+		.test_init = &broadphase_10k_init,
+		.test_reset = &broadphase_reset,
+		.test_free = &broadphase_free,
+	},
+
+	{
+		.id = "dbvh_serial_overlap_pairs_100k",
+		.size = 100000 * sizeof(struct bvh_node),
+		.test = &broadphase_serial_overlap_test,
+		.test_init = &broadphase_100k_init,
+		.test_reset = &broadphase_reset,
+		.test_free = &broadphase_free,
+	},
+
+	{
+		.id = "dbvh_parallel_overlap_pairs_100k",
+		.size = 100000 * sizeof(struct bvh_node),
+		.test = &broadphase_parallel_overlap_test,
+		.test_init = &broadphase_100k_init,
+		.test_reset = &broadphase_reset,
+		.test_free = &broadphase_free,
+	},
+
+	{
+		.id = "contact_solver_scalar_stacks_64x16",
+		.size = 64*16 * sizeof(struct velocity_constraint),
+		.test = &solver_scalar_test,
+		.test_init = &solver_64x16_init,
+		.test_reset = &solver_reset,
+		.test_free = &solver_free,
+	},
+
+	{
+		.id = "contact_solver_wide_stacks_64x16",
+		.size = 64*16 * sizeof(struct velocity_constraint),
+		.test = &solver_wide_test,
+		.test_init = &solver_64x16_init,
+		.test_reset = &solver_reset,
+		.test_free = &solver_free,
+	},
+
+	{
+		.id = "contact_solver_scalar_stacks_256x16",
+		.size = 256*16 * sizeof(struct velocity_constraint),
+		.test = &solver_scalar_test,
+		.test_init = &solver_256x16_init,
+		.test_reset = &solver_reset,
+		.test_free = &solver_free,
+	},
+
+	{
+		.id = "contact_solver_wide_stacks_256x16",
+		.size = 256*16 * sizeof(struct velocity_constraint),
+		.test = &solver_wide_test,
+		.test_init = &solver_256x16_init,
+		.test_reset = &solver_reset,
+		.test_free = &solver_free,
+	},
+
+	{
+		.id = "contact_solver_parallel_stacks_256x16",
+		.size = 256*16 * sizeof(struct velocity_constraint),
+		.test = &solver_parallel_test,
+		.test_init = &solver_256x16_init,
+		.test_reset = &solver_reset,
+		.test_free = &solver_free,
+	},
+
+	{
+		.id = "sat_cache_resting_stacks_64x16",
+		.size = 64*15 * sizeof(struct contact_manifold),
+		.test = &sat_cache_resting_stacks_test,
+		.test_init = &sat_cache_64x16_init,
+		.test_reset = &sat_cache_reset,
+		.test_free = &sat_cache_free,
+	},
+
+	{
+		.id = "physics_tick_placement_none_256x8",
+		.size = 256*8 * sizeof(struct rigid_body),
+		.test = &placement_tick_test,
+		.test_init = &placement_none_256x8_init,
+		.test_reset = &placement_reset,
+		.test_free = &placement_free,
+	},
+
+	{
+		.id = "physics_tick_placement_logical_256x8",
+		.size = 256*8 * sizeof(struct rigid_body),
+		.test = &placement_tick_test,
+		.test_init = &placement_logical_256x8_init,
+		.test_reset = &placement_reset,
+		.test_free = &placement_free,
+	},
+
+	{
+		.id = "physics_tick_placement_physical_256x8",
+		.size = 256*8 * sizeof(struct rigid_body),
+		.test = &placement_tick_test,
+		.test_init = &placement_physical_256x8_init,
+		.test_reset = &placement_reset,
+		.test_free = &placement_free,
+	},
+};
+
+/********************************** Correctness Testing  ************************************/
+
+/* sort the pairs as (min, max) keys so that pair sets can be compared independent of traversal order */
+static struct sort_entry *overlap_pairs_sorted(struct arena *mem, const struct dbvh_overlap *overlap, const u32 count)
+{
+	struct sort_entry *entry = arena_push(mem, count*sizeof(struct sort_entry));
+	struct sort_entry *tmp = arena_push(mem, count*sizeof(struct sort_entry));
+	for (u32 i = 0; i < count; ++i)
+	{
+		const u64 lo = (overlap[i].id1 < overlap[i].id2) ? overlap[i].id1 : overlap[i].id2;
+		const u64 hi = (overlap[i].id1 < overlap[i].id2) ? overlap[i].id2 : overlap[i].id1;
+		entry[i].key = (lo << 32) | hi;
+		entry[i].value = 0;
+	}
+	sort_merge(entry, tmp, count);
+	return entry;
+}
+
+static struct test_output dbvh_parallel_serial_overlap_equal(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	/* run with several workers even on a single core machine so that the parallel path is taken */
+	const u32 thread_count = g_task_ctx->worker_count;
+	test_task_context_reinit(4, TASK_AFFINITY_NONE);
+
+	struct broadphase_input *input = broadphase_init(4*DBVH_PARALLEL_LEAF_COUNT_MIN);
+
+	u32 serial_count, parallel_count;
+	const struct dbvh_overlap *serial = dbvh_push_overlap_pairs(env->mem_1, &serial_count, &input->bvh);
+	const struct dbvh_overlap *parallel = dbvh_parallel_push_overlap_pairs(env->mem_1, &parallel_count, &input->bvh);
+
+	TEST_NOT_ZERO(serial_count);
+	TEST_EQUAL(serial_count, parallel_count);
+
+	const struct sort_entry *serial_sorted = overlap_pairs_sorted(env->mem_1, serial, serial_count);
+	const struct sort_entry *parallel_sorted = overlap_pairs_sorted(env->mem_1, parallel, parallel_count);
+	for (u32 i = 0; i < serial_count; ++i)
+	{
+		TEST_EQUAL(serial_sorted[i].key, parallel_sorted[i].key);
+		/* no pair may be reported twice */
+		if (i)
+		{
+			TEST_TRUE(serial_sorted[i-1].key < serial_sorted[i].key);
+		}
+	}
+
+	broadphase_free(input);
+	task_context_frame_clear();
+	test_task_context_reinit(thread_count, TASK_AFFINITY_NONE);
+
+	return output;
+}
+
+static const struct AABB *proxy_pairs_body_proxy(const struct physics_pipeline *pipeline, const struct rigid_body *b)
+{
+	const struct bvh *tree = (b->flags & RB_DYNAMIC) ? &pipeline->dynamic_tree : &pipeline->static_tree;
+	const struct bvh_node *node = pool_address(&tree->tree.pool, b->proxy);
+	return &node->bbox;
+}
+
+/* the persistent pair set must equal the set of overlapping proxies containing a dynamic body */
+static struct test_output proxy_pairs_match_brute_force(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	struct scene *input = scene_alloc(256);
+	struct physics_pipeline *pipeline = &input->pipeline;
+
+	struct rigid_body_prefab *ground = scene_prefab_add(input, "ground", vec3_inline(8.0f, 0.5f, 8.0f), 0);
+	struct rigid_body_prefab *pillar = scene_prefab_add(input, "pillar", vec3_inline(0.5f, 2.0f, 0.5f), 0);
+	struct rigid_body_prefab *box = scene_prefab_add(input, "box", vec3_inline(0.5f, 0.5f, 0.5f), 1);
+
+	const quat identity = { 0.0f, 0.0f, 0.0f, 1.0f };
+	physics_pipeline_rigid_body_alloc(pipeline, ground, vec3_inline(0.0f, -0.5f, 0.0f), identity, 0);
+	physics_pipeline_rigid_body_alloc(pipeline, pillar, vec3_inline(3.0f, 2.0f, 3.0f), identity, 0);
+
+	const u32 box_count = 64;
+	u32 *handle = arena_push(env->mem_1, box_count*sizeof(u32));
+	for (u32 i = 0; i < box_count; ++i)
+	{
+		const vec3 position = { rng_f32_range(-6.0f, 6.0f), rng_f32_range(0.5f, 6.0f), rng_f32_range(-6.0f, 6.0f) };
+		handle[i] = physics_pipeline_rigid_body_alloc(pipeline, box, position, identity, 0).index;
+	}
+
+	for (u32 frame = 0; frame < 90; ++frame)
+	{
+		/* churn: remove and re-add bodies and statics so that pairs of removed bodies are exercised */
+		if (frame % 10 == 5)
+		{
+			for (u32 i = frame % 4; i < box_count; i += 8)
+			{
+				physics_pipeline_rigid_body_tag_for_removal(pipeline, handle[i]);
+				const vec3 position = { rng_f32_range(-6.0f, 6.0f), rng_f32_range(0.5f, 6.0f), rng_f32_range(-6.0f, 6.0f) };
+				handle[i] = physics_pipeline_rigid_body_alloc(pipeline, box, position, identity, 0).index;
+			}
+		}
+		if (frame == 45)
+		{
+			physics_pipeline_rigid_body_alloc(pipeline, pillar, vec3_inline(-3.0f, 2.0f, -3.0f), identity, 0);
+		}
+
+		physics_pipeline_tick(pipeline);
+
+		arena_push_record(env->mem_1);
+		u32 count = 0;
+		struct dbvh_overlap *overlap = (struct dbvh_overlap *) env->mem_1->stack_ptr;
+		const struct rigid_body *b1 = NULL;
+		for (u32 i = pipeline->body_non_marked_list.first; i != DLL_NULL; i = DLL_NEXT(b1))
+		{
+			b1 = pool_address(&pipeline->body_pool, i);
+			const struct rigid_body *b2 = NULL;
+			for (u32 j = pipeline->body_non_marked_list.first; j != DLL_NULL; j = DLL_NEXT(b2))
+			{
+				b2 = pool_address(&pipeline->body_pool, j);
+				if (i < j && ((b1->flags | b2->flags) & RB_DYNAMIC)
+					&& AABB_test(proxy_pairs_body_proxy(pipeline, b1), proxy_pairs_body_proxy(pipeline, b2)))
+				{
+					struct dbvh_overlap pair = { .id1 = i, .id2 = j };
+					arena_push_packed_memcpy(env->mem_1, &pair, sizeof(pair));
+					count += 1;
+				}
+			}
+		}
+
+		TEST_EQUAL(count, pipeline->proxy_overlap_count);
+		const struct sort_entry *expected = overlap_pairs_sorted(env->mem_1, overlap, count);
+		const struct sort_entry *actual = overlap_pairs_sorted(env->mem_1, pipeline->proxy_overlap, pipeline->proxy_overlap_count);
+		for (u32 i = 0; i < count; ++i)
+		{
+			TEST_EQUAL(expected[i].key, actual[i].key);
+		}
+		arena_pop_record(env->mem_1);
+	}
+
+	scene_free(input);
+
+	return output;
+}
+
+/* every static must own exactly one leaf of the static tree, whether it was inserted incrementally or rebuilt */
+static u32 static_tree_consistent(const struct physics_pipeline *pipeline, const u32 static_count)
+{
+	if (bt_leaf_count(&pipeline->static_tree.tree) != static_count)
+	{
+		return 0;
+	}
+
+	const struct rigid_body *b = NULL;
+	for (u32 i = pipeline->body_non_marked_list.first; i != DLL_NULL; i = DLL_NEXT(b))
+	{
+		b = pool_address(&pipeline->body_pool, i);
+		if ((b->flags & RB_DYNAMIC) == 0)
+		{
+			const struct bvh_node *node = pool_address(&pipeline->static_tree.tree.pool, b->proxy);
+			if (!POOL_SLOT_ALLOCATED(node) || !BT_IS_LEAF(node) || node->bt_left != i)
+			{
+				return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+static struct test_output static_tree_deferred_rebuild(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	struct scene *input = scene_alloc(256);
+	struct physics_pipeline *pipeline = &input->pipeline;
+	struct rigid_body_prefab *pillar = scene_prefab_add(input, "pillar", vec3_inline(0.5f, 2.0f, 0.5f), 0);
+	struct rigid_body_prefab *box = scene_prefab_add(input, "box", vec3_inline(0.5f, 0.5f, 0.5f), 1);
+	const quat identity = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+	/* a single static is inserted and removed without any rebuild */
+	u32 single = physics_pipeline_rigid_body_alloc(pipeline, pillar, vec3_inline(0.0f, 2.0f, 0.0f), identity, 0).index;
+	physics_pipeline_rigid_body_alloc(pipeline, box, vec3_inline(0.0f, 4.5f, 0.0f), identity, 0);
+	TEST_EQUAL(pipeline->static_tree_dirty, 0);
+	TEST_TRUE(static_tree_consistent(pipeline, 1));
+	physics_pipeline_tick(pipeline);
+	physics_pipeline_rigid_body_tag_for_removal(pipeline, single);
+	physics_pipeline_tick(pipeline);
+	TEST_EQUAL(pipeline->static_tree_dirty, 0);
+	TEST_TRUE(static_tree_consistent(pipeline, 0));
+
+	/* few edits relative to the tree size are kept incremental */
+	const u32 static_count = 4*STATIC_TREE_REBUILD_EDIT_FRACTION*STATIC_TREE_REBUILD_EDIT_MIN;
+	u32 *handle = arena_push(env->mem_1, static_count*sizeof(u32));
+	for (u32 i = 0; i < static_count; ++i)
+	{
+		handle[i] = physics_pipeline_rigid_body_alloc(pipeline, pillar, vec3_inline(2.0f*(i % 16), 2.0f, 2.0f*(i / 16)), identity, 0).index;
+	}
+	TEST_EQUAL(pipeline->static_tree_dirty, 1);
+	physics_pipeline_tick(pipeline);
+	TEST_EQUAL(pipeline->static_tree_edit_count, 0);
+	TEST_TRUE(static_tree_consistent(pipeline, static_count));
+
+	for (u32 i = 0; i < STATIC_TREE_REBUILD_EDIT_MIN - 1; ++i)
+	{
+		physics_pipeline_rigid_body_tag_for_removal(pipeline, handle[i]);
+	}
+	physics_pipeline_tick(pipeline);
+	TEST_EQUAL(pipeline->static_tree_dirty, 0);
+	TEST_EQUAL(pipeline->static_tree_edit_count, STATIC_TREE_REBUILD_EDIT_MIN - 1);
+	TEST_TRUE(static_tree_consistent(pipeline, static_count - (STATIC_TREE_REBUILD_EDIT_MIN - 1)));
+
+	/* enough edits defer to a single rebuild */
+	for (u32 i = STATIC_TREE_REBUILD_EDIT_MIN - 1; i < static_count; ++i)
+	{
+		physics_pipeline_rigid_body_tag_for_removal(pipeline, handle[i]);
+	}
+	physics_pipeline_tick(pipeline);
+	TEST_EQUAL(pipeline->static_tree_edit_count, 0);
+	TEST_TRUE(static_tree_consistent(pipeline, 0));
+
+	scene_free(input);
+
+	return output;
+}
+
+/* reserve the manifolds' contacts and sat caches in order, then link them shard by shard (in reverse order) */
+static void c_db_link_batch(struct arena *mem, struct physics_pipeline *pipeline, const struct contact_manifold *cm, const u32 count, const u32 shard_count)
+{
+	arena_push_record(mem);
+	struct c_db_link *link = arena_push(mem, count*sizeof(struct c_db_link));
+	u32 *sat_link = arena_push(mem, count*sizeof(u32));
+	for (u32 i = 0; i < count; ++i)
+	{
+		const u32 lo = (cm[i].i1 < cm[i].i2) ? cm[i].i1 : cm[i].i2;
+		const u32 hi = (cm[i].i1 < cm[i].i2) ? cm[i].i2 : cm[i].i1;
+		const struct sat_cache sat_cache = 
+		{ 
+			.type = SAT_CACHE_SEPARATION, 
+			.separation = cm[i].v[0][0], 
+			.key = key_gen_u32_u32(lo, hi),
+		};
+		sat_link[i] = sat_cache_reserve(&pipeline->c_db, &sat_cache);
+		link[i].cm = cm + i;
+		link[i].index = c_db_reserve_contact(pipeline, cm[i].i1, cm[i].i2);
+	}
+
+	c_db_shard_link_prepare(&pipeline->c_db);
+	for (u32 shard = shard_count; shard--; )
+	{
+		c_db_shard_link_contacts(pipeline, link, count, shard, shard_count);
+		sat_cache_shard_link(&pipeline->c_db, sat_link, count, shard, shard_count);
+	}
+	arena_pop_record(mem);
+}
+
+/*
+ * link contacts and sat caches between the given body pairs in two batches, so that the second batch is prepended
+ * to lists filled by the first, and push a snapshot of the database: (contact index, contact tag, sat cache index, 
+ * sat cache tag) of each pair followed by the contact list of each body terminated by NLL_NULL. 
+ */
+static u32 *c_db_link_snapshot(struct arena *mem, u32 *snapshot_len, const u32 *pair, const u32 pair_count, const u32 body_count, const u32 shard_count)
+{
+	struct scene *input = scene_alloc(body_count);
+	struct physics_pipeline *pipeline = &input->pipeline;
+	struct rigid_body_prefab *box = scene_prefab_add(input, "box", vec3_inline(0.5f, 0.5f, 0.5f), 1);
+
+	const quat identity = { 0.0f, 0.0f, 0.0f, 1.0f };
+	u32 *handle = arena_push(&input->mem, body_count*sizeof(u32));
+	for (u32 i = 0; i < body_count; ++i)
+	{
+		handle[i] = physics_pipeline_rigid_body_alloc(pipeline, box, vec3_inline(4.0f*i, 0.0f, 0.0f), identity, 0).index;
+	}
+
+	struct contact_manifold *cm = arena_push(&input->mem, pair_count*sizeof(struct contact_manifold));
+	memset(cm, 0, pair_count*sizeof(struct contact_manifold));
+	for (u32 i = 0; i < pair_count; ++i)
+	{
+		cm[i].i1 = handle[pair[2*i + 0]];
+		cm[i].i2 = handle[pair[2*i + 1]];
+		cm[i].v_count = 1;
+		vec3_set(cm[i].n, 0.0f, 1.0f, 0.0f);
+		vec3_set(cm[i].v[0], (f32) i, 0.0f, 0.0f);
+		cm[i].depth[0] = 0.01f;
+	}
+
+	c_db_link_batch(&input->mem, pipeline, cm, pair_count / 2, shard_count);
+	c_db_link_batch(&input->mem, pipeline, cm + pair_count / 2, pair_count - pair_count / 2, shard_count);
+
+	const struct contact_database *c_db = &pipeline->c_db;
+	u32 *snapshot = (u32 *) mem->stack_ptr;
+	*snapshot_len = 0;
+	for (u32 i = 0; i < pair_count; ++i)
+	{
+		const u32 ci = c_db_lookup_contact_index(c_db, cm[i].i1, cm[i].i2);
+		const struct contact *c = (ci != NLL_NULL) ? nll_address(&c_db->contact_net, ci) : NULL;
+		const u32 lo = (cm[i].i1 < cm[i].i2) ? cm[i].i1 : cm[i].i2;
+		const u32 hi = (cm[i].i1 < cm[i].i2) ? cm[i].i2 : cm[i].i1;
+		const struct sat_cache *sat = sat_cache_lookup(c_db, lo, hi);
+		const u32 entry[4] =
+		{
+			ci,
+			(c) ? (u32) c->cm.v[0][0] : U32_MAX,
+			(sat) ? pool_index(&c_db->sat_cache_pool, sat) : U32_MAX,
+			(sat) ? (u32) sat->separation : U32_MAX,
+		};
+		arena_push_packed_memcpy(mem, entry, sizeof(entry));
+		*snapshot_len += 4;
+	}
+
+	for (u32 i = 0; i < body_count; ++i)
+	{
+		const struct rigid_body *b = pool_address(&pipeline->body_pool, handle[i]);
+		u32 ci = b->first_contact_index;
+		while (1)
+		{
+			arena_push_packed_memcpy(mem, &ci, sizeof(u32));
+			*snapshot_len += 1;
+			if (ci == NLL_NULL)
+			{
+				break;
+			}
+			const struct contact *c = nll_address(&c_db->contact_net, ci);
+			ci = c->nll_next[(CONTACT_KEY_TO_BODY_0(c->key) == handle[i]) ? 0 : 1];
+		}
+	}
+
+	scene_free(input);
+
+	return snapshot;
+}
+
+/* contacts and sat caches linked by several shards must equal the ones linked serially by a single shard */
+static struct test_output c_db_sharded_link_serial_equal(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	const u32 body_count = 64;
+	const u32 pair_count = 512;
+
+	/* unique random body pairs in random order */
+	u8 *paired = arena_push(env->mem_1, body_count*body_count);
+	memset(paired, 0, body_count*body_count);
+	u32 *pair = arena_push(env->mem_1, 2*pair_count*sizeof(u32));
+	for (u32 i = 0; i < pair_count; )
+	{
+		const u32 b1 = (u32) rng_u64_range(0, body_count-1);
+		const u32 b2 = (u32) rng_u64_range(0, body_count-1);
+		if (b1 != b2 && !paired[b1*body_count + b2])
+		{
+			paired[b1*body_count + b2] = 1;
+			paired[b2*body_count + b1] = 1;
+			pair[2*i + 0] = b1;
+			pair[2*i + 1] = b2;
+			i += 1;
+		}
+	}
+
+	u32 serial_len, sharded_len;
+	const u32 *serial = c_db_link_snapshot(env->mem_1, &serial_len, pair, pair_count, body_count, 1);
+	const u32 *sharded = c_db_link_snapshot(env->mem_1, &sharded_len, pair, pair_count, body_count, 7);
+
+	/* every pair is found with its own data, and every body list holds exactly its pairs */
+	TEST_EQUAL(serial_len, 4*pair_count + 2*pair_count + body_count);
+	for (u32 i = 0; i < pair_count; ++i)
+	{
+		TEST_TRUE(serial[4*i + 0] != NLL_NULL);
+		TEST_EQUAL(serial[4*i + 1], i);
+		TEST_TRUE(serial[4*i + 2] != U32_MAX);
+		TEST_EQUAL(serial[4*i + 3], i);
+	}
+
+	TEST_EQUAL(serial_len, sharded_len);
+	for (u32 i = 0; i < serial_len; ++i)
+	{
+		TEST_EQUAL(serial[i], sharded[i]);
+	}
+
+	return output;
+}
+
+static u32 vec3_approx_equal(const vec3 a, const vec3 b, const f32 tolerance)
+{
+	return f32_abs(a[0] - b[0]) <= tolerance
+		&& f32_abs(a[1] - b[1]) <= tolerance
+		&& f32_abs(a[2] - b[2]) <= tolerance;
+}
+
+/* 
+ * Run the scalar and the wide solver on the same island and compare the resulting velocities and positions.
+ * With a single contact per body the constraints are independent and the solvers must agree up to rounding; in
+ * stacks the iteration order differs, so both are iterated until converged and compared with a looser bound.
+ */
+static u32 solver_wide_scalar_agree(struct test_environment *env, const u32 stack_count, const u32 stack_height, const u32 iteration_count, const f32 tolerance)
+{
+	const struct contact_solver_config config = *g_solver_config;
+	struct solver_input *input = solver_init(stack_count, stack_height);
+	g_solver_config->iteration_count = iteration_count;
+	const f32 timestep = 1.0f / 60.0f;
+
+	struct contact_solver *scalar = contact_solver_init_body_data(env->mem_1, &input->is, timestep);
+	contact_solver_init_velocity_constraints(env->mem_1, scalar, &input->scene->pipeline, &input->is);
+	for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+	{
+		contact_solver_iterate_velocity_constraints(scalar);
+	}
+
+	struct contact_solver *wide = contact_solver_init_body_data(env->mem_1, &input->is, timestep);
+	contact_solver_init_velocity_constraints(env->mem_1, wide, &input->scene->pipeline, &input->is);
+	contact_solver_init_wide_constraints(env->mem_1, wide);
+	for (u32 i = 0; i < g_solver_config->iteration_count; ++i)
+	{
+		contact_solver_iterate_wide_velocity_constraints(wide);
+	}
+	contact_solver_store_wide_impulses(wide);
+
+	u32 agree = (wide->bundle_count > 0);
+	for (u32 i = 0; i < input->is.body_count && agree; ++i)
+	{
+		vec3 scalar_position, wide_position;
+		vec3_copy(scalar_position, input->is.bodies[i]->position);
+		vec3_copy(wide_position, input->is.bodies[i]->position);
+		vec3_translate_scaled(scalar_position, scalar->linear_velocity[i], timestep);
+		vec3_translate_scaled(wide_position, wide->linear_velocity[i], timestep);
+
+		agree = vec3_approx_equal(scalar->linear_velocity[i], wide->linear_velocity[i], tolerance)
+			&& vec3_approx_equal(scalar->angular_velocity[i], wide->angular_velocity[i], tolerance)
+			&& vec3_approx_equal(scalar_position, wide_position, tolerance*timestep);
+	}
+
+	for (u32 i = 0; i < input->is.contact_count && agree; ++i)
+	{
+		for (u32 j = 0; j < scalar->vcs[i].vcp_count; ++j)
+		{
+			const f32 scale = f32_max(1.0f, f32_abs(scalar->vcs[i].vcps[j].normal_impulse));
+			agree = agree && f32_abs(scalar->vcs[i].vcps[j].normal_impulse - wide->vcs[i].vcps[j].normal_impulse) <= tolerance*scale;
+		}
+	}
+
+	solver_free(input);
+	*g_solver_config = config;
+	return agree;
+}
+
+static struct test_output solver_wide_scalar_equal(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	/* lane count + 1 stacks so that the last bundle is partially filled */
+	TEST_TRUE(solver_wide_scalar_agree(env, CONTACT_SOLVER_LANE_COUNT + 1, 1, 10, 1e-5f));
+	TEST_TRUE(solver_wide_scalar_agree(env, 8, 4, 400, 1e-3f));
+
+	return output;
+}
+
+/* n x n grid of unit cells centered at the origin with ccw (upward facing) triangles and vertex heights in [-jitter, jitter] */
+static struct tri_mesh *tri_mesh_grid(struct arena *mem, const u32 n, const f32 jitter)
+{
+	struct tri_mesh *mesh = arena_push(mem, sizeof(struct tri_mesh));
+	mesh->v_count = (n+1)*(n+1);
+	mesh->tri_count = 2*n*n;
+	mesh->v = arena_push(mem, mesh->v_count*sizeof(vec3));
+	mesh->tri = arena_push(mem, mesh->tri_count*sizeof(vec3u32));
+
+	f32 y_min = F32_INFINITY;
+	f32 y_max = -F32_INFINITY;
+	const f32 offset = 0.5f * (f32) n;
+	for (u32 i = 0; i <= n; ++i)
+	{
+		for (u32 j = 0; j <= n; ++j)
+		{
+			const f32 y = (jitter > 0.0f) ? rng_f32_range(-jitter, jitter) : 0.0f;
+			vec3_set(mesh->v[i*(n+1) + j], (f32) i - offset, y, (f32) j - offset);
+			y_min = f32_min(y_min, y);
+			y_max = f32_max(y_max, y);
+		}
+	}
+
+	/* the mesh bvh expects its root box to be centered at the local origin */
+	for (u32 i = 0; i < mesh->v_count; ++i)
+	{
+		mesh->v[i][1] -= 0.5f * (y_min + y_max);
+	}
+
+	u32 t = 0;
+	for (u32 i = 0; i < n; ++i)
+	{
+		for (u32 j = 0; j < n; ++j)
+		{
+			const u32 a = i*(n+1) + j;
+			const u32 b = a + 1;
+			const u32 c = b + (n+1);
+			const u32 d = a + (n+1);
+			vec3u32_set(mesh->tri[t++], a, b, c);
+			vec3u32_set(mesh->tri[t++], a, c, d);
+		}
+	}
+
+	return mesh;
+}
+
+/* the contact between b1 and b2 (without margin) must match the expected normal, uniform depth and point count */
+static u32 tri_mesh_contact_expected(struct arena *tmp, const struct physics_pipeline *pipeline, const u32 i1, const u32 i2, const vec3 n, const f32 depth, const u32 v_count)
+{
+	const struct rigid_body *b1 = pool_address(&pipeline->body_pool, i1);
+	const struct rigid_body *b2 = pool_address(&pipeline->body_pool, i2);
+	struct collision_result result = { 0 };
+	if (!body_body_contact_manifold(tmp, &result, pipeline, b1, b2, 0.0f))
+	{
+		return v_count == 0;
+	}
+
+	if (result.manifold.v_count != v_count || !vec3_approx_equal(result.manifold.n, n, 1e-4f))
+	{
+		return 0;
+	}
+
+	for (u32 i = 0; i < v_count; ++i)
+	{
+		if (f32_abs(result.manifold.depth[i] - depth) > 1e-4f)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static struct test_output tri_mesh_contact(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	struct scene *input = scene_alloc(64);
+	struct physics_pipeline *pipeline = &input->pipeline;
+
+	const struct tri_mesh *mesh = tri_mesh_grid(&input->mem, 8, 0.0f);
+	const struct collision_shape mesh_shape = 
+	{ 
+		.type = COLLISION_SHAPE_TRI_MESH, 
+		.mesh_bvh = tri_mesh_bvh_construct(&input->mem, mesh, 8),
+		.center_of_mass_localized = 1,
+	};
+	TEST_EQUAL(mesh_shape.mesh_bvh.tri_count, mesh->tri_count);
+
+	const struct collision_shape sphere_shape = { .type = COLLISION_SHAPE_SPHERE, .sphere = { .radius = 0.5f } };
+	const struct collision_shape capsule_shape = { .type = COLLISION_SHAPE_CAPSULE, .capsule = { .radius = 0.25f, .half_height = 0.5f } };
+	struct rigid_body_prefab *ground = scene_shape_prefab_add(input, "ground", &mesh_shape, 0);
+	struct rigid_body_prefab *sphere = scene_shape_prefab_add(input, "sphere", &sphere_shape, 1);
+	struct rigid_body_prefab *capsule = scene_shape_prefab_add(input, "capsule", &capsule_shape, 1);
+	struct rigid_body_prefab *box = scene_prefab_add(input, "box", vec3_inline(0.5f, 0.5f, 0.5f), 1);
+
+	const quat identity = { 0.0f, 0.0f, 0.0f, 1.0f };
+	const quat lying = { 0.0f, 0.0f, sqrtf(0.5f), sqrtf(0.5f) };
+	const vec3 up = { 0.0f, 1.0f, 0.0f };
+	const vec3 down = { 0.0f, -1.0f, 0.0f };
+	const u32 g = physics_pipeline_rigid_body_alloc(pipeline, ground, vec3_inline(0.0f, 0.0f, 0.0f), identity, 0).index;
+
+	/* sphere within a single triangle, above a vertex shared by six triangles, and separated */
+	const u32 s1 = physics_pipeline_rigid_body_alloc(pipeline, sphere, vec3_inline(1.0f/3.0f, 0.45f, 2.0f/3.0f), identity, 0).index;
+	const u32 s2 = physics_pipeline_rigid_body_alloc(pipeline, sphere, vec3_inline(-2.0f, 0.4f, -2.0f), identity, 0).index;
+	const u32 s3 = physics_pipeline_rigid_body_alloc(pipeline, sphere, vec3_inline(2.0f, 0.55f, 2.0f), identity, 0).index;
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, g, s1, up, 0.05f, 1));
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, s1, g, down, 0.05f, 1));
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, g, s2, up, 0.1f, 1));
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, g, s3, up, 0.0f, 0));
+
+	/* capsule lying across several triangles gives its two end-point contacts */
+	const u32 c1 = physics_pipeline_rigid_body_alloc(pipeline, capsule, vec3_inline(-1.3f, 0.2f, 1.6f), lying, 0).index;
+	const u32 c2 = physics_pipeline_rigid_body_alloc(pipeline, capsule, vec3_inline(-1.3f, 1.0f, -1.6f), lying, 0).index;
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, g, c1, up, 0.05f, 2));
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, c1, g, down, 0.05f, 2));
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, g, c2, up, 0.0f, 0));
+
+	/* box resting face down on the mesh gives a 4 point manifold */
+	const u32 h1 = physics_pipeline_rigid_body_alloc(pipeline, box, vec3_inline(1.3f, 0.45f, -1.2f), identity, 0).index;
+	const u32 h2 = physics_pipeline_rigid_body_alloc(pipeline, box, vec3_inline(-2.7f, 0.55f, 2.6f), identity, 0).index;
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, g, h1, up, 0.05f, 4));
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, h1, g, down, 0.05f, 4));
+	TEST_TRUE(tri_mesh_contact_expected(env->mem_1, pipeline, g, h2, up, 0.0f, 0));
+
+	scene_free(input);
+
+	return output;
+}
+
+/* the midphase must report exactly the triangles whose boxes overlap the query box */
+static struct test_output tri_mesh_bvh_overlap_match_brute_force(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	const struct tri_mesh *mesh = tri_mesh_grid(env->mem_1, 32, 0.5f);
+	const struct tri_mesh_bvh mesh_bvh = tri_mesh_bvh_construct(env->mem_1, mesh, 8);
+	TEST_EQUAL(mesh_bvh.tri_count, mesh->tri_count);
+
+	u8 *expected = arena_push(env->mem_1, mesh->tri_count);
+	for (u32 q = 0; q < 256; ++q)
+	{
+		struct AABB bbox;
+		vec3_set(bbox.center, rng_f32_range(-17.0f, 17.0f), rng_f32_range(-1.0f, 1.0f), rng_f32_range(-17.0f, 17.0f));
+		vec3_set(bbox.hw, rng_f32_range(0.05f, 3.0f), rng_f32_range(0.05f, 1.0f), rng_f32_range(0.05f, 3.0f));
+
+		u32 expected_count = 0;
+		for (u32 t = 0; t < mesh->tri_count; ++t)
+		{
+			const struct AABB bbox_tri = bbox_triangle(mesh->v[mesh->tri[t][0]], mesh->v[mesh->tri[t][1]], mesh->v[mesh->tri[t][2]]);
+			expected[t] = (u8) AABB_test(&bbox_tri, &bbox);
+			expected_count += expected[t];
+		}
+
+		arena_push_record(env->mem_1);
+		const u32 *tri = (u32 *) env->mem_1->stack_ptr;
+		const u32 count = tri_mesh_bvh_push_bbox_overlaps(env->mem_1, &mesh_bvh, &bbox);
+		TEST_EQUAL(count, expected_count);
+		for (u32 i = 0; i < count; ++i)
+		{
+			/* every reported triangle is expected, and reported once */
+			TEST_EQUAL(expected[tri[i]], 1);
+			expected[tri[i]] = 0;
+		}
+		arena_pop_record(env->mem_1);
+	}
+
+	return output;
+}
+
+/* 
+ * Every body and contact must be in exactly one island range, the island of its (non-static) bodies, and every 
+ * island must be a single connected component of the contact graph. The tails must stay within the compaction bound.
+ */
+static u32 island_ranges_consistent(struct arena *mem, const struct physics_pipeline *pipeline)
+{
+	const struct island_database *is_db = &pipeline->is_db;
+	const u32 body_max = pipeline->body_pool.count_max;
+	const u32 contact_max = pipeline->c_db.contact_net.pool.count_max;
+
+	arena_push_record(mem);
+	u32 *body_island = arena_push(mem, body_max * sizeof(u32));
+	u32 *contact_island = arena_push(mem, contact_max * sizeof(u32));
+	u32 *stack = arena_push(mem, body_max * sizeof(u32));
+	u8 *visited = arena_push(mem, body_max);
+	for (u32 i = 0; i < body_max; ++i) { body_island[i] = U32_MAX; visited[i] = 0; }
+	for (u32 i = 0; i < contact_max; ++i) { contact_island[i] = U32_MAX; }
+
+	u32 consistent = (is_db->body_tail <= 2*is_db->body_compact + IS_DB_RANGE_COMPACT_MIN)
+		&& (is_db->contact_tail <= 2*is_db->contact_compact + IS_DB_RANGE_COMPACT_MIN);
+	for (u32 is_index = 0; is_index < is_db->islands->max_count && consistent; ++is_index)
+	{
+		if (!bit_vec_get_bit(&is_db->island_usage, is_index))
+		{
+			continue;
+		}
+
+		const struct island *is = array_list_address(is_db->islands, is_index);
+		consistent = is->body_count > 0
+			&& is->body_offset + is->body_count <= is_db->body_tail
+			&& is->contact_offset + is->contact_count <= is_db->contact_tail;
+		for (u32 i = 0; i < is->body_count && consistent; ++i)
+		{
+			const u32 body = is_db->body[is->body_offset + i];
+			const struct rigid_body *b = pool_address(&pipeline->body_pool, body);
+			consistent = POOL_SLOT_ALLOCATED(b) && b->island_index == is_index && body_island[body] == U32_MAX;
+			body_island[body] = is_index;
+		}
+
+		for (u32 i = 0; i < is->contact_count && consistent; ++i)
+		{
+			const u32 ci = is_db->contact[is->contact_offset + i];
+			const struct contact *c = nll_address(&pipeline->c_db.contact_net, ci);
+			const struct rigid_body *b1 = pool_address(&pipeline->body_pool, c->cm.i1);
+			const struct rigid_body *b2 = pool_address(&pipeline->body_pool, c->cm.i2);
+			consistent = POOL_SLOT_ALLOCATED(c) && contact_island[ci] == U32_MAX
+				&& (b1->island_index == is_index || b1->island_index == ISLAND_STATIC)
+				&& (b2->island_index == is_index || b2->island_index == ISLAND_STATIC);
+			contact_island[ci] = is_index;
+		}
+
+		/* flood fill the island from its first body over contacts between island bodies */
+		u32 reached = 0;
+		u32 sc = 0;
+		if (consistent)
+		{
+			stack[sc++] = is_db->body[is->body_offset];
+			visited[stack[0]] = 1;
+		}
+		while (sc)
+		{
+			const u32 body = stack[--sc];
+			reached += 1;
+			const struct rigid_body *b = pool_address(&pipeline->body_pool, body);
+			u32 ci = b->first_contact_index;
+			while (ci != NLL_NULL)
+			{
+				const struct contact *c = nll_address(&pipeline->c_db.contact_net, ci);
+				const u32 neighbour = (body == c->cm.i1) ? c->cm.i2 : c->cm.i1;
+				const struct rigid_body *nb = pool_address(&pipeline->body_pool, neighbour);
+				if (nb->island_index != ISLAND_STATIC && !visited[neighbour])
+				{
+					visited[neighbour] = 1;
+					stack[sc++] = neighbour;
+				}
+				ci = c->nll_next[(body == CONTACT_KEY_TO_BODY_0(c->key)) ? 0 : 1];
+			}
+		}
+		consistent = consistent && reached == is->body_count;
+	}
+
+	for (u32 i = 0; i < body_max && consistent; ++i)
+	{
+		const struct rigid_body *b = pool_address(&pipeline->body_pool, i);
+		if (POOL_SLOT_ALLOCATED(b) && b->island_index != ISLAND_STATIC)
+		{
+			consistent = body_island[i] != U32_MAX;
+		}
+	}
+
+	for (u32 i = NLL_NULL + 1; i < contact_max && consistent; ++i)
+	{
+		const struct contact *c = nll_address(&pipeline->c_db.contact_net, i);
+		if (POOL_SLOT_ALLOCATED(c))
+		{
+			consistent = contact_island[i] != U32_MAX;
+		}
+	}
+
+	arena_pop_record(mem);
+	return consistent;
+}
+
+static u32 island_count(const struct physics_pipeline *pipeline)
+{
+	u32 count = 0;
+	for (u32 i = 0; i < pipeline->is_db.islands->max_count; ++i)
+	{
+		count += bit_vec_get_bit(&pipeline->is_db.island_usage, i);
+	}
+	return count;
+}
+
+/*
+ * Stacks of boxes dropped with small gaps land and merge into one island per stack. Removing the second box of
+ * every stack splits off the boxes above it, which merge again once they have landed. The ranges are checked 
+ * every tick.
+ */
+static struct test_output island_ranges_match_components(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	const u32 stack_count = 16;
+	const u32 stack_height = 4;
+	struct scene *input = scene_alloc(1024);
+	const u32 first = scene_box_stacks(input, stack_count, stack_height, 3.0f, 0.05f, 1);
+	u32 *second = arena_push(env->mem_1, stack_count * sizeof(u32));
+	for (u32 s = 0; s < stack_count; ++s)
+	{
+		second[s] = first + s*stack_height + 1;
+	}
+
+	u32 consistent = 1;
+	for (u32 i = 0; i < 60 && consistent; ++i)
+	{
+		physics_pipeline_tick(&input->pipeline);
+		consistent = island_ranges_consistent(env->mem_1, &input->pipeline);
+	}
+	const u32 merged_count = island_count(&input->pipeline);
+
+	for (u32 s = 0; s < stack_count; ++s)
+	{
+		physics_pipeline_rigid_body_tag_for_removal(&input->pipeline, second[s]);
+	}
+
+	u32 split_count = 0;
+	for (u32 i = 0; i < 120 && consistent; ++i)
+	{
+		physics_pipeline_tick(&input->pipeline);
+		consistent = island_ranges_consistent(env->mem_1, &input->pipeline);
+		const u32 count = island_count(&input->pipeline);
+		split_count = (count > split_count) ? count : split_count;
+	}
+	const u32 remerged_count = island_count(&input->pipeline);
+
+	scene_free(input);
+
+	TEST_TRUE(consistent);
+	TEST_EQUAL(merged_count, stack_count);
+	TEST_TRUE(split_count > stack_count);
+	TEST_EQUAL(remerged_count, stack_count);
+
+	return output;
+}
+
+/* a fast sphere falling onto a thin static box tunnels through it, unless it is a bullet */
+static struct test_output bullet_does_not_tunnel(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	struct scene *input = scene_alloc(64);
+	struct physics_pipeline *pipeline = &input->pipeline;
+
+	const struct collision_shape sphere_shape = { .type = COLLISION_SHAPE_SPHERE, .sphere = { .radius = 0.1f } };
+	struct rigid_body_prefab *wall = scene_prefab_add(input, "wall", vec3_inline(4.0f, 0.05f, 4.0f), 0);
+	struct rigid_body_prefab *sphere = scene_shape_prefab_add(input, "sphere", &sphere_shape, 1);
+	struct rigid_body_prefab *bullet = scene_shape_prefab_add(input, "bullet", &sphere_shape, 1);
+	bullet->bullet = 1;
+
+	const quat identity = { 0.0f, 0.0f, 0.0f, 1.0f };
+	physics_pipeline_rigid_body_alloc(pipeline, wall, vec3_inline(0.0f, 0.0f, 0.0f), identity, 0);
+	const u32 s = physics_pipeline_rigid_body_alloc(pipeline, sphere, vec3_inline(-2.0f, 2.0f, 0.0f), identity, 0).index;
+	const u32 b = physics_pipeline_rigid_body_alloc(pipeline, bullet, vec3_inline(2.0f, 2.0f, 0.0f), identity, 0).index;
+
+	/* 5 units per tick at 60Hz, far more than the wall is thick */
+	struct rigid_body *body_s = pool_address(&pipeline->body_pool, s);
+	struct rigid_body *body_b = pool_address(&pipeline->body_pool, b);
+	vec3_set(body_s->velocity, 0.0f, -300.0f, 0.0f);
+	vec3_set(body_b->velocity, 0.0f, -300.0f, 0.0f);
+	const u32 s_bullet = RB_IS_BULLET(body_s);
+	const u32 b_bullet = RB_IS_BULLET(body_b);
+
+	for (u32 i = 0; i < 30; ++i)
+	{
+		physics_pipeline_tick(pipeline);
+	}
+
+	const f32 s_y = body_s->position[1];
+	const f32 b_y = body_b->position[1];
+	scene_free(input);
+
+	TEST_EQUAL(s_bullet, 0);
+	TEST_EQUAL(b_bullet, 1);
+	TEST_TRUE(s_y < -0.05f);
+	TEST_TRUE(b_y > 0.05f);
+
+	return output;
+}
+
+/* box stacks resting on the ground stay standing: no box tips over, slides a quarter box or sinks */
+static struct test_output box_stacks_stay_upright(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	const u32 stack_count = 8;
+	const u32 stack_height = 8;
+	const f32 spacing = 2.0f;
+	struct scene *scene = scene_alloc(128);
+	const u32 first = scene_box_stacks(scene, stack_count, stack_height, spacing, 0.0f, 1);
+
+	for (u32 i = 0; i < 120; ++i)
+	{
+		physics_pipeline_tick(&scene->pipeline);
+	}
+
+	f32 max_slide = 0.0f;
+	f32 max_sink = 0.0f;
+	f32 min_up = 1.0f;
+	for (u32 s = 0; s < stack_count; ++s)
+	{
+		for (u32 h = 0; h < stack_height; ++h)
+		{
+			vec3 rest, drift;
+			scene_box_stack_position(rest, stack_count, spacing, 0.0f, s, h);
+			const struct rigid_body *b = pool_address(&scene->pipeline.body_pool, first + s*stack_height + h);
+			vec3_sub(drift, b->position, rest);
+			max_slide = f32_max(max_slide, f32_sqrt(drift[0]*drift[0] + drift[2]*drift[2]));
+			max_sink = f32_max(max_sink, f32_abs(drift[1]));
+			/* y component of the rotated box y axis */
+			mat3 rot;
+			quat_to_mat3(rot, b->rotation);
+			min_up = f32_min(min_up, f32_abs(rot[1][1]));
+		}
+	}
+
+	scene_free(scene);
+
+	TEST_TRUE(max_slide < 0.25f);
+	TEST_TRUE(max_sink < 0.1f);
+	TEST_TRUE(min_up > 0.99f);
+
+	return output;
+}
+
+/* resting stacks only jitter within the cache tolerances, so (almost) every query should reuse its sat cache */
+static struct test_output sat_cache_resting_stack_reuse(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	struct sat_cache_input *input = sat_cache_init(4, 8);
+	for (u32 frame = 0; frame < 32; ++frame)
+	{
+		sat_cache_reset(input);
+		sat_cache_query_stacks(input);
+	}
+
+	const u64 hit_count = input->hit_count;
+	const u64 miss_count = input->miss_count;
+	sat_cache_free(input);
+
+	TEST_TRUE(hit_count > 0);
+	TEST_TRUE(miss_count <= hit_count / 64);
+
+	return output;
+}
+
+static struct test_output (*physics_tests[])(struct test_environment *) =
+{
+	box_stacks_stay_upright,
+	dbvh_parallel_serial_overlap_equal,
+	proxy_pairs_match_brute_force,
+	static_tree_deferred_rebuild,
+	solver_wide_scalar_equal,
+	tri_mesh_contact,
+	tri_mesh_bvh_overlap_match_brute_force,
+	c_db_sharded_link_serial_equal,
+	island_ranges_match_components,
+	bullet_does_not_tunnel,
+	sat_cache_resting_stack_reuse,
+};
+
+struct suite m_physics_suite =
+{
+	.id = "physics",
+	.unit_test = physics_tests,
+	.unit_test_count = sizeof(physics_tests) / sizeof(physics_tests[0]),
+};
+
+struct suite *physics_suite = &m_physics_suite;
+
+struct performance_suite storage_performance_physics_suite =
+{
+	.id = "Physics Performance",
+	.parallel_test = NULL,
+	.parallel_test_count = 0,
+	.serial_test = physics_serial_test,
+	.serial_test_count = sizeof(physics_serial_test) / sizeof(physics_serial_test[0]),
+	.counters = 1,
+};
+
+struct performance_suite *physics_performance_suite = &storage_performance_physics_suite;
@@ -22,270 +22,234 @@
 
 #include "test_local.h"
 
-//#ifdef __linux__
-//#include <linux/perf_event.h>
-//#include <linux/hw_breakpoint.h>
-//#include <sys/syscall.h>
-//#include <sys/ioctl.h>
-//#include <unistd.h>
-//#include <errno.h>
-//
-//struct os_event_format
-//{
-//	u64 page_faults;
-//	u64 branch_misses;
-//	u64 frontend_stalled_cycles;
-//	u64 backend_stalled_cycles;
-//	u64 cycles;
-//};
-//
-//static void os_get_counters(const struct repetition_tester *tester, const i32 group_fd, struct os_event_format *fm)
-//{
-//	struct 
-//	{
-//		u64 nr;
-//		struct
-//		{
-//			u64 value;
-//			u64 id;
-//		} events[NUM_EVENTS];
-//	} format;
-//
-//	while (read(group_fd, &format, sizeof(format)) == EOF)
-//	{
-//		fprintf(stdout, "Error %s:%d - Warning, EOF on page fault monitoring\n", __FILE__, __LINE__);
-//	}
-//	
-//	static i32 pf = 0;
-//	static i32 bm = 0;
-//	static i32 fnt = 0;
-//	static i32 bck = 0;
-//	static i32 cyc = 0;
-//
-//	assert(format.nr == tester->event_count);
-//	for (i32 i = 0; i < tester->event_count; ++i)
-//	{
-//		if (format.events[i].id == tester->pf_id)
-//		{
-//			fm->page_faults = format.events[i].value;
-//			pf++;
-//		}
-//		else if (format.events[i].id == tester->bm_id)
-//		{
-//			fm->branch_misses = format.events[i].value;
-//			bm++;
-//		}
-//		else if (format.events[i].id == tester->fnt_id)
-//		{
-//			fm->frontend_stalled_cycles = format.events[i].value;
-//			fnt++;
-//		}
-//		else if (format.events[i].id == tester->bck_id)
-//		{
-//			fm->backend_stalled_cycles = format.events[i].value;
-//			bck++;
-//		}
-//		else if (format.events[i].id == tester->cyc_id)
-//		{
-//			fm->cycles = format.events[i].value;
-//			cyc++;
-//		}
-//		else
-//		{
-//			assert(0 && "Should not happen\n");
-//		}
-//	}
-//
-//	assert(pf <= 1 && bm <= 1 && fnt <= 1 && bck <= 1 && cyc <= 1);
-//	pf = 0;
-//	bm = 0;
-//	fnt = 0;
-//	bck = 0;
-//	cyc = 0;
-//}
-//
-//
-//static void os_enable_counters(struct repetition_tester *tester)
-//{
-//	//ioctl(tester->pf_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
-//	ioctl(tester->pf_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
-//}
-//
-//static void os_disable_counters(struct repetition_tester *tester)
-//{
-//	ioctl(tester->pf_fd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
-//}
-//
-//static void os_init_performance_events(struct repetition_tester *tester)
-//{
-//	const i32 pid = 0; /* this process on any cpu */
-//	const i32 cpu = -1;
-//	i32 group_fd = -1;		/* group leader for performance events,
-//					   i.e. os makes sure all events in group
-//					   are counted at for the same set of inst. */
-//	const u32 flags = 0;
-//	struct perf_event_attr pf_attr = { 0 };
-//	{
-//		pf_attr.type = PERF_TYPE_SOFTWARE;
-//		pf_attr.config = PERF_COUNT_SW_PAGE_FAULTS;
-//		pf_attr.size = sizeof(struct perf_event_attr);
-//		//pf_attr.sample_period = PAGE_FAULT_SAMPLING_PERIOD;	/* event granularity of 1, (we get every page fault immediately!) */
-//		pf_attr.disabled = 1;
-//		pf_attr.read_format = PERF_FORMAT_ID | PERF_FORMAT_GROUP;
-//	}
-//
-//	tester->pf_fd = syscall(SYS_perf_event_open, &pf_attr, pid, cpu, group_fd, flags);
-//	group_fd = tester->pf_fd;
-//	if (tester->pf_fd == -1)
-//	{
-//		if (errno == ENOENT)
-//		{
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, "PERF_COUNT_SW_PAGE_FAULTS unsupported");
-//			tester->pf_id = SIZE_MAX;
-//		}
-//		else
-//		{
-//			char buf[256];
-//			strerror_r(errno, buf, sizeof(buf));
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, buf);
-//			exit(1);
-//		}
-//	}
-//	else
-//	{
-//		tester->event_count += 1;
-//	    	ioctl(tester->pf_fd, PERF_EVENT_IOC_ID, &tester->pf_id);
-//	}
-//
-//	struct perf_event_attr bm_attr = { 0 };
-//	{
-//		bm_attr.type = PERF_TYPE_HARDWARE;
-//		bm_attr.config = PERF_COUNT_HW_BRANCH_MISSES;
-//		bm_attr.size = sizeof(struct perf_event_attr);
-//		//bm_attr.sample_period = BRANCH_MISSES_SAMPLING_PERIOD;
-//		bm_attr.disabled = 1;
-//		bm_attr.read_format = PERF_FORMAT_ID | PERF_FORMAT_GROUP;
-//	}
-//
-//	tester->bm_fd = syscall(SYS_perf_event_open, &bm_attr, pid, cpu, group_fd, flags);
-//	if (tester->bm_fd == -1)
-//	{
-//		if (errno == ENOENT)
-//		{
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, "PERF_COUNT_HW_BRANCH_MISSES unsupported");
-//			tester->bm_id = SIZE_MAX;
-//		}
-//		else
-//		{
-//			char buf[256];
-//			strerror_r(errno, buf, sizeof(buf));
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, buf);
-//			exit(1);
-//		}
-//	}
-//	else
-//	{
-//		tester->event_count += 1;
-//	    	ioctl(tester->bm_fd, PERF_EVENT_IOC_ID, &tester->bm_id);
-//	}
-//
-//	struct perf_event_attr cyc_attr = { 0 };
-//	{
-//		cyc_attr.type = PERF_TYPE_HARDWARE;
-//		cyc_attr.config = PERF_COUNT_HW_REF_CPU_CYCLES;
-//		cyc_attr.size = sizeof(struct perf_event_attr);
-//		//cyc_attr.sample_period = BRANCH_MISSES_SAMPLING_PERIOD;
-//		cyc_attr.disabled = 1;
-//		cyc_attr.read_format = PERF_FORMAT_ID | PERF_FORMAT_GROUP;
-//	}
-//
-//	tester->cyc_fd = syscall(SYS_perf_event_open, &cyc_attr, pid, cpu, group_fd, flags);
-//	if (tester->cyc_fd == -1)
-//	{
-//		if (errno == ENOENT)
-//		{
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, "PERF_COUNT_HW_CPU_CYCLES unsupported");
-//			tester->cyc_id = SIZE_MAX;
-//		}
-//		else
-//		{
-//			char buf[256];
-//			strerror_r(errno, buf, sizeof(buf));
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, buf);
-//			exit(1);
-//		}
-//	}
-//	else
-//	{
-//		tester->event_count += 1;
-//	    	ioctl(tester->cyc_fd, PERF_EVENT_IOC_ID, &tester->cyc_id);
-//	}
-//
-//	struct perf_event_attr bck_attr = { 0 };
-//	{
-//		bck_attr.type = PERF_TYPE_HARDWARE;
-//		bck_attr.config = PERF_COUNT_HW_STALLED_CYCLES_BACKEND;
-//		bck_attr.size = sizeof(struct perf_event_attr);
-//		//bck_attr.sample_period = BRANCH_MISSES_SAMPLING_PERIOD;
-//		bck_attr.disabled = 1;
-//		bck_attr.read_format = PERF_FORMAT_ID | PERF_FORMAT_GROUP;
-//	}
-//
-//	tester->bck_fd = syscall(SYS_perf_event_open, &bck_attr, pid, cpu, group_fd, flags);
-//	if (tester->bck_fd == -1)
-//	{
-//		if (errno == ENOENT)
-//		{
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, "PERF_COUNT_HW_STALLED_CYCLES_BACKEND unsupported");
-//			tester->bck_id = SIZE_MAX;
-//		}
-//		else
-//		{
-//			char buf[256];
-//			strerror_r(errno, buf, sizeof(buf));
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, buf);
-//			exit(1);
-//		}
-//	}
-//	else
-//	{
-//		tester->event_count += 1;
-//	    	ioctl(tester->bck_fd, PERF_EVENT_IOC_ID, &tester->bck_id);
-//	}
-//
-//	struct perf_event_attr fnt_attr = { 0 };
-//	{
-//		fnt_attr.type = PERF_TYPE_HARDWARE;
-//		fnt_attr.config = PERF_COUNT_HW_STALLED_CYCLES_FRONTEND;
-//		fnt_attr.size = sizeof(struct perf_event_attr);
-//		//fnt_attr.sample_period = BRANCH_MISSES_SAMPLING_PERIOD;
-//		fnt_attr.disabled = 1;
-//		fnt_attr.read_format = PERF_FORMAT_ID | PERF_FORMAT_GROUP;
-//	}
-//
-//	tester->fnt_fd = syscall(SYS_perf_event_open, &fnt_attr, pid, cpu, group_fd, flags);
-//	if (tester->fnt_fd == -1)
-//	{
-//		if (errno == ENOENT)
-//		{
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, "PERF_COUNT_HW_STALLED_CYCLES_FRONTEND unsupported");
-//			tester->fnt_id = SIZE_MAX;
-//		}
-//		else
-//		{
-//			char buf[256];
-//			strerror_r(errno, buf, sizeof(buf));
-//			fprintf(stderr, "%s:%u - %s\n", __FILE__, __LINE__, buf);
-//			exit(1);
-//		}
-//	}
-//	else
-//	{
-//		tester->event_count += 1;
-//	    	ioctl(tester->fnt_fd, PERF_EVENT_IOC_ID, &tester->fnt_id);
-//	}
-//}
-//#endif
+void repetition_error(struct repetition_tester *tester, const char *file, const u32 line, const char *msg);
+
+#ifdef __linux__
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <errno.h>
+
+struct rt_counter_group
+{
+	i32	fd[RT_COUNTER_COUNT];		/* -1 if not opened, fd[leader] is the group leader */
+	u64	id[RT_COUNTER_COUNT];
+	u32	leader;
+	u64	value[RT_COUNTER_COUNT];	/* counters at the start of the current timed region */
+	u64	time_enabled;
+	u64	time_running;
+};
+
+static const struct
+{
+	u32		type;
+	u64		config;
+	const char *	name;
+} rt_counter_event[RT_COUNTER_COUNT] = 
+{
+	{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, 		"page faults" },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, 		"branch misses" },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, 		"cache misses" },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_FRONTEND, 	"frontend stalled cycles" },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_STALLED_CYCLES_BACKEND, 	"backend stalled cycles" },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, 		"cycles" },
+};
+
+/* counters we have already warned about being unavailable, so we only warn once per run */
+static u32 rt_counter_warned = 0;
+static u32 rt_counters_disabled = 0;
+
+static i32 os_open_event(const enum rt_counter counter, const pid_t tid, const i32 group_fd)
+{
+	struct perf_event_attr attr = { 0 };
+	attr.size = sizeof(struct perf_event_attr);
+	attr.type = rt_counter_event[counter].type;
+	attr.config = rt_counter_event[counter].config;
+	attr.disabled = (group_fd == -1);	/* the leader starts the group */
+	attr.exclude_kernel = 1;		/* allowed with perf_event_paranoid <= 2 */
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return (i32) syscall(SYS_perf_event_open, &attr, tid, -1, group_fd, PERF_FLAG_FD_CLOEXEC);
+}
+
+static void os_close_group(struct rt_counter_group *group)
+{
+	for (u32 i = 0; i < RT_COUNTER_COUNT; ++i)
+	{
+		if (group->fd[i] != -1)
+		{
+			close(group->fd[i]);
+			group->fd[i] = -1;
+		}
+	}
+}
+
+/* open one event group counting the thread tid. Returns 1 on success, 0 if no counter could be opened or
+ * counters are not permitted, in which case every fd of the group is closed. */
+static u32 os_open_group(struct repetition_tester *tester, struct rt_counter_group *group, const pid_t tid)
+{
+	for (u32 i = 0; i < RT_COUNTER_COUNT; ++i)
+	{
+		group->fd[i] = -1;
+	}
+
+	i32 group_fd = -1;
+	u32 available = 0;
+	for (u32 i = 0; i < RT_COUNTER_COUNT; ++i)
+	{
+		group->fd[i] = os_open_event(i, tid, group_fd);
+		if (group->fd[i] == -1)
+		{
+			if (!(rt_counter_warned & (1u << i)))
+			{
+				rt_counter_warned |= (1u << i);
+				fprintf(stdout, "\t\tperf event %s unavailable: %s\n", rt_counter_event[i].name, strerror(errno));
+			}
+
+			if (errno == EACCES || errno == EPERM || errno == ENOSYS)
+			{
+				/* not permitted at all (perf_event_paranoid, seccomp, containers), don't retry
+				 * and fall back to timing only */
+				rt_counters_disabled = 1;
+				os_close_group(group);
+				return 0;
+			}
+			continue;
+		}
+
+		ioctl(group->fd[i], PERF_EVENT_IOC_ID, &group->id[i]);
+		if (group_fd == -1)
+		{
+			group_fd = group->fd[i];
+			group->leader = i;
+		}
+		available |= (1u << i);
+	}
+
+	if (group_fd == -1)
+	{
+		return 0;
+	}
+
+	/* counters of the thread are only kept if every other group counted them as well */
+	tester->counter_available = (tester->group_count) 
+		? tester->counter_available & available
+		: available;
+	ioctl(group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return 1;
+}
+
+static void os_init_performance_events(struct repetition_tester *tester, const enum rt_counter_scope scope)
+{
+	if (scope == RT_COUNTERS_NONE || rt_counters_disabled)
+	{
+		return;
+	}
+
+	const u32 thread_count = (scope == RT_COUNTERS_WORKERS) ? g_task_ctx->worker_count : 1;
+	tester->group = malloc(thread_count * sizeof(struct rt_counter_group));
+	tester->group_count = 0;
+	for (u32 i = 0; i < thread_count; ++i)
+	{
+		/* worker 0 is the calling master thread */
+		const pid_t tid = (i == 0)
+			? (pid_t) kas_thread_self_tid()
+			: (pid_t) kas_thread_tid(g_task_ctx->workers[i].thr);
+		struct rt_counter_group *group = tester->group + tester->group_count;
+		if (!os_open_group(tester, group, tid))
+		{
+			break;
+		}
+		tester->group_count += 1;
+	}
+
+	if (tester->group_count != thread_count)
+	{
+		/* counting only some of the threads would be misleading, fall back to timing only */
+		rt_cleanup(tester);
+	}
+}
+
+/* add the counter deltas since the group's last read to the current test, scaling multiplexed counters */
+static void os_read_counters(struct repetition_tester *tester, const u32 accumulate)
+{
+	struct
+	{
+		u64 nr;
+		u64 time_enabled;
+		u64 time_running;
+		struct
+		{
+			u64 value;
+			u64 id;
+		} event[RT_COUNTER_COUNT];
+	} format;
+
+	for (u32 g = 0; g < tester->group_count; ++g)
+	{
+		struct rt_counter_group *group = tester->group + g;
+		if (read(group->fd[group->leader], &format, sizeof(format)) <= 0)
+		{
+			repetition_error(tester, __FILE__, __LINE__, "Failed to read performance counters");
+			return;
+		}
+
+		const u64 enabled = format.time_enabled - group->time_enabled;
+		const u64 running = format.time_running - group->time_running;
+		group->time_enabled = format.time_enabled;
+		group->time_running = format.time_running;
+		if (accumulate && running < enabled)
+		{
+			tester->counters_scaled = 1;
+		}
+
+		for (u32 i = 0; i < format.nr; ++i)
+		{
+			for (u32 c = 0; c < RT_COUNTER_COUNT; ++c)
+			{
+				if (group->fd[c] != -1 && group->id[c] == format.event[i].id)
+				{
+					u64 delta = format.event[i].value - group->value[c];
+					group->value[c] = format.event[i].value;
+					if (running && running < enabled)
+					{
+						delta = (u64) ((f64) delta * (f64) enabled / (f64) running);
+					}
+
+					if (accumulate)
+					{
+						tester->counter_in_current_test[c] += delta;
+					}
+					break;
+				}
+			}
+		}
+	}
+}
+
+void rt_cleanup(struct repetition_tester *tester)
+{
+	for (u32 g = 0; g < tester->group_count; ++g)
+	{
+		os_close_group(tester->group + g);
+	}
+	free(tester->group);
+	tester->group = NULL;
+	tester->group_count = 0;
+	tester->counter_available = 0;
+}
+
+#else
+
+static void os_init_performance_events(struct repetition_tester *tester, const enum rt_counter_scope scope) { }
+static void os_read_counters(struct repetition_tester *tester, const u32 accumulate) { }
+void rt_cleanup(struct repetition_tester *tester) { }
+
+#endif
 
 void repetition_error(struct repetition_tester *tester, const char *file, const u32 line, const char *msg)
 {
@@ -316,11 +280,7 @@ i32 rt_is_testing(struct repetition_tester *tester)
 				if (tester->tsc_iteration_max < tester->tsc_in_current_test)
 				{
 					tester->tsc_iteration_max = tester->tsc_in_current_test;
-					tester->page_faults_max_time = tester->page_faults_in_current_test;
-					tester->branch_misses_max_time = tester->branch_misses_in_current_test;
-					tester->backend_stalled_cycles_max_time = tester->backend_stalled_cycles_in_current_test;
-					tester->frontend_stalled_cycles_max_time = tester->frontend_stalled_cycles_in_current_test;
-					tester->cycles_max_time = tester->cycles_in_current_test;
+					memcpy(tester->counter_max_time, tester->counter_in_current_test, sizeof(tester->counter_max_time));
 				}
 
 				u64 tsc = rdtsc();
@@ -328,30 +288,21 @@ i32 rt_is_testing(struct repetition_tester *tester)
 				{
 					tester->tsc_start = tsc;
 					tester->tsc_iteration_min = tester->tsc_in_current_test;
-					tester->page_faults_min_time = tester->page_faults_in_current_test;
-					tester->branch_misses_min_time = tester->branch_misses_in_current_test;
-					tester->backend_stalled_cycles_min_time = tester->backend_stalled_cycles_in_current_test;
-					tester->frontend_stalled_cycles_min_time = tester->frontend_stalled_cycles_in_current_test;
-					tester->cycles_min_time = tester->cycles_in_current_test;
+					memcpy(tester->counter_min_time, tester->counter_in_current_test, sizeof(tester->counter_min_time));
 				}
 
 				tester->bytes += tester->bytes_to_process;
 				tester->time += tester->tsc_in_current_test;
-				tester->page_faults += tester->page_faults_in_current_test;
-				tester->branch_misses += tester->branch_misses_in_current_test;
-				tester->backend_stalled_cycles += tester->backend_stalled_cycles_in_current_test;
-				tester->frontend_stalled_cycles += tester->frontend_stalled_cycles_in_current_test;
-				tester->cycles += tester->cycles_in_current_test;
+				for (u32 i = 0; i < RT_COUNTER_COUNT; ++i)
+				{
+					tester->counter[i] += tester->counter_in_current_test[i];
+				}
 				tester->enter_count = 0;
 				tester->exit_count = 0;
 				tester->test_count += 1;
 				tester->tsc_in_current_test = 0;
 				tester->bytes_in_current_test = tester->bytes_to_process;
-				tester->page_faults_in_current_test = 0;
-				tester->backend_stalled_cycles_in_current_test = 0;
-				tester->frontend_stalled_cycles_in_current_test = 0;
-				tester->cycles_in_current_test = 0;
-				tester->branch_misses_in_current_test = 0;
+				memset(tester->counter_in_current_test, 0, sizeof(tester->counter_in_current_test));
 
 				if (tester->tsc_retry_max < tsc - tester->tsc_start)
 				{
@@ -373,7 +324,7 @@ i32 rt_is_testing(struct repetition_tester *tester)
 	return status;
 }
 
-void rt_wave(struct repetition_tester *tester, const u64 bytes_to_process, const u64 tsc_freq, const u64 tsc_retry_max, const u32 print)
+void rt_wave(struct repetition_tester *tester, const u64 bytes_to_process, const u64 tsc_freq, const u64 tsc_retry_max, const u32 print, const enum rt_counter_scope scope)
 {
 	if (tester->state == RT_UNINITIALIZED)
 	{
@@ -381,7 +332,7 @@ void rt_wave(struct repetition_tester *tester, const u64 bytes_to_process, const
 		tester->tsc_freq = tsc_freq;
 		tester->print = print;
 		tester->tsc_iteration_min = UINT64_MAX;
-		//os_init_performance_events(tester);
+		os_init_performance_events(tester, scope);
 	}
 	else if (tester->state == RT_COMPLETED)
 	{
@@ -405,23 +356,13 @@ void rt_wave(struct repetition_tester *tester, const u64 bytes_to_process, const
 	tester->exit_count = 1;
 	tester->bytes_in_current_test = bytes_to_process;
 	tester->tsc_in_current_test = 0;
-	tester->page_faults_in_current_test = 0;
-	tester->branch_misses_in_current_test = 0;
-	tester->frontend_stalled_cycles_in_current_test = 0;
-	tester->backend_stalled_cycles_in_current_test = 0;
-	tester->cycles_in_current_test = 0;
+	memset(tester->counter_in_current_test, 0, sizeof(tester->counter_in_current_test));
 }
 
 void rt_begin_time(struct repetition_tester *tester)
 {
-	//os_enable_counters(tester);
-	//struct os_event_format format = { 0 };
-	//os_get_counters(tester, tester->pf_fd, &format);
-	//tester->page_faults_in_current_test -= format.page_faults;
-	//tester->branch_misses_in_current_test -= format.branch_misses;
-	//tester->frontend_stalled_cycles_in_current_test -= format.frontend_stalled_cycles;
-	//tester->backend_stalled_cycles_in_current_test -= format.backend_stalled_cycles;
-	//tester->cycles_in_current_test -= format.cycles;
+	/* counters are read outside of the timed region */
+	os_read_counters(tester, 0);
 	tester->enter_count += 1;
 	tester->tsc_in_current_test -= rdtsc();
 }
@@ -430,14 +371,56 @@ void rt_end_time(struct repetition_tester *tester)
 {
 	tester->tsc_in_current_test += rdtsc();
 	tester->exit_count += 1;
-	//struct os_event_format format = { 0 };
-	//os_get_counters(tester, tester->pf_fd, &format);
-	//tester->page_faults_in_current_test += format.page_faults;
-	//tester->branch_misses_in_current_test += format.branch_misses;
-	//tester->frontend_stalled_cycles_in_current_test += format.frontend_stalled_cycles;
-	//tester->backend_stalled_cycles_in_current_test += format.backend_stalled_cycles;
-	//tester->cycles_in_current_test += format.cycles;
-	//os_disable_counters(tester);
+	os_read_counters(tester, 1);
+}
+
+static void rt_print_counters(const struct repetition_tester *tester, FILE *file, const u64 *counter, const f64 divisor)
+{
+	const u32 available = tester->counter_available;
+	if (available & (1u << RT_COUNTER_PAGE_FAULTS))
+	{
+		const f64 pf = (f64) counter[RT_COUNTER_PAGE_FAULTS] / divisor;
+		fprintf(file, ", PF: %.1f", pf);
+		if (pf > 0.0)
+		{
+			fprintf(file, " (%.2fkB/PF)", (f64) tester->bytes_to_process / (1024.0 * pf));
+		}
+	}
+
+	if (available & (1u << RT_COUNTER_BRANCH_MISSES))
+	{
+		fprintf(file, ", BM: %.0f", (f64) counter[RT_COUNTER_BRANCH_MISSES] / divisor);
+	}
+
+	if (available & (1u << RT_COUNTER_CACHE_MISSES))
+	{
+		fprintf(file, ", CM: %.0f", (f64) counter[RT_COUNTER_CACHE_MISSES] / divisor);
+	}
+
+	/* stalls are reported as the fraction of cycles stalled when cycles are counted */
+	const u32 has_cycles = (available & (1u << RT_COUNTER_CYCLES)) && counter[RT_COUNTER_CYCLES];
+	if (available & (1u << RT_COUNTER_FRONTEND_STALLED_CYCLES))
+	{
+		fprintf(file, ", FNT_S: %.0f", (f64) counter[RT_COUNTER_FRONTEND_STALLED_CYCLES] / divisor);
+		if (has_cycles)
+		{
+			fprintf(file, " [%.3f]", (f64) counter[RT_COUNTER_FRONTEND_STALLED_CYCLES] / (f64) counter[RT_COUNTER_CYCLES]);
+		}
+	}
+
+	if (available & (1u << RT_COUNTER_BACKEND_STALLED_CYCLES))
+	{
+		fprintf(file, ", BCK_S: %.0f", (f64) counter[RT_COUNTER_BACKEND_STALLED_CYCLES] / divisor);
+		if (has_cycles)
+		{
+			fprintf(file, " [%.3f]", (f64) counter[RT_COUNTER_BACKEND_STALLED_CYCLES] / (f64) counter[RT_COUNTER_CYCLES]);
+		}
+	}
+
+	if (available & (1u << RT_COUNTER_CYCLES))
+	{
+		fprintf(file, ", CYC: %.0f", (f64) counter[RT_COUNTER_CYCLES] / divisor);
+	}
 }
 
 void rt_print_statistics(const struct repetition_tester *tester, FILE *file)
@@ -455,55 +438,15 @@ void rt_print_statistics(const struct repetition_tester *tester, FILE *file)
 	const f64 thr_min = ((f64) tester->bytes_to_process) / (ns_min / (1000.0f * 1000.0f * 1000.0f)); 
 	const f64 thr_avg = ((f64) tester->bytes_to_process) / (ns_avg / (1000.0f * 1000.0f * 1000.0f));
 
-	fprintf(file, "min: [%.5fms] %.3fGB/s\n", ms_min, thr_min / (1024.0f * 1024.0f * 1024.0f));
-	fprintf(file, "max: [%.5fms] %.3fGB/s\n", ms_max, thr_max / (1024.0f * 1024.0f * 1024.0f)); 
-	fprintf(file, "avg: [%.5fms] %.3fGB/s\n", ms_avg, thr_avg / (1024.0f * 1024.0f * 1024.0f)); 
-	fprintf(file, "min Cycles/B: [%.5fCyc/B]\n", (f64) tester->tsc_freq / thr_min); 
-
-	//const f64 pf_mi = tester->page_faults_min_time;
-	//const f64 pf_ma = tester->page_faults_max_time;
-	//const f64 pf_av = (f64) tester->page_faults / tester->test_count;
-
-	//const f64 kb_pf_mi = (f64) tester->bytes_to_process / (1024.0 * pf_mi);
-	//const f64 kb_pf_ma = (f64) tester->bytes_to_process / (1024.0 * pf_ma);
-	//const f64 kb_pf_av = (f64) tester->bytes_to_process / (1024.0 * pf_av);
-
-	//const u64 bm_mi = tester->branch_misses_min_time;
-	//const u64 bm_ma = tester->branch_misses_max_time;
-	//const u64 bm_av = tester->branch_misses / tester->test_count;
-
-	//const u64 fnt_mi = tester->frontend_stalled_cycles_min_time;
-	//const u64 fnt_ma = tester->frontend_stalled_cycles_max_time;
-	//const u64 fnt_av = tester->frontend_stalled_cycles / tester->test_count;
-
-	//const u64 bck_mi = tester->backend_stalled_cycles_min_time;
-	//const u64 bck_ma = tester->backend_stalled_cycles_max_time;
-	//const u64 bck_av = tester->backend_stalled_cycles / tester->test_count;
-
-	//f64 fnt_cyc_mi, fnt_cyc_ma, fnt_cyc_av, bck_cyc_mi, bck_cyc_ma, bck_cyc_av;
-	//if (tester->cyc_fd != -1)
-	//{
-	//	fnt_cyc_mi = (f64) fnt_mi / tester->cycles_min_time;
-	//	fnt_cyc_ma = (f64) fnt_ma / tester->cycles_max_time;
-	//	fnt_cyc_av = (f64) fnt_av / tester->cycles;
-
-	//	bck_cyc_mi = (f64) bck_mi / tester->cycles_min_time;
-	//	bck_cyc_ma = (f64) bck_ma / tester->cycles_max_time;
-	//	bck_cyc_av = (f64) bck_av / tester->cycles;
-	//}
-	//else
-	//{
-	//	fnt_cyc_mi = (f64) fnt_mi / tester->tsc_iteration_min;
-	//	fnt_cyc_ma = (f64) fnt_ma / tester->tsc_iteration_max;
-	//	fnt_cyc_av = (f64) fnt_av / tester->time;
-
-	//	bck_cyc_mi = (f64) bck_mi / tester->tsc_iteration_min;
-	//	bck_cyc_ma = (f64) bck_ma / tester->tsc_iteration_max;
-	//	bck_cyc_av = (f64) bck_av / tester->time;              
-	//}
-
-	//fprintf(file, "min: [%.5fms] %.3fGB/s, PF: [%.4f] %.4fkB/PF, BM: %lu, FNT_S (%lu) [%.4f], BCK_S (%lu) [%.4f]\n", ms_ma, thr_mi, pf_mi, kb_pf_mi, bm_mi, fnt_mi, fnt_cyc_mi, bck_mi, bck_cyc_mi);
-	//fprintf(file, "max: [%.5fms] %.3fGB/s, PF: [%.4f] %.4fkB/PF, BM: %lu, FNT_S (%lu) [%.4f], BCK_S (%lu) [%.4f]\n", ms_mi, thr_ma, pf_ma, kb_pf_ma, bm_ma, fnt_ma, fnt_cyc_ma, bck_ma, bck_cyc_ma); 
-	//fprintf(file, "avg: [%.5fms] %.3fGB/s, PF: [%.4f] %.4fkB/PF, BM: %lu, FNT_S (%lu) [%.4f], BCK_S (%lu) [%.4f]\n", ms_av, thr_av, pf_av, kb_pf_av, bm_av, fnt_av, fnt_cyc_av, bck_av, bck_cyc_av); 
-	//fprintf(file, "min Cycles/B: [%.5fCyc/B]\n", (f64) tester->tsc_freq / (thr_mi * 1024*1024*1024)); 
+	fprintf(file, "min: [%.5fms] %.3fGB/s", ms_min, thr_min / (1024.0f * 1024.0f * 1024.0f));
+	rt_print_counters(tester, file, tester->counter_min_time, 1.0);
+	fprintf(file, "\nmax: [%.5fms] %.3fGB/s", ms_max, thr_max / (1024.0f * 1024.0f * 1024.0f)); 
+	rt_print_counters(tester, file, tester->counter_max_time, 1.0);
+	fprintf(file, "\navg: [%.5fms] %.3fGB/s", ms_avg, thr_avg / (1024.0f * 1024.0f * 1024.0f)); 
+	rt_print_counters(tester, file, tester->counter, (f64) tester->test_count);
+	fprintf(file, "\nmin Cycles/B: [%.5fCyc/B]\n", (f64) tester->tsc_freq / thr_min); 
+	if (tester->counters_scaled)
+	{
+		fprintf(file, "(counters were multiplexed and are scaled estimates)\n");
+	}
 }
@@ -0,0 +1,692 @@
+/*
+==========================================================================
+    Copyright (C) 2026 Axel Sandstedt 
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <https://www.gnu.org/licenses/>.
+==========================================================================
+*/
+
+
+#include <stdlib.h>
+
+#include "test_local.h"
+
+/*
+ * Fork/join overhead of the task system. Tasks are empty, so timings are pure scheduling cost; sizes count
+ * tasks, so Cycles/B reads as cycles per task.
+ */
+
+#define FORK_JOIN_COUNT		4096
+#define FORK_JOIN_FANOUT	64	/* children per root task in the nested test */
+#define GRAPH_LAYER_COUNT	64
+#define GRAPH_LAYER_TASKS	8
+#define WAKE_BUNDLE_TASKS	64
+
+static void *fork_join_init(void)
+{
+	struct arena *mem = malloc(sizeof(struct arena));
+	*mem = arena_alloc(4*1024*1024);
+	return mem;
+}
+
+static void fork_join_reset(void *args)
+{
+	arena_flush(args);
+	task_context_frame_clear();
+}
+
+static void fork_join_free(void *args)
+{
+	arena_free(args);
+	free(args);
+}
+
+static void thread_empty(void *task_addr)
+{
+}
+
+/* main thread forks every task */
+static void fork_join_flat_test(void *args)
+{
+	struct arena *mem = args;
+	struct task_stream *stream = task_stream_init(mem);
+	for (u32 i = 0; i < FORK_JOIN_COUNT; ++i)
+	{
+		task_stream_dispatch(mem, stream, thread_empty, NULL);
+	}
+
+	task_main_master_run_available_jobs();
+	task_stream_spin_wait(stream);
+	task_stream_cleanup(stream);
+}
+
+static void thread_fork_children(void *task_addr)
+{
+	struct task *task = task_addr;
+	struct worker *worker = task->executor;
+
+	arena_push_record(&worker->mem_scratch);
+	struct task_stream *stream = task_stream_init(&worker->mem_scratch);
+	for (u32 i = 0; i < FORK_JOIN_FANOUT; ++i)
+	{
+		task_stream_dispatch(&worker->mem_scratch, stream, thread_empty, NULL);
+	}
+	task_stream_spin_wait(stream);
+	task_stream_cleanup(stream);
+	arena_pop_record(&worker->mem_scratch);
+}
+
+/* main thread forks root tasks, each root task forks and joins its own children */
+static void fork_join_nested_test(void *args)
+{
+	struct arena *mem = args;
+	struct task_stream *stream = task_stream_init(mem);
+	for (u32 i = 0; i < FORK_JOIN_COUNT / FORK_JOIN_FANOUT; ++i)
+	{
+		task_stream_dispatch(mem, stream, thread_fork_children, NULL);
+	}
+
+	task_main_master_run_available_jobs();
+	task_stream_spin_wait(stream);
+	task_stream_cleanup(stream);
+}
+
+static void thread_fork_halves(void *task_addr)
+{
+	struct task *task = task_addr;
+	struct worker *worker = task->executor;
+	const u64 count = (u64) task->input;
+	if (count <= 1)
+	{
+		return;
+	}
+
+	arena_push_record(&worker->mem_scratch);
+	struct task_stream *stream = task_stream_init(&worker->mem_scratch);
+	task_stream_dispatch(&worker->mem_scratch, stream, thread_fork_halves, (void *) (count / 2));
+	task_stream_dispatch(&worker->mem_scratch, stream, thread_fork_halves, (void *) (count - count / 2));
+	task_stream_spin_wait(stream);
+	task_stream_cleanup(stream);
+	arena_pop_record(&worker->mem_scratch);
+}
+
+/* recursive binary fork/join down to single task leaves, 2*FORK_JOIN_COUNT - 1 tasks in total */
+static void fork_join_recursive_test(void *args)
+{
+	struct arena *mem = args;
+	struct task_stream *stream = task_stream_init(mem);
+	task_stream_dispatch(mem, stream, thread_fork_halves, (void *) (u64) FORK_JOIN_COUNT);
+	task_main_master_run_available_jobs();
+	task_stream_spin_wait(stream);
+	task_stream_cleanup(stream);
+}
+
+/* chain of bundles, each layer depending on the previous one; only the last layer is waited on */
+static void bundle_graph_chain_test(void *args)
+{
+	struct arena *mem = args;
+	struct task_bundle *layer = task_bundle_alloc_range(mem, thread_empty, GRAPH_LAYER_TASKS, NULL, GRAPH_LAYER_TASKS, 0, NULL);
+	task_bundle_submit(layer);
+	for (u32 i = 1; i < GRAPH_LAYER_COUNT; ++i)
+	{
+		struct task_bundle *next = task_bundle_alloc_range(mem, thread_empty, GRAPH_LAYER_TASKS, NULL, GRAPH_LAYER_TASKS, 0, NULL);
+		task_bundle_depend(mem, next, layer);
+		task_bundle_submit(next);
+		layer = next;
+	}
+
+	task_bundle_wait(layer);
+	task_bundle_release(layer);
+}
+
+/* let every worker back off all the way into parking, so the next test pays the full wake up latency */
+static void wake_parked_reset(void *args)
+{
+	fork_join_reset(args);
+	while (atomic_load_acq_32(&g_task_ctx->a_parked) + 1 < g_task_ctx->worker_count)
+	{
+		kas_thread_yield();
+	}
+}
+
+/* submit a single bundle to parked workers and wait for it */
+static void bundle_wake_parked_test(void *args)
+{
+	struct arena *mem = args;
+	struct task_bundle *bundle = task_bundle_split_range(mem, thread_empty, WAKE_BUNDLE_TASKS, NULL, WAKE_BUNDLE_TASKS, 0, NULL);
+	task_bundle_wait(bundle);
+	task_bundle_release(bundle);
+}
+
+#ifdef KAS_TASK_TIMELINE
+
+/* record a profiler zone on the main worker; compare the fork/join tests against a build without the timeline
+ * for the capture overhead on the task paths */
+static void timeline_zone_record_test(void *args)
+{
+	for (u32 i = 0; i < FORK_JOIN_COUNT; ++i)
+	{
+		const u32 zone = task_timeline_zone_begin("timeline_zone");
+		task_timeline_zone_end(zone);
+	}
+}
+
+#endif
+
+struct serial_test task_serial_test[] =
+{
+	{ 
+		.id = "fork_join_flat_4096", 
+		.size = FORK_JOIN_COUNT,
+		.test = &fork_join_flat_test,
+		.test_init = &fork_join_init,
+		.test_reset = &fork_join_reset,
+		.test_free = &fork_join_free,
+	},
+
+	{ 
+		.id = "fork_join_nested_64x64", 
+		.size = FORK_JOIN_COUNT + FORK_JOIN_COUNT / FORK_JOIN_FANOUT,
+		.test = &fork_join_nested_test,
+		.test_init = &fork_join_init,
+		.test_reset = &fork_join_reset,
+		.test_free = &fork_join_free,
+	},
+
+	{ 
+		.id = "fork_join_recursive_4096", 
+		.size = 2*FORK_JOIN_COUNT - 1,
+		.test = &fork_join_recursive_test,
+		.test_init = &fork_join_init,
+		.test_reset = &fork_join_reset,
+		.test_free = &fork_join_free,
+	},
+
+	{ 
+		.id = "bundle_graph_chain_64x8", 
+		.size = GRAPH_LAYER_COUNT*GRAPH_LAYER_TASKS,
+		.test = &bundle_graph_chain_test,
+		.test_init = &fork_join_init,
+		.test_reset = &fork_join_reset,
+		.test_free = &fork_join_free,
+	},
+
+	{ 
+		.id = "bundle_wake_parked_64", 
+		.size = WAKE_BUNDLE_TASKS,
+		.test = &bundle_wake_parked_test,
+		.test_init = &fork_join_init,
+		.test_reset = &wake_parked_reset,
+		.test_free = &fork_join_free,
+	},
+
+#ifdef KAS_TASK_TIMELINE
+	{ 
+		.id = "timeline_zone_record_4096", 
+		.size = FORK_JOIN_COUNT,
+		.test = &timeline_zone_record_test,
+		.test_init = &fork_join_init,
+		.test_reset = &fork_join_reset,
+		.test_free = &fork_join_free,
+	},
+#endif
+};
+
+struct performance_suite storage_performance_task_suite =
+{
+	.id = "Task Performance",
+	.serial_test = task_serial_test,
+	.serial_test_count = sizeof(task_serial_test) / sizeof(task_serial_test[0]),
+};
+
+struct performance_suite *task_performance_suite = &storage_performance_task_suite;
+
+/* persistent memory of task contexts re-created by the tests */
+static struct arena test_task_mem = { 0 };
+
+void test_task_context_reinit(const u32 thread_count, const enum task_affinity affinity)
+{
+	task_context_destroy(g_task_ctx);
+	if (test_task_mem.mem_size == 0)
+	{
+		test_task_mem = arena_alloc(16*1024*1024);
+	}
+	arena_flush(&test_task_mem);
+	task_context_init(&test_task_mem, thread_count, affinity);
+}
+
+#define DEQUE_STRESS_ENTRY_COUNT	64		/* small, so that the deque wraps around often */
+#define DEQUE_STRESS_ITEM_COUNT		(1u << 18)
+#define DEQUE_STRESS_THIEF_COUNT	3
+
+struct deque_stress_input
+{
+	struct deque_ws *	deque;
+	u32 *			taken;		/* times each item has been popped or stolen */
+	u32 			a_done;		/* set by the owner once the deque is drained for good */
+};
+
+static void thread_deque_steal(void *task_addr)
+{
+	struct task *task = task_addr;
+	struct deque_stress_input *input = task->input;
+	while (1)
+	{
+		void *item = deque_ws_steal(input->deque);
+		if (item)
+		{
+			atomic_fetch_add_rlx_32(input->taken + ((u64) item - 1), 1);
+		}
+		else if (atomic_load_acq_32(&input->a_done))
+		{
+			break;
+		}
+		else
+		{
+			kas_cpu_relax();
+		}
+	}
+}
+
+/*
+ * The main thread owns a deque and pushes and pops random bursts of items while thieves steal from it. Every
+ * item must be taken exactly once, by either the owner or a single thief.
+ */
+static struct test_output deque_ws_steal_exactly_once(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	test_task_context_reinit(DEQUE_STRESS_THIEF_COUNT + 1, TASK_AFFINITY_NONE);
+
+	struct deque_stress_input input =
+	{
+		.deque = deque_ws_init(env->mem_1, DEQUE_STRESS_ENTRY_COUNT),
+		.taken = arena_push(env->mem_1, DEQUE_STRESS_ITEM_COUNT * sizeof(u32)),
+		.a_done = 0,
+	};
+	memset(input.taken, 0, DEQUE_STRESS_ITEM_COUNT * sizeof(u32));
+
+	struct task_bundle *bundle = task_bundle_split_range(env->mem_1, thread_deque_steal, DEQUE_STRESS_THIEF_COUNT, NULL, DEQUE_STRESS_THIEF_COUNT, 0, &input);
+
+	u32 next = 0;
+	while (next < DEQUE_STRESS_ITEM_COUNT)
+	{
+		const u64 push_count = rng_u64_range(1, 2*DEQUE_STRESS_ENTRY_COUNT);
+		for (u64 i = 0; i < push_count && next < DEQUE_STRESS_ITEM_COUNT; ++i)
+		{
+			if (deque_ws_try_push(input.deque, (void *) (u64) (next + 1)))
+			{
+				next += 1;
+			}
+		}
+
+		/* hand the core to the thieves now and then, so they also get to steal when they share it with the owner */
+		if (rng_u64_range(0, 15) == 0)
+		{
+			kas_thread_yield();
+		}
+
+		const u64 pop_count = rng_u64_range(0, DEQUE_STRESS_ENTRY_COUNT);
+		for (u64 i = 0; i < pop_count; ++i)
+		{
+			void *item = deque_ws_pop(input.deque);
+			if (!item)
+			{
+				break;
+			}
+			atomic_fetch_add_rlx_32(input.taken + ((u64) item - 1), 1);
+		}
+	}
+
+	void *item;
+	while ((item = deque_ws_pop(input.deque)) != NULL)
+	{
+		atomic_fetch_add_rlx_32(input.taken + ((u64) item - 1), 1);
+	}
+
+	atomic_store_rel_32(&input.a_done, 1);
+	task_main_master_run_available_jobs();
+	task_bundle_wait(bundle);
+	task_bundle_release(bundle);
+
+	u32 once = 1;
+	for (u32 i = 0; i < DEQUE_STRESS_ITEM_COUNT; ++i)
+	{
+		once = once && (atomic_load_rlx_32(input.taken + i) == 1);
+	}
+
+	test_task_context_reinit(g_arch_config->logical_core_count, TASK_AFFINITY_NONE);
+
+	TEST_TRUE(once);
+
+	return output;
+}
+
+#define GRAPH_TEST_WORKER_COUNT		4
+#define GRAPH_TEST_LAYER_COUNT		32
+#define GRAPH_TEST_LAYER_TASKS		16
+#define GRAPH_TEST_ROUNDS		64
+#define GRAPH_TEST_NS_TIMEOUT		(5llu*NSEC_PER_SEC)
+
+/* wait on bundle, running tasks on the main thread if help is set. Returns 0 if it did not complete within ns_timeout */
+static u32 test_bundle_wait_bounded(struct task_bundle *bundle, const u32 help, const u64 ns_timeout)
+{
+	const u64 ns_start = time_ns();
+	while (!atomic_load_acq_32(&bundle->a_completed))
+	{
+		if (time_ns() - ns_start > ns_timeout)
+		{
+			return 0;
+		}
+
+		if (help)
+		{
+			task_main_master_run_available_jobs();
+		}
+		kas_thread_yield();
+	}
+
+	return 1;
+}
+
+struct graph_layer
+{
+	u32 *	a_done;		/* completed tasks of the layer */
+	u32 *	a_prev_done;	/* completed tasks of the previous layer, or NULL */
+	u32 *	a_violations;	/* tasks started before every task of the previous layer completed */
+};
+
+static void thread_graph_layer(void *task_addr)
+{
+	struct task *task = task_addr;
+	const struct graph_layer *layer = task->input;
+	if (layer->a_prev_done && atomic_load_acq_32(layer->a_prev_done) != GRAPH_TEST_LAYER_TASKS)
+	{
+		atomic_add_fetch_rel_32(layer->a_violations, 1);
+	}
+	atomic_add_fetch_rel_32(layer->a_done, 1);
+}
+
+/*
+ * Layers of bundles where every layer depends on the two layers before it. The bundles are linked before any is
+ * submitted and submitted last layer first, so every dependency is pending when its link is added. Every task
+ * must see all tasks of the previous layer completed.
+ */
+static struct test_output bundle_graph_layers_ordered(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	test_task_context_reinit(GRAPH_TEST_WORKER_COUNT, TASK_AFFINITY_NONE);
+
+	u32 a_violations = 0;
+	u32 completed = 1;
+	u32 layers_done = 1;
+	u32 *a_done = arena_push(env->mem_1, GRAPH_TEST_LAYER_COUNT * sizeof(u32));
+	struct graph_layer *layer = arena_push(env->mem_1, GRAPH_TEST_LAYER_COUNT * sizeof(struct graph_layer));
+	struct task_bundle **bundle = arena_push(env->mem_1, GRAPH_TEST_LAYER_COUNT * sizeof(struct task_bundle *));
+	for (u32 r = 0; r < GRAPH_TEST_ROUNDS && completed; ++r)
+	{
+		arena_push_record(env->mem_1);
+		memset(a_done, 0, GRAPH_TEST_LAYER_COUNT * sizeof(u32));
+		for (u32 l = 0; l < GRAPH_TEST_LAYER_COUNT; ++l)
+		{
+			layer[l].a_done = a_done + l;
+			layer[l].a_prev_done = (l) ? a_done + l - 1 : NULL;
+			layer[l].a_violations = &a_violations;
+			bundle[l] = task_bundle_alloc_range(env->mem_1, thread_graph_layer, GRAPH_TEST_LAYER_TASKS, NULL, GRAPH_TEST_LAYER_TASKS, 0, layer + l);
+			if (l >= 1)
+			{
+				task_bundle_depend(env->mem_1, bundle[l], bundle[l-1]);
+			}
+			if (l >= 2)
+			{
+				task_bundle_depend(env->mem_1, bundle[l], bundle[l-2]);
+			}
+		}
+
+		for (u32 l = GRAPH_TEST_LAYER_COUNT; l; --l)
+		{
+			task_bundle_submit(bundle[l-1]);
+		}
+
+		completed = test_bundle_wait_bounded(bundle[GRAPH_TEST_LAYER_COUNT-1], 1, GRAPH_TEST_NS_TIMEOUT);
+		for (u32 l = 0; l < GRAPH_TEST_LAYER_COUNT && completed; ++l)
+		{
+			layers_done = layers_done && (atomic_load_acq_32(a_done + l) == GRAPH_TEST_LAYER_TASKS);
+			task_bundle_release(bundle[l]);
+		}
+		arena_pop_record(env->mem_1);
+	}
+
+	test_task_context_reinit(g_arch_config->logical_core_count, TASK_AFFINITY_NONE);
+
+	TEST_TRUE(completed);
+	TEST_TRUE(layers_done);
+	TEST_EQUAL(0, atomic_load_acq_32(&a_violations));
+
+	return output;
+}
+
+struct continuation_input
+{
+	u32	a_parent_done;		/* completed tasks of the parent */
+	u32	a_runs;			/* times the continuation ran */
+	u32	parent_done_seen;	/* parent tasks the continuation saw completed */
+};
+
+static void thread_continuation_parent(void *task_addr)
+{
+	struct task *task = task_addr;
+	struct continuation_input *input = task->input;
+	atomic_add_fetch_rel_32(&input->a_parent_done, 1);
+}
+
+static void thread_continuation(void *task_addr)
+{
+	struct task *task = task_addr;
+	struct continuation_input *input = task->input;
+	input->parent_done_seen = atomic_load_acq_32(&input->a_parent_done);
+	atomic_add_fetch_rel_32(&input->a_runs, 1);
+}
+
+/*
+ * A continuation must run exactly once and only after every task of its parent. Every other round attaches the
+ * continuation after the parent is submitted, racing its completion.
+ */
+static struct test_output bundle_continuation_runs_once(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	test_task_context_reinit(GRAPH_TEST_WORKER_COUNT, TASK_AFFINITY_NONE);
+
+	u32 completed = 1;
+	u32 once = 1;
+	u32 after_parent = 1;
+	for (u32 r = 0; r < GRAPH_TEST_ROUNDS*GRAPH_TEST_LAYER_COUNT && completed; ++r)
+	{
+		arena_push_record(env->mem_1);
+		struct continuation_input input = { 0 };
+		struct task_bundle *parent = task_bundle_alloc_range(env->mem_1, thread_continuation_parent, GRAPH_TEST_LAYER_TASKS, NULL, GRAPH_TEST_LAYER_TASKS, 0, &input);
+		struct task_bundle *continuation;
+		if (r & 1)
+		{
+			task_bundle_submit(parent);
+			continuation = task_bundle_continuation(env->mem_1, parent, thread_continuation, &input);
+		}
+		else
+		{
+			continuation = task_bundle_continuation(env->mem_1, parent, thread_continuation, &input);
+			task_bundle_submit(parent);
+		}
+
+		completed = test_bundle_wait_bounded(continuation, 1, GRAPH_TEST_NS_TIMEOUT);
+		if (completed)
+		{
+			/* any duplicate run would have been published by now */
+			task_main_master_run_available_jobs();
+			completed = atomic_load_acq_32(&parent->a_completed);
+			once = once && (atomic_load_acq_32(&input.a_runs) == 1);
+			after_parent = after_parent && (input.parent_done_seen == GRAPH_TEST_LAYER_TASKS);
+			task_bundle_release(continuation);
+			task_bundle_release(parent);
+		}
+		arena_pop_record(env->mem_1);
+	}
+
+	test_task_context_reinit(g_arch_config->logical_core_count, TASK_AFFINITY_NONE);
+
+	TEST_TRUE(completed);
+	TEST_TRUE(once);
+	TEST_TRUE(after_parent);
+
+	return output;
+}
+
+/*
+ * Depending on a bundle that already completed must not hold the dependent back; it is published as soon as it
+ * is submitted, also when it depends on a pending bundle as well.
+ */
+static struct test_output bundle_depend_on_completed(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	test_task_context_reinit(GRAPH_TEST_WORKER_COUNT, TASK_AFFINITY_NONE);
+
+	u32 completed = 1;
+	u32 closed = 1;
+	u32 ran = 1;
+	for (u32 r = 0; r < GRAPH_TEST_ROUNDS && completed; ++r)
+	{
+		arena_push_record(env->mem_1);
+		struct continuation_input input = { 0 };
+		struct task_bundle *done = task_bundle_split_range(env->mem_1, thread_continuation_parent, GRAPH_TEST_LAYER_TASKS, NULL, GRAPH_TEST_LAYER_TASKS, 0, &input);
+		completed = test_bundle_wait_bounded(done, 1, GRAPH_TEST_NS_TIMEOUT);
+		closed = closed && (atomic_load_acq_64(&done->a_dependents) == TASK_BUNDLE_LINK_CLOSED);
+
+		struct task_bundle *pending = task_bundle_alloc_range(env->mem_1, thread_continuation_parent, GRAPH_TEST_LAYER_TASKS, NULL, GRAPH_TEST_LAYER_TASKS, 0, &input);
+		struct task_bundle *bundle = task_bundle_alloc_task(env->mem_1, thread_continuation, &input);
+		task_bundle_depend(env->mem_1, bundle, done);
+		if (r & 1)
+		{
+			task_bundle_depend(env->mem_1, bundle, pending);
+		}
+		task_bundle_submit(bundle);
+		task_bundle_submit(pending);
+
+		completed = completed 
+			&& test_bundle_wait_bounded(bundle, 1, GRAPH_TEST_NS_TIMEOUT)
+			&& test_bundle_wait_bounded(pending, 1, GRAPH_TEST_NS_TIMEOUT);
+		if (completed)
+		{
+			ran = ran && (atomic_load_acq_32(&input.a_runs) == 1);
+			if (r & 1)
+			{
+				ran = ran && (input.parent_done_seen == 2*GRAPH_TEST_LAYER_TASKS);
+			}
+			task_bundle_release(done);
+			task_bundle_release(pending);
+			task_bundle_release(bundle);
+		}
+		arena_pop_record(env->mem_1);
+	}
+
+	test_task_context_reinit(g_arch_config->logical_core_count, TASK_AFFINITY_NONE);
+
+	TEST_TRUE(completed);
+	TEST_TRUE(closed);
+	TEST_TRUE(ran);
+
+	return output;
+}
+
+#define WAKE_TEST_ROUNDS		64
+
+static void thread_increment(void *task_addr)
+{
+	struct task *task = task_addr;
+	atomic_add_fetch_rel_32((u32 *) task->input, 1);
+}
+
+/* Returns 0 if not every worker but the master parked within ns_timeout */
+static u32 test_workers_parked_bounded(const u64 ns_timeout)
+{
+	const u64 ns_start = time_ns();
+	while (atomic_load_acq_32(&g_task_ctx->a_parked) + 1 < g_task_ctx->worker_count)
+	{
+		if (time_ns() - ns_start > ns_timeout)
+		{
+			return 0;
+		}
+		kas_thread_yield();
+	}
+
+	return 1;
+}
+
+/*
+ * Every worker parks before a bundle is submitted, and the main thread waits without running tasks, so the
+ * bundle only completes if submitting it wakes a parked worker; a lost wake up on a_wake_epoch times out.
+ */
+static struct test_output bundle_wakes_parked_workers(struct test_environment *env)
+{
+	struct test_output output = { .success = 1, .id = __func__ };
+
+	test_task_context_reinit(GRAPH_TEST_WORKER_COUNT, TASK_AFFINITY_NONE);
+	task_context_set_wait_policy(16, 4);
+
+	u32 parked = 1;
+	u32 completed = 1;
+	u32 all_ran = 1;
+	for (u32 r = 0; r < WAKE_TEST_ROUNDS && parked && completed; ++r)
+	{
+		arena_push_record(env->mem_1);
+		parked = test_workers_parked_bounded(GRAPH_TEST_NS_TIMEOUT);
+
+		u32 a_ran = 0;
+		struct task_bundle *bundle = task_bundle_split_range(env->mem_1, thread_increment, WAKE_BUNDLE_TASKS, NULL, WAKE_BUNDLE_TASKS, 0, &a_ran);
+		completed = test_bundle_wait_bounded(bundle, 0, GRAPH_TEST_NS_TIMEOUT);
+		if (completed)
+		{
+			all_ran = all_ran && (atomic_load_acq_32(&a_ran) == WAKE_BUNDLE_TASKS);
+			task_bundle_release(bundle);
+		}
+		arena_pop_record(env->mem_1);
+	}
+
+	test_task_context_reinit(g_arch_config->logical_core_count, TASK_AFFINITY_NONE);
+
+	TEST_TRUE(parked);
+	TEST_TRUE(completed);
+	TEST_TRUE(all_ran);
+
+	return output;
+}
+
+static struct test_output (*task_tests[])(struct test_environment *) =
+{
+	deque_ws_steal_exactly_once,
+	bundle_graph_layers_ordered,
+	bundle_continuation_runs_once,
+	bundle_depend_on_completed,
+	bundle_wakes_parked_workers,
+};
+
+struct suite m_task_suite =
+{
+	.id = "task",
+	.unit_test = task_tests,
+	.unit_test_count = sizeof(task_tests) / sizeof(task_tests[0]),
+};
+
+struct suite *task_suite = &m_task_suite;